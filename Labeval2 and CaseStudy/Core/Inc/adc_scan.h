@@ -0,0 +1,69 @@
+/**
+  ******************************************************************************
+  * @file           : adc_scan.h
+  * @brief          : Timer paced multi-channel ADC acquisition by circular DMA.
+  ******************************************************************************
+  */
+
+#ifndef __ADC_SCAN_H
+#define __ADC_SCAN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "stm32f4xx_hal.h"
+
+/* Every update of a timer starts one conversion of the regular sequence of
+ * the ADC through its TRGO output, so the sample clock is the timer's and
+ * does not depend on the load of the processor.  The DMA stream linked to
+ * the ADC writes the results, in rank order, into a buffer of two halves in
+ * circular mode.  When the DMA finishes a half it goes on with the other
+ * one, and the half it finished is handed to the consumer task as it is,
+ * without copying: the samples stay valid until the consumer waits again,
+ * which must be before the DMA comes back to them one half later. */
+
+/* A completed half of the buffer */
+typedef struct
+{
+    const uint16_t* samples;    /* The sequences, each in rank order */
+    uint64_t timestamp_us;      /* timebase_get_us() time of the trigger of the first sequence */
+    uint32_t period_us;         /* Between the triggers of consecutive sequences */
+    uint32_t sequence;          /* Number of the first sequence since adc_scan_start() */
+} adc_scan_block_t;
+
+typedef struct
+{
+    uint32_t halves;        /* Halves completed since adc_scan_start() */
+    uint32_t overruns;      /* Halves the DMA overwrote before the consumer was done */
+} adc_scan_stats_t;
+
+/* Starts the conversions of hadc, configured for scan, DMA continuous
+ * requests and the TRGO of htim as external trigger, into buffer, which
+ * holds two halves of scans_per_half sequences, then starts htim.  htim
+ * must count microseconds, like TIM5, and send TRGO on update; a sequence
+ * must take less than its period.  The calling task becomes the consumer
+ * and must not use its task notification for anything else. */
+HAL_StatusTypeDef adc_scan_start(ADC_HandleTypeDef* hadc, TIM_HandleTypeDef* htim,
+                                 uint16_t* buffer, uint32_t scans_per_half);
+
+/* Stops the timer, the conversions and the DMA */
+void adc_scan_stop(void);
+
+/* Gives back the half the consumer holds and blocks until the DMA completes
+ * the next one.  Returns pdFAIL on timeout. */
+BaseType_t adc_scan_wait(adc_scan_block_t* block, TickType_t timeout);
+
+void adc_scan_get_stats(adc_scan_stats_t* stats);
+
+/* Call from HAL_ADC_ConvHalfCpltCallback() with half 0 and from
+ * HAL_ADC_ConvCpltCallback() with half 1 */
+void adc_scan_half_complete_from_isr(uint32_t half, BaseType_t* higher_priority_task_woken);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ADC_SCAN_H */
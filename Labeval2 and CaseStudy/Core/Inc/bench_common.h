@@ -0,0 +1,62 @@
+/**
+  ******************************************************************************
+  * @file           : bench_common.h
+  * @brief          : Timing and reporting shared by the benchmarks.
+  ******************************************************************************
+  */
+
+#ifndef __BENCH_COMMON_H
+#define __BENCH_COMMON_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stdint.h"
+
+/* Every case is measured BENCH_ITERATIONS times */
+#define BENCH_ITERATIONS       1000
+#define BENCH_P99_INDEX        (((BENCH_ITERATIONS * 99) + 99) / 100 - 1)
+
+/* On the board the counter is the DWT cycle counter, on the host the
+ * monotonic clock in nanoseconds.  Both wrap at 32 bits, so only the
+ * difference of two timestamps is meaningful. */
+#if defined(KERNEL_BENCHMARK_HOST) || defined(DSP_BENCHMARK_HOST)
+
+#include "time.h"
+
+#define BENCH_UNIT             "ns"
+
+static inline uint32_t bench_timestamp(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t) ((uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec);
+}
+
+#else
+
+#include "main.h"
+
+#define BENCH_UNIT             "cycles"
+
+static inline uint32_t bench_timestamp(void)
+{
+    return DWT->CYCCNT;
+}
+
+#endif
+
+/* Starts the counter.  Call once before the first bench_timestamp(). */
+void bench_timer_init(void);
+
+/* Sorts the BENCH_ITERATIONS samples of a case and prints its result line:
+ *     bench,<case>,<parameter>,<unit>,<samples>,<min>,<median>,<p99>,<max> */
+void bench_report(const char* name, uint32_t parameter, const char* unit, uint32_t* samples);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BENCH_COMMON_H */
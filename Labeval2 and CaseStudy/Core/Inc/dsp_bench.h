@@ -0,0 +1,34 @@
+/**
+  ******************************************************************************
+  * @file           : dsp_bench.h
+  * @brief          : Filter check and benchmark suite.
+  ******************************************************************************
+  */
+
+#ifndef __DSP_BENCH_H
+#define __DSP_BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Define DSP_BENCHMARK to run the suite instead of the application tasks.
+ * It first checks that the SIMD and C versions of the filters of
+ * dsp_filter.c give the same output bit for bit, over random signals and
+ * coefficients passed in blocks of changing size, printing
+ *     check,<case>,<parameter>,<samples>,<mismatches>
+ * and stopping in Error_Handler() on a mismatch.  Then it prints the cost
+ * of each filter on USART2 in the CSV format of kernel_bench.h, per sample
+ * of blocks of DSP_BENCH_BLOCK samples.  The unit is DWT cycles per sample
+ * on the board.  host/Makefile builds the same suite for Linux, with the C
+ * equivalents of the SIMD instructions, where the check is what counts and
+ * the unit is nanoseconds per sample. */
+
+/* Creates the benchmark task.  Must be called before vTaskStartScheduler(). */
+void dsp_bench_start(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DSP_BENCH_H */
@@ -0,0 +1,166 @@
+/**
+  ******************************************************************************
+  * @file           : dsp_filter.h
+  * @brief          : Fixed-point streaming filters for blocks of ADC samples.
+  ******************************************************************************
+  */
+
+#ifndef __DSP_FILTER_H
+#define __DSP_FILTER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* Q15 and Q31 as in CMSIS-DSP: signed fractions in [-1, 1) */
+typedef int16_t q15_t;
+typedef int32_t q31_t;
+
+/* Each filter keeps its state between calls, so a signal can be passed in
+ * blocks, such as the halves of a DMA buffer, and the output is the same as
+ * for the signal in one piece.
+ * Products are summed in 64 bits and the result is truncated, then
+ * saturated to the output format.  The Q31 sums have no guard bits, so
+ * the absolute sum of the Q31 coefficients times the largest input must
+ * stay below 2, and below 1 before the post shift of the IIR filters.
+ *
+ * dsp_fir_q15() and dsp_biquad_q15() use the dual 16-bit multiply
+ * accumulate (SMLALD) and saturation (SSAT) instructions of the Cortex-M4
+ * when DSP_FILTER_SIMD is 1, the default when the compiler targets them.
+ * The _c functions are the portable C versions, always built; both give
+ * the same output bit for bit, which dsp_bench.c checks. */
+#ifndef DSP_FILTER_SIMD
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#define DSP_FILTER_SIMD         1
+#else
+#define DSP_FILTER_SIMD         0
+#endif
+#endif
+
+/* y[n] = b[0] x[n] + b[1] x[n-1] + ... + b[taps-1] x[n-taps+1], with the
+ * coefficients in time reversed order, { b[taps-1], ..., b[1], b[0] }, as
+ * in CMSIS-DSP.  The state holds taps - 1 + max_block samples. */
+typedef struct
+{
+    uint32_t taps;
+    uint32_t max_block;
+    const q15_t* coeffs;
+    q15_t* state;
+} dsp_fir_q15_t;
+
+typedef struct
+{
+    uint32_t taps;
+    uint32_t max_block;
+    const q31_t* coeffs;
+    q31_t* state;
+} dsp_fir_q31_t;
+
+#define DSP_FIR_STATE_SIZE(taps, max_block)    ((taps) - 1U + (max_block))
+
+/* A cascade of second order sections in direct form I, each computing
+ *     y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] + a1 y[n-1] + a2 y[n-2]
+ * with the coefficients scaled down by 2^post_shift, so that coefficients
+ * up to 2^post_shift in magnitude fit; note the sign of a1 and a2.  As in
+ * CMSIS-DSP a Q15 section has the coefficients { b0, 0, b1, b2, a1, a2 },
+ * the zero keeping the pairs aligned for SMLALD, and a Q31 section
+ * { b0, b1, b2, a1, a2 }.  The state holds { x[n-1], x[n-2], y[n-1],
+ * y[n-2] } of each section. */
+typedef struct
+{
+    uint32_t sections;
+    uint32_t post_shift;
+    const q15_t* coeffs;
+    q15_t* state;
+} dsp_biquad_q15_t;
+
+typedef struct
+{
+    uint32_t sections;
+    uint32_t post_shift;
+    const q31_t* coeffs;
+    q31_t* state;
+} dsp_biquad_q31_t;
+
+#define DSP_BIQUAD_Q15_COEFFS_SIZE(sections)   (6U * (sections))
+#define DSP_BIQUAD_Q31_COEFFS_SIZE(sections)   (5U * (sections))
+#define DSP_BIQUAD_STATE_SIZE(sections)        (4U * (sections))
+
+/* The mean of the last 2^log2_length samples, kept as a running sum, so
+ * each sample costs the same whatever the length.  The history holds
+ * 2^log2_length samples. */
+typedef struct
+{
+    uint32_t log2_length;
+    uint32_t index;
+    int32_t sum;
+    q15_t* history;
+} dsp_moving_average_q15_t;
+
+/* A cascaded integrator-comb decimator of order N and ratio
+ * R = 2^log2_ratio: N integrators at the input rate and N combs of delay 1
+ * at the output rate, one output per R samples, with only additions.  It
+ * sums the input like N moving sums of R samples in series, so the output
+ * grows by N log2_ratio bits, and the last ones are dropped for
+ * output_bits; R times fewer samples of uncorrelated noise of an LSB or
+ * more gain log2_ratio / 2 bits of resolution, so 12-bit samples decimated
+ * by 16 give 14 bits and by 256 16 bits.  The samples are unsigned.  The
+ * registers wrap around modulo 2^32, which the combs undo as long as
+ * input_bits + N log2_ratio is at most 32. */
+#define DSP_CIC_MAX_ORDER      4U
+
+typedef struct
+{
+    uint32_t order;
+    uint32_t log2_ratio;
+    uint32_t shift;
+    uint32_t phase;                             /* Samples since the last output */
+    uint32_t integrators[DSP_CIC_MAX_ORDER];
+    uint32_t delays[DSP_CIC_MAX_ORDER];         /* Previous input of each comb */
+} dsp_cic_t;
+
+/* Clear the state, so the signal before the first block is taken as zero */
+void dsp_fir_q15_init(dsp_fir_q15_t* filter, uint32_t taps, const q15_t* coeffs,
+                      q15_t* state, uint32_t max_block);
+void dsp_fir_q31_init(dsp_fir_q31_t* filter, uint32_t taps, const q31_t* coeffs,
+                      q31_t* state, uint32_t max_block);
+void dsp_biquad_q15_init(dsp_biquad_q15_t* filter, uint32_t sections, const q15_t* coeffs,
+                         q15_t* state, uint32_t post_shift);
+void dsp_biquad_q31_init(dsp_biquad_q31_t* filter, uint32_t sections, const q31_t* coeffs,
+                         q31_t* state, uint32_t post_shift);
+void dsp_moving_average_q15_init(dsp_moving_average_q15_t* filter, uint32_t log2_length,
+                                 q15_t* history);
+
+/* Returns 0, or -1 if order is above DSP_CIC_MAX_ORDER, the registers would
+ * need more than 32 bits or output_bits is more than they hold.  The first
+ * order - 1 outputs include the zeros before the first sample. */
+int32_t dsp_cic_init(dsp_cic_t* cic, uint32_t order, uint32_t log2_ratio, uint32_t input_bits,
+                     uint32_t output_bits);
+
+/* Filter count samples, at most max_block for the FIR filters.  out may be
+ * the same buffer as in. */
+void dsp_fir_q15(dsp_fir_q15_t* filter, const q15_t* in, q15_t* out, uint32_t count);
+void dsp_fir_q15_c(dsp_fir_q15_t* filter, const q15_t* in, q15_t* out, uint32_t count);
+void dsp_fir_q31(dsp_fir_q31_t* filter, const q31_t* in, q31_t* out, uint32_t count);
+void dsp_biquad_q15(dsp_biquad_q15_t* filter, const q15_t* in, q15_t* out, uint32_t count);
+void dsp_biquad_q15_c(dsp_biquad_q15_t* filter, const q15_t* in, q15_t* out, uint32_t count);
+void dsp_biquad_q31(dsp_biquad_q31_t* filter, const q31_t* in, q31_t* out, uint32_t count);
+void dsp_moving_average_q15(dsp_moving_average_q15_t* filter, const q15_t* in, q15_t* out,
+                            uint32_t count);
+
+/* Takes one sample.  Returns 1 with the next output in *out when the sample
+ * completes a period of the ratio, else 0. */
+uint32_t dsp_cic_update(dsp_cic_t* cic, uint32_t sample, uint32_t* out);
+
+/* Takes count samples, every stride-th one of in, such as one channel of a
+ * block of ADC scans, and returns the number of outputs written to out */
+uint32_t dsp_cic_decimate(dsp_cic_t* cic, const uint16_t* in, uint32_t stride, uint32_t count,
+                          uint32_t* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DSP_FILTER_H */
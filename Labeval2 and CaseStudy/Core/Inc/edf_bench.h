@@ -0,0 +1,28 @@
+/**
+  ******************************************************************************
+  * @file           : edf_bench.h
+  * @brief          : Context switch latency benchmark for the EDF scheduler.
+  ******************************************************************************
+  */
+
+#ifndef __EDF_BENCH_H
+#define __EDF_BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "FreeRTOS.h"
+
+/* Build with EDF_BENCHMARK defined to run the benchmark instead of the
+ * application tasks.  Results are printed on USART2 as the CSV lines of
+ * bench_common.h. */
+
+/* Creates the benchmark task.  Must be called before vTaskStartScheduler(). */
+void edf_bench_start(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __EDF_BENCH_H */
@@ -0,0 +1,32 @@
+/**
+  ******************************************************************************
+  * @file           : kernel_bench.h
+  * @brief          : Kernel cost benchmark suite.
+  ******************************************************************************
+  */
+
+#ifndef __KERNEL_BENCH_H
+#define __KERNEL_BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "FreeRTOS.h"
+
+/* Build the Benchmark configuration, or define KERNEL_BENCHMARK, to run the
+ * suite instead of the application tasks.  Results are printed on USART2 as
+ * CSV, one line per case:
+ *     bench,<case>,<parameter>,<unit>,<samples>,<min>,<median>,<p99>,<max>
+ * The unit is DWT cycles on the board.  host/Makefile builds the same suite
+ * for Linux, where the unit is nanoseconds.  tools/bench_compare.py compares
+ * two result files. */
+
+/* Creates the benchmark task.  Must be called before vTaskStartScheduler(). */
+void kernel_bench_start(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KERNEL_BENCH_H */
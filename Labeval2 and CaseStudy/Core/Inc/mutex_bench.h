@@ -0,0 +1,28 @@
+/**
+  ******************************************************************************
+  * @file           : mutex_bench.h
+  * @brief          : Lock/unlock cost benchmark for the priority ceiling mutex.
+  ******************************************************************************
+  */
+
+#ifndef __MUTEX_BENCH_H
+#define __MUTEX_BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "FreeRTOS.h"
+
+/* Build with MUTEX_BENCHMARK defined to run the benchmark instead of the
+ * application tasks.  Results are printed on USART2 as the CSV lines of
+ * bench_common.h. */
+
+/* Creates the benchmark task.  Must be called before vTaskStartScheduler(). */
+void mutex_bench_start(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MUTEX_BENCH_H */
@@ -0,0 +1,47 @@
+/**
+  ******************************************************************************
+  * @file           : taskset_config.h
+  * @brief          : Task parameters, generated from Core/taskset.json.
+  *
+  * Generated by tools/taskset_gen.py from the analysed task table; change
+  * the table and generate again instead of editing this file.
+  *
+  * Scheduling: EDF in the band at priority 2, resources under SRP.
+  * Processor demand test passed at utilization 0.182.
+  ******************************************************************************
+  */
+
+#ifndef __TASKSET_CONFIG_H
+#define __TASKSET_CONFIG_H
+
+/* Times in microseconds, stack sizes in words */
+
+/* ADCTask */
+#define ADC_TASK_PRIORITY               2
+#define ADC_TASK_PERIOD_US              100000
+#define ADC_TASK_DEADLINE_US            100000
+#define ADC_TASK_WCET_US                500
+#define ADC_TASK_STACK_SIZE             128
+
+/* LEDHighTask */
+#define LED_HIGH_PRIORITY               2
+#define LED_HIGH_PERIOD_US              350000
+#define LED_HIGH_DEADLINE_US            350000
+#define LED_HIGH_WCET_US                20000
+#define LED_HIGH_STACK_SIZE             208
+
+/* LEDLowTask */
+#define LED_LOW_PRIORITY                2
+#define LED_LOW_PERIOD_US               1000000
+#define LED_LOW_DEADLINE_US             1000000
+#define LED_LOW_WCET_US                 20000
+#define LED_LOW_STACK_SIZE              208
+
+/* BTTask */
+#define BT_SERVER_PRIORITY              2
+#define BT_SERVER_PERIOD_US             250000
+#define BT_SERVER_DEADLINE_US           250000
+#define BT_SERVER_WCET_US               25000
+#define BT_SERVER_STACK_SIZE            128
+
+#endif /* __TASKSET_CONFIG_H */
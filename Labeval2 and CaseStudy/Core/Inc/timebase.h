@@ -0,0 +1,36 @@
+/**
+  ******************************************************************************
+  * @file           : timebase.h
+  * @brief          : 64-bit microsecond time base on TIM5.
+  ******************************************************************************
+  */
+
+#ifndef __TIMEBASE_H
+#define __TIMEBASE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* TIM5 counts microseconds from HAL_InitTick() and is extended to 64 bits in
+ * software, so the time never wraps while the device is running.  Safe to
+ * call from tasks, from interrupts and with interrupts masked. */
+uint64_t timebase_get_us(void);
+
+/* Call timebase_alarm_callback() from the TIM5 interrupt once the time
+ * reaches time_us, using compare channel 2.  A time in the past fires at
+ * once.  Setting a new alarm replaces the pending one; the time must be less
+ * than 2^32 us ahead. */
+void timebase_set_alarm(uint64_t time_us);
+
+/* Called from the TIM5 interrupt when the alarm fires.  The alarm is one-shot
+ * and may be set again from the callback.  Does nothing unless overridden. */
+void timebase_alarm_callback(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TIMEBASE_H */
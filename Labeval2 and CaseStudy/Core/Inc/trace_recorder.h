@@ -0,0 +1,179 @@
+/**
+  ******************************************************************************
+  * @file           : trace_recorder.h
+  * @brief          : Binary scheduling trace recorder.
+  ******************************************************************************
+  */
+
+#ifndef __TRACE_RECORDER_H
+#define __TRACE_RECORDER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* Included at the end of FreeRTOSConfig.h when configUSE_TRACE_RECORDER is 1,
+ * so this header is seen by the kernel sources and must not pull in the HAL.
+ *
+ * Every event is one fixed size record with a TIM5 microsecond timestamp;
+ * nothing is formatted on the target.  tools/trace_decode.py turns a dump
+ * into a per-task timeline and prints response times and preemptions.
+ *
+ * Snapshot mode keeps the most recent TRACE_BUFFER_RECORDS events.  Stop the
+ * trace and save the buffer from the debugger:
+ *     dump binary value trace.bin trace_buffer
+ * Streaming mode sends the events on a UART from a low priority task.  Events
+ * that arrive while the buffer is full are counted and reported in the
+ * stream instead of overwriting unsent ones. */
+
+#ifndef TRACE_BUFFER_RECORDS
+#define TRACE_BUFFER_RECORDS    1024    /* Must be a power of two */
+#endif
+#define TRACE_MAX_TASKS         16
+#define TRACE_TASK_NAME_LEN     16
+
+#define TRACE_MAGIC             0x52544652UL    /* "RFTR" */
+#define TRACE_VERSION           1
+
+#if ( configUSE_TRACE_FACILITY != 1 )
+    #error The trace recorder uses the task and queue numbers, set configUSE_TRACE_FACILITY to 1
+#endif
+
+typedef enum
+{
+    TRACE_MODE_SNAPSHOT = 0,
+    TRACE_MODE_STREAMING = 1
+} trace_mode_t;
+
+/* The object field of a record holds the task number for task events and the
+ * queue number for queue events. */
+typedef enum
+{
+    TRACE_EVENT_TASK_CREATE = 1,            /* data: priority */
+    TRACE_EVENT_TASK_NAME,                  /* timestamp and data: next 6 characters of the name */
+    TRACE_EVENT_TASK_DELETE,
+    TRACE_EVENT_TASK_READY,
+    TRACE_EVENT_TASK_SWITCHED_IN,
+    TRACE_EVENT_TASK_SWITCHED_OUT,          /* data: 1 if the task is still ready (preempted) */
+    TRACE_EVENT_TASK_PRIORITY_SET,          /* data: new priority */
+    TRACE_EVENT_TASK_PRIORITY_INHERIT,      /* data: inherited priority */
+    TRACE_EVENT_TASK_PRIORITY_DISINHERIT,   /* data: restored priority */
+    TRACE_EVENT_TASK_PRIORITY_CEILING,      /* data: ceiling priority */
+    TRACE_EVENT_DEADLINE_MISSED,
+    TRACE_EVENT_SERVER_BUDGET_EXHAUSTED,
+    TRACE_EVENT_QUEUE_CREATE,               /* data: queue type */
+    TRACE_EVENT_QUEUE_SEND,
+    TRACE_EVENT_QUEUE_RECEIVE,
+    TRACE_EVENT_QUEUE_BLOCK_SEND,
+    TRACE_EVENT_QUEUE_BLOCK_RECEIVE,
+    TRACE_EVENT_QUEUE_SEND_FROM_ISR,
+    TRACE_EVENT_QUEUE_RECEIVE_FROM_ISR,
+    TRACE_EVENT_ISR_ENTER,                  /* data: exception number */
+    TRACE_EVENT_ISR_EXIT,                   /* data: exception number */
+    TRACE_EVENT_DROPPED                     /* data: events lost before this one */
+} trace_event_t;
+
+typedef struct
+{
+    uint32_t timestamp;     /* TIM5 count in microseconds */
+    uint8_t event;          /* trace_event_t */
+    uint8_t object;
+    uint16_t data;
+} trace_record_t;
+
+typedef struct
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t capacity;      /* Records in the buffer */
+    uint32_t write_index;   /* Events recorded since trace_start() */
+    uint32_t read_index;    /* Streaming: events sent so far */
+    uint32_t dropped;       /* Streaming: events lost to a full buffer */
+    uint32_t timestamp_hz;
+    uint8_t mode;           /* trace_mode_t */
+    uint8_t running;
+    uint8_t max_tasks;
+    uint8_t name_len;
+} trace_header_t;
+
+/* The dump layout read by the decoder: the header, the task name table
+ * indexed by task number, then the ring of records. */
+typedef struct
+{
+    trace_header_t header;
+    char task_names[TRACE_MAX_TASKS][TRACE_TASK_NAME_LEN];
+    trace_record_t records[TRACE_BUFFER_RECORDS];
+} trace_buffer_t;
+
+extern trace_buffer_t trace_buffer;
+
+struct __UART_HandleTypeDef;
+
+/* Clears the buffer and starts recording.  Can be called before the
+ * scheduler is started so that task creation is recorded. */
+void trace_start(trace_mode_t mode);
+
+/* Stops recording.  The buffer is left intact for the debugger. */
+void trace_stop(void);
+
+/* Starts recording in streaming mode and creates the task that sends the
+ * header, the name table and then the records on the given UART. */
+void trace_stream_start(struct __UART_HandleTypeDef* huart, uint32_t priority);
+
+/* Called through the kernel trace macros below and from interrupt handlers */
+void trace_record(uint8_t event, uint8_t object, uint16_t data);
+void trace_task_create(uint8_t task, uint16_t priority, const char* name);
+uint8_t trace_queue_create(uint8_t queue_type);
+void trace_isr_enter(void);
+void trace_isr_exit(void);
+
+/* Kernel trace macros.  The task switch macros run inside vTaskSwitchContext()
+ * where pxCurrentTCB and the ready lists are visible. */
+#define traceTASK_CREATE( pxNewTCB ) \
+    trace_task_create( ( uint8_t ) ( pxNewTCB )->uxTCBNumber, ( uint16_t ) ( pxNewTCB )->uxPriority, ( pxNewTCB )->pcTaskName )
+#define traceTASK_DELETE( pxTaskToDelete ) \
+    trace_record( TRACE_EVENT_TASK_DELETE, ( uint8_t ) ( pxTaskToDelete )->uxTCBNumber, 0U )
+#define traceMOVED_TASK_TO_READY_STATE( pxTCB ) \
+    trace_record( TRACE_EVENT_TASK_READY, ( uint8_t ) ( pxTCB )->uxTCBNumber, 0U )
+#define traceTASK_SWITCHED_IN() \
+    trace_record( TRACE_EVENT_TASK_SWITCHED_IN, ( uint8_t ) pxCurrentTCB->uxTCBNumber, 0U )
+#define traceTASK_SWITCHED_OUT()                                                                    \
+    trace_record( TRACE_EVENT_TASK_SWITCHED_OUT, ( uint8_t ) pxCurrentTCB->uxTCBNumber,             \
+                  ( uint16_t ) listIS_CONTAINED_WITHIN( &( pxReadyTasksLists[ pxCurrentTCB->uxPriority ] ), \
+                                                        &( pxCurrentTCB->xStateListItem ) ) )
+#define traceTASK_PRIORITY_SET( pxTask, uxNewPriority ) \
+    trace_record( TRACE_EVENT_TASK_PRIORITY_SET, ( uint8_t ) ( pxTask )->uxTCBNumber, ( uint16_t ) ( uxNewPriority ) )
+#define traceTASK_PRIORITY_INHERIT( pxTCBOfMutexHolder, uxInheritedPriority ) \
+    trace_record( TRACE_EVENT_TASK_PRIORITY_INHERIT, ( uint8_t ) ( pxTCBOfMutexHolder )->uxTCBNumber, ( uint16_t ) ( uxInheritedPriority ) )
+#define traceTASK_PRIORITY_DISINHERIT( pxTCBOfMutexHolder, uxOriginalPriority ) \
+    trace_record( TRACE_EVENT_TASK_PRIORITY_DISINHERIT, ( uint8_t ) ( pxTCBOfMutexHolder )->uxTCBNumber, ( uint16_t ) ( uxOriginalPriority ) )
+#define traceTASK_PRIORITY_CEILING( pxTCBOfMutexHolder, uxCeilingPriority ) \
+    trace_record( TRACE_EVENT_TASK_PRIORITY_CEILING, ( uint8_t ) ( pxTCBOfMutexHolder )->uxTCBNumber, ( uint16_t ) ( uxCeilingPriority ) )
+#define traceTASK_DEADLINE_MISSED( pxTCB ) \
+    trace_record( TRACE_EVENT_DEADLINE_MISSED, ( uint8_t ) ( pxTCB )->uxTCBNumber, 0U )
+#define traceTASK_SERVER_BUDGET_EXHAUSTED( pxTCB ) \
+    trace_record( TRACE_EVENT_SERVER_BUDGET_EXHAUSTED, ( uint8_t ) ( pxTCB )->uxTCBNumber, 0U )
+
+#define traceQUEUE_CREATE( pxNewQueue ) \
+    ( pxNewQueue )->uxQueueNumber = trace_queue_create( ( pxNewQueue )->ucQueueType )
+#define traceQUEUE_SEND( pxQueue ) \
+    trace_record( TRACE_EVENT_QUEUE_SEND, ( uint8_t ) ( pxQueue )->uxQueueNumber, 0U )
+#define traceQUEUE_RECEIVE( pxQueue ) \
+    trace_record( TRACE_EVENT_QUEUE_RECEIVE, ( uint8_t ) ( pxQueue )->uxQueueNumber, 0U )
+#define traceBLOCKING_ON_QUEUE_SEND( pxQueue ) \
+    trace_record( TRACE_EVENT_QUEUE_BLOCK_SEND, ( uint8_t ) ( pxQueue )->uxQueueNumber, 0U )
+#define traceBLOCKING_ON_QUEUE_RECEIVE( pxQueue ) \
+    trace_record( TRACE_EVENT_QUEUE_BLOCK_RECEIVE, ( uint8_t ) ( pxQueue )->uxQueueNumber, 0U )
+#define traceQUEUE_SEND_FROM_ISR( pxQueue ) \
+    trace_record( TRACE_EVENT_QUEUE_SEND_FROM_ISR, ( uint8_t ) ( pxQueue )->uxQueueNumber, 0U )
+#define traceQUEUE_RECEIVE_FROM_ISR( pxQueue ) \
+    trace_record( TRACE_EVENT_QUEUE_RECEIVE_FROM_ISR, ( uint8_t ) ( pxQueue )->uxQueueNumber, 0U )
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TRACE_RECORDER_H */
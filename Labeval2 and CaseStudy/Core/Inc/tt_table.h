@@ -0,0 +1,29 @@
+/**
+  ******************************************************************************
+  * @file           : tt_table.h
+  * @brief          : Time triggered schedule, generated from Core/taskset.json.
+  *
+  * Generated by tools/taskset_tt.py from the tasks of the table marked
+  * time_triggered; change the table and generate again instead of
+  * editing this file.
+  *
+  * 1 slots in a major frame of 100000 us, 0.5% of it dispatched.
+  ******************************************************************************
+  */
+
+#ifndef __TT_TABLE_H
+#define __TT_TABLE_H
+
+/* Times in microseconds */
+#define TT_MAJOR_FRAME_US               100000
+
+/* Index of each task in the array of task handles */
+#define TT_ADC_TASK                     0
+#define TT_TASKS                        1
+
+/* The slots of one major frame, ordered by offset */
+#define TT_TABLE_ENTRIES                1
+#define TT_TABLE \
+    TT_SLOT(0, TT_ADC_TASK, 500), \
+
+#endif /* __TT_TABLE_H */
@@ -0,0 +1,140 @@
+/**
+  ******************************************************************************
+  * @file           : adc_scan.c
+  * @brief          : Timer paced multi-channel ADC acquisition by circular DMA.
+  *
+  * The processor only takes the DMA half and full transfer interrupts, two
+  * per buffer, whatever the number of channels and sequences in it.  Each
+  * interrupt notifies the consumer with the number of halves completed so
+  * far.  A half counts as overrun when the DMA starts writing it again while
+  * the consumer still holds it or has not yet taken it.
+  *
+  * The sample times are not read in the interrupt, whose latency varies,
+  * but follow from the timer: the time base is read just before the timer
+  * is started, and the timer and TIM5 both count microseconds of the same
+  * APB1 clock, so the nth sequence is triggered n + 1 periods later.
+  ******************************************************************************
+  */
+
+#include "main.h"
+#include "adc_scan.h"
+#include "timebase.h"
+
+#define ADC_SCAN_NO_HALF    2U
+
+static ADC_HandleTypeDef* scan_adc;
+static TIM_HandleTypeDef* scan_tim;
+static uint16_t* scan_buffer;
+static uint32_t scans_per_block;
+static uint32_t block_samples;
+static uint32_t scan_period_us;
+static uint64_t scan_start_us;
+static TaskHandle_t consumer;
+
+/* The half the consumer is working on, or ADC_SCAN_NO_HALF */
+static volatile uint32_t held_half = ADC_SCAN_NO_HALF;
+static adc_scan_stats_t scan_stats;
+
+HAL_StatusTypeDef adc_scan_start(ADC_HandleTypeDef* hadc, TIM_HandleTypeDef* htim,
+                                 uint16_t* buffer, uint32_t scans_per_half)
+{
+    HAL_StatusTypeDef status;
+
+    scan_adc = hadc;
+    scan_tim = htim;
+    scan_buffer = buffer;
+    scans_per_block = scans_per_half;
+    block_samples = scans_per_half * hadc->Init.NbrOfConversion;
+    scan_period_us = __HAL_TIM_GET_AUTORELOAD(htim) + 1U;
+    consumer = xTaskGetCurrentTaskHandle();
+    held_half = ADC_SCAN_NO_HALF;
+
+    taskENTER_CRITICAL();
+    scan_stats.halves = 0;
+    scan_stats.overruns = 0;
+    taskEXIT_CRITICAL();
+
+    /* A notification left from before would hand over a half never filled */
+    xTaskNotifyStateClear(NULL);
+
+    /* The ADC waits for the first trigger.  The DMA moves half-words, so
+     * the length is in samples. */
+    status = HAL_ADC_Start_DMA(hadc, (uint32_t*)buffer, 2U * block_samples);
+    if (status != HAL_OK)
+    {
+        return status;
+    }
+
+    /* Nothing may come between reading the time and starting the timer */
+    taskENTER_CRITICAL();
+    scan_start_us = timebase_get_us();
+    status = HAL_TIM_Base_Start(htim);
+    taskEXIT_CRITICAL();
+
+    if (status != HAL_OK)
+    {
+        HAL_ADC_Stop_DMA(hadc);
+    }
+    return status;
+}
+
+void adc_scan_stop(void)
+{
+    HAL_TIM_Base_Stop(scan_tim);
+    HAL_ADC_Stop_DMA(scan_adc);
+    held_half = ADC_SCAN_NO_HALF;
+}
+
+BaseType_t adc_scan_wait(adc_scan_block_t* block, TickType_t timeout)
+{
+    uint32_t halves;
+    uint32_t sequence;
+
+    held_half = ADC_SCAN_NO_HALF;
+    if (xTaskNotifyWait(0, 0, &halves, timeout) != pdTRUE)
+    {
+        return pdFAIL;
+    }
+
+    /* The DMA starts with the first half and alternates */
+    held_half = (halves - 1U) & 1U;
+
+    sequence = (halves - 1U) * scans_per_block;
+    block->samples = &scan_buffer[held_half * block_samples];
+    block->timestamp_us = scan_start_us + ((uint64_t)sequence + 1U) * scan_period_us;
+    block->period_us = scan_period_us;
+    block->sequence = sequence;
+
+    return pdPASS;
+}
+
+void adc_scan_get_stats(adc_scan_stats_t* stats)
+{
+    taskENTER_CRITICAL();
+    *stats = scan_stats;
+    taskEXIT_CRITICAL();
+}
+
+void adc_scan_half_complete_from_isr(uint32_t half, BaseType_t* higher_priority_task_woken)
+{
+    UBaseType_t saved = taskENTER_CRITICAL_FROM_ISR();
+
+    scan_stats.halves++;
+
+    /* The DMA has gone on to the other half */
+    if (held_half == (half ^ 1U))
+    {
+        scan_stats.overruns++;
+    }
+
+    /* A notification still pending names the other half as well */
+    if (xTaskNotifyFromISR(consumer, scan_stats.halves, eSetValueWithoutOverwrite,
+                           higher_priority_task_woken) != pdPASS)
+    {
+        scan_stats.overruns++;
+        xTaskNotifyFromISR(consumer, scan_stats.halves, eSetValueWithOverwrite,
+                           higher_priority_task_woken);
+    }
+
+    taskEXIT_CRITICAL_FROM_ISR(saved);
+}
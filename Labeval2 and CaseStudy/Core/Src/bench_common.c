@@ -0,0 +1,58 @@
+/**
+  ******************************************************************************
+  * @file           : bench_common.c
+  * @brief          : Timing and reporting shared by the benchmarks.
+  ******************************************************************************
+  */
+
+#include "stdio.h"
+#include "stdlib.h"
+#include "bench_common.h"
+
+void uart_print(const char* str);
+
+#if defined(KERNEL_BENCHMARK_HOST) || defined(DSP_BENCHMARK_HOST)
+
+void bench_timer_init(void)
+{
+}
+
+#else
+
+void bench_timer_init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+#endif
+
+static int compare_samples(const void* a, const void* b)
+{
+    uint32_t left = *(const uint32_t*) a;
+    uint32_t right = *(const uint32_t*) b;
+
+    return (left > right) - (left < right);
+}
+
+/**
+  * @brief  Sorts the samples of a case and prints its result line
+  * @param  name: Case name
+  * @param  parameter: What the case is measured by, such as a size or a count
+  * @param  unit: Unit of the samples
+  * @param  samples: BENCH_ITERATIONS samples, sorted in place
+  * @retval None
+  */
+void bench_report(const char* name, uint32_t parameter, const char* unit, uint32_t* samples)
+{
+    char uart_buffer[96];
+
+    qsort(samples, BENCH_ITERATIONS, sizeof(samples[0]), compare_samples);
+
+    snprintf(uart_buffer, sizeof(uart_buffer), "bench,%s,%lu,%s,%u,%lu,%lu,%lu,%lu\r\n",
+             name, (unsigned long) parameter, unit, (unsigned) BENCH_ITERATIONS,
+             (unsigned long) samples[0], (unsigned long) samples[BENCH_ITERATIONS / 2],
+             (unsigned long) samples[BENCH_P99_INDEX], (unsigned long) samples[BENCH_ITERATIONS - 1]);
+    uart_print(uart_buffer);
+}
@@ -0,0 +1,378 @@
+/**
+  ******************************************************************************
+  * @file           : dsp_bench.c
+  * @brief          : Filter check and benchmark suite.
+  *
+  * The check runs the SIMD and the C version of a filter side by side, each
+  * with its own state, over CHECK_SAMPLES random samples in blocks of
+  * changing size from 1 to DSP_BENCH_BLOCK.  The coefficients are random
+  * over the whole Q15 range, so the sums saturate often and both ends of
+  * the range are reached.
+  *
+  * Every filter is then timed BENCH_ITERATIONS times on a block of
+  * DSP_BENCH_BLOCK samples, the size of a half of the ADC scan buffer, and
+  * reported as the minimum, median, 99th percentile and maximum of the time
+  * per sample:
+  *   - fir_q15, fir_q15_c: by number of taps,
+  *   - fir_q31: by number of taps,
+  *   - biquad_q15, biquad_q15_c: by number of sections,
+  *   - biquad_q31: by number of sections,
+  *   - moving_average_q15: by length,
+  *   - cic: by order, decimating 12-bit samples by 2^CIC_LOG2_RATIO.
+  * Without DSP_FILTER_SIMD, as in the host build of the application, the
+  * _c cases measure the same code as the others.
+  ******************************************************************************
+  */
+
+#include "stdio.h"
+#include "string.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "dsp_filter.h"
+#include "bench_common.h"
+#include "dsp_bench.h"
+
+#ifdef DSP_BENCHMARK
+
+#define BENCH_PRIORITY         (tskIDLE_PRIORITY + 3)
+#define BENCH_STACK_SIZE       384
+#define DSP_BENCH_BLOCK        32
+#define CHECK_SAMPLES          4096
+#define MAX_TAPS               32
+#define MAX_SECTIONS           2
+#define BENCH_POST_SHIFT       1
+#define MOVING_AVERAGE_LOG2    5
+#define CIC_LOG2_RATIO         5
+#define CIC_INPUT_BITS         12
+#define CIC_OUTPUT_BITS        14
+#define BENCH_SEED             0x2545F491UL
+
+void uart_print(const char* str);
+
+#define SAMPLE_UNIT            BENCH_UNIT "/sample"
+
+#ifdef DSP_BENCHMARK_HOST
+void Error_Handler(void);
+#endif
+
+typedef void (*fir_q15_function_t)(dsp_fir_q15_t* filter, const q15_t* in, q15_t* out, uint32_t count);
+typedef void (*biquad_q15_function_t)(dsp_biquad_q15_t* filter, const q15_t* in, q15_t* out, uint32_t count);
+
+static uint32_t samples[BENCH_ITERATIONS];
+
+static const uint32_t check_taps[] = { 7, 8, 31, MAX_TAPS };
+static const uint32_t bench_taps[] = { 8, MAX_TAPS };
+static const uint32_t bench_sections[] = { 1, MAX_SECTIONS };
+
+static q15_t coeffs_q15[MAX_TAPS];
+static q31_t coeffs_q31[MAX_TAPS];
+static q15_t state_q15[2][DSP_FIR_STATE_SIZE(MAX_TAPS, DSP_BENCH_BLOCK)];
+static q31_t state_q31[DSP_FIR_STATE_SIZE(MAX_TAPS, DSP_BENCH_BLOCK)];
+static q15_t in_q15[DSP_BENCH_BLOCK];
+static q15_t out_q15[2][DSP_BENCH_BLOCK];
+static q31_t in_q31[DSP_BENCH_BLOCK];
+static q31_t out_q31[DSP_BENCH_BLOCK];
+static uint16_t in_u16[DSP_BENCH_BLOCK];
+static uint32_t out_u32[DSP_BENCH_BLOCK];
+
+static uint32_t random_state;
+
+/* xorshift32, so every run filters the same signals */
+static uint32_t random_next(void)
+{
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+static void random_q15(q15_t* values, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        values[i] = (q15_t) (random_next() >> 16);
+    }
+}
+
+/* The parameter is the number of taps or sections, or the length */
+static void report(const char* name, uint32_t parameter)
+{
+    bench_report(name, parameter, SAMPLE_UNIT, samples);
+}
+
+/* The time of one block, rounded to the time per sample */
+static inline uint32_t per_sample(uint32_t start)
+{
+    return (bench_timestamp() - start + DSP_BENCH_BLOCK / 2) / DSP_BENCH_BLOCK;
+}
+
+static void report_check(const char* name, uint32_t parameter, uint32_t mismatches)
+{
+    char uart_buffer[64];
+
+    snprintf(uart_buffer, sizeof(uart_buffer), "check,%s,%lu,%u,%lu\r\n", name,
+             (unsigned long) parameter, (unsigned) CHECK_SAMPLES, (unsigned long) mismatches);
+    uart_print(uart_buffer);
+
+    if (mismatches != 0)
+    {
+        Error_Handler();
+    }
+}
+
+/* Counts the samples where the two outputs differ */
+static uint32_t count_mismatches(uint32_t count)
+{
+    uint32_t mismatches = 0;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        mismatches += (out_q15[0][i] != out_q15[1][i]);
+    }
+    return mismatches;
+}
+
+static void check_fir_q15(void)
+{
+    dsp_fir_q15_t simd;
+    dsp_fir_q15_t portable;
+
+    for (size_t i = 0; i < sizeof(check_taps) / sizeof(check_taps[0]); i++)
+    {
+        uint32_t taps = check_taps[i];
+        uint32_t mismatches = 0;
+        uint32_t block = 1;
+
+        random_state = BENCH_SEED + taps;
+        random_q15(coeffs_q15, taps);
+        dsp_fir_q15_init(&simd, taps, coeffs_q15, state_q15[0], DSP_BENCH_BLOCK);
+        dsp_fir_q15_init(&portable, taps, coeffs_q15, state_q15[1], DSP_BENCH_BLOCK);
+
+        for (uint32_t done = 0; done < CHECK_SAMPLES; done += block)
+        {
+            block = (done % DSP_BENCH_BLOCK) + 1;
+            if (block > CHECK_SAMPLES - done)
+            {
+                block = CHECK_SAMPLES - done;
+            }
+
+            random_q15(in_q15, block);
+            dsp_fir_q15(&simd, in_q15, out_q15[0], block);
+            dsp_fir_q15_c(&portable, in_q15, out_q15[1], block);
+            mismatches += count_mismatches(block);
+        }
+        report_check("fir_q15", taps, mismatches);
+    }
+}
+
+static void check_biquad_q15(void)
+{
+    dsp_biquad_q15_t simd;
+    dsp_biquad_q15_t portable;
+
+    for (uint32_t sections = 1; sections <= MAX_SECTIONS; sections++)
+    {
+        uint32_t mismatches = 0;
+        uint32_t block = 1;
+
+        random_state = BENCH_SEED + sections;
+        random_q15(coeffs_q15, DSP_BIQUAD_Q15_COEFFS_SIZE(sections));
+        for (uint32_t section = 0; section < sections; section++)
+        {
+            coeffs_q15[6 * section + 1] = 0;
+        }
+        dsp_biquad_q15_init(&simd, sections, coeffs_q15, state_q15[0], BENCH_POST_SHIFT);
+        dsp_biquad_q15_init(&portable, sections, coeffs_q15, state_q15[1], BENCH_POST_SHIFT);
+
+        for (uint32_t done = 0; done < CHECK_SAMPLES; done += block)
+        {
+            block = (done % DSP_BENCH_BLOCK) + 1;
+            if (block > CHECK_SAMPLES - done)
+            {
+                block = CHECK_SAMPLES - done;
+            }
+
+            random_q15(in_q15, block);
+            dsp_biquad_q15(&simd, in_q15, out_q15[0], block);
+            dsp_biquad_q15_c(&portable, in_q15, out_q15[1], block);
+            mismatches += count_mismatches(block);
+        }
+        report_check("biquad_q15", sections, mismatches);
+    }
+}
+
+static void bench_fir_q15(const char* name, fir_q15_function_t function)
+{
+    dsp_fir_q15_t filter;
+
+    for (size_t i = 0; i < sizeof(bench_taps) / sizeof(bench_taps[0]); i++)
+    {
+        random_state = BENCH_SEED;
+        random_q15(coeffs_q15, bench_taps[i]);
+        random_q15(in_q15, DSP_BENCH_BLOCK);
+        dsp_fir_q15_init(&filter, bench_taps[i], coeffs_q15, state_q15[0], DSP_BENCH_BLOCK);
+
+        for (uint32_t n = 0; n < BENCH_ITERATIONS; n++)
+        {
+            uint32_t start = bench_timestamp();
+            function(&filter, in_q15, out_q15[0], DSP_BENCH_BLOCK);
+            samples[n] = per_sample(start);
+        }
+        report(name, bench_taps[i]);
+    }
+}
+
+static void bench_fir_q31(void)
+{
+    dsp_fir_q31_t filter;
+
+    for (size_t i = 0; i < sizeof(bench_taps) / sizeof(bench_taps[0]); i++)
+    {
+        random_state = BENCH_SEED;
+        for (uint32_t k = 0; k < bench_taps[i]; k++)
+        {
+            coeffs_q31[k] = (q31_t) random_next();
+        }
+        for (uint32_t k = 0; k < DSP_BENCH_BLOCK; k++)
+        {
+            in_q31[k] = (q31_t) random_next();
+        }
+        dsp_fir_q31_init(&filter, bench_taps[i], coeffs_q31, state_q31, DSP_BENCH_BLOCK);
+
+        for (uint32_t n = 0; n < BENCH_ITERATIONS; n++)
+        {
+            uint32_t start = bench_timestamp();
+            dsp_fir_q31(&filter, in_q31, out_q31, DSP_BENCH_BLOCK);
+            samples[n] = per_sample(start);
+        }
+        report("fir_q31", bench_taps[i]);
+    }
+}
+
+static void bench_biquad_q15(const char* name, biquad_q15_function_t function)
+{
+    dsp_biquad_q15_t filter;
+
+    for (size_t i = 0; i < sizeof(bench_sections) / sizeof(bench_sections[0]); i++)
+    {
+        random_state = BENCH_SEED;
+        random_q15(coeffs_q15, DSP_BIQUAD_Q15_COEFFS_SIZE(bench_sections[i]));
+        random_q15(in_q15, DSP_BENCH_BLOCK);
+        dsp_biquad_q15_init(&filter, bench_sections[i], coeffs_q15, state_q15[0], BENCH_POST_SHIFT);
+
+        for (uint32_t n = 0; n < BENCH_ITERATIONS; n++)
+        {
+            uint32_t start = bench_timestamp();
+            function(&filter, in_q15, out_q15[0], DSP_BENCH_BLOCK);
+            samples[n] = per_sample(start);
+        }
+        report(name, bench_sections[i]);
+    }
+}
+
+static void bench_biquad_q31(void)
+{
+    dsp_biquad_q31_t filter;
+
+    for (size_t i = 0; i < sizeof(bench_sections) / sizeof(bench_sections[0]); i++)
+    {
+        random_state = BENCH_SEED;
+        for (uint32_t k = 0; k < DSP_BIQUAD_Q31_COEFFS_SIZE(bench_sections[i]); k++)
+        {
+            coeffs_q31[k] = (q31_t) random_next();
+        }
+        for (uint32_t k = 0; k < DSP_BENCH_BLOCK; k++)
+        {
+            in_q31[k] = (q31_t) random_next();
+        }
+        dsp_biquad_q31_init(&filter, bench_sections[i], coeffs_q31, state_q31, BENCH_POST_SHIFT);
+
+        for (uint32_t n = 0; n < BENCH_ITERATIONS; n++)
+        {
+            uint32_t start = bench_timestamp();
+            dsp_biquad_q31(&filter, in_q31, out_q31, DSP_BENCH_BLOCK);
+            samples[n] = per_sample(start);
+        }
+        report("biquad_q31", bench_sections[i]);
+    }
+}
+
+static void bench_moving_average(void)
+{
+    dsp_moving_average_q15_t filter;
+
+    random_state = BENCH_SEED;
+    random_q15(in_q15, DSP_BENCH_BLOCK);
+    dsp_moving_average_q15_init(&filter, MOVING_AVERAGE_LOG2, state_q15[0]);
+
+    for (uint32_t n = 0; n < BENCH_ITERATIONS; n++)
+    {
+        uint32_t start = bench_timestamp();
+        dsp_moving_average_q15(&filter, in_q15, out_q15[0], DSP_BENCH_BLOCK);
+        samples[n] = per_sample(start);
+    }
+    report("moving_average_q15", 1UL << MOVING_AVERAGE_LOG2);
+}
+
+static void bench_cic(void)
+{
+    dsp_cic_t cic;
+
+    random_state = BENCH_SEED;
+    for (uint32_t k = 0; k < DSP_BENCH_BLOCK; k++)
+    {
+        in_u16[k] = (uint16_t) (random_next() >> (32 - CIC_INPUT_BITS));
+    }
+
+    for (uint32_t order = 1; order <= DSP_CIC_MAX_ORDER; order++)
+    {
+        if (dsp_cic_init(&cic, order, CIC_LOG2_RATIO, CIC_INPUT_BITS, CIC_OUTPUT_BITS) != 0)
+        {
+            Error_Handler();
+        }
+
+        for (uint32_t n = 0; n < BENCH_ITERATIONS; n++)
+        {
+            uint32_t start = bench_timestamp();
+            dsp_cic_decimate(&cic, in_u16, 1, DSP_BENCH_BLOCK, out_u32);
+            samples[n] = per_sample(start);
+        }
+        report("cic", order);
+    }
+}
+
+static void bench_task(void* parameters)
+{
+    (void) parameters;
+
+    bench_timer_init();
+
+    check_fir_q15();
+    check_biquad_q15();
+
+    uart_print("bench,case,parameter,unit,samples,min,median,p99,max\r\n");
+
+    bench_fir_q15("fir_q15", dsp_fir_q15);
+    bench_fir_q15("fir_q15_c", dsp_fir_q15_c);
+    bench_fir_q31();
+    bench_biquad_q15("biquad_q15", dsp_biquad_q15);
+    bench_biquad_q15("biquad_q15_c", dsp_biquad_q15_c);
+    bench_biquad_q31();
+    bench_moving_average();
+    bench_cic();
+
+#ifdef DSP_BENCHMARK_HOST
+    vTaskEndScheduler();
+#endif
+    vTaskSuspend(NULL);
+}
+
+void dsp_bench_start(void)
+{
+    if (xTaskCreate(bench_task, "DspBench", BENCH_STACK_SIZE, NULL, BENCH_PRIORITY, NULL) != pdPASS)
+    {
+        Error_Handler();
+    }
+}
+
+#endif /* DSP_BENCHMARK */
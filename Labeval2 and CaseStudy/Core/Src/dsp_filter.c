@@ -0,0 +1,441 @@
+/**
+  ******************************************************************************
+  * @file           : dsp_filter.c
+  * @brief          : Fixed-point streaming filters for blocks of ADC samples.
+  *
+  * The FIR filters copy each block behind the last taps - 1 samples of the
+  * previous one in their state, so every output is one pass over contiguous
+  * samples, and move those taps - 1 samples to the front afterwards.  The
+  * IIR sections keep their delayed samples in registers through a block.
+  * The CIC decimator runs its combs only once per output.
+  *
+  * The SIMD versions pair the Q15 operands in 32-bit words.  The FIR filter
+  * computes two outputs per pass, sharing each pair of coefficients, and
+  * the biquad packs x[n-1], x[n-2] and y[n-1], y[n-2] with PKHBT.  They sum
+  * the same products in 64 bits as the C versions, so the results match.
+  ******************************************************************************
+  */
+
+#include "string.h"
+#include "dsp_filter.h"
+
+#if ( DSP_FILTER_SIMD == 1 )
+/* The CMSIS intrinsics of the core */
+#include "stm32f4xx.h"
+#endif
+
+static inline q15_t saturate_q15(int64_t value)
+{
+    if (value > INT16_MAX)
+    {
+        return INT16_MAX;
+    }
+    if (value < INT16_MIN)
+    {
+        return INT16_MIN;
+    }
+    return (q15_t)value;
+}
+
+static inline q31_t saturate_q31(int64_t value)
+{
+    if (value > INT32_MAX)
+    {
+        return INT32_MAX;
+    }
+    if (value < INT32_MIN)
+    {
+        return INT32_MIN;
+    }
+    return (q31_t)value;
+}
+
+#if ( DSP_FILTER_SIMD == 1 )
+/* Two Q15 values, the first in the low half; unaligned loads are allowed */
+static inline uint32_t read_q15x2(const q15_t* p)
+{
+    uint32_t value;
+
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline void write_q15x2(q15_t* p, uint32_t value)
+{
+    memcpy(p, &value, sizeof(value));
+}
+#endif
+
+void dsp_fir_q15_init(dsp_fir_q15_t* filter, uint32_t taps, const q15_t* coeffs,
+                      q15_t* state, uint32_t max_block)
+{
+    filter->taps = taps;
+    filter->max_block = max_block;
+    filter->coeffs = coeffs;
+    filter->state = state;
+    memset(state, 0, DSP_FIR_STATE_SIZE(taps, max_block) * sizeof(q15_t));
+}
+
+void dsp_fir_q15_c(dsp_fir_q15_t* filter, const q15_t* in, q15_t* out, uint32_t count)
+{
+    const uint32_t taps = filter->taps;
+    const q15_t* coeffs = filter->coeffs;
+    q15_t* state = filter->state;
+
+    memcpy(&state[taps - 1U], in, count * sizeof(q15_t));
+
+    for (uint32_t n = 0; n < count; n++)
+    {
+        const q15_t* x = &state[n];
+        int64_t acc = 0;
+
+        for (uint32_t k = 0; k < taps; k++)
+        {
+            acc += (int32_t)coeffs[k] * x[k];
+        }
+        out[n] = saturate_q15(acc >> 15);
+    }
+
+    memmove(state, &state[count], (taps - 1U) * sizeof(q15_t));
+}
+
+#if ( DSP_FILTER_SIMD == 1 )
+void dsp_fir_q15(dsp_fir_q15_t* filter, const q15_t* in, q15_t* out, uint32_t count)
+{
+    const uint32_t taps = filter->taps;
+    const q15_t* coeffs = filter->coeffs;
+    q15_t* state = filter->state;
+    uint32_t n;
+    uint32_t k;
+
+    memcpy(&state[taps - 1U], in, count * sizeof(q15_t));
+
+    for (n = 0; n + 1U < count; n += 2U)
+    {
+        const q15_t* x = &state[n];
+        uint64_t acc0 = 0;
+        uint64_t acc1 = 0;
+
+        for (k = 0; k + 1U < taps; k += 2U)
+        {
+            uint32_t pair = read_q15x2(&coeffs[k]);
+
+            acc0 = __SMLALD(read_q15x2(&x[k]), pair, acc0);
+            acc1 = __SMLALD(read_q15x2(&x[k + 1U]), pair, acc1);
+        }
+        if (k < taps)
+        {
+            acc0 += (uint64_t)(int64_t)((int32_t)coeffs[k] * x[k]);
+            acc1 += (uint64_t)(int64_t)((int32_t)coeffs[k] * x[k + 1U]);
+        }
+
+        out[n] = (q15_t)__SSAT((int32_t)((int64_t)acc0 >> 15), 16);
+        out[n + 1U] = (q15_t)__SSAT((int32_t)((int64_t)acc1 >> 15), 16);
+    }
+
+    if (n < count)
+    {
+        const q15_t* x = &state[n];
+        uint64_t acc = 0;
+
+        for (k = 0; k + 1U < taps; k += 2U)
+        {
+            acc = __SMLALD(read_q15x2(&x[k]), read_q15x2(&coeffs[k]), acc);
+        }
+        if (k < taps)
+        {
+            acc += (uint64_t)(int64_t)((int32_t)coeffs[k] * x[k]);
+        }
+        out[n] = (q15_t)__SSAT((int32_t)((int64_t)acc >> 15), 16);
+    }
+
+    memmove(state, &state[count], (taps - 1U) * sizeof(q15_t));
+}
+#else
+void dsp_fir_q15(dsp_fir_q15_t* filter, const q15_t* in, q15_t* out, uint32_t count)
+{
+    dsp_fir_q15_c(filter, in, out, count);
+}
+#endif
+
+void dsp_fir_q31_init(dsp_fir_q31_t* filter, uint32_t taps, const q31_t* coeffs,
+                      q31_t* state, uint32_t max_block)
+{
+    filter->taps = taps;
+    filter->max_block = max_block;
+    filter->coeffs = coeffs;
+    filter->state = state;
+    memset(state, 0, DSP_FIR_STATE_SIZE(taps, max_block) * sizeof(q31_t));
+}
+
+/* The M4 has no 32-bit SIMD multiply; the compiler makes each product and
+ * sum one SMLAL */
+void dsp_fir_q31(dsp_fir_q31_t* filter, const q31_t* in, q31_t* out, uint32_t count)
+{
+    const uint32_t taps = filter->taps;
+    const q31_t* coeffs = filter->coeffs;
+    q31_t* state = filter->state;
+
+    memcpy(&state[taps - 1U], in, count * sizeof(q31_t));
+
+    for (uint32_t n = 0; n < count; n++)
+    {
+        const q31_t* x = &state[n];
+        int64_t acc = 0;
+
+        for (uint32_t k = 0; k < taps; k++)
+        {
+            acc += (int64_t)coeffs[k] * x[k];
+        }
+        out[n] = saturate_q31(acc >> 31);
+    }
+
+    memmove(state, &state[count], (taps - 1U) * sizeof(q31_t));
+}
+
+void dsp_biquad_q15_init(dsp_biquad_q15_t* filter, uint32_t sections, const q15_t* coeffs,
+                         q15_t* state, uint32_t post_shift)
+{
+    filter->sections = sections;
+    filter->post_shift = post_shift;
+    filter->coeffs = coeffs;
+    filter->state = state;
+    memset(state, 0, DSP_BIQUAD_STATE_SIZE(sections) * sizeof(q15_t));
+}
+
+void dsp_biquad_q15_c(dsp_biquad_q15_t* filter, const q15_t* in, q15_t* out, uint32_t count)
+{
+    const uint32_t shift = 15U - filter->post_shift;
+    const q15_t* coeffs = filter->coeffs;
+    q15_t* state = filter->state;
+    const q15_t* src = in;
+
+    for (uint32_t section = 0; section < filter->sections; section++)
+    {
+        int32_t x1 = state[0];
+        int32_t x2 = state[1];
+        int32_t y1 = state[2];
+        int32_t y2 = state[3];
+
+        for (uint32_t n = 0; n < count; n++)
+        {
+            int32_t x = src[n];
+            int64_t acc = (int64_t)coeffs[0] * x + (int64_t)coeffs[2] * x1 + (int64_t)coeffs[3] * x2 +
+                          (int64_t)coeffs[4] * y1 + (int64_t)coeffs[5] * y2;
+            int32_t y = saturate_q15(acc >> shift);
+
+            x2 = x1;
+            x1 = x;
+            y2 = y1;
+            y1 = y;
+            out[n] = (q15_t)y;
+        }
+
+        state[0] = (q15_t)x1;
+        state[1] = (q15_t)x2;
+        state[2] = (q15_t)y1;
+        state[3] = (q15_t)y2;
+
+        /* Each section after the first filters the output in place */
+        src = out;
+        coeffs += 6;
+        state += 4;
+    }
+}
+
+#if ( DSP_FILTER_SIMD == 1 )
+void dsp_biquad_q15(dsp_biquad_q15_t* filter, const q15_t* in, q15_t* out, uint32_t count)
+{
+    const uint32_t shift = 15U - filter->post_shift;
+    const q15_t* coeffs = filter->coeffs;
+    q15_t* state = filter->state;
+    const q15_t* src = in;
+
+    for (uint32_t section = 0; section < filter->sections; section++)
+    {
+        const int32_t b0 = coeffs[0];
+        const uint32_t b1b2 = read_q15x2(&coeffs[2]);
+        const uint32_t a1a2 = read_q15x2(&coeffs[4]);
+        uint32_t x1x2 = read_q15x2(&state[0]);
+        uint32_t y1y2 = read_q15x2(&state[2]);
+
+        for (uint32_t n = 0; n < count; n++)
+        {
+            int32_t x = src[n];
+            uint64_t acc = (uint64_t)(int64_t)(b0 * x);
+            int32_t y;
+
+            acc = __SMLALD(b1b2, x1x2, acc);
+            acc = __SMLALD(a1a2, y1y2, acc);
+            y = __SSAT((int32_t)((int64_t)acc >> shift), 16);
+
+            /* The new sample into the low half, the previous into the high */
+            x1x2 = __PKHBT((uint32_t)x, x1x2, 16);
+            y1y2 = __PKHBT((uint32_t)y, y1y2, 16);
+            out[n] = (q15_t)y;
+        }
+
+        write_q15x2(&state[0], x1x2);
+        write_q15x2(&state[2], y1y2);
+
+        src = out;
+        coeffs += 6;
+        state += 4;
+    }
+}
+#else
+void dsp_biquad_q15(dsp_biquad_q15_t* filter, const q15_t* in, q15_t* out, uint32_t count)
+{
+    dsp_biquad_q15_c(filter, in, out, count);
+}
+#endif
+
+void dsp_biquad_q31_init(dsp_biquad_q31_t* filter, uint32_t sections, const q31_t* coeffs,
+                         q31_t* state, uint32_t post_shift)
+{
+    filter->sections = sections;
+    filter->post_shift = post_shift;
+    filter->coeffs = coeffs;
+    filter->state = state;
+    memset(state, 0, DSP_BIQUAD_STATE_SIZE(sections) * sizeof(q31_t));
+}
+
+void dsp_biquad_q31(dsp_biquad_q31_t* filter, const q31_t* in, q31_t* out, uint32_t count)
+{
+    const uint32_t shift = 31U - filter->post_shift;
+    const q31_t* coeffs = filter->coeffs;
+    q31_t* state = filter->state;
+    const q31_t* src = in;
+
+    for (uint32_t section = 0; section < filter->sections; section++)
+    {
+        q31_t x1 = state[0];
+        q31_t x2 = state[1];
+        q31_t y1 = state[2];
+        q31_t y2 = state[3];
+
+        for (uint32_t n = 0; n < count; n++)
+        {
+            q31_t x = src[n];
+            int64_t acc = (int64_t)coeffs[0] * x + (int64_t)coeffs[1] * x1 + (int64_t)coeffs[2] * x2 +
+                          (int64_t)coeffs[3] * y1 + (int64_t)coeffs[4] * y2;
+            q31_t y = saturate_q31(acc >> shift);
+
+            x2 = x1;
+            x1 = x;
+            y2 = y1;
+            y1 = y;
+            out[n] = y;
+        }
+
+        state[0] = x1;
+        state[1] = x2;
+        state[2] = y1;
+        state[3] = y2;
+
+        src = out;
+        coeffs += 5;
+        state += 4;
+    }
+}
+
+void dsp_moving_average_q15_init(dsp_moving_average_q15_t* filter, uint32_t log2_length,
+                                 q15_t* history)
+{
+    filter->log2_length = log2_length;
+    filter->index = 0;
+    filter->sum = 0;
+    filter->history = history;
+    memset(history, 0, (1UL << log2_length) * sizeof(q15_t));
+}
+
+void dsp_moving_average_q15(dsp_moving_average_q15_t* filter, const q15_t* in, q15_t* out,
+                            uint32_t count)
+{
+    const uint32_t mask = (1UL << filter->log2_length) - 1U;
+    uint32_t index = filter->index;
+    int32_t sum = filter->sum;
+
+    for (uint32_t n = 0; n < count; n++)
+    {
+        q15_t x = in[n];
+
+        /* The sample leaving the window for the one entering it */
+        sum += x - filter->history[index];
+        filter->history[index] = x;
+        index = (index + 1U) & mask;
+
+        /* The mean of Q15 samples is a Q15 sample */
+        out[n] = (q15_t)(sum >> filter->log2_length);
+    }
+
+    filter->index = index;
+    filter->sum = sum;
+}
+
+int32_t dsp_cic_init(dsp_cic_t* cic, uint32_t order, uint32_t log2_ratio, uint32_t input_bits,
+                     uint32_t output_bits)
+{
+    const uint32_t width = input_bits + order * log2_ratio;
+
+    if (order == 0 || order > DSP_CIC_MAX_ORDER || width > 32U || output_bits > width)
+    {
+        return -1;
+    }
+
+    cic->order = order;
+    cic->log2_ratio = log2_ratio;
+    cic->shift = width - output_bits;
+    cic->phase = 0;
+    memset(cic->integrators, 0, sizeof(cic->integrators));
+    memset(cic->delays, 0, sizeof(cic->delays));
+    return 0;
+}
+
+static inline uint32_t cic_sample(dsp_cic_t* cic, uint32_t sample, uint32_t* out)
+{
+    const uint32_t order = cic->order;
+    uint32_t value = sample;
+
+    /* The sums overflow, but their differences over a period do not */
+    for (uint32_t stage = 0; stage < order; stage++)
+    {
+        cic->integrators[stage] += value;
+        value = cic->integrators[stage];
+    }
+
+    if (++cic->phase < (1UL << cic->log2_ratio))
+    {
+        return 0;
+    }
+    cic->phase = 0;
+
+    for (uint32_t stage = 0; stage < order; stage++)
+    {
+        uint32_t previous = cic->delays[stage];
+
+        cic->delays[stage] = value;
+        value -= previous;
+    }
+
+    /* The true sum, below 2^width, so the wrap around has cancelled */
+    *out = value >> cic->shift;
+    return 1;
+}
+
+uint32_t dsp_cic_update(dsp_cic_t* cic, uint32_t sample, uint32_t* out)
+{
+    return cic_sample(cic, sample, out);
+}
+
+uint32_t dsp_cic_decimate(dsp_cic_t* cic, const uint16_t* in, uint32_t stride, uint32_t count,
+                          uint32_t* out)
+{
+    uint32_t outputs = 0;
+
+    for (uint32_t n = 0; n < count; n++)
+    {
+        outputs += cic_sample(cic, in[n * stride], &out[outputs]);
+    }
+    return outputs;
+}
@@ -0,0 +1,108 @@
+/**
+  ******************************************************************************
+  * @file           : edf_bench.c
+  * @brief          : Context switch latency benchmark for the EDF scheduler.
+  *
+  * All tasks are created in the EDF band, the only priority scheduled by
+  * deadline, so the scheduler has to pick by deadline among all of them
+  * instead of taking turns as in a fixed priority band.  The benchmark task
+  * holds the earliest deadline and yields repeatedly; every yield goes
+  * through PendSV and vTaskSwitchContext and resumes the same task, so the
+  * measured time is the full switch path with N tasks in the Ready state
+  * (edf_switch).  That only times the pick of the head of the ready list, so
+  * the benchmark then suspends the filler with the latest deadline and times
+  * vTaskResume() of it (edf_ready_insert): the insert by deadline walks past
+  * the other N - 1 ready tasks, and the yield of the resume adds one switch
+  * path.  Each case and N is reported as a bench line of bench_common.h, in
+  * DWT cycles.
+  *
+  * FreeRTOSConfig.h takes the TCBs of this build from the heap and leaves
+  * the trace recorder out.  With a stack of FILLER_STACK_SIZE, about 600
+  * bytes of heap per filler, the 63 fillers of N = 64 fit in the heap with
+  * the benchmark, idle and timer tasks.
+  ******************************************************************************
+  */
+
+#include "main.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "bench_common.h"
+#include "edf_bench.h"
+
+/* The EDF band of configEDF_PRIORITY_BANDS */
+#define BENCH_PRIORITY       (tskIDLE_PRIORITY + 2)
+#define BENCH_STACK_SIZE     256
+#define FILLER_STACK_SIZE    64    /* Words, enough to suspend and be switched out */
+#define FILLER_DEADLINE      100000
+
+static const UBaseType_t ready_task_counts[] = { 3, 16, 64 };
+
+static uint32_t samples[BENCH_ITERATIONS];
+
+static void filler_task(void* parameters)
+{
+    (void) parameters;
+
+    /* Only runs once the benchmark has finished */
+    while (1)
+    {
+        vTaskSuspend(NULL);
+    }
+}
+
+static void bench_task(void* parameters)
+{
+    UBaseType_t ready_tasks = 1;  // The benchmark task itself
+    TaskHandle_t latest_filler = NULL;
+
+    (void) parameters;
+
+    bench_timer_init();
+
+    for (size_t i = 0; i < sizeof(ready_task_counts) / sizeof(ready_task_counts[0]); i++)
+    {
+        /* Top the ready list up with tasks that have later deadlines */
+        while (ready_tasks < ready_task_counts[i])
+        {
+            if (xTaskCreate(filler_task, "Filler", FILLER_STACK_SIZE, NULL, BENCH_PRIORITY, &latest_filler) != pdPASS)
+            {
+                Error_Handler();
+            }
+            vTaskSetDeadline(latest_filler, FILLER_DEADLINE + ready_tasks);
+            ready_tasks++;
+        }
+
+        for (uint32_t n = 0; n < BENCH_ITERATIONS; n++)
+        {
+            uint32_t start = bench_timestamp();
+            taskYIELD();
+            samples[n] = bench_timestamp() - start;
+        }
+
+        bench_report("edf_switch", ready_tasks, BENCH_UNIT, samples);
+
+        /* The resumed filler goes to the tail, so it never runs */
+        for (uint32_t n = 0; n < BENCH_ITERATIONS; n++)
+        {
+            vTaskSuspend(latest_filler);
+            uint32_t start = bench_timestamp();
+            vTaskResume(latest_filler);
+            samples[n] = bench_timestamp() - start;
+        }
+
+        bench_report("edf_ready_insert", ready_tasks, BENCH_UNIT, samples);
+    }
+
+    vTaskSuspend(NULL);
+}
+
+void edf_bench_start(void)
+{
+    TaskHandle_t bench_handle;
+
+    if (xTaskCreate(bench_task, "EDFBench", BENCH_STACK_SIZE, NULL, BENCH_PRIORITY, &bench_handle) != pdPASS)
+    {
+        Error_Handler();
+    }
+    vTaskSetDeadline(bench_handle, 0);
+}
@@ -0,0 +1,584 @@
+/**
+  ******************************************************************************
+  * @file           : kernel_bench.c
+  * @brief          : Kernel cost benchmark suite.
+  *
+  * Every case is measured BENCH_ITERATIONS times and reported as the minimum,
+  * median, 99th percentile and maximum, so that the tick and other interrupts
+  * land in the tail instead of in the typical cost:
+  *   - timer_overhead: two back to back reads of the counter,
+  *   - heap_malloc, heap_free: pvPortMalloc() and vPortFree() of the heap
+  *     in use, heap_4.c or heap_tlsf.c, by block size,
+  *   - pool_malloc, pool_free: pvPortPoolMalloc() and vPortPoolFree() of
+  *     pool.c by block size, each from its own class,
+  *   - replay_malloc, replay_free, replay_fragmentation: pvPortMalloc() and
+  *     vPortFree() while a fixed random sequence of allocations, numbered by
+  *     pattern, keeps the heap partly full, and the fragmentation of the free
+  *     space after each step in parts per thousand (the share of the free
+  *     bytes outside the largest free block), whose maximum is the peak,
+  *   - queue_send, queue_receive: by item size, with no task waiting,
+  *   - mutex_take, mutex_give: without contention,
+  *   - mutex_take_blocked: from a higher priority task blocking on a held
+  *     mutex until the holder runs again with the inherited priority,
+  *   - mutex_give_handoff: from the holder giving the mutex until the waiting
+  *     task returns from its take,
+  *   - notify_isr_latency: from xTaskNotifyFromISR() in an interrupt until
+  *     the notified task returns from its wait,
+  *   - switch_edf, switch_fp: a yield through the full switch path that
+  *     resumes the same task, with N tasks ready in the EDF band or in the
+  *     fixed priority bands.
+  * On the board the counter is the DWT cycle counter and the interrupt is
+  * EXTI0 pended in software.  On the host the counter is the monotonic clock
+  * in nanoseconds and the interrupt is simulated by the port.
+  ******************************************************************************
+  */
+
+#include "string.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "bench_common.h"
+#include "kernel_bench.h"
+
+#ifdef KERNEL_BENCHMARK
+
+/* The suite runs in the fixed priority band above the EDF band of the
+ * application and the helper tasks that it wakes run above it. */
+#define BENCH_PRIORITY         (tskIDLE_PRIORITY + 3)
+#define HELPER_PRIORITY        (tskIDLE_PRIORITY + 4)
+#define EDF_BAND_PRIORITY      (tskIDLE_PRIORITY + 2)
+#define FILLER_FP_PRIORITY     (tskIDLE_PRIORITY + 1)
+#define BENCH_STACK_SIZE       384
+#define HELPER_STACK_SIZE      configMINIMAL_STACK_SIZE
+#define FILLER_STACK_SIZE      configMINIMAL_STACK_SIZE
+#define MAX_QUEUE_ITEM_SIZE    256
+#define MAX_READY_TASKS        16
+#define REPLAY_LIVE_BLOCKS     32
+#define REPLAY_LARGE_BLOCKS    4
+#define REPLAY_WARMUP_STEPS    20000
+#define REPLAY_SEED            0x2545F491UL
+#define BENCH_DEADLINE         tskMS_TO_DEADLINE_TIME(10000)
+#define FILLER_DEADLINE        tskMS_TO_DEADLINE_TIME(20000)
+
+void uart_print(const char* str);
+
+static void bench_irq_handler(void);
+
+#ifdef KERNEL_BENCHMARK_HOST
+
+void Error_Handler(void);
+
+static void bench_irq_init(void)
+{
+}
+
+static void bench_irq_trigger(void)
+{
+    vPortGenerateSimulatedInterrupt(bench_irq_handler);
+}
+
+#else
+
+#define BENCH_IRQn             EXTI0_IRQn
+#define BENCH_IRQ_PRIORITY     6    /* May call the FromISR API, see configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY */
+
+static void bench_irq_init(void)
+{
+    HAL_NVIC_SetPriority(BENCH_IRQn, BENCH_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(BENCH_IRQn);
+}
+
+static void bench_irq_trigger(void)
+{
+    NVIC_SetPendingIRQ(BENCH_IRQn);
+    __DSB();
+    __ISB();
+}
+
+/* No EXTI line is configured, the interrupt is only ever pended by software */
+void EXTI0_IRQHandler(void)
+{
+    bench_irq_handler();
+}
+
+#endif /* KERNEL_BENCHMARK_HOST */
+
+/* An allocation pattern: small blocks of random sizes replaced in random
+ * order and, every large_every steps, the oldest of REPLAY_LARGE_BLOCKS
+ * buffers of large_size replaced */
+typedef struct
+{
+    size_t min_size;
+    size_t max_size;
+    size_t large_size;
+    uint32_t large_every;  // 0 for no large buffers
+} replay_pattern_t;
+
+static uint32_t samples[BENCH_ITERATIONS];
+
+/* An interval that ends in another task: mark is the start, result is set
+ * by whichever side takes the end timestamp. */
+static volatile uint32_t mark;
+static volatile uint32_t result;
+
+static TaskHandle_t notify_waiter_handle;
+
+static const size_t heap_block_sizes[] = { 16, 64, 256, 1024 };
+static const size_t pool_block_sizes[] = { 16, 64, 256 };
+static const replay_pattern_t replay_patterns[] = {
+    { 16, 128, 0, 0 },
+    { 16, 256, 1024, 16 },
+    { 32, 384, 1536, 8 },
+};
+static const UBaseType_t queue_item_sizes[] = { 4, 16, 64, MAX_QUEUE_ITEM_SIZE };
+static const UBaseType_t ready_task_counts[] = { 1, 4, MAX_READY_TASKS };
+
+static uint8_t queue_item[MAX_QUEUE_ITEM_SIZE];
+
+static void* replay_blocks[REPLAY_LIVE_BLOCKS + REPLAY_LARGE_BLOCKS];
+static uint32_t replay_state;
+
+/* The parameter is the block size, item size, number of ready tasks or
+ * pattern */
+static void report(const char* name, uint32_t parameter)
+{
+    bench_report(name, parameter, BENCH_UNIT, samples);
+}
+
+static void bench_timer_overhead(void)
+{
+    for (uint32_t n = 0; n < BENCH_ITERATIONS; n++)
+    {
+        uint32_t start = bench_timestamp();
+        samples[n] = bench_timestamp() - start;
+    }
+    report("timer_overhead", 0);
+}
+
+static void bench_heap(void)
+{
+    for (size_t i = 0; i < sizeof(heap_block_sizes) / sizeof(heap_block_sizes[0]); i++)
+    {
+        size_t size = heap_block_sizes[i];
+
+        for (uint32_t n = 0; n < BENCH_ITERATIONS; n++)
+        {
+            uint32_t start = bench_timestamp();
+            void* block = pvPortMalloc(size);
+            samples[n] = bench_timestamp() - start;
+
+            if (block == NULL)
+            {
+                Error_Handler();
+            }
+            vPortFree(block);
+        }
+        report("heap_malloc", size);
+
+        for (uint32_t n = 0; n < BENCH_ITERATIONS; n++)
+        {
+            void* block = pvPortMalloc(size);
+
+            if (block == NULL)
+            {
+                Error_Handler();
+            }
+
+            uint32_t start = bench_timestamp();
+            vPortFree(block);
+            samples[n] = bench_timestamp() - start;
+        }
+        report("heap_free", size);
+    }
+}
+
+static void bench_pool(void)
+{
+    for (size_t i = 0; i < sizeof(pool_block_sizes) / sizeof(pool_block_sizes[0]); i++)
+    {
+        size_t size = pool_block_sizes[i];
+
+        for (uint32_t n = 0; n < BENCH_ITERATIONS; n++)
+        {
+            uint32_t start = bench_timestamp();
+            void* block = pvPortPoolMalloc(size);
+            samples[n] = bench_timestamp() - start;
+
+            if (block == NULL)
+            {
+                Error_Handler();
+            }
+            vPortPoolFree(block);
+        }
+        report("pool_malloc", size);
+
+        for (uint32_t n = 0; n < BENCH_ITERATIONS; n++)
+        {
+            void* block = pvPortPoolMalloc(size);
+
+            if (block == NULL)
+            {
+                Error_Handler();
+            }
+
+            uint32_t start = bench_timestamp();
+            vPortPoolFree(block);
+            samples[n] = bench_timestamp() - start;
+        }
+        report("pool_free", size);
+    }
+}
+
+static uint32_t replay_random(void)
+{
+    /* xorshift32 */
+    replay_state ^= replay_state << 13;
+    replay_state ^= replay_state >> 17;
+    replay_state ^= replay_state << 5;
+    return replay_state;
+}
+
+/**
+  * @brief  Replaces one block of a replayed pattern
+  * @param  pattern: Allocation pattern
+  * @param  step: Step number, from 0
+  * @param  malloc_time: Set to the time of pvPortMalloc()
+  * @param  free_time: Set to the time of vPortFree()
+  * @retval None
+  */
+static void replay_step(const replay_pattern_t* pattern, uint32_t step, uint32_t* malloc_time, uint32_t* free_time)
+{
+    size_t slot;
+    size_t size;
+
+    if ((pattern->large_every != 0) && ((step % pattern->large_every) == 0))
+    {
+        slot = REPLAY_LIVE_BLOCKS + (step / pattern->large_every) % REPLAY_LARGE_BLOCKS;
+        size = pattern->large_size;
+    }
+    else
+    {
+        slot = replay_random() % REPLAY_LIVE_BLOCKS;
+        size = pattern->min_size + replay_random() % (pattern->max_size - pattern->min_size + 1);
+    }
+
+    uint32_t start = bench_timestamp();
+    vPortFree(replay_blocks[slot]);
+    *free_time = bench_timestamp() - start;
+
+    start = bench_timestamp();
+    replay_blocks[slot] = pvPortMalloc(size);
+    *malloc_time = bench_timestamp() - start;
+
+    if (replay_blocks[slot] == NULL)
+    {
+        Error_Handler();
+    }
+}
+
+static void bench_replay(void)
+{
+    static const char* const names[] = { "replay_malloc", "replay_free", "replay_fragmentation" };
+    HeapStats_t stats;
+    uint32_t times[2];
+
+    for (size_t i = 0; i < sizeof(replay_patterns) / sizeof(replay_patterns[0]); i++)
+    {
+        const replay_pattern_t* pattern = &replay_patterns[i];
+
+        /* The sequence is the same on every pass and with every heap, so each
+         * pass records one of the cases without a sample array of its own */
+        for (size_t measure = 0; measure < sizeof(names) / sizeof(names[0]); measure++)
+        {
+            /* The warm up brings the heap to the state it settles in on a
+             * long running unit */
+            replay_state = REPLAY_SEED;
+            for (uint32_t step = 0; step < REPLAY_WARMUP_STEPS; step++)
+            {
+                replay_step(pattern, step, &times[0], &times[1]);
+            }
+
+            for (uint32_t n = 0; n < BENCH_ITERATIONS; n++)
+            {
+                replay_step(pattern, REPLAY_WARMUP_STEPS + n, &times[0], &times[1]);
+
+                if (measure < 2)
+                {
+                    samples[n] = times[measure];
+                }
+                else
+                {
+                    vPortGetHeapStats(&stats);
+                    samples[n] = 1000 - (uint32_t) (((uint64_t) stats.xSizeOfLargestFreeBlockInBytes * 1000)
+                                                    / stats.xAvailableHeapSpaceInBytes);
+                }
+            }
+            bench_report(names[measure], i, (measure < 2) ? BENCH_UNIT : "permille", samples);
+
+            for (size_t slot = 0; slot < sizeof(replay_blocks) / sizeof(replay_blocks[0]); slot++)
+            {
+                vPortFree(replay_blocks[slot]);
+                replay_blocks[slot] = NULL;
+            }
+        }
+    }
+}
+
+static void bench_queue(void)
+{
+    for (size_t i = 0; i < sizeof(queue_item_sizes) / sizeof(queue_item_sizes[0]); i++)
+    {
+        UBaseType_t size = queue_item_sizes[i];
+        QueueHandle_t queue = xQueueCreate(1, size);
+
+        if (queue == NULL)
+        {
+            Error_Handler();
+        }
+
+        for (uint32_t n = 0; n < BENCH_ITERATIONS; n++)
+        {
+            uint32_t start = bench_timestamp();
+            xQueueSend(queue, queue_item, 0);
+            samples[n] = bench_timestamp() - start;
+
+            xQueueReceive(queue, queue_item, 0);
+        }
+        report("queue_send", size);
+
+        for (uint32_t n = 0; n < BENCH_ITERATIONS; n++)
+        {
+            xQueueSend(queue, queue_item, 0);
+
+            uint32_t start = bench_timestamp();
+            xQueueReceive(queue, queue_item, 0);
+            samples[n] = bench_timestamp() - start;
+        }
+        report("queue_receive", size);
+
+        vQueueDelete(queue);
+    }
+}
+
+static void bench_mutex(SemaphoreHandle_t mutex)
+{
+    for (uint32_t n = 0; n < BENCH_ITERATIONS; n++)
+    {
+        uint32_t start = bench_timestamp();
+        xSemaphoreTake(mutex, portMAX_DELAY);
+        samples[n] = bench_timestamp() - start;
+
+        xSemaphoreGive(mutex);
+    }
+    report("mutex_take", 0);
+
+    for (uint32_t n = 0; n < BENCH_ITERATIONS; n++)
+    {
+        xSemaphoreTake(mutex, portMAX_DELAY);
+
+        uint32_t start = bench_timestamp();
+        xSemaphoreGive(mutex);
+        samples[n] = bench_timestamp() - start;
+    }
+    report("mutex_give", 0);
+}
+
+/**
+  * @brief  Blocks on the mutex each time the benchmark task, holding it,
+  *         notifies this task
+  * @param  parameters: Mutex handle
+  * @retval None
+  */
+static void mutex_waiter_task(void* parameters)
+{
+    SemaphoreHandle_t mutex = parameters;
+
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        mark = bench_timestamp();
+        xSemaphoreTake(mutex, portMAX_DELAY);
+        result = bench_timestamp() - mark;
+
+        xSemaphoreGive(mutex);
+    }
+}
+
+static void bench_mutex_contended(SemaphoreHandle_t mutex)
+{
+    TaskHandle_t waiter_handle;
+
+    if (xTaskCreate(mutex_waiter_task, "MtxWait", HELPER_STACK_SIZE, mutex, HELPER_PRIORITY, &waiter_handle) != pdPASS)
+    {
+        Error_Handler();
+    }
+
+    /* Both intervals come from the same sequence, one per pass */
+    for (uint32_t pass = 0; pass < 2; pass++)
+    {
+        for (uint32_t n = 0; n < BENCH_ITERATIONS; n++)
+        {
+            uint32_t blocked;
+
+            xSemaphoreTake(mutex, portMAX_DELAY);
+
+            /* The waiter preempts, blocks on the mutex and raises this task */
+            xTaskNotifyGive(waiter_handle);
+            blocked = bench_timestamp() - mark;
+
+            /* The give hands the mutex over and the waiter preempts again */
+            mark = bench_timestamp();
+            xSemaphoreGive(mutex);
+
+            samples[n] = (pass == 0) ? blocked : result;
+        }
+        report((pass == 0) ? "mutex_take_blocked" : "mutex_give_handoff", 0);
+    }
+
+    vTaskDelete(waiter_handle);
+}
+
+static void bench_irq_handler(void)
+{
+    BaseType_t higher_priority_task_woken = pdFALSE;
+
+    mark = bench_timestamp();
+    xTaskNotifyFromISR(notify_waiter_handle, 1, eSetBits, &higher_priority_task_woken);
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+}
+
+static void notify_waiter_task(void* parameters)
+{
+    (void) parameters;
+
+    while (1)
+    {
+        xTaskNotifyWait(0, UINT32_MAX, NULL, portMAX_DELAY);
+        result = bench_timestamp() - mark;
+    }
+}
+
+static void bench_notify_from_isr(void)
+{
+    if (xTaskCreate(notify_waiter_task, "NtfWait", HELPER_STACK_SIZE, NULL, HELPER_PRIORITY,
+                    &notify_waiter_handle) != pdPASS)
+    {
+        Error_Handler();
+    }
+
+    for (uint32_t n = 0; n < BENCH_ITERATIONS; n++)
+    {
+        /* The waiter has run and blocked again by the time this returns */
+        bench_irq_trigger();
+        samples[n] = result;
+    }
+    report("notify_isr_latency", 0);
+
+    vTaskDelete(notify_waiter_handle);
+}
+
+static void filler_task(void* parameters)
+{
+    (void) parameters;
+
+    /* Never runs while the case is measured, it only fills the ready list */
+    while (1)
+    {
+        vTaskSuspend(NULL);
+    }
+}
+
+/**
+  * @brief  Measures a yield with growing numbers of ready tasks
+  * @param  name: Case name
+  * @param  priority: Priority the benchmark task yields at
+  * @param  filler_priority: Priority of the other ready tasks
+  * @retval None
+  */
+static void bench_switch(const char* name, UBaseType_t priority, UBaseType_t filler_priority)
+{
+    TaskHandle_t filler_handles[MAX_READY_TASKS];
+    DeadlineTime_t now = xTaskGetDeadlineTime();
+    UBaseType_t ready_tasks = 1;  // The benchmark task itself
+
+    /* In the EDF band the benchmark task has the earliest deadline, so each
+     * yield selects it again */
+    vTaskSetDeadline(NULL, now + BENCH_DEADLINE);
+    vTaskPrioritySet(NULL, priority);
+
+    for (size_t i = 0; i < sizeof(ready_task_counts) / sizeof(ready_task_counts[0]); i++)
+    {
+        while (ready_tasks < ready_task_counts[i])
+        {
+            if (xTaskCreate(filler_task, "Filler", FILLER_STACK_SIZE, NULL, filler_priority,
+                            &filler_handles[ready_tasks - 1]) != pdPASS)
+            {
+                Error_Handler();
+            }
+            vTaskSetDeadline(filler_handles[ready_tasks - 1], now + FILLER_DEADLINE + ready_tasks);
+            ready_tasks++;
+        }
+
+        for (uint32_t n = 0; n < BENCH_ITERATIONS; n++)
+        {
+            uint32_t start = bench_timestamp();
+            taskYIELD();
+            samples[n] = bench_timestamp() - start;
+        }
+        report(name, ready_tasks);
+    }
+
+    vTaskPrioritySet(NULL, BENCH_PRIORITY);
+    while (ready_tasks > 1)
+    {
+        ready_tasks--;
+        vTaskDelete(filler_handles[ready_tasks - 1]);
+    }
+}
+
+static void bench_task(void* parameters)
+{
+    SemaphoreHandle_t mutex;
+
+    (void) parameters;
+
+    mutex = xSemaphoreCreateMutex();
+    if (mutex == NULL)
+    {
+        Error_Handler();
+    }
+
+    bench_timer_init();
+    bench_irq_init();
+
+    uart_print("bench,case,parameter,unit,samples,min,median,p99,max\r\n");
+
+    /* The heap is measured first, before the helper tasks fragment it */
+    bench_timer_overhead();
+    bench_heap();
+    bench_pool();
+    bench_replay();
+    bench_queue();
+    bench_mutex(mutex);
+    bench_mutex_contended(mutex);
+    bench_notify_from_isr();
+    bench_switch("switch_edf", EDF_BAND_PRIORITY, EDF_BAND_PRIORITY);
+    bench_switch("switch_fp", BENCH_PRIORITY, FILLER_FP_PRIORITY);
+
+#ifdef KERNEL_BENCHMARK_HOST
+    vTaskEndScheduler();
+#endif
+    vTaskSuspend(NULL);
+}
+
+void kernel_bench_start(void)
+{
+    if (xTaskCreate(bench_task, "KrnBench", BENCH_STACK_SIZE, NULL, BENCH_PRIORITY, NULL) != pdPASS)
+    {
+        Error_Handler();
+    }
+}
+
+#endif /* KERNEL_BENCHMARK */
@@ -9,42 +9,216 @@
 #include "stm32f4xx_hal_adc.h"
 #include "stm32f4xx_hal_uart.h"
 #include "stm32f4xx_hal_conf.h"
+#include "edf_bench.h"
+#include "mutex_bench.h"
+#include "kernel_bench.h"
+#include "dsp_bench.h"
+#include "taskset_config.h"
+#include "tt_table.h"
+#include "timebase.h"
+#include "adc_scan.h"
+#include "dsp_filter.h"
 
 /* Private defines ------------------------------------------------------------*/
-#define TASK_STACK_SIZE        128
-#define ADC_TASK_PRIORITY      3    // Highest priority
-#define LED_HIGH_PRIORITY      2    // Medium priority
-#define LED_LOW_PRIORITY       1    // Lowest priority
-#define MUTEX_CEILING_PRIORITY ADC_TASK_PRIORITY  // Priority ceiling
+/* Priorities, stack sizes, periods, relative deadlines and worst case
+ * execution times come from taskset_config.h, generated from the analysed
+ * table in Core/taskset.json by tools/taskset_gen.py.  All tasks share the
+ * EDF band, so they are scheduled earliest deadline first and the ADC result
+ * is shared under SRP.  The LED WCETs are dominated by the blocking UART
+ * print (about 17 bytes at 9600 baud). */
+#define ADC_TASK_PERIOD        tskUS_TO_DEADLINE_TIME(ADC_TASK_PERIOD_US)
+#define ADC_TASK_DEADLINE      tskUS_TO_DEADLINE_TIME(ADC_TASK_DEADLINE_US)
+#define ADC_TASK_WCET          tskUS_TO_DEADLINE_TIME(ADC_TASK_WCET_US)
+#define LED_HIGH_PERIOD        tskUS_TO_DEADLINE_TIME(LED_HIGH_PERIOD_US)
+#define LED_HIGH_DEADLINE      tskUS_TO_DEADLINE_TIME(LED_HIGH_DEADLINE_US)
+#define LED_HIGH_WCET          tskUS_TO_DEADLINE_TIME(LED_HIGH_WCET_US)
+#define LED_LOW_PERIOD         tskUS_TO_DEADLINE_TIME(LED_LOW_PERIOD_US)
+#define LED_LOW_DEADLINE       tskUS_TO_DEADLINE_TIME(LED_LOW_DEADLINE_US)
+#define LED_LOW_WCET           tskUS_TO_DEADLINE_TIME(LED_LOW_WCET_US)
+
+/* The Bluetooth command handler is aperiodic and runs in a Constant Bandwidth
+ * Server, so a burst of commands cannot take more than 10% of the processor
+ * from the periodic tasks.  One reply is about 20 bytes at 9600 baud.  The
+ * table describes the server as a task with its budget as the WCET. */
+#define BT_SERVER_BUDGET       tskUS_TO_DEADLINE_TIME(BT_SERVER_WCET_US)
+#define BT_SERVER_PERIOD       tskUS_TO_DEADLINE_TIME(BT_SERVER_PERIOD_US)
+
+/* Build with TIME_TRIGGERED defined to dispatch the ADC task from the static
+ * schedule in tt_table.h, generated by tools/taskset_tt.py, instead of by
+ * EDF.  The dispatcher runs from the TIM5 channel 2 compare and gives each
+ * slot the processor without a scheduling decision, so the ADC task sits in
+ * the fixed priority band and the shared values are protected by critical
+ * sections, as a slot does not respect SRP ceilings.  The LED tasks block
+ * inside their jobs and the Bluetooth task is aperiodic, so they stay EDF. */
+#define TT_TASK_PRIORITY       (tskIDLE_PRIORITY + 1)
+#define TT_START_DELAY_US      1000
+#define TT_SLOT(offset_us, task, budget_us) \
+    { tskUS_TO_DEADLINE_TIME(offset_us), (task), tskUS_TO_DEADLINE_TIME(budget_us) }
+
+/* Build with ADC_SCAN defined to convert the channels of ADC_SCAN_CHANNELS
+ * at ADC_SCAN_RATE_HZ instead of one sample of channel 0 per job.  Each
+ * update of TIM3, counting microseconds, starts a sequence through TRGO, so
+ * the sample clock does not move with the load, the tick or the release
+ * of the ADC task.  The DMA writes the results into the two halves of
+ * adc_scan_buffer in circular mode and hands each half to the ADC task as
+ * it completes, with the TIM5 time of its first trigger, so the processor
+ * takes two interrupts per ADC_SCAN_SCANS_PER_HALF sequences.  A sequence
+ * of five at 84 + 12 cycles of the 4 MHz ADC clock takes 120 us of the
+ * 1 ms period.  The ADC task is released by the DMA instead of by a
+ * period, so it sits in the fixed priority band above EDF and the shared
+ * values are protected by critical sections. */
+#ifndef ADC_SCAN_CHANNELS
+#define ADC_SCAN_CHANNELS      ADC_CHANNEL_0, ADC_CHANNEL_6, ADC_CHANNEL_7, ADC_CHANNEL_8, ADC_CHANNEL_9
+#endif
+#ifndef ADC_SCAN_RATE_HZ
+#define ADC_SCAN_RATE_HZ       1000
+#endif
+#define ADC_SCAN_SAMPLING_TIME ADC_SAMPLETIME_84CYCLES
+#ifndef ADC_SCAN_LOG2_SCANS_PER_HALF
+#define ADC_SCAN_LOG2_SCANS_PER_HALF 5
+#endif
+#define ADC_SCAN_SCANS_PER_HALF (1U << ADC_SCAN_LOG2_SCANS_PER_HALF)
+#define ADC_SCAN_CHANNEL_COUNT (sizeof(adc_scan_channels) / sizeof(adc_scan_channels[0]))
+#define ADC_SCAN_TASK_PRIORITY (tskIDLE_PRIORITY + 3)
+#define ADC_SCAN_TIMEOUT       pdMS_TO_TICKS(100)
+
+/* Channel 0 also goes through a second order Butterworth low-pass of 10 Hz
+ * at the 1 kHz sample rate, one half of the scan buffer at a time, and the
+ * last output selects the LED pattern, so the noise of a value near
+ * threshold1 or threshold2 does not make the pattern flicker.  The samples
+ * are shifted into bits 27 to 16 of a Q31 value, leaving room for the
+ * overshoot.  A pole this close to 1 needs the Q31 filter: the Q15 one
+ * would truncate each output by up to an LSB that the feedback multiplies
+ * by 1 / (1 - a1 - a2), some 260, far more than the 3 bits it has below
+ * the ADC result.  The coefficients are halved for a post shift of 1. */
+#define ADC_FILTER_SHIFT       16
+#define ADC_FILTER_POST_SHIFT  1
+
+/* Each channel is decimated by a CIC filter of order ADC_SCAN_CIC_ORDER to
+ * one value per half of ADC_SCAN_OUTPUT_BITS bits, in place of the mean of
+ * the 12-bit samples: the 32 samples of a half gain 2.5 bits when their
+ * noise is an LSB or more, and at the third order it rejects what would
+ * alias onto the rate of the halves far better than the mean.  16 bits take a
+ * ratio of 256, ADC_SCAN_LOG2_SCANS_PER_HALF 8, at order 2 for the sums to
+ * fit in 32 bits. */
+#ifndef ADC_SCAN_CIC_ORDER
+#define ADC_SCAN_CIC_ORDER     3
+#endif
+#ifndef ADC_SCAN_OUTPUT_BITS
+#define ADC_SCAN_OUTPUT_BITS   14
+#endif
+#define ADC_SCAN_INPUT_BITS    12
+
+#if defined(TIME_TRIGGERED) && defined(ADC_SCAN)
+#error The ADC task is either dispatched from the schedule table or released by the DMA
+#endif
+#if (1000000 % ADC_SCAN_RATE_HZ) != 0
+#error ADC_SCAN_RATE_HZ must divide 1 MHz, TIM3 counts whole microseconds
+#endif
+#if (ADC_SCAN_INPUT_BITS + ADC_SCAN_CIC_ORDER * ADC_SCAN_LOG2_SCANS_PER_HALF) > 32
+#error The CIC sums of ADC_SCAN_CIC_ORDER over a half do not fit in 32 bits
+#endif
+
+#ifdef TIME_TRIGGERED
+#define ADC_LOCK()             taskENTER_CRITICAL()
+#define ADC_UNLOCK()           taskEXIT_CRITICAL()
+#define ADC_WAIT_FOR_NEXT_JOB() vTaskWaitForNextSlot()
+#elif defined(ADC_SCAN)
+#define ADC_LOCK()             taskENTER_CRITICAL()
+#define ADC_UNLOCK()           taskEXIT_CRITICAL()
+#else
+#define ADC_LOCK()             vTaskSRPLock(adc_resource)
+#define ADC_UNLOCK()           vTaskSRPUnlock(adc_resource)
+#define ADC_WAIT_FOR_NEXT_JOB() ((void)xTaskWaitForNextPeriod())
+#endif
+
+/* A conversion takes a few microseconds; the timeout only ends the wait if
+ * the end of conversion interrupt is lost. */
+#define ADC_CONVERSION_TIMEOUT pdMS_TO_TICKS(2)
+
+/* Build with TRACE_STREAMING defined to send the trace on USART1 (PA9)
+ * instead of keeping a snapshot in RAM.  The sending task runs in the fixed
+ * priority band below the application. */
+#define TRACE_UART_BAUDRATE    460800
+#define TRACE_TASK_PRIORITY    (tskIDLE_PRIORITY + 1)
+
+/* Room for the application tasks, the idle and timer tasks and the trace task */
+#define RUN_STATS_MAX_TASKS    8
 
 /* Private variables ---------------------------------------------------------*/
 ADC_HandleTypeDef hadc1;
+DMA_HandleTypeDef hdma_adc1;
+#ifdef ADC_SCAN
+TIM_HandleTypeDef htim3;
+#endif
 UART_HandleTypeDef huart2;  // For Bluetooth
 UART_HandleTypeDef huart1;
 
-SemaphoreHandle_t adc_mutex;
+/* Protects shared_adc_value and led_pattern_selection */
+static SRPResourceHandle_t adc_resource;
 static uint32_t shared_adc_value;
 static uint8_t led_pattern_selection = 0;
 
-/* Task original priorities */
-static UBaseType_t adc_task_original_priority;
-static UBaseType_t led_high_task_original_priority;
-static UBaseType_t led_low_task_original_priority;
+#ifdef ADC_SCAN
+static const uint32_t adc_scan_channels[] = { ADC_SCAN_CHANNELS };
+
+/* Filled by the DMA; the CIC output of each channel for a half is published
+ * in shared_scan_values, with the time of the first sequence of the half in
+ * shared_scan_time_us, and the low-pass output of the first as
+ * shared_adc_value */
+static uint16_t adc_scan_buffer[2 * ADC_SCAN_SCANS_PER_HALF * ADC_SCAN_CHANNEL_COUNT];
+static uint32_t shared_scan_values[ADC_SCAN_CHANNEL_COUNT];
+static uint64_t shared_scan_time_us;
+static dsp_cic_t adc_scan_cic[ADC_SCAN_CHANNEL_COUNT];
+
+/* { b0, b1, b2, a1, a2 } in Q31, see ADC_FILTER_SHIFT */
+static const q31_t adc_filter_coeffs[DSP_BIQUAD_Q31_COEFFS_SIZE(1)] = {
+    1014355, 2028710, 1014355, 2052132225, -982447822
+};
+static q31_t adc_filter_state[DSP_BIQUAD_STATE_SIZE(1)];
+/* Channel 0 of a half, filtered in place; static to spare the task stack */
+static q31_t adc_filter_block[ADC_SCAN_SCANS_PER_HALF];
+#endif
+
+static TaskHandle_t adc_task_handle;
+static TaskHandle_t led_high_task_handle;
+static TaskHandle_t led_low_task_handle;
+static TaskHandle_t bluetooth_task_handle;
+
+#ifdef TIME_TRIGGERED
+/* The schedule and the tasks it names, in the order of tt_table.h */
+static const TimeTriggeredEntry_t tt_table[TT_TABLE_ENTRIES] = { TT_TABLE };
+static TaskHandle_t tt_tasks[TT_TASKS];
+#endif
 
 static uint8_t rx_buffer[1];  // UART receive buffer
+static TaskRunStats_t run_stats[RUN_STATS_MAX_TASKS];  // Too large for the task stack
 static void MX_USART2_UART_Init(void);
+#ifdef TRACE_STREAMING
+static void MX_USART1_UART_Init(void);
+#endif
 
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
+static void MX_DMA_Init(void);
 static void MX_ADC1_Init(void);
+static uint8_t adc_pattern(uint32_t value);
+#ifdef ADC_SCAN
+static void MX_TIM3_Init(void);
+static void adc_scan_task(void* parameters);
+#else
+static BaseType_t adc_read(uint32_t* value);
 static void adc_reading_task(void* parameters);
+#endif
 static void led_pattern_high_task(void* parameters);
 static void led_pattern_low_task(void* parameters);
-void raise_priority_to_ceiling(TaskHandle_t task_handle);
-void restore_task_priority(TaskHandle_t task_handle, UBaseType_t original_priority);
 static void MX_USART2_UART_Init(void);
 static void bluetooth_task(void* parameters);
+static void print_run_stats(void);
+#ifdef TIME_TRIGGERED
+static void start_time_triggered(void);
+#endif
 void uart_print(const char* str);
 
 /* UART2 Initialization (For Bluetooth) */
@@ -65,6 +239,26 @@ static void MX_USART2_UART_Init(void)
     }
 }
 
+#ifdef TRACE_STREAMING
+/* UART1 Initialization (For the trace stream) */
+static void MX_USART1_UART_Init(void)
+{
+    huart1.Instance = USART1;
+    huart1.Init.BaudRate = TRACE_UART_BAUDRATE;
+    huart1.Init.WordLength = UART_WORDLENGTH_8B;
+    huart1.Init.StopBits = UART_STOPBITS_1;
+    huart1.Init.Parity = UART_PARITY_NONE;
+    huart1.Init.Mode = UART_MODE_TX;
+    huart1.Init.HwFlowCtl = UART_HWCONTROL_NONE;
+    huart1.Init.OverSampling = UART_OVERSAMPLING_16;
+
+    if (HAL_UART_Init(&huart1) != HAL_OK)
+    {
+        Error_Handler();
+    }
+}
+#endif
+
 
 int main(void)
 {
@@ -76,27 +270,69 @@ int main(void)
 
     /* Initialize all configured peripherals */
     MX_GPIO_Init();
+    MX_DMA_Init();
     MX_ADC1_Init();
-
-    /* Create mutex for PCP */
-    adc_mutex = xSemaphoreCreateMutex();
-    if (adc_mutex == NULL) {
+#ifdef ADC_SCAN
+    MX_TIM3_Init();
+#endif
+
+#if ( configUSE_TRACE_RECORDER == 1 )
+    /* Start before any task is created so the trace has every task name */
+#ifdef TRACE_STREAMING
+    MX_USART1_UART_Init();
+    trace_stream_start(&huart1, TRACE_TASK_PRIORITY);
+#else
+    trace_start(TRACE_MODE_SNAPSHOT);
+#endif
+#endif
+
+    /* Create the SRP resource for the ADC result */
+    adc_resource = xTaskCreateSRPResource();
+    if (adc_resource == NULL) {
         Error_Handler();
     }
 
-    /* Create the three tasks with different priorities */
-    TaskHandle_t adc_task_handle, led_high_task_handle, led_low_task_handle;
+#ifdef EDF_BENCHMARK
+    /* Measure the scheduler instead of running the application */
+    edf_bench_start();
+#elif defined(MUTEX_BENCHMARK)
+    mutex_bench_start();
+#elif defined(KERNEL_BENCHMARK)
+    kernel_bench_start();
+#elif defined(DSP_BENCHMARK)
+    dsp_bench_start();
+#else
+    /* Task creation fails if the task set would not be schedulable */
+#ifdef TIME_TRIGGERED
+    if (xTaskCreate(adc_reading_task, "ADCTask", ADC_TASK_STACK_SIZE, NULL, TT_TASK_PRIORITY,
+                    &adc_task_handle) != pdPASS ||
+#elif defined(ADC_SCAN)
+    if (xTaskCreate(adc_scan_task, "ADCTask", ADC_TASK_STACK_SIZE, NULL, ADC_SCAN_TASK_PRIORITY,
+                    &adc_task_handle) != pdPASS ||
+#else
+    if (xTaskCreatePeriodic(adc_reading_task, "ADCTask", ADC_TASK_STACK_SIZE, NULL, ADC_TASK_PRIORITY,
+                            ADC_TASK_PERIOD, ADC_TASK_DEADLINE, ADC_TASK_WCET, &adc_task_handle) != pdPASS ||
+#endif
+        xTaskCreatePeriodic(led_pattern_high_task, "LEDHighTask", LED_HIGH_STACK_SIZE, NULL, LED_HIGH_PRIORITY,
+                            LED_HIGH_PERIOD, LED_HIGH_DEADLINE, LED_HIGH_WCET, &led_high_task_handle) != pdPASS ||
+        xTaskCreatePeriodic(led_pattern_low_task, "LEDLowTask", LED_LOW_STACK_SIZE, NULL, LED_LOW_PRIORITY,
+                            LED_LOW_PERIOD, LED_LOW_DEADLINE, LED_LOW_WCET, &led_low_task_handle) != pdPASS ||
+        xTaskCreateServed(bluetooth_task, "BTTask", BT_SERVER_STACK_SIZE, NULL, BT_SERVER_PRIORITY,
+                          BT_SERVER_BUDGET, BT_SERVER_PERIOD, &bluetooth_task_handle) != pdPASS)
+    {
+        Error_Handler();
+    }
 
-    adc_task_original_priority = ADC_TASK_PRIORITY;
-    led_high_task_original_priority = LED_HIGH_PRIORITY;
-    led_low_task_original_priority = LED_LOW_PRIORITY;
+    /* The resource ceiling is the preemption level of its most urgent user */
+    vTaskAddSRPResourceUser(adc_resource, adc_task_handle);
+    vTaskAddSRPResourceUser(adc_resource, led_high_task_handle);
+    vTaskAddSRPResourceUser(adc_resource, led_low_task_handle);
+    vTaskAddSRPResourceUser(adc_resource, bluetooth_task_handle);
 
-    xTaskCreate(adc_reading_task, "ADCTask", TASK_STACK_SIZE, &adc_task_handle, ADC_TASK_PRIORITY, NULL);
-    xTaskCreate(led_pattern_high_task, "LEDHighTask", TASK_STACK_SIZE, &led_high_task_handle, LED_HIGH_PRIORITY, NULL);
-    xTaskCreate(led_pattern_low_task, "LEDLowTask", TASK_STACK_SIZE, &led_low_task_handle, LED_LOW_PRIORITY, NULL);
-    vTaskSetDeadline(adc_task_handle,2000);
-    vTaskSetDeadline(led_high_task_handle,3000);
-    vTaskSetDeadline(adc_task_handle,1000);
+#ifdef TIME_TRIGGERED
+    start_time_triggered();
+#endif
+#endif
     /* Start scheduler */
     vTaskStartScheduler();
 
@@ -107,54 +343,143 @@ int main(void)
 }
 
 /**
-  * @brief  ADC Reading Task - Highest Priority
-  * @param  parameters: Not used
-  * @retval None
+  * @brief  Selects the LED pattern for an ADC result
+  * @param  value: The 12-bit result
+  * @retval 1 (slow), 2 (medium) or 3 (fast)
   */
-static void adc_reading_task(void* parameters)
+static uint8_t adc_pattern(uint32_t value)
 {
-    uint32_t local_adc_value;
     const uint32_t threshold1 = 1365;  // One-third of max (4095/3)
     const uint32_t threshold2 = 2730;  // Two-thirds of max (2*4095/3)
-    char uart_buffer[50];  // Buffer to hold the UART message
+
+    if (value < threshold1) {
+        return 1;  // Slow pattern
+    } else if (value < threshold2) {
+        return 2;  // Medium pattern
+    } else {
+        return 3;  // Fast pattern
+    }
+}
+
+#ifdef ADC_SCAN
+/**
+  * @brief  ADC Task - decimates each channel over every half of the scan
+  *         buffer the DMA completes, in place, and low-pass filters channel 0
+  *         for the LED pattern
+  * @param  parameters: Not used
+  * @retval None
+  */
+static void adc_scan_task(void* parameters)
+{
+    adc_scan_block_t block;
+    const uint16_t* samples;
+    uint32_t values[ADC_SCAN_CHANNEL_COUNT];
+    dsp_biquad_q31_t filter;
+
+    dsp_biquad_q31_init(&filter, 1, adc_filter_coeffs, adc_filter_state, ADC_FILTER_POST_SHIFT);
+    for (uint32_t channel = 0; channel < ADC_SCAN_CHANNEL_COUNT; channel++)
+    {
+        if (dsp_cic_init(&adc_scan_cic[channel], ADC_SCAN_CIC_ORDER, ADC_SCAN_LOG2_SCANS_PER_HALF,
+                         ADC_SCAN_INPUT_BITS, ADC_SCAN_OUTPUT_BITS) != 0)
+        {
+            Error_Handler();
+        }
+    }
+
+    /* This task becomes the consumer of the halves */
+    if (adc_scan_start(&hadc1, &htim3, adc_scan_buffer, ADC_SCAN_SCANS_PER_HALF) != HAL_OK)
+    {
+        Error_Handler();
+    }
 
     while (1)
     {
-        TaskHandle_t current_task_handle = xTaskGetCurrentTaskHandle();
+        /* The half stays ours until the next wait */
+        if (adc_scan_wait(&block, ADC_SCAN_TIMEOUT) != pdPASS)
+        {
+            continue;
+        }
+        samples = block.samples;
 
-        /* Take mutex with PCP - Temporarily raise to ceiling priority */
-        if (xSemaphoreTake(adc_mutex, portMAX_DELAY) == pdTRUE)
+        /* A half is one period of the ratio, so one value per channel */
+        for (uint32_t channel = 0; channel < ADC_SCAN_CHANNEL_COUNT; channel++)
+        {
+            dsp_cic_decimate(&adc_scan_cic[channel], &samples[channel], ADC_SCAN_CHANNEL_COUNT,
+                             ADC_SCAN_SCANS_PER_HALF, &values[channel]);
+        }
+        for (uint32_t scan = 0; scan < ADC_SCAN_SCANS_PER_HALF; scan++)
         {
-            raise_priority_to_ceiling(current_task_handle);  // Elevate priority to ceiling
+            adc_filter_block[scan] = (q31_t)samples[scan * ADC_SCAN_CHANNEL_COUNT] << ADC_FILTER_SHIFT;
+        }
+        dsp_biquad_q31(&filter, adc_filter_block, adc_filter_block, ADC_SCAN_SCANS_PER_HALF);
 
+        ADC_LOCK();
+        for (uint32_t channel = 0; channel < ADC_SCAN_CHANNEL_COUNT; channel++)
+        {
+            shared_scan_values[channel] = values[channel];
+        }
+        shared_scan_time_us = block.timestamp_us;
+        shared_adc_value = (uint32_t)(adc_filter_block[ADC_SCAN_SCANS_PER_HALF - 1U] >> ADC_FILTER_SHIFT);
+        led_pattern_selection = adc_pattern(shared_adc_value);
+        ADC_UNLOCK();
+    }
+}
+#else
+/**
+  * @brief  Converts one sample, blocking the calling task until the end of
+  *         conversion interrupt instead of polling the ADC
+  * @param  value: Set to the conversion result
+  * @retval pdPASS, or pdFAIL if the conversion did not complete
+  */
+static BaseType_t adc_read(uint32_t* value)
+{
+    BaseType_t result = pdFAIL;
 
-            /* Read ADC */
-            HAL_ADC_Start(&hadc1);
-            if (HAL_ADC_PollForConversion(&hadc1, HAL_MAX_DELAY) == HAL_OK)
-            {
-                local_adc_value = HAL_ADC_GetValue(&hadc1);
-                shared_adc_value = local_adc_value;
-
-                /* Update LED pattern based on ADC value */
-                if (local_adc_value < threshold1) {
-                    led_pattern_selection = 1;  // Slow pattern
-                } else if (local_adc_value < threshold2) {
-                    led_pattern_selection = 2;  // Medium pattern
-                } else {
-                    led_pattern_selection = 3;  // Fast pattern
-                }
+    /* A give left by a conversion that timed out would end the wait early.
+     * ulTaskNotifyTake() looks at the count, not the state, so clear the count. */
+    ulTaskNotifyValueClear(NULL, UINT32_MAX);
 
-            }
-            HAL_ADC_Stop(&hadc1);
+    if (HAL_ADC_Start_IT(&hadc1) == HAL_OK)
+    {
+        if (ulTaskNotifyTake(pdTRUE, ADC_CONVERSION_TIMEOUT) != 0)
+        {
+            *value = HAL_ADC_GetValue(&hadc1);
+            result = pdPASS;
+        }
+        HAL_ADC_Stop_IT(&hadc1);
+    }
+
+    return result;
+}
+
+/**
+  * @brief  ADC Reading Task - Highest Priority
+  * @param  parameters: Not used
+  * @retval None
+  */
+static void adc_reading_task(void* parameters)
+{
+    uint32_t local_adc_value;
 
-            xSemaphoreGive(adc_mutex);  // Release the mutex
-            restore_task_priority(current_task_handle, adc_task_original_priority);  // Restore original priority
+    while (1)
+    {
+        /* Read ADC; other tasks run during the conversion */
+        if (adc_read(&local_adc_value) == pdPASS)
+        {
+            /* Publish the result under ADC_LOCK() - never blocks */
+            ADC_LOCK();
+            shared_adc_value = local_adc_value;
+
+            /* Update LED pattern based on ADC value */
+            led_pattern_selection = adc_pattern(local_adc_value);
+            ADC_UNLOCK();
         }
 
-        /* ADC reading interval */
-        vTaskDelay(pdMS_TO_TICKS(100));
+        /* Wait for the next release */
+        ADC_WAIT_FOR_NEXT_JOB();
     }
 }
+#endif
 
 /**
   * @brief  LED Pattern High Priority Task
@@ -164,103 +489,310 @@ static void adc_reading_task(void* parameters)
 static void led_pattern_high_task(void* parameters)
 {
     uint8_t local_pattern;
-    TaskHandle_t current_task_handle = xTaskGetCurrentTaskHandle();
     char uart_buffer[50];
     while (1)
     {
-        /* Take mutex with PCP - Temporarily raise to ceiling priority */
-        if (xSemaphoreTake(adc_mutex, portMAX_DELAY) == pdTRUE)
+        /* Read the pattern under ADC_LOCK() - never blocks */
+        ADC_LOCK();
+        local_pattern = led_pattern_selection;
+        ADC_UNLOCK();
+
+        /* High priority pattern - Quick double blink */
+        if (local_pattern == 3)  // Only run when ADC is in highest range
         {
-            raise_priority_to_ceiling(current_task_handle);  // Elevate priority to ceiling
+            HAL_GPIO_WritePin(GPIOD, GPIO_PIN_14, GPIO_PIN_SET);
+            vTaskDelay(pdMS_TO_TICKS(50));
+            HAL_GPIO_WritePin(GPIOD, GPIO_PIN_14, GPIO_PIN_RESET);
+            vTaskDelay(pdMS_TO_TICKS(50));
+            HAL_GPIO_WritePin(GPIOD, GPIO_PIN_14, GPIO_PIN_SET);
+            vTaskDelay(pdMS_TO_TICKS(50));
+            HAL_GPIO_WritePin(GPIOD, GPIO_PIN_14, GPIO_PIN_RESET);
+            snprintf(uart_buffer, sizeof(uart_buffer), "High Priority \r\n");
+            uart_print(uart_buffer);
+        }
 
-            local_pattern = led_pattern_selection;
+        xTaskWaitForNextPeriod();  // Medium period between patterns
+    }
+}
 
-            xSemaphoreGive(adc_mutex);  // Release the mutex
-            restore_task_priority(current_task_handle, led_high_task_original_priority);  // Restore original priority
+/**
+  * @brief  LED Pattern Low Priority Task
+  * @param  parameters: Not used
+  * @retval None
+  */
+static void led_pattern_low_task(void* parameters)
+{
+    uint8_t local_pattern;
+    char uart_buffer[50];
+    while (1)
+    {
+        /* Read the pattern under ADC_LOCK() - never blocks */
+        ADC_LOCK();
+        local_pattern = led_pattern_selection;
+        ADC_UNLOCK();
 
-            /* High priority pattern - Quick double blink */
-            if (local_pattern == 3)  // Only run when ADC is in highest range
-            {
-                HAL_GPIO_WritePin(GPIOD, GPIO_PIN_14, GPIO_PIN_SET);
-                vTaskDelay(pdMS_TO_TICKS(50));
-                HAL_GPIO_WritePin(GPIOD, GPIO_PIN_14, GPIO_PIN_RESET);
-                vTaskDelay(pdMS_TO_TICKS(50));
-                HAL_GPIO_WritePin(GPIOD, GPIO_PIN_14, GPIO_PIN_SET);
-                vTaskDelay(pdMS_TO_TICKS(50));
-                HAL_GPIO_WritePin(GPIOD, GPIO_PIN_14, GPIO_PIN_RESET);
-                snprintf(uart_buffer, sizeof(uart_buffer), "High Priority \r\n");
+        /* Low priority patterns */
+        switch(local_pattern)
+        {
+            case 1:  // Slow single blink
+                HAL_GPIO_WritePin(GPIOD, GPIO_PIN_12, GPIO_PIN_SET);
+//                    HAL_GPIO_WritePin(GPIOD, GPIO_PIN_1, GPIO_PIN_SET);
+                vTaskDelay(pdMS_TO_TICKS(500));
+                HAL_GPIO_WritePin(GPIOD, GPIO_PIN_12, GPIO_PIN_RESET);
+                snprintf(uart_buffer, sizeof(uart_buffer), "Low Priority\r\n");
                 uart_print(uart_buffer);
-            }
+                break;
+
+            case 2:  // Medium single blink
+                HAL_GPIO_WritePin(GPIOD, GPIO_PIN_13, GPIO_PIN_SET);
+                vTaskDelay(pdMS_TO_TICKS(200));
+                HAL_GPIO_WritePin(GPIOD, GPIO_PIN_13, GPIO_PIN_RESET);
+                snprintf(uart_buffer, sizeof(uart_buffer), "Medium Priority\r\n");
+                uart_print(uart_buffer);
+                break;
+
+            default:
+                // Do nothing when pattern 3 is active (handled by high priority task)
+                break;
         }
 
-        vTaskDelay(pdMS_TO_TICKS(200));  // Medium delay between patterns
+        xTaskWaitForNextPeriod();  // Longer period for low priority task
     }
 }
 
 /**
-  * @brief  LED Pattern Low Priority Task
+  * @brief  Bluetooth Command Task - Served aperiodic task
   * @param  parameters: Not used
   * @retval None
   */
-static void led_pattern_low_task(void* parameters)
+static void bluetooth_task(void* parameters)
 {
+    uint32_t received;
+#ifdef ADC_SCAN
+    uint32_t local_scan_values[ADC_SCAN_CHANNEL_COUNT];
+    int length;
+#else
+    uint32_t local_adc_value;
+#endif
     uint8_t local_pattern;
-    TaskHandle_t current_task_handle = xTaskGetCurrentTaskHandle();
     char uart_buffer[50];
+
+    /* Each received byte is passed on by HAL_UART_RxCpltCallback() */
+    HAL_UART_Receive_IT(&huart2, rx_buffer, 1);
+
     while (1)
     {
+        xTaskNotifyWait(0, 0, &received, portMAX_DELAY);
 
-        /* Take mutex with PCP - Temporarily raise to ceiling priority */
-        if (xSemaphoreTake(adc_mutex, portMAX_DELAY) == pdTRUE)
+        if ((char)received == '?')
         {
-            raise_priority_to_ceiling(current_task_handle);  // Elevate priority to ceiling
-
+#ifdef ADC_SCAN
+            ADC_LOCK();
+            for (uint32_t channel = 0; channel < ADC_SCAN_CHANNEL_COUNT; channel++)
+            {
+                local_scan_values[channel] = shared_scan_values[channel];
+            }
             local_pattern = led_pattern_selection;
+            ADC_UNLOCK();
 
-            xSemaphoreGive(adc_mutex);  // Release the mutex
-            restore_task_priority(current_task_handle, led_low_task_original_priority);  // Restore original priority
-
-            /* Low priority patterns */
-            switch(local_pattern)
+            /* One value of ADC_SCAN_OUTPUT_BITS per channel, in the order of
+             * ADC_SCAN_CHANNELS */
+            length = snprintf(uart_buffer, sizeof(uart_buffer), "ADC");
+            for (uint32_t channel = 0; channel < ADC_SCAN_CHANNEL_COUNT; channel++)
             {
-                case 1:  // Slow single blink
-                    HAL_GPIO_WritePin(GPIOD, GPIO_PIN_12, GPIO_PIN_SET);
-//                    HAL_GPIO_WritePin(GPIOD, GPIO_PIN_1, GPIO_PIN_SET);
-                    vTaskDelay(pdMS_TO_TICKS(500));
-                    HAL_GPIO_WritePin(GPIOD, GPIO_PIN_12, GPIO_PIN_RESET);
-                    snprintf(uart_buffer, sizeof(uart_buffer), "Low Priority\r\n");
-                    uart_print(uart_buffer);
-                    break;
-
-                case 2:  // Medium single blink
-                    HAL_GPIO_WritePin(GPIOD, GPIO_PIN_13, GPIO_PIN_SET);
-                    vTaskDelay(pdMS_TO_TICKS(200));
-                    HAL_GPIO_WritePin(GPIOD, GPIO_PIN_13, GPIO_PIN_RESET);
-                    snprintf(uart_buffer, sizeof(uart_buffer), "Medium Priority\r\n");
-                    uart_print(uart_buffer);
-                    break;
-
-                default:
-                    // Do nothing when pattern 3 is active (handled by high priority task)
-                    break;
+                length += snprintf(uart_buffer + length, sizeof(uart_buffer) - length, " %lu",
+                                   (unsigned long)local_scan_values[channel]);
             }
+            snprintf(uart_buffer + length, sizeof(uart_buffer) - length, " Pattern %u\r\n",
+                     (unsigned)local_pattern);
+#else
+            ADC_LOCK();
+            local_adc_value = shared_adc_value;
+            local_pattern = led_pattern_selection;
+            ADC_UNLOCK();
+
+            snprintf(uart_buffer, sizeof(uart_buffer), "ADC %lu Pattern %u\r\n",
+                     (unsigned long)local_adc_value, (unsigned)local_pattern);
+#endif
+            uart_print(uart_buffer);
         }
+        else if ((char)received == 's')
+        {
+            print_run_stats();
+        }
+    }
+}
+
+/**
+  * @brief  Prints the CPU share of each task, the response time and release
+  *         jitter of the periodic tasks and the idle time
+  * @retval None
+  */
+static void print_run_stats(void)
+{
+    char uart_buffer[80];
+    configRUN_TIME_COUNTER_TYPE total_time;
+    configRUN_TIME_COUNTER_TYPE idle_time;
+    UBaseType_t task_count;
+
+    task_count = uxTaskGetRunStats(run_stats, RUN_STATS_MAX_TASKS, &total_time, &idle_time);
+    if (task_count == 0 || total_time == 0)
+    {
+        return;
+    }
+
+    for (UBaseType_t i = 0; i < task_count; i++)
+    {
+        const TaskJobStats_t* jobs = &run_stats[i].xJobStats;
+        unsigned long share = (unsigned long)((run_stats[i].ulRunTimeCounter * 1000U) / total_time);
+
+        snprintf(uart_buffer, sizeof(uart_buffer), "%-10s cpu %lu.%lu%%",
+                 pcTaskGetName(run_stats[i].xHandle), share / 10, share % 10);
+        uart_print(uart_buffer);
+
+        if (jobs->ulJobs > 0)
+        {
+            snprintf(uart_buffer, sizeof(uart_buffer), " jobs %lu resp %lu/%lu/%lu us jitter %lu us",
+                     (unsigned long)jobs->ulJobs,
+                     (unsigned long)jobs->xMinResponseTime,
+                     (unsigned long)(jobs->ullTotalResponseTime / jobs->ulJobs),
+                     (unsigned long)jobs->xMaxResponseTime,
+                     (unsigned long)(jobs->xMaxStartLatency - jobs->xMinStartLatency));
+            uart_print(uart_buffer);
+        }
+        uart_print("\r\n");
+    }
+
+    snprintf(uart_buffer, sizeof(uart_buffer), "idle %lu%%\r\n",
+             (unsigned long)((idle_time * 100U) / total_time));
+    uart_print(uart_buffer);
+
+#ifdef TIME_TRIGGERED
+    TimeTriggeredStats_t tt_stats;
+
+    vTaskGetTimeTriggeredStats(&tt_stats);
+    snprintf(uart_buffer, sizeof(uart_buffer), "frames %lu overruns %lu not ready %lu jitter %lu us\r\n",
+             (unsigned long)tt_stats.ulFrames, (unsigned long)tt_stats.ulOverruns,
+             (unsigned long)tt_stats.ulNotReady,
+             (unsigned long)(tt_stats.xMaxLatency - tt_stats.xMinLatency));
+    uart_print(uart_buffer);
+#endif
+
+#ifdef ADC_SCAN
+    adc_scan_stats_t scan_stats;
+    uint64_t scan_time_us;
+
+    adc_scan_get_stats(&scan_stats);
+    ADC_LOCK();
+    scan_time_us = shared_scan_time_us;
+    ADC_UNLOCK();
+    snprintf(uart_buffer, sizeof(uart_buffer), "scan halves %lu overruns %lu last at %lu us\r\n",
+             (unsigned long)scan_stats.halves, (unsigned long)scan_stats.overruns,
+             (unsigned long)scan_time_us);
+    uart_print(uart_buffer);
+#endif
+}
+
+#ifdef TIME_TRIGGERED
+/**
+  * @brief  Installs the schedule table, with the first major frame starting
+  *         shortly after the scheduler, and sets the alarm for its first slot
+  * @retval None
+  */
+static void start_time_triggered(void)
+{
+    uint64_t start = timebase_get_us() + TT_START_DELAY_US;
+
+    tt_tasks[TT_ADC_TASK] = adc_task_handle;
+    if (xTaskStartTimeTriggered(tt_table, TT_TABLE_ENTRIES, tt_tasks, TT_TASKS,
+                                tskUS_TO_DEADLINE_TIME(TT_MAJOR_FRAME_US), start) != pdPASS)
+    {
+        Error_Handler();
+    }
+    timebase_set_alarm(start);
+}
+
+/* Starts and ends the slots that are due and sets the alarm for the next */
+void timebase_alarm_callback(void)
+{
+    BaseType_t higher_priority_task_woken = pdFALSE;
+
+    timebase_set_alarm(xTaskTimeTriggeredDispatchFromISR(&higher_priority_task_woken));
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+}
+#endif
+
+#ifdef ADC_SCAN
+/* Hands the first half of the scan buffer to the ADC task */
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc)
+{
+    BaseType_t higher_priority_task_woken = pdFALSE;
+
+    if (hadc->Instance == ADC1)
+    {
+        adc_scan_half_complete_from_isr(0, &higher_priority_task_woken);
+        portYIELD_FROM_ISR(higher_priority_task_woken);
+    }
+}
+
+/* Hands the second half of the scan buffer to the ADC task */
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
+{
+    BaseType_t higher_priority_task_woken = pdFALSE;
+
+    if (hadc->Instance == ADC1)
+    {
+        adc_scan_half_complete_from_isr(1, &higher_priority_task_woken);
+        portYIELD_FROM_ISR(higher_priority_task_woken);
+    }
+}
+#else
+/* Wakes the ADC task blocked in adc_read() */
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
+{
+    BaseType_t higher_priority_task_woken = pdFALSE;
 
-        vTaskDelay(pdMS_TO_TICKS(500));  // Longer delay for low priority task
+    if (hadc->Instance == ADC1)
+    {
+        vTaskNotifyGiveFromISR(adc_task_handle, &higher_priority_task_woken);
+        portYIELD_FROM_ISR(higher_priority_task_woken);
     }
 }
+#endif
 
-/* Raise task priority to the ceiling */
-void raise_priority_to_ceiling(TaskHandle_t task_handle)
+/* Passes the received byte to the Bluetooth task and receives the next one */
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
 {
-    vTaskPrioritySet(task_handle, MUTEX_CEILING_PRIORITY);
+    BaseType_t higher_priority_task_woken = pdFALSE;
+
+    if (huart->Instance == USART2)
+    {
+        xTaskNotifyFromISR(bluetooth_task_handle, rx_buffer[0], eSetValueWithOverwrite,
+                           &higher_priority_task_woken);
+        HAL_UART_Receive_IT(&huart2, rx_buffer, 1);
+        portYIELD_FROM_ISR(higher_priority_task_woken);
+    }
 }
 
-/* Restore task priority after mutex release */
-void restore_task_priority(TaskHandle_t task_handle, UBaseType_t original_priority)
+/* A framing or overrun error ends the reception, so start it again */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
 {
-    vTaskPrioritySet(task_handle, original_priority);
+    if (huart->Instance == USART2)
+    {
+        HAL_UART_Receive_IT(&huart2, rx_buffer, 1);
+    }
+}
+
+/* Called by the kernel when a periodic task misses a deadline.  Runs from the
+ * context switch, so it only latches the blue LED; the per-task counts and
+ * tardiness histograms are read with vTaskGetDeadlineStats(). */
+void vApplicationDeadlineMissHook(TaskHandle_t xTask, DeadlineTime_t xTardiness)
+{
+    (void)xTask;
+    (void)xTardiness;
+    HAL_GPIO_WritePin(GPIOD, GPIO_PIN_15, GPIO_PIN_SET);
 }
+
 /* UART printing function */
 void uart_print(const char* str)
 {
@@ -279,6 +811,7 @@ static void MX_GPIO_Init(void)
     HAL_GPIO_WritePin(GPIOD, GPIO_PIN_12, GPIO_PIN_RESET);
     HAL_GPIO_WritePin(GPIOD, GPIO_PIN_13, GPIO_PIN_RESET);
     HAL_GPIO_WritePin(GPIOD, GPIO_PIN_14, GPIO_PIN_RESET);
+    HAL_GPIO_WritePin(GPIOD, GPIO_PIN_15, GPIO_PIN_RESET);
 
     /* Configure GPIO pin : PD13 */
     GPIO_InitStruct.Pin = GPIO_PIN_13;
@@ -301,6 +834,13 @@ static void MX_GPIO_Init(void)
 	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
 	HAL_GPIO_Init(GPIOD, &GPIO_InitStruct);
 
+    /* Configure GPIO pin : PD15 (deadline miss indicator) */
+    GPIO_InitStruct.Pin = GPIO_PIN_15;
+    GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+    HAL_GPIO_Init(GPIOD, &GPIO_InitStruct);
+
     /* Configure GPIO pin : PA0 */
     GPIO_InitStruct.Pin = GPIO_PIN_0;
     GPIO_InitStruct.Mode = GPIO_MODE_ANALOG;
@@ -308,6 +848,16 @@ static void MX_GPIO_Init(void)
     HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
 }
 
+/* Enable the DMA controller clock and the interrupt of the ADC1 stream */
+static void MX_DMA_Init(void)
+{
+    __HAL_RCC_DMA2_CLK_ENABLE();
+
+    /* DMA2_Stream0_IRQn interrupt configuration */
+    HAL_NVIC_SetPriority(DMA2_Stream0_IRQn, 6, 0);
+    HAL_NVIC_EnableIRQ(DMA2_Stream0_IRQn);
+}
+
 /* Initialize ADC1 */
 static void MX_ADC1_Init(void)
 {
@@ -320,6 +870,34 @@ static void MX_ADC1_Init(void)
     hadc1.Init.ClockPrescaler = ADC_CLOCK_SYNC_PCLK_DIV4;
     hadc1.Init.Resolution = ADC_RESOLUTION_12B;
     hadc1.Init.DataAlign = ADC_DATAALIGN_RIGHT;
+#ifdef ADC_SCAN
+    /* The whole sequence on each TIM3 update, each result taken by the DMA */
+    hadc1.Init.ScanConvMode = ENABLE;
+    hadc1.Init.EOCSelection = ADC_EOC_SEQ_CONV;
+    hadc1.Init.ContinuousConvMode = DISABLE;
+    hadc1.Init.DiscontinuousConvMode = DISABLE;
+    hadc1.Init.NbrOfConversion = ADC_SCAN_CHANNEL_COUNT;
+    hadc1.Init.ExternalTrigConv = ADC_EXTERNALTRIGCONV_T3_TRGO;
+    hadc1.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_RISING;
+    hadc1.Init.DMAContinuousRequests = ENABLE;
+
+    if (HAL_ADC_Init(&hadc1) != HAL_OK)
+    {
+        Error_Handler();
+    }
+
+    for (uint32_t rank = 0; rank < ADC_SCAN_CHANNEL_COUNT; rank++)
+    {
+        sConfig.Channel = adc_scan_channels[rank];
+        sConfig.Rank = rank + 1;
+        sConfig.SamplingTime = ADC_SCAN_SAMPLING_TIME;
+
+        if (HAL_ADC_ConfigChannel(&hadc1, &sConfig) != HAL_OK)
+        {
+            Error_Handler();
+        }
+    }
+#else
     hadc1.Init.ScanConvMode = DISABLE;
     hadc1.Init.EOCSelection = ADC_EOC_SINGLE_CONV;
     hadc1.Init.ContinuousConvMode = DISABLE;
@@ -342,7 +920,51 @@ static void MX_ADC1_Init(void)
     {
         Error_Handler();
     }
+#endif
+}
+
+#ifdef ADC_SCAN
+/* Initialize TIM3 to count microseconds, like TIM5, and to send TRGO at
+ * ADC_SCAN_RATE_HZ.  It is started by adc_scan_start(). */
+static void MX_TIM3_Init(void)
+{
+    TIM_MasterConfigTypeDef sMasterConfig = {0};
+    RCC_ClkInitTypeDef clkconfig;
+    uint32_t timclock;
+    uint32_t latency;
+
+    /* Enable TIM3 clock */
+    __HAL_RCC_TIM3_CLK_ENABLE();
+
+    /* The timers of APB1 run at twice PCLK1 when APB1 is divided */
+    HAL_RCC_GetClockConfig(&clkconfig, &latency);
+    timclock = HAL_RCC_GetPCLK1Freq();
+    if (clkconfig.APB1CLKDivider != RCC_HCLK_DIV1)
+    {
+        timclock *= 2U;
+    }
+
+    htim3.Instance = TIM3;
+    htim3.Init.Prescaler = (timclock / 1000000U) - 1U;
+    htim3.Init.CounterMode = TIM_COUNTERMODE_UP;
+    htim3.Init.Period = (1000000U / ADC_SCAN_RATE_HZ) - 1U;
+    htim3.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    htim3.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+
+    if (HAL_TIM_Base_Init(&htim3) != HAL_OK)
+    {
+        Error_Handler();
+    }
+
+    sMasterConfig.MasterOutputTrigger = TIM_TRGO_UPDATE;
+    sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+
+    if (HAL_TIMEx_MasterConfigSynchronization(&htim3, &sMasterConfig) != HAL_OK)
+    {
+        Error_Handler();
+    }
 }
+#endif
 
 void SystemClock_Config(void)
 {
@@ -0,0 +1,87 @@
+/**
+  ******************************************************************************
+  * @file           : mutex_bench.c
+  * @brief          : Lock/unlock cost benchmark for the priority ceiling mutex.
+  *
+  * Measures one uncontended take/give pair in three variants:
+  *   - a plain mutex,
+  *   - a plain mutex with the ceiling applied by hand through
+  *     vTaskPrioritySet() after the take and before the give,
+  *   - a mutex created with xSemaphoreCreateMutexWithCeiling(), where the
+  *     kernel raises the holder inside the take and drops it on the give.
+  * Each variant is reported as a bench line of bench_common.h, in DWT cycles.
+  ******************************************************************************
+  */
+
+#include "main.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "bench_common.h"
+#include "mutex_bench.h"
+
+#define BENCH_PRIORITY       (tskIDLE_PRIORITY + 1)
+#define CEILING_PRIORITY     (tskIDLE_PRIORITY + 3)
+#define BENCH_STACK_SIZE     256
+
+typedef enum
+{
+    LOCK_PLAIN,
+    LOCK_MANUAL_CEILING,
+    LOCK_KERNEL_CEILING
+} lock_variant_t;
+
+static const char* const variant_names[] = { "mutex_plain", "mutex_manual_ceiling", "mutex_kernel_ceiling" };
+
+static uint32_t samples[BENCH_ITERATIONS];
+
+static void run_variant(lock_variant_t variant, SemaphoreHandle_t mutex)
+{
+    for (uint32_t n = 0; n < BENCH_ITERATIONS; n++)
+    {
+        uint32_t start = bench_timestamp();
+
+        xSemaphoreTake(mutex, portMAX_DELAY);
+        if (variant == LOCK_MANUAL_CEILING)
+        {
+            vTaskPrioritySet(NULL, CEILING_PRIORITY);
+            vTaskPrioritySet(NULL, BENCH_PRIORITY);
+        }
+        xSemaphoreGive(mutex);
+
+        samples[n] = bench_timestamp() - start;
+    }
+
+    bench_report(variant_names[variant], 0, BENCH_UNIT, samples);
+}
+
+static void bench_task(void* parameters)
+{
+    SemaphoreHandle_t plain_mutex;
+    SemaphoreHandle_t ceiling_mutex;
+
+    (void) parameters;
+
+    plain_mutex = xSemaphoreCreateMutex();
+    ceiling_mutex = xSemaphoreCreateMutexWithCeiling(CEILING_PRIORITY);
+    if (plain_mutex == NULL || ceiling_mutex == NULL)
+    {
+        Error_Handler();
+    }
+
+    bench_timer_init();
+
+    run_variant(LOCK_PLAIN, plain_mutex);
+    run_variant(LOCK_MANUAL_CEILING, plain_mutex);
+    run_variant(LOCK_KERNEL_CEILING, ceiling_mutex);
+
+    vTaskSuspend(NULL);
+}
+
+void mutex_bench_start(void)
+{
+    if (xTaskCreate(bench_task, "MtxBench", BENCH_STACK_SIZE, NULL, BENCH_PRIORITY, NULL) != pdPASS)
+    {
+        Error_Handler();
+    }
+}
@@ -20,19 +20,26 @@
 /* Includes ------------------------------------------------------------------*/
 #include "stm32f4xx_hal.h"
 #include "stm32f4xx_hal_tim.h"
+#include "timebase.h"
 
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
+/* Number of 1MHz counts between two HAL ticks */
+#define TIMEBASE_US_PER_TICK     (1000000U / 1000U)
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
 TIM_HandleTypeDef        htim5;
+/* Upper 32 bits of the microsecond time, counted by the TIM5 update interrupt */
+static volatile uint32_t uwTimebaseOverflows = 0U;
 /* Private function prototypes -----------------------------------------------*/
 /* Private functions ---------------------------------------------------------*/
 
 /**
   * @brief  This function configures the TIM5 as a time base source.
-  *         The time source is configured  to have 1ms time base with a dedicated
-  *         Tick interrupt priority.
+  *         TIM5 is a free running 32-bit counter at 1MHz.  Its update interrupt
+  *         extends it to the 64-bit time returned by timebase_get_us(), and
+  *         compare channel 1 generates the 1ms HAL tick with a dedicated Tick
+  *         interrupt priority.
   * @note   This function is called  automatically at the beginning of program after
   *         reset by HAL_Init() or at any time when clock is configured, by HAL_RCC_ClockConfig().
   * @param  TickPriority: Tick interrupt priority.
@@ -71,12 +78,12 @@ HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority)
 
   /* Initialize TIMx peripheral as follow:
 
-  + Period = [(TIM5CLK/1000) - 1]. to have a (1/1000) s time base.
+  + Period = 0xFFFFFFFF so the counter runs over its full 32-bit range.
   + Prescaler = (uwTimclock/1000000 - 1) to have a 1MHz counter clock.
   + ClockDivision = 0
   + Counter direction = Up
   */
-  htim5.Init.Period = (1000000U / 1000U) - 1U;
+  htim5.Init.Period = 0xFFFFFFFFU;
   htim5.Init.Prescaler = uwPrescalerValue;
   htim5.Init.ClockDivision = 0;
   htim5.Init.CounterMode = TIM_COUNTERMODE_UP;
@@ -85,9 +92,28 @@ HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority)
   status = HAL_TIM_Base_Init(&htim5);
   if (status == HAL_OK)
   {
+    TIM_OC_InitTypeDef sConfigOC = {0};
+
+    /* Channel 1 only raises an interrupt, the 1ms tick, and drives no pin */
+    sConfigOC.OCMode = TIM_OCMODE_TIMING;
+    sConfigOC.Pulse = TIMEBASE_US_PER_TICK;
+    sConfigOC.OCPolarity = TIM_OCPOLARITY_HIGH;
+    sConfigOC.OCFastMode = TIM_OCFAST_DISABLE;
+    status = HAL_TIM_OC_ConfigChannel(&htim5, &sConfigOC, TIM_CHANNEL_1);
+  }
+  if (status == HAL_OK)
+  {
+    /* The init generated an update event that is not an overflow */
+    __HAL_TIM_CLEAR_FLAG(&htim5, TIM_FLAG_UPDATE);
+    uwTimebaseOverflows = 0U;
+
     /* Start the TIM time Base generation in interrupt mode */
     status = HAL_TIM_Base_Start_IT(&htim5);
     if (status == HAL_OK)
+    {
+      status = HAL_TIM_OC_Start_IT(&htim5, TIM_CHANNEL_1);
+    }
+    if (status == HAL_OK)
     {
     /* Enable the TIM5 global Interrupt */
         HAL_NVIC_EnableIRQ(TIM5_IRQn);
@@ -111,25 +137,125 @@ HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority)
 
 /**
   * @brief  Suspend Tick increment.
-  * @note   Disable the tick increment by disabling TIM5 update interrupt.
+  * @note   Disable the tick increment by disabling TIM5 channel 1 interrupt.
+  *         The update interrupt is left running so the time base stays valid.
   * @param  None
   * @retval None
   */
 void HAL_SuspendTick(void)
 {
-  /* Disable TIM5 update Interrupt */
-  __HAL_TIM_DISABLE_IT(&htim5, TIM_IT_UPDATE);
+  /* Disable TIM5 Capture/Compare 1 Interrupt */
+  __HAL_TIM_DISABLE_IT(&htim5, TIM_IT_CC1);
 }
 
 /**
   * @brief  Resume Tick increment.
-  * @note   Enable the tick increment by Enabling TIM5 update interrupt.
+  * @note   Enable the tick increment by Enabling TIM5 channel 1 interrupt.
   * @param  None
   * @retval None
   */
 void HAL_ResumeTick(void)
 {
-  /* Enable TIM5 Update interrupt */
-  __HAL_TIM_ENABLE_IT(&htim5, TIM_IT_UPDATE);
+  /* Restart the tick period from now rather than catching up missed ticks */
+  __HAL_TIM_SET_COMPARE(&htim5, TIM_CHANNEL_1, __HAL_TIM_GET_COUNTER(&htim5) + TIMEBASE_US_PER_TICK);
+  /* Enable TIM5 Capture/Compare 1 interrupt */
+  __HAL_TIM_ENABLE_IT(&htim5, TIM_IT_CC1);
+}
+
+/**
+  * @brief  Read the 64-bit microsecond time.
+  * @note   The upper word is re-read until no update interrupt has changed it
+  *         during the read.  If the counter has wrapped but the update
+  *         interrupt is masked, the pending flag accounts for the overflow.
+  * @param  None
+  * @retval Microseconds since the time base was started.
+  */
+uint64_t timebase_get_us(void)
+{
+  uint32_t high;
+  uint32_t low;
+  uint32_t pending;
+
+  do
+  {
+    high = uwTimebaseOverflows;
+    low = TIM5->CNT;
+    pending = TIM5->SR & TIM_SR_UIF;
+  } while (high != uwTimebaseOverflows);
+
+  /* The flag may have been set just after a count close to the top was read,
+   * in which case that count belongs to the old upper word */
+  if ((pending != 0U) && (low < 0x80000000U))
+  {
+    high++;
+  }
+
+  return ((uint64_t)high << 32) | low;
+}
+
+/**
+  * @brief  Set the one-shot alarm on TIM5 compare channel 2.
+  * @note   The compare only matches the low word of the time, so the alarm
+  *         is forced with a software compare event if the time has already
+  *         passed, including while the compare was being written.
+  * @param  time_us Time at which timebase_alarm_callback() is called.
+  * @retval None
+  */
+void timebase_set_alarm(uint64_t time_us)
+{
+  __HAL_TIM_SET_COMPARE(&htim5, TIM_CHANNEL_2, (uint32_t)time_us);
+  __HAL_TIM_CLEAR_FLAG(&htim5, TIM_FLAG_CC2);
+  __HAL_TIM_ENABLE_IT(&htim5, TIM_IT_CC2);
+
+  if (timebase_get_us() >= time_us)
+  {
+    htim5.Instance->EGR = TIM_EGR_CC2G;
+  }
+}
+
+/**
+  * @brief  Alarm callback, called by TIM5 channel 2 when the alarm fires.
+  * @note   This function should not be modified, when the callback is needed,
+  *         timebase_alarm_callback() could be implemented in the user file.
+  * @param  None
+  * @retval None
+  */
+__weak void timebase_alarm_callback(void)
+{
+}
+
+/**
+  * @brief  Period elapsed callback, called on each TIM5 counter overflow.
+  * @param  htim TIM handle
+  * @retval None
+  */
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
+{
+  if (htim->Instance == TIM5)
+  {
+    uwTimebaseOverflows++;
+  }
+}
+
+/**
+  * @brief  Output compare callback, called every 1ms by TIM5 channel 1 and
+  *         by channel 2 when the alarm fires.
+  * @param  htim TIM handle
+  * @retval None
+  */
+void HAL_TIM_OC_DelayElapsedCallback(TIM_HandleTypeDef *htim)
+{
+  if ((htim->Instance == TIM5) && (htim->Channel == HAL_TIM_ACTIVE_CHANNEL_2))
+  {
+    /* The alarm is one-shot, the callback sets the next one */
+    __HAL_TIM_DISABLE_IT(htim, TIM_IT_CC2);
+    timebase_alarm_callback();
+  }
+  else if (htim->Instance == TIM5)
+  {
+    /* Advance the compare by one period; the 32-bit sum wraps with the counter */
+    __HAL_TIM_SET_COMPARE(htim, TIM_CHANNEL_1, __HAL_TIM_GET_COMPARE(htim, TIM_CHANNEL_1) + TIMEBASE_US_PER_TICK);
+    HAL_IncTick();
+  }
 }
 
@@ -0,0 +1,230 @@
+/**
+  ******************************************************************************
+  * @file           : trace_recorder.c
+  * @brief          : Binary scheduling trace recorder.
+  *
+  * Events are written with interrupts masked so that the kernel, interrupt
+  * handlers and tasks can all record into the same buffer.  Recording an
+  * event is a timer read and an 8 byte store; the names of the tasks are
+  * kept in a table next to the records so that a snapshot can still name
+  * tasks whose creation has been overwritten.
+  ******************************************************************************
+  */
+
+#include "main.h"
+#include "string.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* trace_recorder.h is included by FreeRTOSConfig.h */
+#if ( configUSE_TRACE_RECORDER == 1 )
+
+#define TRACE_STREAM_STACK_SIZE    128
+#define TRACE_STREAM_PERIOD_MS     10
+#define TRACE_TIMESTAMP_HZ         1000000UL
+
+/* Not static so that the debugger can dump it by name */
+trace_buffer_t trace_buffer;
+
+static uint8_t queue_count;
+
+typedef char trace_record_size_check[(sizeof(trace_record_t) == 8) ? 1 : -1];
+
+static void trace_write(uint8_t event, uint8_t object, uint16_t data, uint32_t timestamp)
+{
+    trace_header_t* header = &trace_buffer.header;
+    trace_record_t* record;
+
+    if ((header->mode == TRACE_MODE_STREAMING) &&
+        ((header->write_index - header->read_index) >= TRACE_BUFFER_RECORDS))
+    {
+        header->dropped++;
+        return;
+    }
+
+    record = &trace_buffer.records[header->write_index & (TRACE_BUFFER_RECORDS - 1)];
+    record->timestamp = timestamp;
+    record->event = event;
+    record->object = object;
+    record->data = data;
+    header->write_index++;
+}
+
+void trace_record(uint8_t event, uint8_t object, uint16_t data)
+{
+    uint32_t primask;
+
+    if (!trace_buffer.header.running)
+    {
+        return;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    trace_write(event, object, data, TIM5->CNT);
+    __set_PRIMASK(primask);
+}
+
+void trace_task_create(uint8_t task, uint16_t priority, const char* name)
+{
+    uint32_t primask;
+    uint32_t i;
+
+    if (task < TRACE_MAX_TASKS)
+    {
+        strncpy(trace_buffer.task_names[task], name, TRACE_TASK_NAME_LEN - 1);
+    }
+
+    if (!trace_buffer.header.running)
+    {
+        return;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    trace_write(TRACE_EVENT_TASK_CREATE, task, priority, TIM5->CNT);
+
+    /* The name follows in records of 6 characters for the streaming decoder */
+    for (i = 0; i < configMAX_TASK_NAME_LEN; i += 6)
+    {
+        char chunk[6] = {0};
+
+        strncpy(chunk, &name[i], sizeof(chunk));
+        trace_write(TRACE_EVENT_TASK_NAME, task,
+                    (uint16_t)((uint8_t)chunk[4] | ((uint8_t)chunk[5] << 8)),
+                    (uint32_t)(uint8_t)chunk[0] | ((uint32_t)(uint8_t)chunk[1] << 8) |
+                    ((uint32_t)(uint8_t)chunk[2] << 16) | ((uint32_t)(uint8_t)chunk[3] << 24));
+        if (memchr(chunk, '\0', sizeof(chunk)) != NULL)
+        {
+            break;
+        }
+    }
+    __set_PRIMASK(primask);
+}
+
+uint8_t trace_queue_create(uint8_t queue_type)
+{
+    uint8_t queue = ++queue_count;
+
+    trace_record(TRACE_EVENT_QUEUE_CREATE, queue, queue_type);
+    return queue;
+}
+
+void trace_isr_enter(void)
+{
+    trace_record(TRACE_EVENT_ISR_ENTER, 0, (uint16_t)__get_IPSR());
+}
+
+void trace_isr_exit(void)
+{
+    trace_record(TRACE_EVENT_ISR_EXIT, 0, (uint16_t)__get_IPSR());
+}
+
+void trace_start(trace_mode_t mode)
+{
+    trace_header_t* header = &trace_buffer.header;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    header->magic = TRACE_MAGIC;
+    header->version = TRACE_VERSION;
+    header->record_size = sizeof(trace_record_t);
+    header->capacity = TRACE_BUFFER_RECORDS;
+    header->write_index = 0;
+    header->read_index = 0;
+    header->dropped = 0;
+    header->timestamp_hz = TRACE_TIMESTAMP_HZ;
+    header->mode = mode;
+    header->max_tasks = TRACE_MAX_TASKS;
+    header->name_len = TRACE_TASK_NAME_LEN;
+    header->running = 1;
+    __set_PRIMASK(primask);
+}
+
+void trace_stop(void)
+{
+    trace_buffer.header.running = 0;
+}
+
+/**
+  * @brief  Sends the recorded events on the trace UART
+  * @param  parameters: UART handle
+  * @retval None
+  */
+static void trace_stream_task(void* parameters)
+{
+    UART_HandleTypeDef* huart = parameters;
+    trace_header_t* header = &trace_buffer.header;
+    uint32_t reported_drops = 0;
+    uint32_t last_timestamp = 0;
+
+    /* The decoder reads the header and the name table first */
+    HAL_UART_Transmit(huart, (uint8_t*)&trace_buffer,
+                      sizeof(trace_buffer.header) + sizeof(trace_buffer.task_names), HAL_MAX_DELAY);
+
+    while (1)
+    {
+        uint32_t read_index = header->read_index;
+        uint32_t write_index;
+        uint32_t dropped;
+        uint32_t primask;
+
+        /* Events are only dropped while the ring is full, so those counted
+         * here were lost after every record written so far */
+        primask = __get_PRIMASK();
+        __disable_irq();
+        write_index = header->write_index;
+        dropped = header->dropped;
+        __set_PRIMASK(primask);
+
+        if ((write_index == read_index) && (dropped == reported_drops))
+        {
+            vTaskDelay(pdMS_TO_TICKS(TRACE_STREAM_PERIOD_MS));
+            continue;
+        }
+
+        /* Up to the end of the ring, then from its start */
+        while (read_index != write_index)
+        {
+            uint32_t start = read_index & (TRACE_BUFFER_RECORDS - 1);
+            uint32_t pending = write_index - read_index;
+
+            if (pending > TRACE_BUFFER_RECORDS - start)
+            {
+                pending = TRACE_BUFFER_RECORDS - start;
+            }
+            HAL_UART_Transmit(huart, (uint8_t*)&trace_buffer.records[start],
+                              pending * sizeof(trace_record_t), HAL_MAX_DELAY);
+            last_timestamp = trace_buffer.records[start + pending - 1].timestamp;
+            read_index += pending;
+            header->read_index = read_index;
+        }
+
+        /* After the records sent and with the time of the last one, so the
+         * timestamps never go back, which the decoder would take as a wrap */
+        if (dropped != reported_drops)
+        {
+            trace_record_t marker = {
+                .timestamp = last_timestamp,
+                .event = TRACE_EVENT_DROPPED,
+                .data = (uint16_t)(dropped - reported_drops)
+            };
+
+            reported_drops = dropped;
+            HAL_UART_Transmit(huart, (uint8_t*)&marker, sizeof(marker), HAL_MAX_DELAY);
+        }
+    }
+}
+
+void trace_stream_start(struct __UART_HandleTypeDef* huart, uint32_t priority)
+{
+    trace_start(TRACE_MODE_STREAMING);
+
+    if (xTaskCreate(trace_stream_task, "TraceTask", TRACE_STREAM_STACK_SIZE, huart,
+                    priority, NULL) != pdPASS)
+    {
+        Error_Handler();
+    }
+}
+
+#endif /* configUSE_TRACE_RECORDER */
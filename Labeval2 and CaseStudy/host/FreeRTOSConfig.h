@@ -28,46 +28,64 @@
 #ifndef FREERTOS_CONFIG_H
 #define FREERTOS_CONFIG_H
 
-#define configTOTAL_HEAP_SIZE ((size_t)(8 * 1024))  // Set to 8KB, adjust based on your requirements
-
 /*-----------------------------------------------------------
- * Application specific definitions.
- *
- * These definitions should be adjusted for your particular hardware and
- * application requirements.
- *
- * THESE PARAMETERS ARE DESCRIBED WITHIN THE 'CONFIGURATION' SECTION OF THE
- * FreeRTOS API DOCUMENTATION AVAILABLE ON THE FreeRTOS.org WEB SITE.
+ * Configuration of the host build.
  *
- * See http://www.freertos.org/a00110.html
+ * The kernel features match thirdparty/FreeRTOS/Source/include/FreeRTOSConfig.h
+ * so that the same scheduler code runs on the host as on the board.  Only the
+ * port specific settings differ.
  *----------------------------------------------------------*/
 
-/* Ensure stdint is only used by the compiler, and not the assembler. */
-#ifdef __GNUC__
-	#include <stdint.h>
-	extern uint32_t SystemCoreClock;
-#endif
+#include <stdint.h>
+#include <stdlib.h>
+extern uint64_t timebase_get_us( void );
 
 #define configUSE_PREEMPTION			1
-#define configUSE_IDLE_HOOK				0
+#define configUSE_TIME_SLICING          1
+#define configSCHEDULING_POLICY		SCHEDULING_POLICY_HYBRID
+#define configEDF_PRIORITY_BANDS	( 1UL << 2 )
+#define configUSE_EDF_ADMISSION_CONTROL	1
+#define configUSE_EDF_MICROSECOND_TIME	1
+#define portGET_DEADLINE_TIME()			timebase_get_us()
+#define configUSE_DEADLINE_MISS_DETECTION	1
+#define configUSE_DEADLINE_MISS_HOOK	1
+#define configTARDINESS_HISTOGRAM_BUCKETS	16
+#define configUSE_SRP					1
+#define configUSE_CBS					1
+#define configUSE_TIME_TRIGGERED		1
+
+/* The port advances virtual time from the idle hook, see host/port/port.c. */
+#define configUSE_IDLE_HOOK				1
 #define configUSE_TICK_HOOK				0
-#define configCPU_CLOCK_HZ				( SystemCoreClock )
+#define configCPU_CLOCK_HZ				( 84000000UL )
 #define configTICK_RATE_HZ				( ( TickType_t ) 1000 )
 #define configMAX_PRIORITIES			( 5 )
 #define configMINIMAL_STACK_SIZE		( ( unsigned short ) 130 )
-#define configTOTAL_HEAP_SIZE			( ( size_t ) ( 75 * 1024 ) )
+#define configTOTAL_HEAP_SIZE			( ( size_t ) ( 48 * 1024 ) )
 #define configMAX_TASK_NAME_LEN			( 10 )
 #define configUSE_TRACE_FACILITY		1
 #define configUSE_16_BIT_TICKS			0
 #define configIDLE_SHOULD_YIELD			1
 #define configUSE_MUTEXES				1
+#define configUSE_MUTEX_CEILING			1
 #define configQUEUE_REGISTRY_SIZE		8
 #define configCHECK_FOR_STACK_OVERFLOW	0
 #define configUSE_RECURSIVE_MUTEXES		1
 #define configUSE_MALLOC_FAILED_HOOK	0
 #define configUSE_APPLICATION_TASK_TAG	0
 #define configUSE_COUNTING_SEMAPHORES	1
-#define configGENERATE_RUN_TIME_STATS	0
+#define configGENERATE_RUN_TIME_STATS	1
+#define configUSE_JOB_STATS				1
+
+/* The kernel objects are shared by the host programs, so the pools have room
+for the TCBs of the benchmark, which are 392 bytes with 64-bit pointers. */
+#define configUSE_POOL_ALLOCATOR		1
+#define configTCB_FROM_POOL				1
+#define configPOOL_CLASSES( X )			X( 32, 16 ) X( 128, 8 ) X( 512, 24 )
+
+#define configRUN_TIME_COUNTER_TYPE		uint64_t
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()	timebase_get_us()
 
 
 /* Software timer definitions. */
@@ -86,40 +104,10 @@ to exclude the API function. */
 #define INCLUDE_vTaskDelayUntil			1
 #define INCLUDE_vTaskDelay				1
 
-/* Cortex-M specific definitions. */
-#ifdef __NVIC_PRIO_BITS
-	/* __BVIC_PRIO_BITS will be specified when CMSIS is being used. */
-	#define configPRIO_BITS       		__NVIC_PRIO_BITS
-#else
-	#define configPRIO_BITS       		4        /* 15 priority levels */
-#endif
+/* Stop at the first failed assertion instead of spinning. */
+#define configASSERT( x ) if( ( x ) == 0 ) { abort(); }
 
-/* The lowest interrupt priority that can be used in a call to a "set priority"
-function. */
-#define configLIBRARY_LOWEST_INTERRUPT_PRIORITY			0xf
-
-/* The highest interrupt priority that can be used by any interrupt service
-routine that makes calls to interrupt safe FreeRTOS API functions.  DO NOT CALL
-INTERRUPT SAFE FREERTOS API FUNCTIONS FROM ANY INTERRUPT THAT HAS A HIGHER
-PRIORITY THAN THIS! (higher priorities are lower numeric values. */
-#define configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY	5
-
-/* Interrupt priorities used by the kernel port layer itself.  These are generic
-to all Cortex-M ports, and do not rely on any particular library functions. */
-#define configKERNEL_INTERRUPT_PRIORITY 		( configLIBRARY_LOWEST_INTERRUPT_PRIORITY << (8 - configPRIO_BITS) )
-/* !!!! configMAX_SYSCALL_INTERRUPT_PRIORITY must not be set to zero !!!!
-See http://www.FreeRTOS.org/RTOS-Cortex-M3-M4.html. */
-#define configMAX_SYSCALL_INTERRUPT_PRIORITY 	( configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY << (8 - configPRIO_BITS) )
-
-/* Normal assert() semantics without relying on the provision of an assert.h
-header file. */
-#define configASSERT( x ) if( ( x ) == 0 ) { taskDISABLE_INTERRUPTS(); for( ;; ); }
-
-/* Definitions that map the FreeRTOS port interrupt handlers to their CMSIS
-standard names. */
-#define vPortSVCHandler SVC_Handler
-#define xPortPendSVHandler PendSV_Handler
-#define xPortSysTickHandler SysTick_Handler
+/* The binary trace recorder reads TIM5 and is not built on the host. */
+#define configUSE_TRACE_RECORDER		0
 
 #endif /* FREERTOS_CONFIG_H */
-
@@ -0,0 +1,94 @@
+/**
+  ******************************************************************************
+  * @file           : app_main.c
+  * @brief          : The board application on the STM32 peripheral model.
+  *
+  * Runs Core/Src/main.c with the HAL drivers and the CMSIS device headers,
+  * unmodified, on the host port and the register level model in stm32/.
+  * The application's own main() is built as board_main() and called after
+  * what the reset handler does.  The USART2 output of the application goes
+  * to stdout; the Bluetooth commands arrive on USART2 at fixed virtual times,
+  * with an 's' that makes the application print its statistics.
+  *
+  * At the end the model prints the processor time spent accessing each
+  * peripheral and the part of it spent polling, which is what the blocking
+  * HAL drivers cost at the clock configuration of SystemClock_Config().
+  *
+  *     build/app [-v] [seconds]
+  *
+  * -v prints every context switch and GPIO output change; the default
+  * length is 10 seconds.
+  ******************************************************************************
+  */
+
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "stm32f4xx.h"
+#include "stm32_model.h"
+
+#define NS_PER_SECOND          1000000000ULL
+
+/* The Bluetooth input on USART2 */
+typedef struct
+{
+    uint64_t time_ns;
+    const char* bytes;
+} BluetoothInput_t;
+
+static const BluetoothInput_t bluetooth_input[] =
+{
+    { 1250000000ULL, "?" },
+    { 2500000000ULL, "??" },
+    { 4000000000ULL, "s" },
+    { 8750000000ULL, "?" },
+};
+
+static uint64_t seconds = 10;
+
+/* Core/Src/main.c, renamed by the Makefile */
+int board_main(void);
+
+static void print_report(void)
+{
+    fflush(stdout);
+    printf("\n--- %llu s of virtual time\n", (unsigned long long)seconds);
+    stm32_model_print_profile(stdout);
+    printf("context switches %llu\n", (unsigned long long)ullPortGetContextSwitches());
+    printf("schedule hash %016llx\n", (unsigned long long)ullPortGetScheduleHash());
+
+    /* board_main() never returns */
+    exit(EXIT_SUCCESS);
+}
+
+int main(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-v") == 0)
+        {
+            vPortLogSchedule(pdTRUE);
+            stm32_model_log(1);
+        }
+        else
+        {
+            seconds = strtoull(argv[i], NULL, 10);
+        }
+    }
+
+    stm32_model_init();
+    SystemInit();
+
+    for (unsigned i = 0; i < sizeof(bluetooth_input) / sizeof(bluetooth_input[0]); i++)
+    {
+        stm32_model_uart_receive(USART2, bluetooth_input[i].time_ns, bluetooth_input[i].bytes,
+                                 strlen(bluetooth_input[i].bytes));
+    }
+
+    vPortSetSimulationEnd(seconds * NS_PER_SECOND);
+    vPortSetSimulationEndHook(print_report);
+
+    return board_main();
+}
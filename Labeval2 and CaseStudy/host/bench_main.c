@@ -0,0 +1,49 @@
+/**
+  ******************************************************************************
+  * @file           : bench_main.c
+  * @brief          : Host entry point of the kernel benchmark suite.
+  *
+  * Stands in for main.c: starts the suite of Core/Src/kernel_bench.c, or
+  * of Core/Src/dsp_bench.c when built with DSP_BENCHMARK, on the host port
+  * and provides the functions the suite takes from the board application.
+  * The results go to stdout.
+  ******************************************************************************
+  */
+
+#include "stdio.h"
+#include "stdlib.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "kernel_bench.h"
+#include "dsp_bench.h"
+
+void uart_print(const char* str)
+{
+    fputs(str, stdout);
+}
+
+void Error_Handler(void)
+{
+    fprintf(stderr, "benchmark failed\n");
+    exit(EXIT_FAILURE);
+}
+
+void vApplicationDeadlineMissHook(TaskHandle_t xTask, DeadlineTime_t xTardiness)
+{
+    (void)xTask;
+    (void)xTardiness;
+}
+
+int main(void)
+{
+#ifdef DSP_BENCHMARK
+    dsp_bench_start();
+#else
+    kernel_bench_start();
+#endif
+
+    /* Returns when the suite ends the scheduler */
+    vTaskStartScheduler();
+
+    return 0;
+}
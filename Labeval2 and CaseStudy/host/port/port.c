@@ -0,0 +1,591 @@
+/*
+ * FreeRTOS Kernel V10.5.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/*-----------------------------------------------------------
+* Implementation of functions defined in portable.h for the single threaded
+* virtual time host port.
+*----------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* The kernel stack of a task only holds a pointer to its host thread; the
+ * code of the task runs on a host stack large enough for the C library. */
+#define portHOST_STACK_SIZE              ( 256 * 1024 )
+
+#define portNANOSECONDS_PER_TICK         ( 1000000000ULL / configTICK_RATE_HZ )
+#define portMAX_SCHEDULED_INTERRUPTS     64
+#define portNO_EVENT                     UINT64_MAX
+
+/* FNV-1a, folds the schedule into ullScheduleHash. */
+#define portHASH_OFFSET_BASIS            14695981039346656037ULL
+#define portHASH_PRIME                   1099511628211ULL
+
+typedef struct HostThread
+{
+    ucontext_t xContext;
+    void * pvStack;
+    TaskFunction_t pxCode;
+    void * pvParameters;
+} HostThread_t;
+
+typedef struct ScheduledInterrupt
+{
+    uint64_t ullTimeNs;
+    void ( * pvHandler )( void );
+} ScheduledInterrupt_t;
+
+/* The context of the caller of vTaskStartScheduler(), resumed by
+ * vPortEndScheduler(). */
+static ucontext_t xSchedulerContext;
+
+/* Interrupts are masked while this is not zero.  As on the Cortex-M4 they are
+ * enabled out of reset, and the first critical section entered before the
+ * scheduler starts leaves them masked until it does. */
+static UBaseType_t uxCriticalNesting = 0xaaaaaaaa;
+static BaseType_t xInterruptsMasked = pdFALSE;
+static BaseType_t xInsideInterrupt = pdFALSE;
+
+/* The equivalent of PRIMASK, set by __disable_irq() in the peripheral model
+ * build.  Masks everything, independently of the critical sections. */
+static uint32_t ulPrimask = 0;
+static BaseType_t xSchedulerStarted = pdFALSE;
+
+/* Set when a switch was requested while it could not be taken, the
+ * equivalent of a pended PendSV. */
+static BaseType_t xSwitchPending = pdFALSE;
+
+/* Virtual time only moves in vPortExecute() and in the idle task, so a run
+ * depends on nothing but the program and its inputs. */
+static uint64_t ullVirtualTimeNs = 0;
+static uint64_t ullNextTickNs = portNO_EVENT;
+static uint64_t ullSimulationEndNs = portNO_EVENT;
+
+/* Pending interrupts in time order; equal times keep the order they were
+ * scheduled in. */
+static ScheduledInterrupt_t xScheduledInterrupts[ portMAX_SCHEDULED_INTERRUPTS ];
+static UBaseType_t uxScheduledInterrupts = 0;
+
+static void ( * pvSimulationEndHook )( void ) = NULL;
+
+static BaseType_t xLogSchedule = pdFALSE;
+static uint64_t ullContextSwitches = 0;
+static uint64_t ullScheduleHash = portHASH_OFFSET_BASIS;
+
+/*-----------------------------------------------------------*/
+
+static HostThread_t * prvGetThread( void * pxTCB )
+{
+    /* pxTopOfStack is the first member of the TCB and points at the slot
+     * pxPortInitialiseStack() stored the thread in. */
+    StackType_t * pxTopOfStack = *( ( StackType_t ** ) pxTCB );
+
+    return ( HostThread_t * ) *pxTopOfStack;
+}
+/*-----------------------------------------------------------*/
+
+static void prvHash( const void * pvData,
+                     size_t xLength )
+{
+    const uint8_t * pucData = pvData;
+
+    while( xLength-- > 0 )
+    {
+        ullScheduleHash = ( ullScheduleHash ^ *pucData++ ) * portHASH_PRIME;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvRecordSwitch( void )
+{
+    const char * pcName = pcTaskGetName( NULL );
+    size_t xLength = 0;
+
+    while( pcName[ xLength ] != '\0' )
+    {
+        xLength++;
+    }
+
+    ullContextSwitches++;
+    prvHash( &ullVirtualTimeNs, sizeof( ullVirtualTimeNs ) );
+    prvHash( pcName, xLength );
+
+    if( xLogSchedule != pdFALSE )
+    {
+        printf( "%4llu.%06llu %s\n", ( unsigned long long ) ( ullVirtualTimeNs / 1000000000ULL ),
+                ( unsigned long long ) ( ( ullVirtualTimeNs / 1000ULL ) % 1000000ULL ), pcName );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvTaskEntry( void )
+{
+    HostThread_t * pxThread = prvGetThread( xTaskGetCurrentTaskHandle() );
+
+    pxThread->pxCode( pxThread->pvParameters );
+
+    /* Tasks must not return; delete it as the Cortex-M4 port would trap. */
+    vTaskDelete( NULL );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvInterruptsEnabled( void )
+{
+    return ( xInterruptsMasked == pdFALSE ) && ( ulPrimask == 0 ) && ( xInsideInterrupt == pdFALSE );
+}
+/*-----------------------------------------------------------*/
+
+static void prvSwitchContext( void )
+{
+    HostThread_t * pxFrom = prvGetThread( xTaskGetCurrentTaskHandle() );
+    HostThread_t * pxTo;
+
+    /* PendSV runs with interrupts masked up to the kernel priority; nothing
+     * may run in the middle of vTaskSwitchContext(). */
+    xSwitchPending = pdFALSE;
+    xInterruptsMasked = pdTRUE;
+    vTaskSwitchContext();
+    xInterruptsMasked = pdFALSE;
+    pxTo = prvGetThread( xTaskGetCurrentTaskHandle() );
+
+    if( pxTo != pxFrom )
+    {
+        prvRecordSwitch();
+        swapcontext( &( pxFrom->xContext ), &( pxTo->xContext ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvEndSimulation( void )
+{
+    if( pvSimulationEndHook != NULL )
+    {
+        pvSimulationEndHook();
+    }
+
+    vTaskEndScheduler();
+}
+/*-----------------------------------------------------------*/
+
+static void prvTickHandler( void )
+{
+    if( xTaskIncrementTick() != pdFALSE )
+    {
+        portYIELD_FROM_ISR( pdTRUE );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t prvNextEventTime( void )
+{
+    uint64_t ullNext = ullNextTickNs;
+
+    if( ( uxScheduledInterrupts > 0 ) && ( xScheduledInterrupts[ 0 ].ullTimeNs < ullNext ) )
+    {
+        ullNext = xScheduledInterrupts[ 0 ].ullTimeNs;
+    }
+
+    return ullNext;
+}
+/*-----------------------------------------------------------*/
+
+/* Runs the tick and the scheduled interrupts that are due, in time order with
+ * the tick first.  A handler can switch to another task, which then carries on
+ * with the interrupts that are still due.  Before the scheduler starts the
+ * interrupts run on the stack of main(), there is no tick yet. */
+static void prvRunDueInterrupts( void )
+{
+    while( ( prvInterruptsEnabled() != pdFALSE ) &&
+           ( prvNextEventTime() <= ullVirtualTimeNs ) )
+    {
+        if( ullNextTickNs <= prvNextEventTime() )
+        {
+            ullNextTickNs += portNANOSECONDS_PER_TICK;
+            vPortGenerateSimulatedInterrupt( prvTickHandler );
+        }
+        else
+        {
+            void ( * pvHandler )( void ) = xScheduledInterrupts[ 0 ].pvHandler;
+            UBaseType_t ux;
+
+            uxScheduledInterrupts--;
+
+            for( ux = 0; ux < uxScheduledInterrupts; ux++ )
+            {
+                xScheduledInterrupts[ ux ] = xScheduledInterrupts[ ux + 1 ];
+            }
+
+            vPortGenerateSimulatedInterrupt( pvHandler );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+StackType_t * pxPortInitialiseStack( StackType_t * pxTopOfStack,
+                                     TaskFunction_t pxCode,
+                                     void * pvParameters )
+{
+    HostThread_t * pxThread = malloc( sizeof( HostThread_t ) );
+    int iFlags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+    #ifdef MAP_32BIT
+
+        /* Drivers store buffer addresses in 32-bit registers, as DMA address
+         * registers, so anything on a task stack must have a 32-bit address
+         * for the peripheral model.  The program is linked without PIE for
+         * the same reason. */
+        iFlags |= MAP_32BIT;
+    #endif
+
+    configASSERT( pxThread != NULL );
+    pxThread->pvStack = mmap( NULL, portHOST_STACK_SIZE, PROT_READ | PROT_WRITE, iFlags, -1, 0 );
+    configASSERT( pxThread->pvStack != MAP_FAILED );
+    pxThread->pxCode = pxCode;
+    pxThread->pvParameters = pvParameters;
+
+    getcontext( &( pxThread->xContext ) );
+    pxThread->xContext.uc_stack.ss_sp = pxThread->pvStack;
+    pxThread->xContext.uc_stack.ss_size = portHOST_STACK_SIZE;
+    pxThread->xContext.uc_link = NULL;
+    makecontext( &( pxThread->xContext ), prvTaskEntry, 0 );
+
+    pxTopOfStack--;
+    *pxTopOfStack = ( StackType_t ) pxThread;
+
+    return pxTopOfStack;
+}
+/*-----------------------------------------------------------*/
+
+void vPortCleanUpTCB( void * pxTCB )
+{
+    HostThread_t * pxThread = prvGetThread( pxTCB );
+
+    /* Only called for tasks that are not running, from the idle task or from
+     * the task that deleted them. */
+    munmap( pxThread->pvStack, portHOST_STACK_SIZE );
+    free( pxThread );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortStartScheduler( void )
+{
+    ullNextTickNs = ullVirtualTimeNs + portNANOSECONDS_PER_TICK;
+
+    /* The first task starts with interrupts enabled.  A switch requested by
+     * an interrupt before now is replaced by the start of the first task. */
+    uxCriticalNesting = 0;
+    xInterruptsMasked = pdFALSE;
+    xSwitchPending = pdFALSE;
+    xSchedulerStarted = pdTRUE;
+
+    prvRecordSwitch();
+    swapcontext( &xSchedulerContext, &( prvGetThread( xTaskGetCurrentTaskHandle() )->xContext ) );
+
+    /* Back here from vPortEndScheduler(). */
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+void vPortEndScheduler( void )
+{
+    /* main() carries on without the scheduler, so nothing may run. */
+    xSchedulerStarted = pdFALSE;
+    uxCriticalNesting = 0xaaaaaaaa;
+    xInterruptsMasked = pdTRUE;
+
+    /* The stack of the calling task is not freed, it is still in use. */
+    setcontext( &xSchedulerContext );
+}
+/*-----------------------------------------------------------*/
+
+void vPortYield( void )
+{
+    if( prvInterruptsEnabled() == pdFALSE )
+    {
+        xSwitchPending = pdTRUE;
+    }
+    else
+    {
+        prvSwitchContext();
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnterCritical( void )
+{
+    xInterruptsMasked = pdTRUE;
+    uxCriticalNesting++;
+}
+/*-----------------------------------------------------------*/
+
+void vPortExitCritical( void )
+{
+    configASSERT( uxCriticalNesting );
+    uxCriticalNesting--;
+
+    if( uxCriticalNesting == 0 )
+    {
+        vPortEnableInterrupts();
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vPortDisableInterrupts( void )
+{
+    xInterruptsMasked = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnableInterrupts( void )
+{
+    xInterruptsMasked = pdFALSE;
+
+    if( prvInterruptsEnabled() != pdFALSE )
+    {
+        /* Interrupts that came due while masked run before the pended switch,
+         * as they would before PendSV. */
+        prvRunDueInterrupts();
+
+        if( ( xSwitchPending != pdFALSE ) && ( xSchedulerStarted != pdFALSE ) )
+        {
+            prvSwitchContext();
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxPortSetInterruptMask( void )
+{
+    UBaseType_t uxSavedMask = ( UBaseType_t ) xInterruptsMasked;
+
+    xInterruptsMasked = pdTRUE;
+
+    return uxSavedMask;
+}
+/*-----------------------------------------------------------*/
+
+void vPortClearInterruptMask( UBaseType_t uxSavedMask )
+{
+    if( uxSavedMask == 0 )
+    {
+        vPortEnableInterrupts();
+    }
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortIsInsideInterrupt( void )
+{
+    return xInsideInterrupt;
+}
+/*-----------------------------------------------------------*/
+
+void vPortGenerateSimulatedInterrupt( void ( * pvHandler )( void ) )
+{
+    configASSERT( prvInterruptsEnabled() != pdFALSE );
+
+    xInsideInterrupt = pdTRUE;
+    pvHandler();
+    xInsideInterrupt = pdFALSE;
+
+    /* The pended switch is taken on the way out of the handler. */
+    if( ( xSwitchPending != pdFALSE ) && ( xSchedulerStarted != pdFALSE ) )
+    {
+        prvSwitchContext();
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vPortScheduleInterrupt( uint64_t ullTimeNs,
+                             void ( * pvHandler )( void ) )
+{
+    UBaseType_t ux = uxScheduledInterrupts;
+
+    configASSERT( uxScheduledInterrupts < portMAX_SCHEDULED_INTERRUPTS );
+
+    /* An interrupt due in the past runs as soon as interrupts allow. */
+    if( ullTimeNs < ullVirtualTimeNs )
+    {
+        ullTimeNs = ullVirtualTimeNs;
+    }
+
+    while( ( ux > 0 ) && ( xScheduledInterrupts[ ux - 1 ].ullTimeNs > ullTimeNs ) )
+    {
+        xScheduledInterrupts[ ux ] = xScheduledInterrupts[ ux - 1 ];
+        ux--;
+    }
+
+    xScheduledInterrupts[ ux ].ullTimeNs = ullTimeNs;
+    xScheduledInterrupts[ ux ].pvHandler = pvHandler;
+    uxScheduledInterrupts++;
+}
+/*-----------------------------------------------------------*/
+
+void vPortExecute( uint64_t ullDurationNs )
+{
+    uint64_t ullRemainingNs = ullDurationNs;
+
+    for( ; ; )
+    {
+        uint64_t ullStepNs = ullRemainingNs;
+        uint64_t ullNextNs;
+
+        /* Preempted here if an interrupt is due; the rest of the work is done
+         * when this task runs again. */
+        prvRunDueInterrupts();
+
+        if( ( xSchedulerStarted != pdFALSE ) && ( ullVirtualTimeNs >= ullSimulationEndNs ) )
+        {
+            prvEndSimulation();
+        }
+
+        if( ullRemainingNs == 0 )
+        {
+            break;
+        }
+
+        ullNextNs = prvNextEventTime();
+
+        /* Masked interrupts do not stop the work, they run once unmasked. */
+        if( ( prvInterruptsEnabled() != pdFALSE ) &&
+            ( ullNextNs - ullVirtualTimeNs < ullStepNs ) )
+        {
+            ullStepNs = ullNextNs - ullVirtualTimeNs;
+        }
+
+        if( ( xSchedulerStarted != pdFALSE ) && ( ullSimulationEndNs - ullVirtualTimeNs < ullStepNs ) )
+        {
+            ullStepNs = ullSimulationEndNs - ullVirtualTimeNs;
+        }
+
+        ullVirtualTimeNs += ullStepNs;
+        ullRemainingNs -= ullStepNs;
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vPortAdvanceTime( uint64_t ullDurationNs )
+{
+    ullVirtualTimeNs += ullDurationNs;
+}
+/*-----------------------------------------------------------*/
+
+uint64_t ullPortGetNextEventTime( void )
+{
+    uint64_t ullNext = prvNextEventTime();
+
+    if( ( xSchedulerStarted != pdFALSE ) && ( ullSimulationEndNs < ullNext ) )
+    {
+        ullNext = ullSimulationEndNs;
+    }
+
+    return ullNext;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortInterruptsEnabled( void )
+{
+    return prvInterruptsEnabled();
+}
+/*-----------------------------------------------------------*/
+
+void vPortSetPRIMASK( uint32_t ulPriMask )
+{
+    ulPrimask = ulPriMask & 1UL;
+
+    /* Clearing PRIMASK lets through what it held back. */
+    if( ( ulPrimask == 0 ) && ( xInterruptsMasked == pdFALSE ) )
+    {
+        vPortEnableInterrupts();
+    }
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulPortGetPRIMASK( void )
+{
+    return ulPrimask;
+}
+/*-----------------------------------------------------------*/
+
+/* The idle task moves virtual time on to the next interrupt. */
+void vApplicationIdleHook( void )
+{
+    vPortExecute( prvNextEventTime() - ullVirtualTimeNs );
+}
+/*-----------------------------------------------------------*/
+
+uint64_t ullPortGetVirtualTime( void )
+{
+    return ullVirtualTimeNs;
+}
+/*-----------------------------------------------------------*/
+
+void vPortSetSimulationEnd( uint64_t ullTimeNs )
+{
+    ullSimulationEndNs = ullTimeNs;
+}
+/*-----------------------------------------------------------*/
+
+void vPortSetSimulationEndHook( void ( * pvHook )( void ) )
+{
+    pvSimulationEndHook = pvHook;
+}
+/*-----------------------------------------------------------*/
+
+void vPortLogSchedule( BaseType_t xEnable )
+{
+    xLogSchedule = xEnable;
+}
+/*-----------------------------------------------------------*/
+
+uint64_t ullPortGetContextSwitches( void )
+{
+    return ullContextSwitches;
+}
+/*-----------------------------------------------------------*/
+
+uint64_t ullPortGetScheduleHash( void )
+{
+    return ullScheduleHash;
+}
+/*-----------------------------------------------------------*/
+
+/* Stands in for the TIM5 time base of the board for portGET_DEADLINE_TIME()
+ * and the run time statistics.  Weak, so that the TIM5 time base of the board
+ * replaces it when the peripheral model is linked. */
+__attribute__( ( weak ) ) uint64_t timebase_get_us( void )
+{
+    return ullVirtualTimeNs / 1000ULL;
+}
@@ -0,0 +1,211 @@
+/*
+ * FreeRTOS Kernel V10.5.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+
+#ifndef PORTMACRO_H
+    #define PORTMACRO_H
+
+    #ifdef __cplusplus
+        extern "C" {
+    #endif
+
+/*-----------------------------------------------------------
+ * Port specific definitions for the single threaded host port.
+ *
+ * Every task runs on its own ucontext stack inside one host thread, so only
+ * one task executes at a time and a context switch is a swapcontext().
+ * There are no real interrupts: "interrupt" handlers are run through
+ * vPortGenerateSimulatedInterrupt(), and a yield requested while interrupts
+ * are masked or from inside a handler is held back until they are unmasked,
+ * as PendSV does on the Cortex-M4.
+ *
+ * Time is virtual.  It only advances while a task "executes" through
+ * vPortExecute() or while the idle task waits for the next event, and the
+ * tick and the interrupts scheduled with vPortScheduleInterrupt() run at
+ * exactly their virtual time.  The same program therefore produces the same
+ * schedule on every run.
+ *-----------------------------------------------------------
+ */
+
+    #include <stdint.h>
+
+/* Type definitions. */
+    #define portCHAR          char
+    #define portFLOAT         float
+    #define portDOUBLE        double
+    #define portLONG          long
+    #define portSHORT         short
+    #define portSTACK_TYPE    uintptr_t
+    #define portBASE_TYPE     long
+
+    typedef portSTACK_TYPE   StackType_t;
+    typedef long             BaseType_t;
+    typedef unsigned long    UBaseType_t;
+
+    #if ( configUSE_16_BIT_TICKS == 1 )
+        typedef uint16_t     TickType_t;
+        #define portMAX_DELAY              ( TickType_t ) 0xffff
+    #else
+        typedef uint32_t     TickType_t;
+        #define portMAX_DELAY              ( TickType_t ) 0xffffffffUL
+
+/* Only one task runs at a time, so reads of the tick count are atomic. */
+        #define portTICK_TYPE_IS_ATOMIC    1
+    #endif
+/*-----------------------------------------------------------*/
+
+/* Architecture specifics. */
+    #define portSTACK_GROWTH      ( -1 )
+    #define portTICK_PERIOD_MS    ( ( TickType_t ) 1000 / configTICK_RATE_HZ )
+    #define portBYTE_ALIGNMENT    8
+    #define portPOINTER_SIZE_TYPE uintptr_t
+    #define portDONT_DISCARD      __attribute__( ( used ) )
+/*-----------------------------------------------------------*/
+
+/* Scheduler utilities. */
+    extern void vPortYield( void );
+
+    #define portYIELD()                                 vPortYield()
+    #define portEND_SWITCHING_ISR( xSwitchRequired )    do { if( xSwitchRequired != pdFALSE ) portYIELD(); } while( 0 )
+    #define portYIELD_FROM_ISR( x )                     portEND_SWITCHING_ISR( x )
+/*-----------------------------------------------------------*/
+
+/* Critical section management. */
+    extern void vPortEnterCritical( void );
+    extern void vPortExitCritical( void );
+    extern void vPortDisableInterrupts( void );
+    extern void vPortEnableInterrupts( void );
+    extern UBaseType_t uxPortSetInterruptMask( void );
+    extern void vPortClearInterruptMask( UBaseType_t uxSavedMask );
+
+    #define portSET_INTERRUPT_MASK_FROM_ISR()         uxPortSetInterruptMask()
+    #define portCLEAR_INTERRUPT_MASK_FROM_ISR( x )    vPortClearInterruptMask( x )
+    #define portDISABLE_INTERRUPTS()                  vPortDisableInterrupts()
+    #define portENABLE_INTERRUPTS()                   vPortEnableInterrupts()
+    #define portENTER_CRITICAL()                      vPortEnterCritical()
+    #define portEXIT_CRITICAL()                       vPortExitCritical()
+
+/*-----------------------------------------------------------*/
+
+/* Task function macros as described on the FreeRTOS.org WEB site. */
+    #define portTASK_FUNCTION_PROTO( vFunction, pvParameters )    void vFunction( void * pvParameters )
+    #define portTASK_FUNCTION( vFunction, pvParameters )          void vFunction( void * pvParameters )
+/*-----------------------------------------------------------*/
+
+/* The host stack of a task is released when the kernel frees its TCB. */
+    extern void vPortCleanUpTCB( void * pxTCB );
+    #define portCLEAN_UP_TCB( pxTCB )    vPortCleanUpTCB( pxTCB )
+/*-----------------------------------------------------------*/
+
+/* Architecture specific optimisations. */
+    #ifndef configUSE_PORT_OPTIMISED_TASK_SELECTION
+        #define configUSE_PORT_OPTIMISED_TASK_SELECTION    1
+    #endif
+
+    #if configUSE_PORT_OPTIMISED_TASK_SELECTION == 1
+
+/* Check the configuration. */
+        #if ( configMAX_PRIORITIES > 32 )
+            #error configUSE_PORT_OPTIMISED_TASK_SELECTION can only be set to 1 when configMAX_PRIORITIES is less than or equal to 32.
+        #endif
+
+/* Store/clear the ready priorities in a bit map. */
+        #define portRECORD_READY_PRIORITY( uxPriority, uxReadyPriorities )    ( uxReadyPriorities ) |= ( 1UL << ( uxPriority ) )
+        #define portRESET_READY_PRIORITY( uxPriority, uxReadyPriorities )     ( uxReadyPriorities ) &= ~( 1UL << ( uxPriority ) )
+
+/*-----------------------------------------------------------*/
+
+        #define portGET_HIGHEST_PRIORITY( uxTopPriority, uxReadyPriorities )    uxTopPriority = ( 31UL - ( uint32_t ) __builtin_clz( ( uint32_t ) ( uxReadyPriorities ) ) )
+
+    #endif /* configUSE_PORT_OPTIMISED_TASK_SELECTION */
+
+/*-----------------------------------------------------------*/
+
+/* Runs pvHandler as an interrupt handler: the FromISR API functions can be
+ * called from it and a context switch it requests happens when it returns.
+ * Must not be called with interrupts masked. */
+    extern void vPortGenerateSimulatedInterrupt( void ( * pvHandler )( void ) );
+
+    extern BaseType_t xPortIsInsideInterrupt( void );
+
+/* Consumes ullDurationNs of virtual processor time in the calling task.  Due
+ * interrupts run on the way and may preempt it; the rest of the time is
+ * consumed when it runs again.  With interrupts masked the time passes and the
+ * interrupts run once they are unmasked. */
+    extern void vPortExecute( uint64_t ullDurationNs );
+
+/* Runs pvHandler as an interrupt at virtual time ullTimeNs.  Interrupts due at
+ * the same time run after the tick, in the order they were scheduled. */
+    extern void vPortScheduleInterrupt( uint64_t ullTimeNs,
+                                        void ( * pvHandler )( void ) );
+
+/* Ends the scheduler, returning from vTaskStartScheduler(), when virtual time
+ * reaches ullTimeNs.  The hook, if set, is called from the running task just
+ * before; it may also end the program. */
+    extern void vPortSetSimulationEnd( uint64_t ullTimeNs );
+    extern void vPortSetSimulationEndHook( void ( * pvHook )( void ) );
+
+    extern uint64_t ullPortGetVirtualTime( void );
+
+/* For models of hardware that run where no switch can be taken: advances
+ * virtual time without running what comes due, and reports when the next
+ * interrupt, tick or the end of the simulation is due and whether it could
+ * run now.  vPortExecute( 0 ) then runs it. */
+    extern void vPortAdvanceTime( uint64_t ullDurationNs );
+    extern uint64_t ullPortGetNextEventTime( void );
+    extern BaseType_t xPortInterruptsEnabled( void );
+
+/* PRIMASK, for __disable_irq() and __enable_irq() in the peripheral model
+ * build.  Masks the tick and all interrupts on top of critical sections. */
+    extern void vPortSetPRIMASK( uint32_t ulPriMask );
+    extern uint32_t ulPortGetPRIMASK( void );
+
+/* Prints the virtual time and the name of the task switched in on every
+ * context switch when xEnable is pdTRUE. */
+    extern void vPortLogSchedule( BaseType_t xEnable );
+
+/* The number of context switches so far and an FNV-1a hash of their times and
+ * task names, which identifies the schedule. */
+    extern uint64_t ullPortGetContextSwitches( void );
+    extern uint64_t ullPortGetScheduleHash( void );
+
+    #define portNOP()
+
+    #define portINLINE              __inline
+
+    #ifndef portFORCE_INLINE
+        #define portFORCE_INLINE    inline __attribute__( ( always_inline ) )
+    #endif
+
+    #define portMEMORY_BARRIER()    __asm volatile ( "" ::: "memory" )
+
+    #ifdef __cplusplus
+        }
+    #endif
+
+#endif /* PORTMACRO_H */
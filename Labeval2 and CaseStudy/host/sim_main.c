@@ -0,0 +1,347 @@
+/**
+  ******************************************************************************
+  * @file           : sim_main.c
+  * @brief          : Virtual time simulation of the application task set.
+  *
+  * Runs the task set of Core/Src/main.c on the host port with the scheduler
+  * configuration of the board: the ADC task and the two LED pattern tasks are
+  * periodic EDF tasks sharing the ADC result under SRP, and the Bluetooth
+  * command handler runs in a Constant Bandwidth Server.  The peripherals are
+  * replaced by the time they cost: a blocking UART print takes 10 bit times
+  * per byte at 9600 baud, the ADC reads a fixed ramp and the Bluetooth
+  * commands arrive as receive interrupts at fixed virtual times.
+  *
+  * Nothing depends on the host clock, so every run prints the same schedule
+  * hash.  A change to the scheduler that alters the schedule changes the
+  * hash, and the per-task statistics show what moved.
+  *
+  *     build/sim [-v] [seconds]
+  *
+  * -v prints every context switch; the default length is 10 seconds.
+  ******************************************************************************
+  */
+
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "taskset_config.h"
+
+/* Task parameters, from the same generated header as Core/Src/main.c */
+#define ADC_TASK_PERIOD        tskUS_TO_DEADLINE_TIME(ADC_TASK_PERIOD_US)
+#define ADC_TASK_DEADLINE      tskUS_TO_DEADLINE_TIME(ADC_TASK_DEADLINE_US)
+#define ADC_TASK_WCET          tskUS_TO_DEADLINE_TIME(ADC_TASK_WCET_US)
+#define LED_HIGH_PERIOD        tskUS_TO_DEADLINE_TIME(LED_HIGH_PERIOD_US)
+#define LED_HIGH_DEADLINE      tskUS_TO_DEADLINE_TIME(LED_HIGH_DEADLINE_US)
+#define LED_HIGH_WCET          tskUS_TO_DEADLINE_TIME(LED_HIGH_WCET_US)
+#define LED_LOW_PERIOD         tskUS_TO_DEADLINE_TIME(LED_LOW_PERIOD_US)
+#define LED_LOW_DEADLINE       tskUS_TO_DEADLINE_TIME(LED_LOW_DEADLINE_US)
+#define LED_LOW_WCET           tskUS_TO_DEADLINE_TIME(LED_LOW_WCET_US)
+#define BT_SERVER_BUDGET       tskUS_TO_DEADLINE_TIME(BT_SERVER_WCET_US)
+#define BT_SERVER_PERIOD       tskUS_TO_DEADLINE_TIME(BT_SERVER_PERIOD_US)
+
+/* Time taken by the modelled peripherals, in nanoseconds */
+#define UART_NS_PER_BYTE       (10ULL * 1000000000ULL / 9600)
+#define ADC_CONVERSION_NS      15000ULL
+#define ADC_RAMP_STEP          97
+
+#define NS_PER_SECOND          1000000000ULL
+#define RUN_STATS_MAX_TASKS    8
+
+/* The Bluetooth input: one byte per receive interrupt */
+typedef struct
+{
+    uint64_t time_ns;
+    char byte;
+} BluetoothByte_t;
+
+static const BluetoothByte_t bluetooth_input[] =
+{
+    { 1250000000ULL, '?' },
+    { 2500000000ULL, '?' },
+    { 2500000000ULL, '?' },
+    { 4000000000ULL, 's' },
+    { 6100000000ULL, '?' },
+    { 6100500000ULL, '?' },
+    { 6101000000ULL, '?' },
+    { 8750000000ULL, '?' },
+};
+
+static SRPResourceHandle_t adc_resource;
+static uint32_t shared_adc_value;
+static uint8_t led_pattern_selection = 0;
+static uint32_t adc_input = 0;
+static unsigned bluetooth_next = 0;
+
+static TaskHandle_t adc_task_handle;
+static TaskHandle_t led_high_task_handle;
+static TaskHandle_t led_low_task_handle;
+static TaskHandle_t bluetooth_task_handle;
+
+static TaskRunStats_t run_stats[RUN_STATS_MAX_TASKS];
+
+/* A blocking HAL_UART_Transmit() keeps the task busy for the whole frame */
+void uart_print(const char* str)
+{
+    size_t length = strlen(str);
+
+    if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+    {
+        vPortExecute(length * UART_NS_PER_BYTE);
+    }
+    fputs(str, stdout);
+}
+
+void Error_Handler(void)
+{
+    fprintf(stderr, "simulation failed\n");
+    exit(EXIT_FAILURE);
+}
+
+void vApplicationDeadlineMissHook(TaskHandle_t xTask, DeadlineTime_t xTardiness)
+{
+    /* Counted by the kernel, reported by print_deadline_stats() */
+    (void)xTask;
+    (void)xTardiness;
+}
+
+/* Stands in for the ADC: a conversion returns the next step of a ramp */
+static uint32_t adc_read(void)
+{
+    vPortExecute(ADC_CONVERSION_NS);
+    adc_input = (adc_input + ADC_RAMP_STEP) % 4096;
+
+    return adc_input;
+}
+
+static void adc_reading_task(void* parameters)
+{
+    uint32_t local_adc_value;
+    const uint32_t threshold1 = 1365;
+    const uint32_t threshold2 = 2730;
+
+    (void)parameters;
+    while (1)
+    {
+        local_adc_value = adc_read();
+
+        vTaskSRPLock(adc_resource);
+        shared_adc_value = local_adc_value;
+        if (local_adc_value < threshold1) {
+            led_pattern_selection = 1;
+        } else if (local_adc_value < threshold2) {
+            led_pattern_selection = 2;
+        } else {
+            led_pattern_selection = 3;
+        }
+        vTaskSRPUnlock(adc_resource);
+
+        xTaskWaitForNextPeriod();
+    }
+}
+
+static void led_pattern_high_task(void* parameters)
+{
+    uint8_t local_pattern;
+
+    (void)parameters;
+    while (1)
+    {
+        vTaskSRPLock(adc_resource);
+        local_pattern = led_pattern_selection;
+        vTaskSRPUnlock(adc_resource);
+
+        if (local_pattern == 3)
+        {
+            vTaskDelay(pdMS_TO_TICKS(50));
+            vTaskDelay(pdMS_TO_TICKS(50));
+            vTaskDelay(pdMS_TO_TICKS(50));
+            uart_print("High Priority \n");
+        }
+
+        xTaskWaitForNextPeriod();
+    }
+}
+
+static void led_pattern_low_task(void* parameters)
+{
+    uint8_t local_pattern;
+
+    (void)parameters;
+    while (1)
+    {
+        vTaskSRPLock(adc_resource);
+        local_pattern = led_pattern_selection;
+        vTaskSRPUnlock(adc_resource);
+
+        switch(local_pattern)
+        {
+            case 1:
+                vTaskDelay(pdMS_TO_TICKS(500));
+                uart_print("Low Priority\n");
+                break;
+
+            case 2:
+                vTaskDelay(pdMS_TO_TICKS(200));
+                uart_print("Medium Priority\n");
+                break;
+
+            default:
+                break;
+        }
+
+        xTaskWaitForNextPeriod();
+    }
+}
+
+/* Prints the CPU share and job statistics of each task */
+static void print_run_stats(void)
+{
+    char buffer[120];
+    configRUN_TIME_COUNTER_TYPE total_time;
+    configRUN_TIME_COUNTER_TYPE idle_time;
+    UBaseType_t task_count;
+
+    task_count = uxTaskGetRunStats(run_stats, RUN_STATS_MAX_TASKS, &total_time, &idle_time);
+    if (task_count == 0 || total_time == 0)
+    {
+        return;
+    }
+
+    for (UBaseType_t i = 0; i < task_count; i++)
+    {
+        const TaskJobStats_t* jobs = &run_stats[i].xJobStats;
+        unsigned long share = (unsigned long)((run_stats[i].ulRunTimeCounter * 1000U) / total_time);
+
+        snprintf(buffer, sizeof(buffer), "%-10s cpu %lu.%lu%%",
+                 pcTaskGetName(run_stats[i].xHandle), share / 10, share % 10);
+        uart_print(buffer);
+
+        if (jobs->ulJobs > 0)
+        {
+            snprintf(buffer, sizeof(buffer), " jobs %lu resp %lu/%lu/%lu us jitter %lu us",
+                     (unsigned long)jobs->ulJobs,
+                     (unsigned long)jobs->xMinResponseTime,
+                     (unsigned long)(jobs->ullTotalResponseTime / jobs->ulJobs),
+                     (unsigned long)jobs->xMaxResponseTime,
+                     (unsigned long)(jobs->xMaxStartLatency - jobs->xMinStartLatency));
+            uart_print(buffer);
+        }
+        uart_print("\n");
+    }
+
+    snprintf(buffer, sizeof(buffer), "idle %lu%%\n",
+             (unsigned long)((idle_time * 100U) / total_time));
+    uart_print(buffer);
+}
+
+static void bluetooth_task(void* parameters)
+{
+    uint32_t received;
+    uint32_t local_adc_value;
+    uint8_t local_pattern;
+    char buffer[50];
+
+    (void)parameters;
+    while (1)
+    {
+        xTaskNotifyWait(0, 0, &received, portMAX_DELAY);
+
+        if ((char)received == '?')
+        {
+            vTaskSRPLock(adc_resource);
+            local_adc_value = shared_adc_value;
+            local_pattern = led_pattern_selection;
+            vTaskSRPUnlock(adc_resource);
+
+            snprintf(buffer, sizeof(buffer), "ADC %lu Pattern %u\n",
+                     (unsigned long)local_adc_value, (unsigned)local_pattern);
+            uart_print(buffer);
+        }
+        else if ((char)received == 's')
+        {
+            print_run_stats();
+        }
+    }
+}
+
+/* The USART2 receive interrupt, one per entry of bluetooth_input */
+static void bluetooth_rx_isr(void)
+{
+    BaseType_t higher_priority_task_woken = pdFALSE;
+
+    xTaskNotifyFromISR(bluetooth_task_handle, (uint32_t)bluetooth_input[bluetooth_next++].byte,
+                       eSetValueWithOverwrite, &higher_priority_task_woken);
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+}
+
+static void print_deadline_stats(const char* name, TaskHandle_t task)
+{
+    TaskDeadlineStats_t stats;
+
+    vTaskGetDeadlineStats(task, &stats);
+    printf("%-10s jobs %lu missed %lu max tardiness %lu us\n", name,
+           (unsigned long)stats.ulJobsCompleted, (unsigned long)stats.ulDeadlinesMissed,
+           (unsigned long)stats.xMaxTardiness);
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t seconds = 10;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-v") == 0)
+        {
+            vPortLogSchedule(pdTRUE);
+        }
+        else
+        {
+            seconds = strtoull(argv[i], NULL, 10);
+        }
+    }
+
+    adc_resource = xTaskCreateSRPResource();
+    if (adc_resource == NULL)
+    {
+        Error_Handler();
+    }
+
+    if (xTaskCreatePeriodic(adc_reading_task, "ADCTask", ADC_TASK_STACK_SIZE, NULL, ADC_TASK_PRIORITY,
+                            ADC_TASK_PERIOD, ADC_TASK_DEADLINE, ADC_TASK_WCET, &adc_task_handle) != pdPASS ||
+        xTaskCreatePeriodic(led_pattern_high_task, "LEDHighTask", LED_HIGH_STACK_SIZE, NULL, LED_HIGH_PRIORITY,
+                            LED_HIGH_PERIOD, LED_HIGH_DEADLINE, LED_HIGH_WCET, &led_high_task_handle) != pdPASS ||
+        xTaskCreatePeriodic(led_pattern_low_task, "LEDLowTask", LED_LOW_STACK_SIZE, NULL, LED_LOW_PRIORITY,
+                            LED_LOW_PERIOD, LED_LOW_DEADLINE, LED_LOW_WCET, &led_low_task_handle) != pdPASS ||
+        xTaskCreateServed(bluetooth_task, "BTTask", BT_SERVER_STACK_SIZE, NULL, BT_SERVER_PRIORITY,
+                          BT_SERVER_BUDGET, BT_SERVER_PERIOD, &bluetooth_task_handle) != pdPASS)
+    {
+        Error_Handler();
+    }
+
+    vTaskAddSRPResourceUser(adc_resource, adc_task_handle);
+    vTaskAddSRPResourceUser(adc_resource, led_high_task_handle);
+    vTaskAddSRPResourceUser(adc_resource, led_low_task_handle);
+    vTaskAddSRPResourceUser(adc_resource, bluetooth_task_handle);
+
+    for (unsigned i = 0; i < sizeof(bluetooth_input) / sizeof(bluetooth_input[0]); i++)
+    {
+        vPortScheduleInterrupt(bluetooth_input[i].time_ns, bluetooth_rx_isr);
+    }
+
+    vPortSetSimulationEnd(seconds * NS_PER_SECOND);
+
+    /* Returns when virtual time reaches the end */
+    vTaskStartScheduler();
+
+    printf("--- %llu s of virtual time\n", (unsigned long long)seconds);
+    print_run_stats();
+    print_deadline_stats("ADCTask", adc_task_handle);
+    print_deadline_stats("LEDHighTask", led_high_task_handle);
+    print_deadline_stats("LEDLowTask", led_low_task_handle);
+    printf("context switches %llu\n", (unsigned long long)ullPortGetContextSwitches());
+    printf("schedule hash %016llx\n", (unsigned long long)ullPortGetScheduleHash());
+
+    return 0;
+}
@@ -0,0 +1,408 @@
+/**************************************************************************//**
+ * @file     cmsis_gcc.h
+ * @brief    CMSIS compiler GCC header file for the host build
+ * @version  V5.4.1
+ * @date     27. May 2021
+ ******************************************************************************/
+/*
+ * Copyright (c) 2009-2021 Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Replaces Drivers/CMSIS/Include/cmsis_gcc.h when the device headers and the
+ * HAL are compiled for the host against the peripheral model in this
+ * directory.  The compiler definitions are those of the original; the core
+ * intrinsics are C equivalents, the interrupt masks go to the host port and
+ * IPSR to the interrupt dispatch of the model.  Of the DSP (SIMD) intrinsics
+ * only the C equivalents of those that Core/Src/dsp_filter.c uses are
+ * provided, so that its SIMD versions can be checked against its C versions
+ * on the host; __ARM_FEATURE_DSP is never defined on the host.
+ */
+
+#ifndef __CMSIS_GCC_H
+#define __CMSIS_GCC_H
+
+#include <stdint.h>
+
+/* CMSIS compiler specific defines */
+#ifndef   __ASM
+  #define __ASM                                  __asm
+#endif
+#ifndef   __INLINE
+  #define __INLINE                               inline
+#endif
+#ifndef   __STATIC_INLINE
+  #define __STATIC_INLINE                        static inline
+#endif
+#ifndef   __STATIC_FORCEINLINE
+  #define __STATIC_FORCEINLINE                   __attribute__((always_inline)) static inline
+#endif
+#ifndef   __NO_RETURN
+  #define __NO_RETURN                            __attribute__((__noreturn__))
+#endif
+#ifndef   __USED
+  #define __USED                                 __attribute__((used))
+#endif
+#ifndef   __WEAK
+  #define __WEAK                                 __attribute__((weak))
+#endif
+#ifndef   __PACKED
+  #define __PACKED                               __attribute__((packed, aligned(1)))
+#endif
+#ifndef   __PACKED_STRUCT
+  #define __PACKED_STRUCT                        struct __attribute__((packed, aligned(1)))
+#endif
+#ifndef   __PACKED_UNION
+  #define __PACKED_UNION                         union __attribute__((packed, aligned(1)))
+#endif
+#ifndef   __UNALIGNED_UINT32        /* deprecated */
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wpacked"
+  #pragma GCC diagnostic ignored "-Wattributes"
+  struct __attribute__((packed)) T_UINT32 { uint32_t v; };
+  #pragma GCC diagnostic pop
+  #define __UNALIGNED_UINT32(x)                  (((struct T_UINT32 *)(x))->v)
+#endif
+#ifndef   __UNALIGNED_UINT16_WRITE
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wpacked"
+  #pragma GCC diagnostic ignored "-Wattributes"
+  __PACKED_STRUCT T_UINT16_WRITE { uint16_t v; };
+  #pragma GCC diagnostic pop
+  #define __UNALIGNED_UINT16_WRITE(addr, val)    (void)((((struct T_UINT16_WRITE *)(void *)(addr))->v) = (val))
+#endif
+#ifndef   __UNALIGNED_UINT16_READ
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wpacked"
+  #pragma GCC diagnostic ignored "-Wattributes"
+  __PACKED_STRUCT T_UINT16_READ { uint16_t v; };
+  #pragma GCC diagnostic pop
+  #define __UNALIGNED_UINT16_READ(addr)          (((const struct T_UINT16_READ *)(const void *)(addr))->v)
+#endif
+#ifndef   __UNALIGNED_UINT32_WRITE
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wpacked"
+  #pragma GCC diagnostic ignored "-Wattributes"
+  __PACKED_STRUCT T_UINT32_WRITE { uint32_t v; };
+  #pragma GCC diagnostic pop
+  #define __UNALIGNED_UINT32_WRITE(addr, val)    (void)((((struct T_UINT32_WRITE *)(void *)(addr))->v) = (val))
+#endif
+#ifndef   __UNALIGNED_UINT32_READ
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wpacked"
+  #pragma GCC diagnostic ignored "-Wattributes"
+  __PACKED_STRUCT T_UINT32_READ { uint32_t v; };
+  #pragma GCC diagnostic pop
+  #define __UNALIGNED_UINT32_READ(addr)          (((const struct T_UINT32_READ *)(const void *)(addr))->v)
+#endif
+#ifndef   __ALIGNED
+  #define __ALIGNED(x)                           __attribute__((aligned(x)))
+#endif
+#ifndef   __RESTRICT
+  #define __RESTRICT                             __restrict
+#endif
+#ifndef   __COMPILER_BARRIER
+  #define __COMPILER_BARRIER()                   __ASM volatile("":::"memory")
+#endif
+
+/* Implemented by the host port and the peripheral model */
+extern void vPortSetPRIMASK(uint32_t ulPriMask);
+extern uint32_t ulPortGetPRIMASK(void);
+extern uint32_t stm32_model_get_ipsr(void);
+
+
+/* ###########################  Core Function Access  ########################### */
+
+__STATIC_FORCEINLINE void __enable_irq(void)
+{
+  vPortSetPRIMASK(0U);
+}
+
+__STATIC_FORCEINLINE void __disable_irq(void)
+{
+  vPortSetPRIMASK(1U);
+}
+
+__STATIC_FORCEINLINE uint32_t __get_PRIMASK(void)
+{
+  return ulPortGetPRIMASK();
+}
+
+__STATIC_FORCEINLINE void __set_PRIMASK(uint32_t priMask)
+{
+  vPortSetPRIMASK(priMask);
+}
+
+__STATIC_FORCEINLINE uint32_t __get_IPSR(void)
+{
+  return stm32_model_get_ipsr();
+}
+
+__STATIC_FORCEINLINE uint32_t __get_xPSR(void)
+{
+  return stm32_model_get_ipsr();
+}
+
+__STATIC_FORCEINLINE uint32_t __get_APSR(void)
+{
+  return 0U;
+}
+
+/* The kernel masks through the port, so BASEPRI, FAULTMASK and CONTROL are
+ * only remembered */
+extern uint32_t __cmsis_host_basepri;
+extern uint32_t __cmsis_host_faultmask;
+extern uint32_t __cmsis_host_control;
+
+__STATIC_FORCEINLINE uint32_t __get_BASEPRI(void)
+{
+  return __cmsis_host_basepri;
+}
+
+__STATIC_FORCEINLINE void __set_BASEPRI(uint32_t basePri)
+{
+  __cmsis_host_basepri = basePri & 0xFFU;
+}
+
+__STATIC_FORCEINLINE void __set_BASEPRI_MAX(uint32_t basePri)
+{
+  basePri &= 0xFFU;
+  if ((basePri != 0U) && ((__cmsis_host_basepri == 0U) || (basePri < __cmsis_host_basepri)))
+  {
+    __cmsis_host_basepri = basePri;
+  }
+}
+
+__STATIC_FORCEINLINE uint32_t __get_FAULTMASK(void)
+{
+  return __cmsis_host_faultmask;
+}
+
+__STATIC_FORCEINLINE void __set_FAULTMASK(uint32_t faultMask)
+{
+  __cmsis_host_faultmask = faultMask & 1U;
+}
+
+__STATIC_FORCEINLINE void __enable_fault_irq(void)
+{
+  __cmsis_host_faultmask = 0U;
+}
+
+__STATIC_FORCEINLINE void __disable_fault_irq(void)
+{
+  __cmsis_host_faultmask = 1U;
+}
+
+__STATIC_FORCEINLINE uint32_t __get_CONTROL(void)
+{
+  return __cmsis_host_control;
+}
+
+__STATIC_FORCEINLINE void __set_CONTROL(uint32_t control)
+{
+  __cmsis_host_control = control;
+}
+
+/* There is no separate main and process stack pointer to report */
+__STATIC_FORCEINLINE uint32_t __get_MSP(void)
+{
+  return 0U;
+}
+
+__STATIC_FORCEINLINE void __set_MSP(uint32_t topOfMainStack)
+{
+  (void)topOfMainStack;
+}
+
+__STATIC_FORCEINLINE uint32_t __get_PSP(void)
+{
+  return 0U;
+}
+
+__STATIC_FORCEINLINE void __set_PSP(uint32_t topOfProcStack)
+{
+  (void)topOfProcStack;
+}
+
+__STATIC_FORCEINLINE uint32_t __get_FPSCR(void)
+{
+  return 0U;
+}
+
+__STATIC_FORCEINLINE void __set_FPSCR(uint32_t fpscr)
+{
+  (void)fpscr;
+}
+
+
+/* ##########################  Core Instruction Access  ######################### */
+
+/* A single task runs at a time and the model is called synchronously, so the
+ * barriers only have to stop the compiler from reordering */
+#define __NOP()                             __COMPILER_BARRIER()
+#define __WFI()                             __COMPILER_BARRIER()
+#define __WFE()                             __COMPILER_BARRIER()
+#define __SEV()                             __COMPILER_BARRIER()
+#define __BKPT(value)                       __builtin_trap()
+
+__STATIC_FORCEINLINE void __ISB(void)
+{
+  __COMPILER_BARRIER();
+}
+
+__STATIC_FORCEINLINE void __DSB(void)
+{
+  __COMPILER_BARRIER();
+}
+
+__STATIC_FORCEINLINE void __DMB(void)
+{
+  __COMPILER_BARRIER();
+}
+
+__STATIC_FORCEINLINE uint32_t __REV(uint32_t value)
+{
+  return __builtin_bswap32(value);
+}
+
+__STATIC_FORCEINLINE uint32_t __REV16(uint32_t value)
+{
+  return ((value & 0xFF00FF00U) >> 8) | ((value & 0x00FF00FFU) << 8);
+}
+
+__STATIC_FORCEINLINE int16_t __REVSH(int16_t value)
+{
+  return (int16_t)__builtin_bswap16((uint16_t)value);
+}
+
+__STATIC_FORCEINLINE uint32_t __ROR(uint32_t op1, uint32_t op2)
+{
+  op2 %= 32U;
+  if (op2 == 0U)
+  {
+    return op1;
+  }
+  return (op1 >> op2) | (op1 << (32U - op2));
+}
+
+__STATIC_FORCEINLINE uint32_t __RBIT(uint32_t value)
+{
+  uint32_t result = 0U;
+
+  for (uint32_t i = 0U; i < 32U; i++)
+  {
+    result = (result << 1) | ((value >> i) & 1U);
+  }
+  return result;
+}
+
+__STATIC_FORCEINLINE uint8_t __CLZ(uint32_t value)
+{
+  if (value == 0U)
+  {
+    return 32U;
+  }
+  return (uint8_t)__builtin_clz(value);
+}
+
+/* The exclusive monitor never fails with one thread of execution */
+__STATIC_FORCEINLINE uint8_t __LDREXB(volatile uint8_t *addr)
+{
+  return *addr;
+}
+
+__STATIC_FORCEINLINE uint16_t __LDREXH(volatile uint16_t *addr)
+{
+  return *addr;
+}
+
+__STATIC_FORCEINLINE uint32_t __LDREXW(volatile uint32_t *addr)
+{
+  return *addr;
+}
+
+__STATIC_FORCEINLINE uint32_t __STREXB(uint8_t value, volatile uint8_t *addr)
+{
+  *addr = value;
+  return 0U;
+}
+
+__STATIC_FORCEINLINE uint32_t __STREXH(uint16_t value, volatile uint16_t *addr)
+{
+  *addr = value;
+  return 0U;
+}
+
+__STATIC_FORCEINLINE uint32_t __STREXW(uint32_t value, volatile uint32_t *addr)
+{
+  *addr = value;
+  return 0U;
+}
+
+__STATIC_FORCEINLINE void __CLREX(void)
+{
+}
+
+__STATIC_FORCEINLINE int32_t __SSAT(int32_t val, uint32_t sat)
+{
+  if ((sat >= 1U) && (sat <= 32U))
+  {
+    const int32_t max = (int32_t)((1U << (sat - 1U)) - 1U);
+    const int32_t min = -1 - max ;
+    if (val > max)
+    {
+      return max;
+    }
+    else if (val < min)
+    {
+      return min;
+    }
+  }
+  return val;
+}
+
+__STATIC_FORCEINLINE uint32_t __USAT(int32_t val, uint32_t sat)
+{
+  if (sat <= 31U)
+  {
+    const uint32_t max = ((1U << sat) - 1U);
+    if (val > (int32_t)max)
+    {
+      return max;
+    }
+    else if (val < 0)
+    {
+      return 0U;
+    }
+  }
+  return (uint32_t)val;
+}
+
+__STATIC_FORCEINLINE uint64_t __SMLALD (uint32_t op1, uint32_t op2, uint64_t acc)
+{
+  const int64_t low = (int64_t)((int16_t)op1 * (int16_t)op2);
+  const int64_t high = (int64_t)((int16_t)(op1 >> 16) * (int16_t)(op2 >> 16));
+
+  return acc + (uint64_t)(low + high);
+}
+
+__STATIC_FORCEINLINE uint32_t __PKHBT (uint32_t op1, uint32_t op2, uint32_t shift)
+{
+  return (op1 & 0x0000FFFFU) | ((op2 << shift) & 0xFFFF0000U);
+}
+
+#endif /* __CMSIS_GCC_H */
@@ -0,0 +1,2563 @@
+/**
+  ******************************************************************************
+  * @file           : stm32_model.c
+  * @brief          : Register level model of the STM32F401 peripherals.
+  *
+  * The peripheral (0x40000000) and core (0xE0000000) address ranges are
+  * shared memory mapped twice: at the device addresses without access
+  * rights, where the application and the HAL use them, and at a second
+  * address where the model keeps the register contents.  An access faults;
+  * the fault handler charges the bus cycles to virtual time, brings the
+  * model up to date, prepares the value a read returns, opens the pages and
+  * single-steps the instruction.  The trap after it closes them again and
+  * applies what the access does: write-1-to-clear flags, BSRR, a conversion
+  * start, a byte into the transmitter, and so on.
+  *
+  * The peripherals are discrete event models: each knows the virtual time of
+  * its next event (a conversion done, a byte shifted out, a timer update)
+  * and the model wakes through vPortScheduleInterrupt() at the earliest one.
+  * Interrupt requests go through the NVIC model to the handlers of the
+  * vector table, run as interrupts of the host port.  When an interrupt is
+  * due at an access made with interrupts enabled, the fault handler diverts
+  * the program into an entry stub that runs it, as the processor would
+  * between two instructions.
+  *
+  * A loop that polls a register that cannot change until the next event
+  * (TXE, EOC, RDY flags) is recognised after three rounds and fast-forwarded
+  * to that event, its accesses and their time counted as polling.
+  ******************************************************************************
+  */
+
+#define _GNU_SOURCE
+#include <signal.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "stm32f4xx_hal.h"
+#include "stm32_model.h"
+
+#if !defined(__linux__) || !defined(__x86_64__)
+#error "The STM32 peripheral model traps register accesses on Linux x86-64 only"
+#endif
+
+/* Address ranges mapped at their device addresses */
+#define PERIPH_WINDOW_BASE     0x40000000UL
+#define PERIPH_WINDOW_SIZE     0x00028000UL    /* APB1, APB2 and AHB1 */
+#define CORE_WINDOW_BASE       0xE0000000UL
+#define CORE_WINDOW_SIZE       0x00043000UL    /* ITM, DWT, SCS and DBGMCU */
+
+#define NO_EVENT               UINT64_MAX
+#define NS_PER_SECOND          1000000000ULL
+#define PS_PER_SECOND          1000000000000ULL
+
+/* Cost of a register access: the load or store and the instructions around
+ * it in HCLK cycles, plus the wait on the bus bridge in bus clock cycles */
+#define ACCESS_CPU_CYCLES      4
+#define APB_WAIT_CYCLES        2
+#define AHB_WAIT_CYCLES        1
+
+/* Oscillator start-up and PLL lock times, datasheet typical values */
+#define HSI_STARTUP_NS         2000ULL
+#define HSE_STARTUP_NS         2000000ULL
+#define PLL_LOCK_NS            100000ULL
+#define LSI_STARTUP_NS         40000ULL
+#define LSE_STARTUP_NS         2000000000ULL
+
+/* DMA memory-to-memory transfer: a read and a write on the AHB per item */
+#define DMA_M2M_CYCLES_PER_ITEM 2
+
+/* Input levels of the internal channels, as 12-bit values at VDDA = 3.3 V */
+#define ADC_CHANNEL_TEMP       18
+#define ADC_CHANNEL_VREF       17
+#define ADC_TEMP_VALUE         943     /* 0.76 V, 25 degrees C */
+#define ADC_VREF_VALUE         1501    /* 1.21 V */
+
+#define EFLAGS_TRAP            0x100
+#define USART_RX_QUEUE_SIZE    256
+#define MAX_MODEL_WAKES        48
+#define POLL_HISTORY           12
+#define POLL_MAX_LOOP          4
+#define DISPATCH_ROUNDS        8
+#define IRQ_WORDS              3
+#define IRQ_RETRY_NS           1000ULL
+
+typedef enum
+{
+    BUS_CORE,
+    BUS_AHB1,
+    BUS_APB1,
+    BUS_APB2
+} Bus_t;
+
+typedef enum
+{
+    KIND_PLAIN,
+    KIND_RCC,
+    KIND_GPIO,
+    KIND_ADC,
+    KIND_ADC_COMMON,
+    KIND_USART,
+    KIND_TIM,
+    KIND_DMA,
+    KIND_NVIC,
+    KIND_STIR,
+    KIND_DWT
+} Kind_t;
+
+typedef struct
+{
+    const char* name;
+    uintptr_t base;
+    uint32_t size;
+    Kind_t kind;
+    Bus_t bus;
+    uint8_t index;
+    uint64_t accesses;
+    uint64_t time_ps;
+    uint64_t polled_accesses;
+    uint64_t polled_ps;
+} Peripheral_t;
+
+typedef struct
+{
+    uintptr_t base;
+    size_t size;
+    size_t offset;
+    uint8_t* alias;
+} Window_t;
+
+typedef struct
+{
+    uint32_t sysclk;
+    uint32_t hclk;
+    uint32_t pclk1;
+    uint32_t pclk2;
+    uint32_t timclk1;
+    uint32_t adcclk;
+} Clocks_t;
+
+typedef struct
+{
+    const char* name;
+    uint8_t reg;                /* 0: CR, 1: CSR, 2: BDCR */
+    uint32_t on;
+    uint32_t ready;
+    uint64_t startup_ns;
+    uint64_t ready_time;
+} Oscillator_t;
+
+typedef struct
+{
+    const char* name;
+    GPIO_TypeDef* regs;
+    uint16_t driven;
+    uint16_t level;
+    uint32_t rising_edges[16];
+} Gpio_t;
+
+typedef struct
+{
+    ADC_TypeDef* regs;
+    ADC_Common_TypeDef* common;
+    stm32_analog_input_t input;
+    int busy;
+    uint64_t conversion_end;
+    uint32_t rank;
+    int dr_unread;
+    int dma_stopped;
+    uint64_t conversions;
+} Adc_t;
+
+typedef enum
+{
+    DMA_ADC1,
+    DMA_USART1_RX,
+    DMA_USART1_TX,
+    DMA_USART2_RX,
+    DMA_USART2_TX,
+    DMA_USART6_RX,
+    DMA_USART6_TX
+} DmaRequest_t;
+
+typedef struct
+{
+    uint64_t time;
+    uint8_t byte;
+} UsartRxByte_t;
+
+typedef struct
+{
+    const char* name;
+    USART_TypeDef* regs;
+    Bus_t bus;
+    DmaRequest_t rx_request;
+    DmaRequest_t tx_request;
+    FILE* output;
+    int tx_busy;
+    int tdr_full;
+    uint8_t tx_shift;
+    uint8_t tdr;
+    uint64_t tx_end;
+    int sr_read;
+    uint64_t line_idle;
+    int idle_armed;
+    UsartRxByte_t rx[USART_RX_QUEUE_SIZE];
+    unsigned rx_head;
+    unsigned rx_count;
+    uint64_t bytes_sent;
+    uint64_t bytes_received;
+} Usart_t;
+
+typedef struct
+{
+    TIM_TypeDef* regs;
+    uint32_t max;
+    int8_t adc_trigger[5];      /* ADC EXTSEL of CC1-CC4 and TRGO, -1 none */
+    int running;
+    uint64_t base_time;
+    uint32_t base_count;
+    uint32_t psc;
+    uint32_t arr;
+} Tim_t;
+
+typedef struct
+{
+    DMA_TypeDef* regs;
+    DMA_Stream_TypeDef* streams[8];
+    uint32_t items[8];
+    uint32_t transferred[8];
+    int active[8];
+    uint64_t m2m_end[8];
+} Dma_t;
+
+typedef struct
+{
+    uintptr_t rip;
+    uintptr_t address;
+    uint32_t value;
+    int write;
+    uint64_t time;
+} Access_t;
+
+/* Where the DMA requests of a peripheral can go */
+static const struct
+{
+    DmaRequest_t request;
+    uint8_t dma;
+    uint8_t stream;
+    uint8_t channel;
+} dma_routes[] =
+{
+    { DMA_ADC1,      1, 0, 0 },
+    { DMA_ADC1,      1, 4, 0 },
+    { DMA_USART1_RX, 1, 2, 4 },
+    { DMA_USART1_RX, 1, 5, 4 },
+    { DMA_USART1_TX, 1, 7, 4 },
+    { DMA_USART6_RX, 1, 1, 5 },
+    { DMA_USART6_RX, 1, 2, 5 },
+    { DMA_USART6_TX, 1, 6, 5 },
+    { DMA_USART6_TX, 1, 7, 5 },
+    { DMA_USART2_RX, 0, 5, 4 },
+    { DMA_USART2_TX, 0, 6, 4 },
+};
+
+static Peripheral_t peripherals[] =
+{
+    { "TIM2",    TIM2_BASE,          0x400, KIND_TIM,        BUS_APB1, 0 },
+    { "TIM3",    TIM3_BASE,          0x400, KIND_TIM,        BUS_APB1, 1 },
+    { "TIM4",    TIM4_BASE,          0x400, KIND_TIM,        BUS_APB1, 2 },
+    { "TIM5",    TIM5_BASE,          0x400, KIND_TIM,        BUS_APB1, 3 },
+    { "USART2",  USART2_BASE,        0x400, KIND_USART,      BUS_APB1, 1 },
+    { "PWR",     PWR_BASE,           0x400, KIND_PLAIN,      BUS_APB1, 0 },
+    { "USART1",  USART1_BASE,        0x400, KIND_USART,      BUS_APB2, 0 },
+    { "USART6",  USART6_BASE,        0x400, KIND_USART,      BUS_APB2, 2 },
+    { "ADC1",    ADC1_BASE,          0x100, KIND_ADC,        BUS_APB2, 0 },
+    { "ADC",     ADC1_COMMON_BASE,   0x100, KIND_ADC_COMMON, BUS_APB2, 0 },
+    { "GPIOA",   GPIOA_BASE,         0x400, KIND_GPIO,       BUS_AHB1, 0 },
+    { "GPIOB",   GPIOB_BASE,         0x400, KIND_GPIO,       BUS_AHB1, 1 },
+    { "GPIOC",   GPIOC_BASE,         0x400, KIND_GPIO,       BUS_AHB1, 2 },
+    { "GPIOD",   GPIOD_BASE,         0x400, KIND_GPIO,       BUS_AHB1, 3 },
+    { "GPIOE",   GPIOE_BASE,         0x400, KIND_GPIO,       BUS_AHB1, 4 },
+    { "GPIOH",   GPIOH_BASE,         0x400, KIND_GPIO,       BUS_AHB1, 5 },
+    { "RCC",     RCC_BASE,           0x400, KIND_RCC,        BUS_AHB1, 0 },
+    { "FLASH",   FLASH_R_BASE,       0x400, KIND_PLAIN,      BUS_AHB1, 0 },
+    { "DMA1",    DMA1_BASE,          0x400, KIND_DMA,        BUS_AHB1, 0 },
+    { "DMA2",    DMA2_BASE,          0x400, KIND_DMA,        BUS_AHB1, 1 },
+    { "DWT",     DWT_BASE,           0x1000, KIND_DWT,       BUS_CORE, 0 },
+    { "SysTick", SysTick_BASE,       0x10,  KIND_PLAIN,      BUS_CORE, 0 },
+    { "NVIC",    NVIC_BASE,          0x400, KIND_NVIC,       BUS_CORE, 0 },
+    { "SCB",     SCB_BASE,           0x100, KIND_PLAIN,      BUS_CORE, 0 },
+    { "NVIC",    SCS_BASE + 0x0F00UL, 4,    KIND_STIR,       BUS_CORE, 0 },
+    { "DBGMCU",  DBGMCU_BASE,        0x400, KIND_PLAIN,      BUS_CORE, 0 },
+};
+
+static Peripheral_t unmapped = { "other", 0, 0, KIND_PLAIN, BUS_APB1, 0 };
+
+static Window_t windows[2] =
+{
+    { PERIPH_WINDOW_BASE, PERIPH_WINDOW_SIZE, 0, NULL },
+    { CORE_WINDOW_BASE,   CORE_WINDOW_SIZE,   PERIPH_WINDOW_SIZE, NULL },
+};
+
+static Oscillator_t oscillators[] =
+{
+    { "HSI",    0, RCC_CR_HSION,    RCC_CR_HSIRDY,    HSI_STARTUP_NS, NO_EVENT },
+    { "HSE",    0, RCC_CR_HSEON,    RCC_CR_HSERDY,    HSE_STARTUP_NS, NO_EVENT },
+    { "PLL",    0, RCC_CR_PLLON,    RCC_CR_PLLRDY,    PLL_LOCK_NS,    NO_EVENT },
+    { "PLLI2S", 0, RCC_CR_PLLI2SON, RCC_CR_PLLI2SRDY, PLL_LOCK_NS,    NO_EVENT },
+    { "LSI",    1, RCC_CSR_LSION,   RCC_CSR_LSIRDY,   LSI_STARTUP_NS, NO_EVENT },
+    { "LSE",    2, RCC_BDCR_LSEON,  RCC_BDCR_LSERDY,  LSE_STARTUP_NS, NO_EVENT },
+};
+
+static RCC_TypeDef* rcc;
+static Gpio_t gpios[6];
+static Adc_t adc;
+static Usart_t usarts[3];
+static Tim_t tims[4];
+static Dma_t dmas[2];
+static NVIC_Type* nvic;
+
+static uint32_t nvic_enabled[IRQ_WORDS];
+static uint32_t nvic_pending[IRQ_WORDS];
+static uint32_t ipsr;
+
+static struct
+{
+    int running;
+    uint64_t base_time;
+    uint32_t base_cycles;
+} dwt;
+
+/* The access being single-stepped */
+static struct
+{
+    int active;
+    uintptr_t address;
+    Peripheral_t* peripheral;
+    uint32_t old;
+    int write;
+    unsigned windows;
+} stepping;
+
+static Access_t history[POLL_HISTORY];
+static unsigned history_count;
+static uint64_t cost_residual_ps;
+
+static uint64_t wakes[MAX_MODEL_WAKES];
+static unsigned wake_count;
+
+static int log_outputs;
+static uint64_t polling_skips;
+
+static void model_sync(uint64_t t);
+static void schedule_wake(uint64_t t);
+static void schedule_wakes(void);
+static void service_dma_requests(uint64_t t);
+static int dma_request(DmaRequest_t request, uint64_t t);
+static void adc_external_trigger(int extsel, uint64_t t);
+
+/* Entry stub for an interrupt taken at a register access, see enter_interrupts() */
+void model_interrupt_entry(void);
+
+/* Handlers of the vector table, from Core/Src/stm32f4xx_it.c where defined */
+#define VECTOR_TABLE(X) \
+    X(EXTI0_IRQn, EXTI0_IRQHandler) \
+    X(EXTI1_IRQn, EXTI1_IRQHandler) \
+    X(EXTI2_IRQn, EXTI2_IRQHandler) \
+    X(EXTI3_IRQn, EXTI3_IRQHandler) \
+    X(EXTI4_IRQn, EXTI4_IRQHandler) \
+    X(DMA1_Stream0_IRQn, DMA1_Stream0_IRQHandler) \
+    X(DMA1_Stream1_IRQn, DMA1_Stream1_IRQHandler) \
+    X(DMA1_Stream2_IRQn, DMA1_Stream2_IRQHandler) \
+    X(DMA1_Stream3_IRQn, DMA1_Stream3_IRQHandler) \
+    X(DMA1_Stream4_IRQn, DMA1_Stream4_IRQHandler) \
+    X(DMA1_Stream5_IRQn, DMA1_Stream5_IRQHandler) \
+    X(DMA1_Stream6_IRQn, DMA1_Stream6_IRQHandler) \
+    X(ADC_IRQn, ADC_IRQHandler) \
+    X(EXTI9_5_IRQn, EXTI9_5_IRQHandler) \
+    X(TIM2_IRQn, TIM2_IRQHandler) \
+    X(TIM3_IRQn, TIM3_IRQHandler) \
+    X(TIM4_IRQn, TIM4_IRQHandler) \
+    X(USART1_IRQn, USART1_IRQHandler) \
+    X(USART2_IRQn, USART2_IRQHandler) \
+    X(EXTI15_10_IRQn, EXTI15_10_IRQHandler) \
+    X(DMA1_Stream7_IRQn, DMA1_Stream7_IRQHandler) \
+    X(TIM5_IRQn, TIM5_IRQHandler) \
+    X(DMA2_Stream0_IRQn, DMA2_Stream0_IRQHandler) \
+    X(DMA2_Stream1_IRQn, DMA2_Stream1_IRQHandler) \
+    X(DMA2_Stream2_IRQn, DMA2_Stream2_IRQHandler) \
+    X(DMA2_Stream3_IRQn, DMA2_Stream3_IRQHandler) \
+    X(DMA2_Stream4_IRQn, DMA2_Stream4_IRQHandler) \
+    X(DMA2_Stream5_IRQn, DMA2_Stream5_IRQHandler) \
+    X(DMA2_Stream6_IRQn, DMA2_Stream6_IRQHandler) \
+    X(DMA2_Stream7_IRQn, DMA2_Stream7_IRQHandler) \
+    X(USART6_IRQn, USART6_IRQHandler)
+
+#define DECLARE_HANDLER(irq, handler) extern void handler(void) __attribute__((weak));
+VECTOR_TABLE(DECLARE_HANDLER)
+
+static void (*vector(int irq))(void)
+{
+    switch (irq)
+    {
+#define VECTOR_CASE(irq, handler) case irq: return handler;
+        VECTOR_TABLE(VECTOR_CASE)
+        default:
+            return NULL;
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * Addresses and clocks
+ * ------------------------------------------------------------------------- */
+
+static Window_t* find_window(uintptr_t address)
+{
+    for (unsigned i = 0; i < 2; i++)
+    {
+        if ((address >= windows[i].base) && (address - windows[i].base < windows[i].size))
+        {
+            return &windows[i];
+        }
+    }
+    return NULL;
+}
+
+/* Where the model keeps the register at a device address */
+static void* alias(uintptr_t address)
+{
+    Window_t* window = find_window(address);
+
+    return window->alias + (address - window->base);
+}
+
+static Peripheral_t* find_peripheral(uintptr_t address)
+{
+    for (unsigned i = 0; i < sizeof(peripherals) / sizeof(peripherals[0]); i++)
+    {
+        if ((address >= peripherals[i].base) && (address - peripherals[i].base < peripherals[i].size))
+        {
+            return &peripherals[i];
+        }
+    }
+    return &unmapped;
+}
+
+static uint32_t ahb_divider(uint32_t hpre)
+{
+    static const uint16_t dividers[8] = { 2, 4, 8, 16, 64, 128, 256, 512 };
+
+    return (hpre < 8) ? 1 : dividers[hpre - 8];
+}
+
+static uint32_t apb_divider(uint32_t ppre)
+{
+    return (ppre < 4) ? 1 : (2U << (ppre - 4));
+}
+
+/* The clock tree as configured in RCC at this moment */
+static void get_clocks(Clocks_t* clocks)
+{
+    uint32_t cfgr = rcc->CFGR;
+    uint32_t pllcfgr = rcc->PLLCFGR;
+    uint32_t ppre1 = apb_divider((cfgr & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos);
+    uint32_t ppre2 = apb_divider((cfgr & RCC_CFGR_PPRE2) >> RCC_CFGR_PPRE2_Pos);
+
+    switch (cfgr & RCC_CFGR_SWS)
+    {
+        case RCC_CFGR_SWS_HSE:
+            clocks->sysclk = HSE_VALUE;
+            break;
+        case RCC_CFGR_SWS_PLL:
+        {
+            uint64_t source = (pllcfgr & RCC_PLLCFGR_PLLSRC) ? HSE_VALUE : HSI_VALUE;
+            uint32_t m = pllcfgr & RCC_PLLCFGR_PLLM;
+            uint32_t n = (pllcfgr & RCC_PLLCFGR_PLLN) >> RCC_PLLCFGR_PLLN_Pos;
+            uint32_t p = (((pllcfgr & RCC_PLLCFGR_PLLP) >> RCC_PLLCFGR_PLLP_Pos) + 1) * 2;
+
+            clocks->sysclk = (m == 0) ? 0 : (uint32_t)(source * n / m / p);
+            break;
+        }
+        default:
+            clocks->sysclk = HSI_VALUE;
+            break;
+    }
+
+    clocks->hclk = clocks->sysclk / ahb_divider((cfgr & RCC_CFGR_HPRE) >> RCC_CFGR_HPRE_Pos);
+    clocks->pclk1 = clocks->hclk / ppre1;
+    clocks->pclk2 = clocks->hclk / ppre2;
+    clocks->timclk1 = (ppre1 == 1) ? clocks->pclk1 : 2 * clocks->pclk1;
+    clocks->adcclk = clocks->pclk2 / ((((adc.common->CCR & ADC_CCR_ADCPRE) >> ADC_CCR_ADCPRE_Pos) + 1) * 2);
+}
+
+/* Time for a number of cycles of a clock, rounded up to whole nanoseconds */
+static uint64_t cycles_ns(uint64_t cycles, uint32_t hz)
+{
+    if (hz == 0)
+    {
+        return NO_EVENT;
+    }
+    return (uint64_t)(((unsigned __int128)cycles * NS_PER_SECOND + hz - 1) / hz);
+}
+
+/* ---------------------------------------------------------------------------
+ * RCC
+ * ------------------------------------------------------------------------- */
+
+static volatile uint32_t* oscillator_register(const Oscillator_t* oscillator)
+{
+    switch (oscillator->reg)
+    {
+        case 1:
+            return &rcc->CSR;
+        case 2:
+            return &rcc->BDCR;
+        default:
+            return &rcc->CR;
+    }
+}
+
+static void tim_rebase(Tim_t* tim, uint64_t t);
+
+/* Moves what counts clock cycles onto the clocks before a clock change */
+static void rebase_clocked(uint64_t t)
+{
+    Clocks_t clocks;
+
+    for (unsigned i = 0; i < 4; i++)
+    {
+        tim_rebase(&tims[i], t);
+    }
+
+    if (dwt.running)
+    {
+        get_clocks(&clocks);
+        dwt.base_cycles += (uint32_t)((unsigned __int128)(t - dwt.base_time) * clocks.hclk / NS_PER_SECOND);
+        dwt.base_time = t;
+    }
+}
+
+/* Completes a system clock switch once the new source is ready */
+static void rcc_switch_clock(uint64_t t)
+{
+    static const uint32_t ready[3] = { RCC_CR_HSIRDY, RCC_CR_HSERDY, RCC_CR_PLLRDY };
+    uint32_t sw = rcc->CFGR & RCC_CFGR_SW;
+
+    if ((sw < 3) && (sw != (rcc->CFGR & RCC_CFGR_SWS) >> RCC_CFGR_SWS_Pos) && (rcc->CR & ready[sw]))
+    {
+        rebase_clocked(t);
+        rcc->CFGR = (rcc->CFGR & ~RCC_CFGR_SWS) | (sw << RCC_CFGR_SWS_Pos);
+    }
+}
+
+static uint64_t rcc_next_event(void)
+{
+    uint64_t next = NO_EVENT;
+
+    for (unsigned i = 0; i < sizeof(oscillators) / sizeof(oscillators[0]); i++)
+    {
+        if (oscillators[i].ready_time < next)
+        {
+            next = oscillators[i].ready_time;
+        }
+    }
+    return next;
+}
+
+static void rcc_step(uint64_t t)
+{
+    for (unsigned i = 0; i < sizeof(oscillators) / sizeof(oscillators[0]); i++)
+    {
+        if (oscillators[i].ready_time <= t)
+        {
+            *oscillator_register(&oscillators[i]) |= oscillators[i].ready;
+            oscillators[i].ready_time = NO_EVENT;
+        }
+    }
+    rcc_switch_clock(t);
+}
+
+static void rcc_write(uint32_t offset, uint32_t old, uint32_t value, uint64_t t)
+{
+    uint32_t read_only = 0;
+    volatile uint32_t* reg = (volatile uint32_t*)((uint8_t*)rcc + offset);
+    uint8_t index;
+
+    switch (offset)
+    {
+        case offsetof(RCC_TypeDef, CR):
+            read_only = RCC_CR_HSIRDY | RCC_CR_HSICAL | RCC_CR_HSERDY | RCC_CR_PLLRDY | RCC_CR_PLLI2SRDY;
+            index = 0;
+            break;
+        case offsetof(RCC_TypeDef, CSR):
+            read_only = RCC_CSR_LSIRDY | 0xFE000000U;
+            if (value & RCC_CSR_RMVF)
+            {
+                old &= ~0xFE000000U;
+                value &= ~RCC_CSR_RMVF;
+            }
+            index = 1;
+            break;
+        case offsetof(RCC_TypeDef, BDCR):
+            read_only = RCC_BDCR_LSERDY;
+            index = 2;
+            break;
+        case offsetof(RCC_TypeDef, CFGR):
+            *reg = (value & ~RCC_CFGR_SWS) | (old & RCC_CFGR_SWS);
+            rcc_switch_clock(t);
+            return;
+        default:
+            return;
+    }
+
+    value = (value & ~read_only) | (old & read_only);
+    for (unsigned i = 0; i < sizeof(oscillators) / sizeof(oscillators[0]); i++)
+    {
+        Oscillator_t* oscillator = &oscillators[i];
+
+        if (oscillator->reg != index)
+        {
+            continue;
+        }
+        if ((value & oscillator->on) && !(old & oscillator->on) && !(value & oscillator->ready))
+        {
+            oscillator->ready_time = t + oscillator->startup_ns;
+        }
+        else if (!(value & oscillator->on))
+        {
+            value &= ~oscillator->ready;
+            oscillator->ready_time = NO_EVENT;
+        }
+    }
+    *reg = value;
+}
+
+/* ---------------------------------------------------------------------------
+ * GPIO
+ * ------------------------------------------------------------------------- */
+
+static uint32_t gpio_idr(const Gpio_t* gpio)
+{
+    uint32_t idr = 0;
+
+    for (unsigned pin = 0; pin < 16; pin++)
+    {
+        uint32_t mode = (gpio->regs->MODER >> (2 * pin)) & 3;
+        uint32_t pull = (gpio->regs->PUPDR >> (2 * pin)) & 3;
+        uint32_t level;
+
+        if (mode == 1)
+        {
+            level = (gpio->regs->ODR >> pin) & 1;
+        }
+        else if (mode == 3)
+        {
+            level = 0;
+        }
+        else if (gpio->driven & (1U << pin))
+        {
+            level = (gpio->level >> pin) & 1;
+        }
+        else
+        {
+            level = (pull == 1);
+        }
+        idr |= level << pin;
+    }
+    return idr;
+}
+
+static void gpio_output_changed(Gpio_t* gpio, uint32_t old_odr, uint64_t t)
+{
+    uint32_t odr = gpio->regs->ODR & 0xFFFF;
+    uint32_t changed = (odr ^ old_odr) & 0xFFFF;
+
+    for (unsigned pin = 0; pin < 16; pin++)
+    {
+        if (!(changed & (1U << pin)) || (((gpio->regs->MODER >> (2 * pin)) & 3) != 1))
+        {
+            continue;
+        }
+        if (odr & (1U << pin))
+        {
+            gpio->rising_edges[pin]++;
+        }
+        if (log_outputs)
+        {
+            printf("%4llu.%06llu %s %u %lu\n", (unsigned long long)(t / NS_PER_SECOND),
+                   (unsigned long long)((t / 1000) % 1000000), gpio->name, pin, (unsigned long)((odr >> pin) & 1));
+        }
+    }
+}
+
+static void gpio_write(Gpio_t* gpio, uint32_t offset, uint32_t old, uint32_t value, uint64_t t)
+{
+    uint32_t old_odr = gpio->regs->ODR;
+
+    switch (offset)
+    {
+        case offsetof(GPIO_TypeDef, BSRR):
+            /* Set wins over reset for the same pin */
+            gpio->regs->ODR = ((old_odr & ~(value >> 16)) | value) & 0xFFFF;
+            gpio->regs->BSRR = 0;
+            gpio_output_changed(gpio, old_odr, t);
+            break;
+        case offsetof(GPIO_TypeDef, ODR):
+            gpio->regs->ODR = value & 0xFFFF;
+            gpio_output_changed(gpio, old, t);
+            break;
+        case offsetof(GPIO_TypeDef, IDR):
+            gpio->regs->IDR = old;
+            break;
+        default:
+            break;
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * ADC1
+ * ------------------------------------------------------------------------- */
+
+static uint16_t default_analog_input(uint32_t channel, uint64_t time_ns)
+{
+    uint64_t period = (channel + 2) * NS_PER_SECOND;
+    uint64_t phase = time_ns % period;
+
+    if (channel == ADC_CHANNEL_TEMP)
+    {
+        return ADC_TEMP_VALUE;
+    }
+    if (channel == ADC_CHANNEL_VREF)
+    {
+        return ADC_VREF_VALUE;
+    }
+
+    /* A triangle from 0 to 4095 and back, slower on higher channels */
+    if (phase >= period / 2)
+    {
+        phase = period - phase;
+    }
+    return (uint16_t)(4095 * phase / (period / 2));
+}
+
+static uint32_t adc_sequence_length(void)
+{
+    if (!(adc.regs->CR1 & ADC_CR1_SCAN))
+    {
+        return 1;
+    }
+    return ((adc.regs->SQR1 & ADC_SQR1_L) >> ADC_SQR1_L_Pos) + 1;
+}
+
+static uint32_t adc_channel(uint32_t rank)
+{
+    if (rank < 6)
+    {
+        return (adc.regs->SQR3 >> (5 * rank)) & 0x1F;
+    }
+    if (rank < 12)
+    {
+        return (adc.regs->SQR2 >> (5 * (rank - 6))) & 0x1F;
+    }
+    return (adc.regs->SQR1 >> (5 * (rank - 12))) & 0x1F;
+}
+
+static uint32_t adc_resolution(void)
+{
+    static const uint8_t bits[4] = { 12, 10, 8, 6 };
+
+    return bits[(adc.regs->CR1 & ADC_CR1_RES) >> ADC_CR1_RES_Pos];
+}
+
+static void adc_start_conversion(uint64_t t)
+{
+    static const uint16_t sampling_cycles[8] = { 3, 15, 28, 56, 84, 112, 144, 480 };
+    uint32_t channel = adc_channel(adc.rank);
+    uint32_t smp = (channel < 10) ? (adc.regs->SMPR2 >> (3 * channel)) & 7
+                                  : (adc.regs->SMPR1 >> (3 * (channel - 10))) & 7;
+    Clocks_t clocks;
+
+    get_clocks(&clocks);
+    adc.busy = 1;
+    adc.conversion_end = t + cycles_ns(sampling_cycles[smp] + adc_resolution(), clocks.adcclk);
+    adc.regs->SR |= ADC_SR_STRT;
+}
+
+static void adc_start_sequence(uint64_t t)
+{
+    if (!(adc.regs->CR2 & ADC_CR2_ADON) || adc.busy)
+    {
+        return;
+    }
+    adc.rank = 0;
+    adc_start_conversion(t);
+}
+
+static void adc_external_trigger(int extsel, uint64_t t)
+{
+    uint32_t cr2 = adc.regs->CR2;
+
+    if ((cr2 & ADC_CR2_EXTEN) && ((int)((cr2 & ADC_CR2_EXTSEL) >> ADC_CR2_EXTSEL_Pos) == extsel))
+    {
+        adc_start_sequence(t);
+    }
+}
+
+static uint64_t adc_next_event(void)
+{
+    return adc.busy ? adc.conversion_end : NO_EVENT;
+}
+
+static void adc_step(uint64_t t)
+{
+    uint32_t cr1 = adc.regs->CR1;
+    uint32_t cr2 = adc.regs->CR2;
+    uint32_t channel = adc_channel(adc.rank);
+    uint32_t bits = adc_resolution();
+    uint32_t value = adc.input(channel, t) >> (12 - bits);
+    int last = (adc.rank + 1 >= adc_sequence_length());
+
+    adc.conversions++;
+
+    /* Overrun: the previous result was not read.  The ADC stops. */
+    if (adc.dr_unread && ((cr2 & ADC_CR2_EOCS) || (cr2 & ADC_CR2_DMA)))
+    {
+        adc.regs->SR |= ADC_SR_OVR;
+        adc.busy = 0;
+        return;
+    }
+
+    if (cr1 & ADC_CR1_AWDEN)
+    {
+        if (!(cr1 & ADC_CR1_AWDSGL) || ((cr1 & ADC_CR1_AWDCH) == channel))
+        {
+            if ((value > adc.regs->HTR) || (value < adc.regs->LTR))
+            {
+                adc.regs->SR |= ADC_SR_AWD;
+            }
+        }
+    }
+
+    if (cr2 & ADC_CR2_ALIGN)
+    {
+        value <<= (bits == 6) ? 2 : 16 - bits;
+    }
+    adc.regs->DR = value;
+    adc.dr_unread = 1;
+
+    if ((cr2 & ADC_CR2_EOCS) || last)
+    {
+        adc.regs->SR |= ADC_SR_EOC;
+    }
+    if ((cr2 & ADC_CR2_DMA) && !adc.dma_stopped)
+    {
+        dma_request(DMA_ADC1, t);
+    }
+
+    adc.busy = 0;
+    if (!last)
+    {
+        adc.rank++;
+        adc_start_conversion(t);
+    }
+    else if (cr2 & ADC_CR2_CONT)
+    {
+        adc_start_sequence(t);
+    }
+}
+
+static uint32_t adc_read_dr(void)
+{
+    adc.regs->SR &= ~ADC_SR_EOC;
+    adc.dr_unread = 0;
+    return adc.regs->DR;
+}
+
+static void adc_write(uint32_t offset, uint32_t old, uint32_t value, uint64_t t)
+{
+    switch (offset)
+    {
+        case offsetof(ADC_TypeDef, SR):
+            adc.regs->SR = old & (value | ~0x3FU);
+            break;
+        case offsetof(ADC_TypeDef, CR2):
+            if (!(value & ADC_CR2_ADON))
+            {
+                adc.busy = 0;
+            }
+            if ((value & ADC_CR2_DMA) && !(old & ADC_CR2_DMA))
+            {
+                adc.dma_stopped = 0;
+            }
+            if (value & ADC_CR2_SWSTART)
+            {
+                adc.regs->CR2 = value & ~ADC_CR2_SWSTART;
+                adc_start_sequence(t);
+            }
+            adc.regs->CR2 &= ~ADC_CR2_JSWSTART;
+            break;
+        case offsetof(ADC_TypeDef, DR):
+            adc.regs->DR = old;
+            break;
+        default:
+            break;
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * USART
+ * ------------------------------------------------------------------------- */
+
+/* Time of one frame: start bit, 8 or 9 data bits and the stop bits */
+static uint64_t usart_frame_ns(const Usart_t* usart)
+{
+    static const uint8_t stop_half_bits[4] = { 2, 1, 4, 3 };
+    uint32_t cr1 = usart->regs->CR1;
+    uint32_t brr = usart->regs->BRR & 0xFFFF;
+    uint64_t half_bits = 2 * (1 + ((cr1 & USART_CR1_M) ? 9 : 8)) +
+                         stop_half_bits[(usart->regs->CR2 & USART_CR2_STOP) >> USART_CR2_STOP_Pos];
+    Clocks_t clocks;
+    uint32_t pclk;
+
+    get_clocks(&clocks);
+    pclk = (usart->bus == BUS_APB1) ? clocks.pclk1 : clocks.pclk2;
+
+    if (cr1 & USART_CR1_OVER8)
+    {
+        /* USARTDIV = BRR[15:4] + BRR[2:0] / 8, baud = 2 * pclk / (16 * USARTDIV) */
+        brr = (brr & 0xFFF0) | ((brr & 7) << 1);
+        return cycles_ns(half_bits * brr, 4 * pclk);
+    }
+    return cycles_ns(half_bits * brr, 2 * pclk);
+}
+
+static int usart_enabled(const Usart_t* usart, uint32_t direction)
+{
+    return (usart->regs->CR1 & (USART_CR1_UE | direction)) == (USART_CR1_UE | direction);
+}
+
+static uint64_t usart_rx_arrival(const Usart_t* usart)
+{
+    uint64_t start = usart->rx[usart->rx_head].time;
+
+    if (usart->line_idle > start)
+    {
+        start = usart->line_idle;
+    }
+    if (!usart_enabled(usart, USART_CR1_RE) || ((usart->regs->BRR & 0xFFFF) == 0))
+    {
+        return start;
+    }
+    return start + usart_frame_ns(usart);
+}
+
+static uint64_t usart_next_event(const Usart_t* usart)
+{
+    uint64_t next = usart->tx_busy ? usart->tx_end : NO_EVENT;
+
+    if (usart->rx_count > 0)
+    {
+        uint64_t arrival = usart_rx_arrival(usart);
+
+        if (arrival < next)
+        {
+            next = arrival;
+        }
+    }
+    else if (usart->idle_armed && usart_enabled(usart, USART_CR1_RE))
+    {
+        uint64_t idle = usart->line_idle + usart_frame_ns(usart);
+
+        if (idle < next)
+        {
+            next = idle;
+        }
+    }
+    return next;
+}
+
+static void usart_start_shift(Usart_t* usart, uint8_t byte, uint64_t t)
+{
+    usart->tx_busy = 1;
+    usart->tx_shift = byte;
+    usart->tx_end = t + usart_frame_ns(usart);
+    usart->regs->SR |= USART_SR_TXE;
+}
+
+static void usart_write_dr(Usart_t* usart, uint32_t value, uint64_t t)
+{
+    if (!usart_enabled(usart, USART_CR1_TE))
+    {
+        return;
+    }
+    usart->regs->SR &= ~USART_SR_TC;
+    if (!usart->tx_busy)
+    {
+        usart_start_shift(usart, (uint8_t)value, t);
+    }
+    else
+    {
+        usart->tdr = (uint8_t)value;
+        usart->tdr_full = 1;
+        usart->regs->SR &= ~USART_SR_TXE;
+    }
+}
+
+static uint32_t usart_read_dr(Usart_t* usart)
+{
+    if (usart->sr_read)
+    {
+        usart->regs->SR &= ~(USART_SR_PE | USART_SR_FE | USART_SR_NE | USART_SR_ORE | USART_SR_IDLE);
+        usart->sr_read = 0;
+    }
+    usart->regs->SR &= ~USART_SR_RXNE;
+    return usart->regs->DR;
+}
+
+static void usart_step(Usart_t* usart, uint64_t t)
+{
+    if (usart->tx_busy && (usart->tx_end == t))
+    {
+        usart->bytes_sent++;
+        if (usart->output != NULL)
+        {
+            fputc(usart->tx_shift, usart->output);
+        }
+        if (usart->tdr_full)
+        {
+            usart->tdr_full = 0;
+            usart_start_shift(usart, usart->tdr, t);
+        }
+        else
+        {
+            usart->tx_busy = 0;
+            usart->regs->SR |= USART_SR_TC;
+        }
+    }
+
+    if ((usart->rx_count > 0) && (usart_rx_arrival(usart) == t))
+    {
+        uint8_t byte = usart->rx[usart->rx_head].byte;
+
+        usart->rx_head = (usart->rx_head + 1) % USART_RX_QUEUE_SIZE;
+        usart->rx_count--;
+        usart->line_idle = t;
+        if (usart_enabled(usart, USART_CR1_RE))
+        {
+            usart->bytes_received++;
+            usart->idle_armed = 1;
+            if (usart->regs->SR & USART_SR_RXNE)
+            {
+                usart->regs->SR |= USART_SR_ORE;
+            }
+            else
+            {
+                usart->regs->DR = byte;
+                usart->regs->SR |= USART_SR_RXNE;
+            }
+        }
+    }
+    else if ((usart->rx_count == 0) && usart->idle_armed && usart_enabled(usart, USART_CR1_RE) &&
+             (usart->line_idle + usart_frame_ns(usart) == t))
+    {
+        usart->idle_armed = 0;
+        usart->regs->SR |= USART_SR_IDLE;
+    }
+}
+
+static void usart_write(Usart_t* usart, uint32_t offset, uint32_t old, uint32_t value, uint64_t t)
+{
+    const uint32_t rc_w0 = USART_SR_RXNE | USART_SR_TC | USART_SR_LBD | USART_SR_CTS;
+
+    switch (offset)
+    {
+        case offsetof(USART_TypeDef, SR):
+            usart->regs->SR = old & (value | ~rc_w0);
+            break;
+        case offsetof(USART_TypeDef, DR):
+            usart->regs->DR = old;
+            usart_write_dr(usart, value, t);
+            break;
+        case offsetof(USART_TypeDef, CR1):
+            if (!(value & USART_CR1_UE))
+            {
+                usart->tx_busy = 0;
+                usart->tdr_full = 0;
+                usart->idle_armed = 0;
+                usart->regs->SR |= USART_SR_TXE | USART_SR_TC;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static Usart_t* find_usart(USART_TypeDef* instance)
+{
+    for (unsigned i = 0; i < 3; i++)
+    {
+        if ((uintptr_t)alias((uintptr_t)instance) == (uintptr_t)usarts[i].regs)
+        {
+            return &usarts[i];
+        }
+    }
+    return NULL;
+}
+
+/* ---------------------------------------------------------------------------
+ * TIM2-TIM5, up-counting
+ *
+ * A running counter is kept as the count at a base time.  Every event moves
+ * the base to the tick of the event, and so does any access, to the last
+ * tick before it, so the phase of the ticks is never lost.
+ * ------------------------------------------------------------------------- */
+
+/* TIM2-TIM5 are on APB1 */
+static uint64_t tim_clock(void)
+{
+    Clocks_t clocks;
+
+    get_clocks(&clocks);
+    return clocks.timclk1;
+}
+
+/* Virtual time of the k-th tick after the base */
+static uint64_t tim_tick_time(const Tim_t* tim, uint64_t ticks)
+{
+    uint64_t clock = tim_clock();
+
+    if (clock == 0)
+    {
+        return NO_EVENT;
+    }
+    return tim->base_time +
+           (uint64_t)(((unsigned __int128)ticks * (tim->psc + 1) * NS_PER_SECOND + clock - 1) / clock);
+}
+
+/* Ticks from the base up to time t */
+static uint64_t tim_ticks(const Tim_t* tim, uint64_t t)
+{
+    uint64_t clock = tim_clock();
+
+    return (uint64_t)((unsigned __int128)(t - tim->base_time) * clock / ((uint64_t)(tim->psc + 1) * NS_PER_SECOND));
+}
+
+static void tim_rebase(Tim_t* tim, uint64_t t)
+{
+    uint64_t ticks;
+
+    if (!tim->running)
+    {
+        return;
+    }
+    ticks = tim_ticks(tim, t);
+    tim->base_time = tim_tick_time(tim, ticks);
+    tim->base_count += (uint32_t)ticks;
+    tim->regs->CNT = tim->base_count;
+}
+
+/* Ticks from the base to the overflow, and to the next compare match */
+static uint64_t tim_overflow_ticks(const Tim_t* tim)
+{
+    uint32_t top = (tim->base_count <= tim->arr) ? tim->arr : tim->max;
+
+    return (uint64_t)(top - tim->base_count) + 1;
+}
+
+static int tim_compare_mode(const Tim_t* tim, unsigned channel)
+{
+    uint32_t ccmr = (channel < 2) ? tim->regs->CCMR1 : tim->regs->CCMR2;
+
+    return ((ccmr >> (8 * (channel & 1))) & TIM_CCMR1_CC1S) == 0;
+}
+
+static uint32_t tim_ccr(const Tim_t* tim, unsigned channel)
+{
+    const volatile uint32_t* ccr = &tim->regs->CCR1;
+
+    return ccr[channel];
+}
+
+static uint64_t tim_next_event(const Tim_t* tim)
+{
+    uint64_t ticks;
+
+    if (!tim->running || (tim->arr == 0))
+    {
+        return NO_EVENT;
+    }
+
+    ticks = tim_overflow_ticks(tim);
+    for (unsigned channel = 0; channel < 4; channel++)
+    {
+        uint32_t ccr = tim_ccr(tim, channel);
+
+        if (tim_compare_mode(tim, channel) && (ccr > tim->base_count) && (ccr - tim->base_count < ticks))
+        {
+            ticks = ccr - tim->base_count;
+        }
+    }
+    return tim_tick_time(tim, ticks);
+}
+
+static void tim_compare_event(Tim_t* tim, unsigned channel, uint64_t t)
+{
+    tim->regs->SR |= TIM_SR_CC1IF << channel;
+    if (tim->adc_trigger[channel] >= 0)
+    {
+        adc_external_trigger(tim->adc_trigger[channel], t);
+    }
+}
+
+/* The preloaded prescaler and auto-reload values take effect */
+static void tim_update_event(Tim_t* tim)
+{
+    tim->psc = tim->regs->PSC & 0xFFFF;
+    tim->arr = tim->regs->ARR & tim->max;
+}
+
+static void tim_step(Tim_t* tim, uint64_t t)
+{
+    uint64_t ticks = tim_ticks(tim, t);
+    int overflow = (ticks >= tim_overflow_ticks(tim));
+    uint32_t count = overflow ? 0 : tim->base_count + (uint32_t)ticks;
+
+    tim->base_time = t;
+    tim->base_count = count;
+    tim->regs->CNT = count;
+
+    if (overflow)
+    {
+        if (!(tim->regs->CR1 & TIM_CR1_UDIS))
+        {
+            tim->regs->SR |= TIM_SR_UIF;
+            tim_update_event(tim);
+            if (((tim->regs->CR2 & TIM_CR2_MMS) == TIM_CR2_MMS_1) && (tim->adc_trigger[4] >= 0))
+            {
+                adc_external_trigger(tim->adc_trigger[4], t);
+            }
+        }
+        if (tim->regs->CR1 & TIM_CR1_OPM)
+        {
+            tim->regs->CR1 &= ~TIM_CR1_CEN;
+            tim->running = 0;
+        }
+    }
+
+    for (unsigned channel = 0; channel < 4; channel++)
+    {
+        if (tim_compare_mode(tim, channel) && (tim_ccr(tim, channel) == count))
+        {
+            tim_compare_event(tim, channel, t);
+        }
+    }
+}
+
+static void tim_write(Tim_t* tim, uint32_t offset, uint32_t old, uint32_t value, uint64_t t)
+{
+    const uint32_t rc_w0 = 0x1E7F;
+
+    switch (offset)
+    {
+        case offsetof(TIM_TypeDef, CR1):
+            if ((value & TIM_CR1_CEN) && !tim->running)
+            {
+                tim->running = 1;
+                tim->base_time = t;
+                tim->base_count = tim->regs->CNT;
+            }
+            else if (!(value & TIM_CR1_CEN))
+            {
+                tim->running = 0;
+            }
+            if (!(value & TIM_CR1_ARPE))
+            {
+                tim->arr = tim->regs->ARR & tim->max;
+            }
+            break;
+        case offsetof(TIM_TypeDef, SR):
+            tim->regs->SR = old & (value | ~rc_w0);
+            break;
+        case offsetof(TIM_TypeDef, EGR):
+            tim->regs->EGR = 0;
+            if (value & TIM_EGR_UG)
+            {
+                tim->base_time = t;
+                tim->base_count = 0;
+                tim->regs->CNT = 0;
+                if (!(tim->regs->CR1 & TIM_CR1_UDIS))
+                {
+                    tim_update_event(tim);
+                    if (!(tim->regs->CR1 & TIM_CR1_URS))
+                    {
+                        tim->regs->SR |= TIM_SR_UIF;
+                    }
+                }
+            }
+            for (unsigned channel = 0; channel < 4; channel++)
+            {
+                if (value & (TIM_EGR_CC1G << channel))
+                {
+                    tim_compare_event(tim, channel, t);
+                }
+            }
+            if (value & TIM_EGR_TG)
+            {
+                tim->regs->SR |= TIM_SR_TIF;
+            }
+            break;
+        case offsetof(TIM_TypeDef, CNT):
+            tim->regs->CNT = value & tim->max;
+            tim->base_time = t;
+            tim->base_count = value & tim->max;
+            break;
+        case offsetof(TIM_TypeDef, ARR):
+            if (!(tim->regs->CR1 & TIM_CR1_ARPE))
+            {
+                tim->arr = value & tim->max;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * DMA1, DMA2
+ * ------------------------------------------------------------------------- */
+
+#define DMA_FEIF     0x01U
+#define DMA_DMEIF    0x04U
+#define DMA_TEIF     0x08U
+#define DMA_HTIF     0x10U
+#define DMA_TCIF     0x20U
+
+static const uint8_t dma_flag_shift[4] = { 0, 6, 16, 22 };
+
+static volatile uint32_t* dma_isr(Dma_t* dma, unsigned stream)
+{
+    return (stream < 4) ? &dma->regs->LISR : &dma->regs->HISR;
+}
+
+static void dma_set_flags(Dma_t* dma, unsigned stream, uint32_t flags)
+{
+    *dma_isr(dma, stream) |= flags << dma_flag_shift[stream & 3];
+}
+
+static uint32_t dma_flags(Dma_t* dma, unsigned stream)
+{
+    return (*dma_isr(dma, stream) >> dma_flag_shift[stream & 3]) & 0x3D;
+}
+
+static uint32_t memory_read(uintptr_t address, uint32_t size)
+{
+    uint32_t value = 0;
+
+    memcpy(&value, (const void*)address, size);
+    return value;
+}
+
+static void memory_write(uintptr_t address, uint32_t value, uint32_t size)
+{
+    memcpy((void*)address, &value, size);
+}
+
+/* A peripheral register read or written by the DMA, with its side effects */
+static uint32_t peripheral_read(uintptr_t address)
+{
+    if (find_window(address) == NULL)
+    {
+        return memory_read(address, 4);
+    }
+    if (address == ADC1_BASE + offsetof(ADC_TypeDef, DR))
+    {
+        return adc_read_dr();
+    }
+    for (unsigned i = 0; i < 3; i++)
+    {
+        if ((uintptr_t)alias(address) == (uintptr_t)&usarts[i].regs->DR)
+        {
+            return usart_read_dr(&usarts[i]);
+        }
+    }
+    return *(volatile uint32_t*)alias(address);
+}
+
+static void peripheral_write(uintptr_t address, uint32_t value, uint32_t size, uint64_t t)
+{
+    if (find_window(address) == NULL)
+    {
+        memory_write(address, value, size);
+        return;
+    }
+    for (unsigned i = 0; i < 3; i++)
+    {
+        if ((uintptr_t)alias(address) == (uintptr_t)&usarts[i].regs->DR)
+        {
+            usart_write_dr(&usarts[i], value, t);
+            return;
+        }
+    }
+    memory_write((uintptr_t)alias(address), value, size);
+}
+
+static void dma_disable(Dma_t* dma, unsigned stream)
+{
+    dma->streams[stream]->CR &= ~DMA_SxCR_EN;
+    dma->active[stream] = 0;
+}
+
+/* Moves one item between the peripheral and memory */
+static void dma_transfer(Dma_t* dma, unsigned stream, DmaRequest_t request, uint64_t t)
+{
+    DMA_Stream_TypeDef* s = dma->streams[stream];
+    uint32_t cr = s->CR;
+    uint32_t size = 1U << ((cr & DMA_SxCR_PSIZE) >> DMA_SxCR_PSIZE_Pos);
+    uintptr_t memory = (cr & DMA_SxCR_CT) ? s->M1AR : s->M0AR;
+
+    if (cr & DMA_SxCR_MINC)
+    {
+        memory += (uintptr_t)dma->transferred[stream] * size;
+    }
+    if (memory < 0x10000)
+    {
+        dma_set_flags(dma, stream, DMA_TEIF);
+        dma_disable(dma, stream);
+        return;
+    }
+
+    if ((cr & DMA_SxCR_DIR) == 0)
+    {
+        memory_write(memory, peripheral_read(s->PAR), size);
+    }
+    else
+    {
+        peripheral_write(s->PAR, memory_read(memory, size), size, t);
+    }
+
+    s->NDTR--;
+    dma->transferred[stream]++;
+    if ((dma->items[stream] >= 2) && (dma->transferred[stream] == dma->items[stream] / 2))
+    {
+        dma_set_flags(dma, stream, DMA_HTIF);
+    }
+    if (s->NDTR == 0)
+    {
+        dma_set_flags(dma, stream, DMA_TCIF);
+        if (cr & (DMA_SxCR_CIRC | DMA_SxCR_DBM))
+        {
+            s->NDTR = dma->items[stream];
+            dma->transferred[stream] = 0;
+            if (cr & DMA_SxCR_DBM)
+            {
+                s->CR ^= DMA_SxCR_CT;
+            }
+        }
+        else
+        {
+            dma_disable(dma, stream);
+            if ((request == DMA_ADC1) && !(adc.regs->CR2 & ADC_CR2_DDS))
+            {
+                adc.dma_stopped = 1;
+            }
+        }
+    }
+}
+
+/* A request from a peripheral; returns 0 when no stream takes it */
+static int dma_request(DmaRequest_t request, uint64_t t)
+{
+    for (unsigned i = 0; i < sizeof(dma_routes) / sizeof(dma_routes[0]); i++)
+    {
+        Dma_t* dma = &dmas[dma_routes[i].dma];
+        unsigned stream = dma_routes[i].stream;
+
+        if ((dma_routes[i].request == request) && dma->active[stream] &&
+            (((dma->streams[stream]->CR & DMA_SxCR_CHSEL) >> DMA_SxCR_CHSEL_Pos) == dma_routes[i].channel))
+        {
+            dma_transfer(dma, stream, request, t);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* The USART requests are levels: TXE and RXNE while DMAT and DMAR are set */
+static void service_dma_requests(uint64_t t)
+{
+    for (unsigned i = 0; i < 3; i++)
+    {
+        Usart_t* usart = &usarts[i];
+
+        while ((usart->regs->CR3 & USART_CR3_DMAT) && (usart->regs->SR & USART_SR_TXE) &&
+               !usart->tdr_full && usart_enabled(usart, USART_CR1_TE) && dma_request(usart->tx_request, t))
+        {
+        }
+        if ((usart->regs->CR3 & USART_CR3_DMAR) && (usart->regs->SR & USART_SR_RXNE))
+        {
+            dma_request(usart->rx_request, t);
+        }
+    }
+}
+
+static uint64_t dma_next_event(const Dma_t* dma)
+{
+    uint64_t next = NO_EVENT;
+
+    for (unsigned stream = 0; stream < 8; stream++)
+    {
+        if (dma->m2m_end[stream] < next)
+        {
+            next = dma->m2m_end[stream];
+        }
+    }
+    return next;
+}
+
+static void dma_step(Dma_t* dma, uint64_t t)
+{
+    for (unsigned stream = 0; stream < 8; stream++)
+    {
+        DMA_Stream_TypeDef* s = dma->streams[stream];
+        uint32_t size = 1U << ((s->CR & DMA_SxCR_PSIZE) >> DMA_SxCR_PSIZE_Pos);
+
+        if (dma->m2m_end[stream] > t)
+        {
+            continue;
+        }
+        dma->m2m_end[stream] = NO_EVENT;
+        for (uint32_t item = 0; item < dma->items[stream]; item++)
+        {
+            uintptr_t source = s->PAR + ((s->CR & DMA_SxCR_PINC) ? item * size : 0);
+            uintptr_t destination = s->M0AR + ((s->CR & DMA_SxCR_MINC) ? item * size : 0);
+
+            memory_write(destination, memory_read(source, size), size);
+        }
+        s->NDTR = 0;
+        dma_set_flags(dma, stream, DMA_TCIF);
+        dma_disable(dma, stream);
+    }
+}
+
+static void dma_write(Dma_t* dma, uint32_t offset, uint32_t old, uint32_t value, uint64_t t)
+{
+    switch (offset)
+    {
+        case offsetof(DMA_TypeDef, LISR):
+        case offsetof(DMA_TypeDef, HISR):
+            *(volatile uint32_t*)((uint8_t*)dma->regs + offset) = old;
+            return;
+        case offsetof(DMA_TypeDef, LIFCR):
+            dma->regs->LISR &= ~value;
+            dma->regs->LIFCR = 0;
+            return;
+        case offsetof(DMA_TypeDef, HIFCR):
+            dma->regs->HISR &= ~value;
+            dma->regs->HIFCR = 0;
+            return;
+        default:
+            break;
+    }
+
+    if ((offset >= 0x10) && ((offset - 0x10) % sizeof(DMA_Stream_TypeDef) == offsetof(DMA_Stream_TypeDef, CR)))
+    {
+        unsigned stream = (offset - 0x10) / sizeof(DMA_Stream_TypeDef);
+        DMA_Stream_TypeDef* s = dma->streams[stream];
+
+        if ((value & DMA_SxCR_EN) && !(old & DMA_SxCR_EN))
+        {
+            Clocks_t clocks;
+
+            dma->items[stream] = s->NDTR & 0xFFFF;
+            dma->transferred[stream] = 0;
+            if ((value & DMA_SxCR_DIR) == DMA_SxCR_DIR_1)
+            {
+                get_clocks(&clocks);
+                dma->m2m_end[stream] = t + cycles_ns((uint64_t)dma->items[stream] * DMA_M2M_CYCLES_PER_ITEM, clocks.hclk);
+            }
+            else
+            {
+                dma->active[stream] = 1;
+            }
+        }
+        else if (!(value & DMA_SxCR_EN) && (old & DMA_SxCR_EN))
+        {
+            /* Disabled before the end of the transfer */
+            if (dma->active[stream] || (dma->m2m_end[stream] != NO_EVENT))
+            {
+                dma_set_flags(dma, stream, DMA_TCIF);
+            }
+            dma->active[stream] = 0;
+            dma->m2m_end[stream] = NO_EVENT;
+        }
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * NVIC and interrupt dispatch
+ * ------------------------------------------------------------------------- */
+
+static void set_irq(uint32_t* levels, int irq, int level)
+{
+    if (level)
+    {
+        levels[irq / 32] |= 1U << (irq % 32);
+    }
+}
+
+/* Interrupt requests of the peripherals, on top of those pended by software */
+static void irq_levels(uint32_t* levels)
+{
+    static const uint8_t dma_irqs[2][8] =
+    {
+        { DMA1_Stream0_IRQn, DMA1_Stream1_IRQn, DMA1_Stream2_IRQn, DMA1_Stream3_IRQn,
+          DMA1_Stream4_IRQn, DMA1_Stream5_IRQn, DMA1_Stream6_IRQn, DMA1_Stream7_IRQn },
+        { DMA2_Stream0_IRQn, DMA2_Stream1_IRQn, DMA2_Stream2_IRQn, DMA2_Stream3_IRQn,
+          DMA2_Stream4_IRQn, DMA2_Stream5_IRQn, DMA2_Stream6_IRQn, DMA2_Stream7_IRQn },
+    };
+    static const uint8_t tim_irqs[4] = { TIM2_IRQn, TIM3_IRQn, TIM4_IRQn, TIM5_IRQn };
+    static const uint8_t usart_irqs[3] = { USART1_IRQn, USART2_IRQn, USART6_IRQn };
+    uint32_t sr = adc.regs->SR;
+    uint32_t cr1 = adc.regs->CR1;
+
+    for (unsigned i = 0; i < IRQ_WORDS; i++)
+    {
+        levels[i] = nvic_pending[i];
+    }
+
+    set_irq(levels, ADC_IRQn, ((sr & ADC_SR_EOC) && (cr1 & ADC_CR1_EOCIE)) ||
+                              ((sr & ADC_SR_OVR) && (cr1 & ADC_CR1_OVRIE)) ||
+                              ((sr & ADC_SR_AWD) && (cr1 & ADC_CR1_AWDIE)) ||
+                              ((sr & ADC_SR_JEOC) && (cr1 & ADC_CR1_JEOCIE)));
+
+    for (unsigned i = 0; i < 4; i++)
+    {
+        set_irq(levels, tim_irqs[i], (tims[i].regs->SR & tims[i].regs->DIER & 0x5F) != 0);
+    }
+
+    for (unsigned i = 0; i < 3; i++)
+    {
+        USART_TypeDef* regs = usarts[i].regs;
+
+        sr = regs->SR;
+        cr1 = regs->CR1;
+        set_irq(levels, usart_irqs[i], ((sr & USART_SR_TXE) && (cr1 & USART_CR1_TXEIE)) ||
+                                       ((sr & USART_SR_TC) && (cr1 & USART_CR1_TCIE)) ||
+                                       ((sr & (USART_SR_RXNE | USART_SR_ORE)) && (cr1 & USART_CR1_RXNEIE)) ||
+                                       ((sr & USART_SR_IDLE) && (cr1 & USART_CR1_IDLEIE)) ||
+                                       ((sr & USART_SR_PE) && (cr1 & USART_CR1_PEIE)) ||
+                                       ((sr & (USART_SR_FE | USART_SR_NE | USART_SR_ORE)) &&
+                                        (regs->CR3 & USART_CR3_EIE) && (regs->CR3 & USART_CR3_DMAR)));
+    }
+
+    for (unsigned d = 0; d < 2; d++)
+    {
+        for (unsigned stream = 0; stream < 8; stream++)
+        {
+            uint32_t flags = dma_flags(&dmas[d], stream);
+            uint32_t cr = dmas[d].streams[stream]->CR;
+
+            set_irq(levels, dma_irqs[d][stream], ((flags & DMA_TCIF) && (cr & DMA_SxCR_TCIE)) ||
+                                                 ((flags & DMA_HTIF) && (cr & DMA_SxCR_HTIE)) ||
+                                                 ((flags & DMA_TEIF) && (cr & DMA_SxCR_TEIE)) ||
+                                                 ((flags & DMA_DMEIF) && (cr & DMA_SxCR_DMEIE)) ||
+                                                 ((flags & DMA_FEIF) && (dmas[d].streams[stream]->FCR & DMA_SxFCR_FEIE)));
+        }
+    }
+}
+
+/* The enabled pending interrupt of highest priority, the lowest number on a tie */
+static int highest_pending_irq(void)
+{
+    uint32_t levels[IRQ_WORDS];
+    int best = -1;
+
+    irq_levels(levels);
+    for (int irq = 0; irq < 32 * IRQ_WORDS; irq++)
+    {
+        if ((levels[irq / 32] & nvic_enabled[irq / 32] & (1U << (irq % 32))) &&
+            ((best < 0) || (nvic->IP[irq] < nvic->IP[best])))
+        {
+            best = irq;
+        }
+    }
+    return best;
+}
+
+static void nvic_refresh(void)
+{
+    uint32_t levels[IRQ_WORDS];
+
+    irq_levels(levels);
+    for (unsigned i = 0; i < IRQ_WORDS; i++)
+    {
+        nvic->ISER[i] = nvic_enabled[i];
+        nvic->ICER[i] = nvic_enabled[i];
+        nvic->ISPR[i] = levels[i];
+        nvic->ICPR[i] = levels[i];
+        nvic->IABR[i] = ((ipsr >= 16) && ((ipsr - 16) / 32 == i)) ? 1U << ((ipsr - 16) % 32) : 0;
+    }
+}
+
+static void nvic_write(uint32_t offset, uint32_t value)
+{
+    unsigned word = (offset % 0x80) / 4;
+
+    if (word >= IRQ_WORDS)
+    {
+        return;
+    }
+    switch (offset / 0x80)
+    {
+        case 0:
+            nvic_enabled[word] |= value;
+            break;
+        case 1:
+            nvic_enabled[word] &= ~value;
+            break;
+        case 2:
+            nvic_pending[word] |= value;
+            break;
+        case 3:
+            nvic_pending[word] &= ~value;
+            break;
+        default:
+            break;
+    }
+}
+
+/* Runs in an interrupt of the host port: takes the pending interrupts in
+ * priority order, one after the other as tail-chaining would. */
+static void dispatch_interrupts(void)
+{
+    for (unsigned round = 0; round < DISPATCH_ROUNDS; round++)
+    {
+        int irq = highest_pending_irq();
+        void (*handler)(void);
+
+        if (irq < 0)
+        {
+            return;
+        }
+
+        handler = vector(irq);
+        if (handler == NULL)
+        {
+            fprintf(stderr, "stm32 model: no handler for IRQ %d, disabled\n", irq);
+            nvic_enabled[irq / 32] &= ~(1U << (irq % 32));
+            continue;
+        }
+
+        nvic_pending[irq / 32] &= ~(1U << (irq % 32));
+        ipsr = (uint32_t)irq + 16;
+        handler();
+        ipsr = 0;
+        model_sync(ullPortGetVirtualTime());
+    }
+
+    /* A handler that does not clear its request would hold the processor
+     * forever; take it again a little later so that time moves on. */
+    if (highest_pending_irq() >= 0)
+    {
+        schedule_wake(ullPortGetVirtualTime() + IRQ_RETRY_NS);
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * Event scheduling
+ * ------------------------------------------------------------------------- */
+
+static uint64_t model_next_event(void)
+{
+    uint64_t next = rcc_next_event();
+    uint64_t t;
+
+    if ((t = adc_next_event()) < next)
+    {
+        next = t;
+    }
+    for (unsigned i = 0; i < 3; i++)
+    {
+        if ((t = usart_next_event(&usarts[i])) < next)
+        {
+            next = t;
+        }
+    }
+    for (unsigned i = 0; i < 4; i++)
+    {
+        if ((t = tim_next_event(&tims[i])) < next)
+        {
+            next = t;
+        }
+    }
+    for (unsigned i = 0; i < 2; i++)
+    {
+        if ((t = dma_next_event(&dmas[i])) < next)
+        {
+            next = t;
+        }
+    }
+    return next;
+}
+
+/* Runs the events of the peripherals up to time t */
+static void model_sync(uint64_t t)
+{
+    for (;;)
+    {
+        uint64_t next = model_next_event();
+
+        if (next > t)
+        {
+            return;
+        }
+        if (rcc_next_event() == next)
+        {
+            rcc_step(next);
+        }
+        for (unsigned i = 0; i < 4; i++)
+        {
+            if (tim_next_event(&tims[i]) == next)
+            {
+                tim_step(&tims[i], next);
+            }
+        }
+        if (adc_next_event() == next)
+        {
+            adc_step(next);
+        }
+        for (unsigned i = 0; i < 3; i++)
+        {
+            if (usart_next_event(&usarts[i]) == next)
+            {
+                usart_step(&usarts[i], next);
+            }
+        }
+        for (unsigned i = 0; i < 2; i++)
+        {
+            if (dma_next_event(&dmas[i]) == next)
+            {
+                dma_step(&dmas[i], next);
+            }
+        }
+        service_dma_requests(next);
+    }
+}
+
+static void model_wake(void)
+{
+    uint64_t now = ullPortGetVirtualTime();
+    unsigned kept = 0;
+
+    for (unsigned i = 0; i < wake_count; i++)
+    {
+        if (wakes[i] > now)
+        {
+            wakes[kept++] = wakes[i];
+        }
+    }
+    wake_count = kept;
+
+    model_sync(now);
+    dispatch_interrupts();
+    schedule_wakes();
+}
+
+static void schedule_wake(uint64_t t)
+{
+    uint64_t now = ullPortGetVirtualTime();
+
+    if (t < now)
+    {
+        t = now;
+    }
+    for (unsigned i = 0; i < wake_count; i++)
+    {
+        if (wakes[i] == t)
+        {
+            return;
+        }
+    }
+    configASSERT(wake_count < MAX_MODEL_WAKES);
+    wakes[wake_count++] = t;
+    vPortScheduleInterrupt(t, model_wake);
+}
+
+/* Makes sure the model wakes for its next event and for a pending interrupt */
+static void schedule_wakes(void)
+{
+    uint64_t next = model_next_event();
+
+    if (next != NO_EVENT)
+    {
+        schedule_wake(next);
+    }
+    if ((ipsr == 0) && (highest_pending_irq() >= 0))
+    {
+        schedule_wake(ullPortGetVirtualTime());
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * Access trapping
+ * ------------------------------------------------------------------------- */
+
+/* The interrupt entry: saves what the interrupted code may hold in
+ * caller-saved registers, runs the due interrupts through the port and
+ * returns to the access, which is then executed.  enter_interrupts() leaves
+ * the return address below the red zone of the interrupted code. */
+__asm__(
+    ".text\n"
+    ".globl model_interrupt_entry\n"
+    ".type model_interrupt_entry, @function\n"
+    "model_interrupt_entry:\n"
+    "    pushfq\n"
+    "    cld\n"
+    "    push %rax\n"
+    "    push %rcx\n"
+    "    push %rdx\n"
+    "    push %rsi\n"
+    "    push %rdi\n"
+    "    push %r8\n"
+    "    push %r9\n"
+    "    push %r10\n"
+    "    push %r11\n"
+    "    push %rbp\n"
+    "    mov %rsp, %rbp\n"
+    "    sub $512, %rsp\n"
+    "    and $-64, %rsp\n"
+    "    fxsave64 (%rsp)\n"
+    "    call model_run_interrupts\n"
+    "    fxrstor64 (%rsp)\n"
+    "    mov %rbp, %rsp\n"
+    "    pop %rbp\n"
+    "    pop %r11\n"
+    "    pop %r10\n"
+    "    pop %r9\n"
+    "    pop %r8\n"
+    "    pop %rdi\n"
+    "    pop %rsi\n"
+    "    pop %rdx\n"
+    "    pop %rcx\n"
+    "    pop %rax\n"
+    "    popfq\n"
+    "    ret $128\n"
+    ".size model_interrupt_entry, .-model_interrupt_entry\n");
+
+void model_run_interrupts(void) __attribute__((used, noinline));
+
+void model_run_interrupts(void)
+{
+    vPortExecute(0);
+}
+
+/* Leaves the signal handler into the interrupt entry instead of the code */
+static void enter_interrupts(ucontext_t* context, greg_t resume)
+{
+    greg_t* gregs = context->uc_mcontext.gregs;
+    greg_t sp = gregs[REG_RSP] - 128 - 8;
+
+    *(greg_t*)sp = resume;
+    gregs[REG_RSP] = sp;
+    gregs[REG_RIP] = (greg_t)(uintptr_t)model_interrupt_entry;
+}
+
+static void protect(unsigned mask, int prot)
+{
+    for (unsigned i = 0; i < 2; i++)
+    {
+        if (mask & (1U << i))
+        {
+            mprotect((void*)windows[i].base, windows[i].size, prot);
+        }
+    }
+}
+
+/* Registers whose value moves with time without an event */
+static int is_free_running(const Peripheral_t* peripheral, uint32_t offset)
+{
+    return ((peripheral->kind == KIND_TIM) && (offset == offsetof(TIM_TypeDef, CNT))) ||
+           ((peripheral->kind == KIND_DWT) && (offset == offsetof(DWT_Type, CYCCNT)));
+}
+
+/* Brings a register up to date before the access */
+static void before_access(Peripheral_t* peripheral, int write, uint64_t t)
+{
+    Clocks_t clocks;
+
+    switch (peripheral->kind)
+    {
+        case KIND_RCC:
+            if (write)
+            {
+                rebase_clocked(t);
+            }
+            break;
+        case KIND_GPIO:
+            gpios[peripheral->index].regs->IDR = gpio_idr(&gpios[peripheral->index]);
+            break;
+        case KIND_ADC_COMMON:
+            adc.common->CSR = adc.regs->SR & 0x3F;
+            break;
+        case KIND_TIM:
+            tim_rebase(&tims[peripheral->index], t);
+            break;
+        case KIND_NVIC:
+            nvic_refresh();
+            break;
+        case KIND_DWT:
+            if (dwt.running)
+            {
+                get_clocks(&clocks);
+                ((DWT_Type*)alias(DWT_BASE))->CYCCNT =
+                    dwt.base_cycles + (uint32_t)((unsigned __int128)(t - dwt.base_time) * clocks.hclk / NS_PER_SECOND);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static void after_read(Peripheral_t* peripheral, uint32_t offset)
+{
+    switch (peripheral->kind)
+    {
+        case KIND_ADC:
+            if (offset == offsetof(ADC_TypeDef, DR))
+            {
+                adc_read_dr();
+            }
+            break;
+        case KIND_USART:
+            if (offset == offsetof(USART_TypeDef, SR))
+            {
+                usarts[peripheral->index].sr_read = 1;
+            }
+            else if (offset == offsetof(USART_TypeDef, DR))
+            {
+                usart_read_dr(&usarts[peripheral->index]);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static void after_write(Peripheral_t* peripheral, uint32_t offset, uint32_t old, uint32_t value, uint64_t t)
+{
+    DWT_Type* dwt_regs = (DWT_Type*)alias(DWT_BASE);
+
+    switch (peripheral->kind)
+    {
+        case KIND_RCC:
+            rcc_write(offset, old, value, t);
+            break;
+        case KIND_GPIO:
+            gpio_write(&gpios[peripheral->index], offset, old, value, t);
+            break;
+        case KIND_ADC:
+            adc_write(offset, old, value, t);
+            break;
+        case KIND_ADC_COMMON:
+            adc.common->CSR = adc.regs->SR & 0x3F;
+            break;
+        case KIND_USART:
+            usart_write(&usarts[peripheral->index], offset, old, value, t);
+            break;
+        case KIND_TIM:
+            tim_write(&tims[peripheral->index], offset, old, value, t);
+            break;
+        case KIND_DMA:
+            dma_write(&dmas[peripheral->index], offset, old, value, t);
+            break;
+        case KIND_NVIC:
+            nvic_write(offset, value);
+            nvic_refresh();
+            break;
+        case KIND_STIR:
+            nvic_pending[(value & 0x1FF) / 32 % IRQ_WORDS] |= 1U << ((value & 0x1FF) % 32);
+            break;
+        case KIND_DWT:
+            if ((offset == offsetof(DWT_Type, CTRL)) || (offset == offsetof(DWT_Type, CYCCNT)))
+            {
+                dwt.running = dwt_regs->CTRL & DWT_CTRL_CYCCNTENA_Msk;
+                dwt.base_time = t;
+                dwt.base_cycles = dwt_regs->CYCCNT;
+            }
+            break;
+        default:
+            break;
+    }
+    service_dma_requests(t);
+}
+
+/* Recognises a loop of up to POLL_MAX_LOOP reads that returned the same
+ * values at a fixed period three rounds in a row, and moves it on to the round
+ * before the next event, which is the earliest anything it reads can
+ * change. */
+static void skip_polling(Peripheral_t* peripheral, uint64_t now)
+{
+    for (unsigned length = 1; length <= POLL_MAX_LOOP; length++)
+    {
+        uint64_t period;
+        uint64_t next;
+        uint64_t rounds;
+        unsigned i;
+
+        if (history_count < 3 * length)
+        {
+            break;
+        }
+        for (i = 0; i < 2 * length; i++)
+        {
+            const Access_t* a = &history[i];
+            const Access_t* b = &history[i + length];
+
+            if (a->write || b->write || (a->rip != b->rip) || (a->address != b->address) || (a->value != b->value))
+            {
+                break;
+            }
+        }
+        if (i < 2 * length)
+        {
+            continue;
+        }
+
+        period = history[0].time - history[length].time;
+        if ((period == 0) || (history[length].time - history[2 * length].time != period))
+        {
+            continue;
+        }
+
+        next = model_next_event();
+        if (xPortInterruptsEnabled() && (ullPortGetNextEventTime() < next))
+        {
+            next = ullPortGetNextEventTime();
+        }
+        if ((next == NO_EVENT) || (next <= now + period))
+        {
+            return;
+        }
+
+        rounds = (next - 1 - now) / period;
+        vPortAdvanceTime(rounds * period);
+        for (i = 0; i < POLL_HISTORY; i++)
+        {
+            history[i].time += rounds * period;
+        }
+        polling_skips++;
+        peripheral->accesses += rounds * length;
+        peripheral->time_ps += rounds * period * 1000;
+        peripheral->polled_accesses += rounds * length;
+        peripheral->polled_ps += rounds * period * 1000;
+        return;
+    }
+}
+
+static void record_access(greg_t rip, uintptr_t address, uint32_t value, int write, uint64_t time)
+{
+    memmove(&history[1], &history[0], sizeof(history) - sizeof(history[0]));
+    history[0].rip = (uintptr_t)rip;
+    history[0].address = address;
+    history[0].value = value;
+    history[0].write = write;
+    history[0].time = time;
+    if (history_count < POLL_HISTORY)
+    {
+        history_count++;
+    }
+}
+
+static uint64_t access_cost_ps(const Peripheral_t* peripheral)
+{
+    Clocks_t clocks;
+    uint64_t ps;
+
+    get_clocks(&clocks);
+    if (clocks.hclk == 0)
+    {
+        return 0;
+    }
+    ps = ACCESS_CPU_CYCLES * PS_PER_SECOND / clocks.hclk;
+    switch (peripheral->bus)
+    {
+        case BUS_APB1:
+            ps += APB_WAIT_CYCLES * PS_PER_SECOND / clocks.pclk1;
+            break;
+        case BUS_APB2:
+            ps += APB_WAIT_CYCLES * PS_PER_SECOND / clocks.pclk2;
+            break;
+        case BUS_AHB1:
+            ps += AHB_WAIT_CYCLES * PS_PER_SECOND / clocks.hclk;
+            break;
+        default:
+            break;
+    }
+    return ps;
+}
+
+static void on_access_fault(int signo, siginfo_t* info, void* ucontext)
+{
+    ucontext_t* context = ucontext;
+    greg_t* gregs = context->uc_mcontext.gregs;
+    uintptr_t address = (uintptr_t)info->si_addr;
+    uintptr_t word = address & ~(uintptr_t)3;
+    Window_t* window = find_window(address);
+    unsigned window_bit;
+    Peripheral_t* peripheral;
+    int write = (gregs[REG_ERR] & 2) != 0;
+    uint64_t cost_ps;
+    uint64_t cost_ns;
+    uint64_t now = ullPortGetVirtualTime();
+    uint32_t offset;
+    uint32_t value;
+
+    (void)signo;
+    if (window == NULL)
+    {
+        /* Not a register: let the fault kill the program as it would */
+        signal(SIGSEGV, SIG_DFL);
+        return;
+    }
+    window_bit = 1U << (window - windows);
+
+    if (stepping.active)
+    {
+        /* The same instruction touches the other window as well (a copy
+         * between peripherals): let it through unmodelled */
+        stepping.windows |= window_bit;
+        protect(window_bit, PROT_READ | PROT_WRITE);
+        return;
+    }
+
+    peripheral = find_peripheral(word);
+    offset = (uint32_t)(word - peripheral->base);
+    cost_ps = access_cost_ps(peripheral);
+    cost_ns = (cost_residual_ps + cost_ps) / 1000;
+
+    /* An interrupt due before the access completes is taken first */
+    if (xPortInterruptsEnabled() && (ullPortGetNextEventTime() <= now + cost_ns))
+    {
+        uint64_t next = ullPortGetNextEventTime();
+
+        if (next > now)
+        {
+            vPortAdvanceTime(next - now);
+        }
+        enter_interrupts(context, gregs[REG_RIP]);
+        return;
+    }
+
+    cost_residual_ps = (cost_residual_ps + cost_ps) % 1000;
+    vPortAdvanceTime(cost_ns);
+    now += cost_ns;
+    peripheral->accesses++;
+    peripheral->time_ps += cost_ps;
+
+    model_sync(now);
+    before_access(peripheral, write, now);
+    value = *(volatile uint32_t*)alias(word);
+
+    if (is_free_running(peripheral, offset))
+    {
+        history_count = 0;
+    }
+    else
+    {
+        record_access(gregs[REG_RIP], word, value, write, now);
+        if (!write)
+        {
+            skip_polling(peripheral, now);
+        }
+    }
+
+    stepping.active = 1;
+    stepping.address = word;
+    stepping.peripheral = peripheral;
+    stepping.old = value;
+    stepping.write = write;
+    stepping.windows = window_bit;
+    protect(window_bit, PROT_READ | PROT_WRITE);
+    gregs[REG_EFL] |= EFLAGS_TRAP;
+}
+
+static void on_access_done(int signo, siginfo_t* info, void* ucontext)
+{
+    ucontext_t* context = ucontext;
+    greg_t* gregs = context->uc_mcontext.gregs;
+    uint64_t now = ullPortGetVirtualTime();
+
+    (void)signo;
+    (void)info;
+    if (!stepping.active)
+    {
+        signal(SIGTRAP, SIG_DFL);
+        return;
+    }
+
+    protect(stepping.windows, PROT_NONE);
+    gregs[REG_EFL] &= ~EFLAGS_TRAP;
+    stepping.active = 0;
+
+    if (stepping.write)
+    {
+        uint32_t value = *(volatile uint32_t*)alias(stepping.address);
+
+        after_write(stepping.peripheral, (uint32_t)(stepping.address - stepping.peripheral->base), stepping.old, value, now);
+    }
+    else
+    {
+        after_read(stepping.peripheral, (uint32_t)(stepping.address - stepping.peripheral->base));
+    }
+    schedule_wakes();
+
+    if (xPortInterruptsEnabled() && (ullPortGetNextEventTime() <= now))
+    {
+        enter_interrupts(context, gregs[REG_RIP]);
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * Set up and API
+ * ------------------------------------------------------------------------- */
+
+static void reset(void)
+{
+    static const uintptr_t gpio_bases[6] = { GPIOA_BASE, GPIOB_BASE, GPIOC_BASE, GPIOD_BASE, GPIOE_BASE, GPIOH_BASE };
+    static const char* const gpio_names[6] = { "GPIOA", "GPIOB", "GPIOC", "GPIOD", "GPIOE", "GPIOH" };
+    static const uintptr_t tim_bases[4] = { TIM2_BASE, TIM3_BASE, TIM4_BASE, TIM5_BASE };
+    static const int8_t tim_adc_triggers[4][5] =
+    {
+        { -1, 3, 4, 5, 6 },     /* TIM2: CC2, CC3, CC4, TRGO */
+        { 7, -1, -1, -1, 8 },   /* TIM3: CC1, TRGO */
+        { -1, -1, -1, 9, -1 },  /* TIM4: CC4 */
+        { 10, 11, 12, -1, -1 }, /* TIM5: CC1, CC2, CC3 */
+    };
+    static const struct
+    {
+        const char* name;
+        uintptr_t base;
+        Bus_t bus;
+        DmaRequest_t rx;
+        DmaRequest_t tx;
+    } usart_config[3] =
+    {
+        { "USART1", USART1_BASE, BUS_APB2, DMA_USART1_RX, DMA_USART1_TX },
+        { "USART2", USART2_BASE, BUS_APB1, DMA_USART2_RX, DMA_USART2_TX },
+        { "USART6", USART6_BASE, BUS_APB2, DMA_USART6_RX, DMA_USART6_TX },
+    };
+    static const uintptr_t dma_bases[2] = { DMA1_BASE, DMA2_BASE };
+    SCB_Type* scb = (SCB_Type*)alias(SCB_BASE);
+
+    rcc = (RCC_TypeDef*)alias(RCC_BASE);
+    rcc->CR = 0x00000083;
+    rcc->PLLCFGR = 0x24003010;
+    rcc->CSR = 0x0E000000;
+    rcc->PLLI2SCFGR = 0x24003000;
+    ((PWR_TypeDef*)alias(PWR_BASE))->CR = 0x00004000;
+    ((PWR_TypeDef*)alias(PWR_BASE))->CSR = PWR_CSR_VOSRDY;
+    ((DBGMCU_TypeDef*)alias(DBGMCU_BASE))->IDCODE = 0x10006423;
+    *(volatile uint32_t*)&scb->CPUID = 0x410FC241;
+
+    for (unsigned i = 0; i < 6; i++)
+    {
+        gpios[i].name = gpio_names[i];
+        gpios[i].regs = (GPIO_TypeDef*)alias(gpio_bases[i]);
+    }
+    gpios[0].regs->MODER = 0xA8000000;
+    gpios[0].regs->PUPDR = 0x64000000;
+    gpios[0].regs->OSPEEDR = 0x0C000000;
+    gpios[1].regs->MODER = 0x00000280;
+    gpios[1].regs->PUPDR = 0x00000100;
+    gpios[1].regs->OSPEEDR = 0x000000C0;
+
+    adc.regs = (ADC_TypeDef*)alias(ADC1_BASE);
+    adc.common = (ADC_Common_TypeDef*)alias(ADC1_COMMON_BASE);
+    adc.input = default_analog_input;
+
+    for (unsigned i = 0; i < 3; i++)
+    {
+        usarts[i].name = usart_config[i].name;
+        usarts[i].regs = (USART_TypeDef*)alias(usart_config[i].base);
+        usarts[i].bus = usart_config[i].bus;
+        usarts[i].rx_request = usart_config[i].rx;
+        usarts[i].tx_request = usart_config[i].tx;
+        usarts[i].regs->SR = USART_SR_TXE | USART_SR_TC;
+    }
+    usarts[1].output = stdout;
+
+    for (unsigned i = 0; i < 4; i++)
+    {
+        tims[i].regs = (TIM_TypeDef*)alias(tim_bases[i]);
+        tims[i].max = ((i == 0) || (i == 3)) ? 0xFFFFFFFF : 0xFFFF;
+        tims[i].regs->ARR = tims[i].max;
+        tims[i].arr = tims[i].max;
+        memcpy(tims[i].adc_trigger, tim_adc_triggers[i], sizeof(tims[i].adc_trigger));
+    }
+
+    for (unsigned i = 0; i < 2; i++)
+    {
+        dmas[i].regs = (DMA_TypeDef*)alias(dma_bases[i]);
+        for (unsigned stream = 0; stream < 8; stream++)
+        {
+            dmas[i].streams[stream] = (DMA_Stream_TypeDef*)((uint8_t*)dmas[i].regs + 0x10 + 0x18 * stream);
+            dmas[i].streams[stream]->FCR = 0x00000021;
+            dmas[i].m2m_end[stream] = NO_EVENT;
+        }
+    }
+
+    nvic = (NVIC_Type*)alias(NVIC_BASE);
+}
+
+void stm32_model_init(void)
+{
+    struct sigaction action;
+    int fd = memfd_create("stm32", 0);
+    uint8_t* alias_base;
+
+    if ((fd < 0) || (ftruncate(fd, PERIPH_WINDOW_SIZE + CORE_WINDOW_SIZE) != 0))
+    {
+        perror("stm32 model");
+        exit(EXIT_FAILURE);
+    }
+
+    alias_base = mmap(NULL, PERIPH_WINDOW_SIZE + CORE_WINDOW_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (alias_base == MAP_FAILED)
+    {
+        perror("stm32 model");
+        exit(EXIT_FAILURE);
+    }
+    for (unsigned i = 0; i < 2; i++)
+    {
+        windows[i].alias = alias_base + windows[i].offset;
+        if (mmap((void*)windows[i].base, windows[i].size, PROT_NONE, MAP_SHARED | MAP_FIXED_NOREPLACE,
+                 fd, (off_t)windows[i].offset) != (void*)windows[i].base)
+        {
+            fprintf(stderr, "stm32 model: cannot map the registers at 0x%08lx\n", (unsigned long)windows[i].base);
+            exit(EXIT_FAILURE);
+        }
+    }
+    close(fd);
+
+    reset();
+
+    memset(&action, 0, sizeof(action));
+    action.sa_flags = SA_SIGINFO;
+    sigemptyset(&action.sa_mask);
+    action.sa_sigaction = on_access_fault;
+    sigaction(SIGSEGV, &action, NULL);
+    action.sa_sigaction = on_access_done;
+    sigaction(SIGTRAP, &action, NULL);
+}
+
+void stm32_model_set_analog_input(stm32_analog_input_t input)
+{
+    adc.input = (input != NULL) ? input : default_analog_input;
+}
+
+void stm32_model_uart_receive(USART_TypeDef* usart, uint64_t time_ns, const void* data, size_t length)
+{
+    Usart_t* u = find_usart(usart);
+    const uint8_t* bytes = data;
+
+    configASSERT(u != NULL);
+    for (size_t i = 0; i < length; i++)
+    {
+        configASSERT(u->rx_count < USART_RX_QUEUE_SIZE);
+        u->rx[(u->rx_head + u->rx_count) % USART_RX_QUEUE_SIZE].time = time_ns;
+        u->rx[(u->rx_head + u->rx_count) % USART_RX_QUEUE_SIZE].byte = bytes[i];
+        u->rx_count++;
+    }
+    schedule_wakes();
+}
+
+void stm32_model_set_uart_output(USART_TypeDef* usart, FILE* stream)
+{
+    Usart_t* u = find_usart(usart);
+
+    configASSERT(u != NULL);
+    u->output = stream;
+}
+
+void stm32_model_set_pin(GPIO_TypeDef* port, uint32_t pin, int level)
+{
+    for (unsigned i = 0; i < 6; i++)
+    {
+        if ((uintptr_t)gpios[i].regs == (uintptr_t)alias((uintptr_t)port))
+        {
+            gpios[i].driven |= (uint16_t)(1U << pin);
+            gpios[i].level = (uint16_t)((gpios[i].level & ~(1U << pin)) | ((level != 0) << pin));
+        }
+    }
+}
+
+void stm32_model_log(int enable)
+{
+    log_outputs = enable;
+}
+
+uint32_t stm32_model_get_ipsr(void)
+{
+    return ipsr;
+}
+
+void stm32_model_print_profile(FILE* stream)
+{
+    uint64_t now = ullPortGetVirtualTime();
+    uint64_t total_ps = 0;
+    uint64_t polled_ps = 0;
+    Clocks_t clocks;
+
+    get_clocks(&clocks);
+    fprintf(stream, "\nclocks: SYSCLK %lu Hz, HCLK %lu Hz, PCLK1 %lu Hz, PCLK2 %lu Hz, ADCCLK %lu Hz\n",
+            (unsigned long)clocks.sysclk, (unsigned long)clocks.hclk, (unsigned long)clocks.pclk1,
+            (unsigned long)clocks.pclk2, (unsigned long)clocks.adcclk);
+
+    fprintf(stream, "\n%-10s %12s %12s %12s %12s %8s\n",
+            "peripheral", "accesses", "polled", "time (us)", "polling (us)", "CPU");
+    for (unsigned i = 0; i < sizeof(peripherals) / sizeof(peripherals[0]) + 1; i++)
+    {
+        const Peripheral_t* p = (i < sizeof(peripherals) / sizeof(peripherals[0])) ? &peripherals[i] : &unmapped;
+
+        if (p->accesses == 0)
+        {
+            continue;
+        }
+        total_ps += p->time_ps;
+        polled_ps += p->polled_ps;
+        fprintf(stream, "%-10s %12llu %12llu %12llu %12llu %7.3f%%\n", p->name,
+                (unsigned long long)p->accesses, (unsigned long long)p->polled_accesses,
+                (unsigned long long)(p->time_ps / 1000000), (unsigned long long)(p->polled_ps / 1000000),
+                (now == 0) ? 0.0 : 100.0 * (double)p->time_ps / 1000.0 / (double)now);
+    }
+    fprintf(stream, "%-10s %12s %12s %12llu %12llu %7.3f%%\n", "total", "", "",
+            (unsigned long long)(total_ps / 1000000), (unsigned long long)(polled_ps / 1000000),
+            (now == 0) ? 0.0 : 100.0 * (double)total_ps / 1000.0 / (double)now);
+    fprintf(stream, "polling loops fast-forwarded: %llu\n", (unsigned long long)polling_skips);
+
+    fprintf(stream, "\nADC1: %llu conversions\n", (unsigned long long)adc.conversions);
+    for (unsigned i = 0; i < 3; i++)
+    {
+        if ((usarts[i].bytes_sent != 0) || (usarts[i].bytes_received != 0))
+        {
+            fprintf(stream, "%s: %llu bytes sent, %llu received\n", usarts[i].name,
+                    (unsigned long long)usarts[i].bytes_sent, (unsigned long long)usarts[i].bytes_received);
+        }
+    }
+    for (unsigned i = 0; i < 6; i++)
+    {
+        for (unsigned pin = 0; pin < 16; pin++)
+        {
+            if (gpios[i].rising_edges[pin] != 0)
+            {
+                fprintf(stream, "%s pin %u: %lu rising edges\n", gpios[i].name, pin,
+                        (unsigned long)gpios[i].rising_edges[pin]);
+            }
+        }
+    }
+}
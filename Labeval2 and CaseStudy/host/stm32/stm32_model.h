@@ -0,0 +1,75 @@
+/**
+  ******************************************************************************
+  * @file           : stm32_model.h
+  * @brief          : Register level model of the STM32F401 peripherals.
+  *
+  * Lets the application, the HAL drivers and the CMSIS device header run
+  * unmodified on the host port.  The peripheral address ranges are mapped at
+  * their addresses on the device and every access to them is trapped, so a
+  * read or write of a register has the effect it has on the chip, at the
+  * virtual time it happens, and costs the bus cycles it costs there.
+  *
+  * Modelled: RCC (oscillator start-up, clock switch and the clock tree),
+  * FLASH and PWR (storage only), GPIOA-E/H, ADC1 (regular conversions with
+  * their sampling and conversion cycles, scan, continuous, DMA, analog
+  * watchdog, triggers from TIM2-5), USART1/2/6 (byte times from BRR and the
+  * frame format, interrupts, DMA), TIM2-5 (up-counting, update, output
+  * compare, TRGO on update), DMA1/DMA2 (peripheral and memory transfers,
+  * circular and double buffer), the NVIC and the DWT cycle counter.
+  * Not modelled: injected ADC conversions, timer input capture and PWM
+  * outputs, EXTI, SysTick, nested interrupt preemption and flash wait states.
+  *
+  * Needs Linux on x86-64, and a program linked without PIE so that buffers
+  * given to DMA have 32-bit addresses (the host port puts the task stacks
+  * below 2 GB).
+  ******************************************************************************
+  */
+
+#ifndef __STM32_MODEL_H
+#define __STM32_MODEL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include "stm32f4xx.h"
+
+/* Returns the voltage on an ADC input as a 12-bit value (0 to 4095) */
+typedef uint16_t (*stm32_analog_input_t)(uint32_t channel, uint64_t time_ns);
+
+/* Maps the peripherals at their device addresses, sets the reset values and
+ * starts trapping accesses.  Call first in main(), before SystemInit(). */
+void stm32_model_init(void);
+
+/* Replaces the default ADC input: a triangle wave per channel, with the
+ * internal reference and the temperature sensor at constant values */
+void stm32_model_set_analog_input(stm32_analog_input_t input);
+
+/* Sends length bytes to the receiver of usart, back to back at its baud rate
+ * from time_ns on.  A byte that finds the receiver disabled is lost. */
+void stm32_model_uart_receive(USART_TypeDef* usart, uint64_t time_ns, const void* data, size_t length);
+
+/* Where the bytes sent by usart are written; USART2 goes to stdout, the
+ * others nowhere, unless set here (NULL discards) */
+void stm32_model_set_uart_output(USART_TypeDef* usart, FILE* stream);
+
+/* Drives an input pin; pins that are not driven read their pull */
+void stm32_model_set_pin(GPIO_TypeDef* port, uint32_t pin, int level);
+
+/* Prints every change of a GPIO output with its virtual time */
+void stm32_model_log(int enable);
+
+/* Prints the clock tree, the register accesses and the processor time they
+ * took per peripheral, the part of it spent polling, and the GPIO edges */
+void stm32_model_print_profile(FILE* stream);
+
+/* IPSR: 16 + the IRQ number while an interrupt handler runs, else 0 */
+uint32_t stm32_model_get_ipsr(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STM32_MODEL_H */
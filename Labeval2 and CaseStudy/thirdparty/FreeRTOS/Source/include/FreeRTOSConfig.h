@@ -44,10 +44,22 @@
 #ifdef __GNUC__
 	#include <stdint.h>
 	extern uint32_t SystemCoreClock;
+	extern uint64_t timebase_get_us( void );
 #endif
 
 #define configUSE_PREEMPTION			1
 #define configUSE_TIME_SLICING          1
+#define configSCHEDULING_POLICY		SCHEDULING_POLICY_HYBRID
+#define configEDF_PRIORITY_BANDS	( 1UL << 2 )
+#define configUSE_EDF_ADMISSION_CONTROL	1
+#define configUSE_EDF_MICROSECOND_TIME	1
+#define portGET_DEADLINE_TIME()			timebase_get_us()
+#define configUSE_DEADLINE_MISS_DETECTION	1
+#define configUSE_DEADLINE_MISS_HOOK	1
+#define configTARDINESS_HISTOGRAM_BUCKETS	16
+#define configUSE_SRP					1
+#define configUSE_CBS					1
+#define configUSE_TIME_TRIGGERED		1
 
 #define configUSE_IDLE_HOOK				0
 #define configUSE_TICK_HOOK				0
@@ -55,19 +67,46 @@
 #define configTICK_RATE_HZ				( ( TickType_t ) 1000 )
 #define configMAX_PRIORITIES			( 5 )
 #define configMINIMAL_STACK_SIZE		( ( unsigned short ) 130 )
-#define configTOTAL_HEAP_SIZE			( ( size_t ) ( 62 * 1024 ) )
+#define configTOTAL_HEAP_SIZE			( ( size_t ) ( 43 * 1024 ) )	/* Leaves room in the 64K of RAM for the pools and the trace buffer */
 #define configMAX_TASK_NAME_LEN			( 10 )
 #define configUSE_TRACE_FACILITY		1
 #define configUSE_16_BIT_TICKS			0
 #define configIDLE_SHOULD_YIELD			1
 #define configUSE_MUTEXES				1
+#define configUSE_MUTEX_CEILING			1
 #define configQUEUE_REGISTRY_SIZE		8
 #define configCHECK_FOR_STACK_OVERFLOW	0
 #define configUSE_RECURSIVE_MUTEXES		1
 #define configUSE_MALLOC_FAILED_HOOK	0
 #define configUSE_APPLICATION_TASK_TAG	0
 #define configUSE_COUNTING_SEMAPHORES	1
-#define configGENERATE_RUN_TIME_STATS	0
+#define configGENERATE_RUN_TIME_STATS	1
+#define configUSE_JOB_STATS				1
+
+/* Fixed block pools beside heap_4, see portable/MemMang/pool.c.  The TCBs
+(312 bytes) come from the 384 byte class, so creating and deleting a task never
+walks the heap.  The Benchmark configuration creates a task per ready list
+entry, up to 16, beside the idle and timer tasks, and adds the two small
+classes that the pool cases of kernel_bench.c allocate from.  The EDF benchmark
+creates up to 64 tasks, too many for the pool, and takes their TCBs from the
+heap instead. */
+#define configUSE_POOL_ALLOCATOR		1
+#ifdef EDF_BENCHMARK
+	#define configTCB_FROM_POOL			0
+#else
+	#define configTCB_FROM_POOL			1
+#endif
+#ifdef KERNEL_BENCHMARK
+	#define configPOOL_CLASSES( X )		X( 32, 16 ) X( 128, 8 ) X( 384, 24 )
+#else
+	#define configPOOL_CLASSES( X )		X( 384, 8 )
+#endif
+
+/* Run time stats count microseconds on the TIM5 time base, which is started
+by HAL_InitTick() before the scheduler. */
+#define configRUN_TIME_COUNTER_TYPE		uint64_t
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()	timebase_get_us()
 
 
 /* Software timer definitions. */
@@ -121,5 +160,18 @@ standard names. */
 #define xPortPendSVHandler PendSV_Handler
 #define xPortSysTickHandler SysTick_Handler
 
+/* Record scheduling, queue and interrupt events into the binary trace buffer,
+see Core/Inc/trace_recorder.h.  The benchmarks of the kernel measure it
+without the recorder. */
+#if defined( KERNEL_BENCHMARK ) || defined( EDF_BENCHMARK )
+	#define configUSE_TRACE_RECORDER	0
+#else
+	#define configUSE_TRACE_RECORDER	1
+#endif
+
+#if ( configUSE_TRACE_RECORDER == 1 )
+	#include "trace_recorder.h"
+#endif
+
 #endif /* FREERTOS_CONFIG_H */
 
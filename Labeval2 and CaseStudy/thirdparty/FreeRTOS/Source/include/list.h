@@ -376,6 +376,39 @@ typedef struct xLIST
         ( ( pxList )->uxNumberOfItems )++;                   \
     }
 
+/*
+ * Version of vListInsert() for lists that are not ordered by item value.  The
+ * caller has already found the position of the new item, which is inserted
+ * immediately before pxPosition.  pxPosition can be the list end marker, in
+ * which case the item becomes the last in the list.
+ *
+ * @param pxList The list into which the item is to be inserted.
+ *
+ * @param pxPosition The list item that will follow the new item.
+ *
+ * @param pxNewListItem The list item to be inserted into the list.
+ *
+ * \page listINSERT_BEFORE listINSERT_BEFORE
+ * \ingroup LinkedList
+ */
+#define listINSERT_BEFORE( pxList, pxPosition, pxNewListItem )                  \
+    {                                                                           \
+        ListItem_t * const pxNext = ( pxPosition );                             \
+                                                                                \
+        listTEST_LIST_INTEGRITY( ( pxList ) );                                  \
+        listTEST_LIST_ITEM_INTEGRITY( ( pxNewListItem ) );                      \
+                                                                                \
+        ( pxNewListItem )->pxNext = pxNext;                                     \
+        ( pxNewListItem )->pxPrevious = pxNext->pxPrevious;                     \
+                                                                                \
+        pxNext->pxPrevious->pxNext = ( pxNewListItem );                         \
+        pxNext->pxPrevious = ( pxNewListItem );                                 \
+                                                                                \
+        ( pxNewListItem )->pxContainer = ( pxList );                            \
+                                                                                \
+        ( ( pxList )->uxNumberOfItems )++;                                      \
+    }
+
 /*
  * Access function to obtain the owner of the first entry in a list.  Lists
  * are normally sorted in ascending item value order.
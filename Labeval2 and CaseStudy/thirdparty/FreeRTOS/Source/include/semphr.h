@@ -798,6 +798,79 @@ typedef QueueHandle_t SemaphoreHandle_t;
     #define xSemaphoreCreateMutexStatic( pxMutexBuffer )    xQueueCreateMutexStatic( queueQUEUE_TYPE_MUTEX, ( pxMutexBuffer ) )
 #endif
 
+/**
+ * semphr. h
+ * @code{c}
+ * SemaphoreHandle_t xSemaphoreCreateMutexWithCeiling( UBaseType_t uxCeilingPriority );
+ * @endcode
+ *
+ * configUSE_MUTEX_CEILING must be defined as 1 for this macro to be available.
+ *
+ * Creates a mutex that implements the immediate priority ceiling protocol.  A
+ * task that takes the mutex is raised to uxCeilingPriority, if it is not
+ * already at or above it, in the same critical section in which it obtains the
+ * mutex.  It returns to its base priority in the critical section that gives
+ * the mutex back, once it holds no other mutexes.  No other task that uses the
+ * mutex can therefore run while it is held, as long as the ceiling is at least
+ * the priority of every task that takes it.
+ *
+ * This replaces calling vTaskPrioritySet() after xSemaphoreTake() and before
+ * xSemaphoreGive(), which needs two more calls into the kernel and leaves a
+ * window between taking the mutex and raising the priority in which the holder
+ * can be preempted.
+ *
+ * The mutex is otherwise the same as one created by xSemaphoreCreateMutex(),
+ * and is accessed using the xSemaphoreTake() and xSemaphoreGive() macros.  If
+ * a task of a priority above the ceiling does block on the mutex then the
+ * holder inherits its priority as with any other mutex.
+ *
+ * @param uxCeilingPriority The highest priority of any task that takes the
+ * mutex.
+ *
+ * @return If the mutex was successfully created then a handle to the created
+ * mutex is returned.  If there was not enough heap to allocate the mutex data
+ * structures then NULL is returned.
+ *
+ * Example usage:
+ * @code{c}
+ * SemaphoreHandle_t xSemaphore;
+ *
+ * void vATask( void * pvParameters )
+ * {
+ *  // Tasks of priorities 1 to 3 take the mutex.
+ *  xSemaphore = xSemaphoreCreateMutexWithCeiling( 3 );
+ *
+ *  if( xSemaphoreTake( xSemaphore, portMAX_DELAY ) == pdTRUE )
+ *  {
+ *      // Runs at priority 3 until the mutex is given back.
+ *      xSemaphoreGive( xSemaphore );
+ *  }
+ * }
+ * @endcode
+ * \defgroup xSemaphoreCreateMutexWithCeiling xSemaphoreCreateMutexWithCeiling
+ * \ingroup Semaphores
+ */
+#if ( ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) && ( configUSE_MUTEX_CEILING == 1 ) )
+    #define xSemaphoreCreateMutexWithCeiling( uxCeilingPriority )    xQueueCreateMutexWithCeiling( ( uxCeilingPriority ) )
+#endif
+
+/**
+ * semphr. h
+ * @code{c}
+ * SemaphoreHandle_t xSemaphoreCreateMutexWithCeilingStatic( UBaseType_t uxCeilingPriority, StaticSemaphore_t *pxMutexBuffer );
+ * @endcode
+ *
+ * As xSemaphoreCreateMutexWithCeiling(), but the memory for the mutex is
+ * provided by the application in pxMutexBuffer, as for
+ * xSemaphoreCreateMutexStatic().
+ *
+ * \defgroup xSemaphoreCreateMutexWithCeilingStatic xSemaphoreCreateMutexWithCeilingStatic
+ * \ingroup Semaphores
+ */
+#if ( ( configSUPPORT_STATIC_ALLOCATION == 1 ) && ( configUSE_MUTEX_CEILING == 1 ) )
+    #define xSemaphoreCreateMutexWithCeilingStatic( uxCeilingPriority, pxMutexBuffer )    xQueueCreateMutexWithCeilingStatic( ( uxCeilingPriority ), ( pxMutexBuffer ) )
+#endif
+
 
 /**
  * semphr. h
@@ -47,6 +47,9 @@
 
 #undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
 
+/* heap_tlsf.c provides the heap instead when configUSE_TLSF_HEAP is 1. */
+#if ( configUSE_TLSF_HEAP == 0 )
+
 #if ( configSUPPORT_DYNAMIC_ALLOCATION == 0 )
     #error This file must not be used if configSUPPORT_DYNAMIC_ALLOCATION is 0
 #endif
@@ -535,3 +538,5 @@ void vPortGetHeapStats( HeapStats_t * pxHeapStats )
     taskEXIT_CRITICAL();
 }
 /*-----------------------------------------------------------*/
+
+#endif /* configUSE_TLSF_HEAP */
@@ -0,0 +1,649 @@
+/*
+ * FreeRTOS Kernel V10.5.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/*
+ * An implementation of pvPortMalloc() and vPortFree() with a Two-Level
+ * Segregated Fit allocator, which finds a free block and frees one in
+ * constant time however fragmented the heap has become.
+ *
+ * Free blocks are kept in one list per size class.  The first level divides
+ * the sizes by powers of two and the second divides each power of two into
+ * 16 equal ranges, with bitmaps of the lists that are not empty.  An
+ * allocation first tries the first block of the class of the request itself,
+ * which leaves the larger blocks whole.  Failing that it rounds the request
+ * up to the next class, so that any block of that class or above fits, and
+ * takes the first block of the lowest such class found with two bit scans.
+ * Every block records the block before it in memory, so a freed block is
+ * merged with free neighbours on both sides without searching.
+ *
+ * Replaces heap_4.c when configUSE_TLSF_HEAP is set to 1; only one of them is
+ * compiled.  configTLSF_FL_INDEX_MAX sets the largest block to less than
+ * 2 ^ ( configTLSF_FL_INDEX_MAX + 1 ) bytes, which must cover
+ * configTOTAL_HEAP_SIZE.
+ */
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+ * all the API functions to use the MPU wrappers.  That should only be done when
+ * task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#if ( configUSE_TLSF_HEAP == 1 )
+
+#if ( configSUPPORT_DYNAMIC_ALLOCATION == 0 )
+    #error This file must not be used if configSUPPORT_DYNAMIC_ALLOCATION is 0
+#endif
+
+#ifndef configHEAP_CLEAR_MEMORY_ON_FREE
+    #define configHEAP_CLEAR_MEMORY_ON_FREE    0
+#endif
+
+#ifndef configTLSF_FL_INDEX_MAX
+    #define configTLSF_FL_INDEX_MAX    16
+#endif
+
+/* Index of the highest and lowest set bit of a non-zero 32-bit value. */
+#ifndef tlsfFLS
+    #define tlsfFLS( ulValue )    ( ( UBaseType_t ) ( 31U - ( uint32_t ) __builtin_clz( ulValue ) ) )
+#endif
+#ifndef tlsfFFS
+    #define tlsfFFS( ulValue )    ( ( UBaseType_t ) __builtin_ctz( ulValue ) )
+#endif
+
+#if ( portBYTE_ALIGNMENT == 4 )
+    #define tlsfALIGNMENT_LOG2    2U
+#elif ( portBYTE_ALIGNMENT == 8 )
+    #define tlsfALIGNMENT_LOG2    3U
+#elif ( portBYTE_ALIGNMENT == 16 )
+    #define tlsfALIGNMENT_LOG2    4U
+#elif ( portBYTE_ALIGNMENT == 32 )
+    #define tlsfALIGNMENT_LOG2    5U
+#else
+    #error heap_tlsf.c does not support this portBYTE_ALIGNMENT
+#endif
+
+/* Each power of two is divided into 2 ^ tlsfSL_INDEX_COUNT_LOG2 classes.
+ * Blocks smaller than tlsfSMALL_BLOCK_SIZE are all in the first level, in
+ * classes one alignment unit apart. */
+#define tlsfSL_INDEX_COUNT_LOG2    4U
+#define tlsfSL_INDEX_COUNT         ( 1U << tlsfSL_INDEX_COUNT_LOG2 )
+#define tlsfFL_INDEX_SHIFT         ( tlsfSL_INDEX_COUNT_LOG2 + tlsfALIGNMENT_LOG2 )
+#define tlsfFL_INDEX_COUNT         ( configTLSF_FL_INDEX_MAX - tlsfFL_INDEX_SHIFT + 2U )
+#define tlsfSMALL_BLOCK_SIZE       ( ( size_t ) 1U << tlsfFL_INDEX_SHIFT )
+
+/* The lowest bit of the size of a block is set while the block is free. */
+#define tlsfBLOCK_FREE_BIT                 ( ( size_t ) 1U )
+#define tlsfBLOCK_SIZE( pxBlock )          ( ( pxBlock )->xBlockSize & ~tlsfBLOCK_FREE_BIT )
+#define tlsfBLOCK_IS_FREE( pxBlock )       ( ( ( pxBlock )->xBlockSize & tlsfBLOCK_FREE_BIT ) != 0U )
+#define tlsfNEXT_PHYS_BLOCK( pxBlock )     ( ( TLSFBlock_t * ) ( ( ( uint8_t * ) ( pxBlock ) ) + tlsfBLOCK_SIZE( pxBlock ) ) )
+
+/* Max value that fits in a size_t type. */
+#define heapSIZE_MAX    ( ~( ( size_t ) 0 ) )
+
+/* Check if multiplying a and b will result in overflow. */
+#define heapMULTIPLY_WILL_OVERFLOW( a, b )    ( ( ( a ) > 0 ) && ( ( b ) > ( heapSIZE_MAX / ( a ) ) ) )
+
+/*-----------------------------------------------------------*/
+
+/* Allocate the memory for the heap. */
+#if ( configAPPLICATION_ALLOCATED_HEAP == 1 )
+
+/* The application writer has already defined the array used for the RTOS
+* heap - probably so it can be placed in a special segment or address. */
+    extern uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
+#else
+    PRIVILEGED_DATA static uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
+#endif /* configAPPLICATION_ALLOCATED_HEAP */
+
+/* The header at the start of every block.  The free list links are only
+ * used while the block is free, so an allocated block starts right after
+ * xBlockSize. */
+typedef struct A_TLSF_BLOCK
+{
+    struct A_TLSF_BLOCK * pxPrevPhysBlock; /*<< The block before this one in memory, NULL for the first block. */
+    size_t xBlockSize;                     /*<< The size of the block including its header, with tlsfBLOCK_FREE_BIT. */
+    struct A_TLSF_BLOCK * pxNextFreeBlock; /*<< The next free block of the same class. */
+    struct A_TLSF_BLOCK * pxPrevFreeBlock; /*<< The previous free block of the same class. */
+} TLSFBlock_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * The first and second level index of the class that holds blocks of xSize
+ * bytes.
+ */
+static void prvMappingInsert( size_t xSize,
+                              UBaseType_t * puxFL,
+                              UBaseType_t * puxSL ) PRIVILEGED_FUNCTION;
+
+/*
+ * Adds a free block to the list of its class, and removes one from the list
+ * of the class it was found in.
+ */
+static void prvInsertFreeBlock( TLSFBlock_t * pxBlock ) PRIVILEGED_FUNCTION;
+static void prvRemoveFreeBlock( TLSFBlock_t * pxBlock,
+                                UBaseType_t uxFL,
+                                UBaseType_t uxSL ) PRIVILEGED_FUNCTION;
+
+/*
+ * Called automatically to setup the required heap structures the first time
+ * pvPortMalloc() is called.
+ */
+static void prvHeapInit( void ) PRIVILEGED_FUNCTION;
+
+/*-----------------------------------------------------------*/
+
+/* The space an allocated block takes before the memory returned, and the
+ * smallest block, which must be able to hold the free list links. */
+static const size_t xHeapStructSize = ( offsetof( TLSFBlock_t, pxNextFreeBlock ) + ( ( size_t ) ( portBYTE_ALIGNMENT - 1 ) ) ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+static const size_t xMinimumBlockSize = ( sizeof( TLSFBlock_t ) + ( ( size_t ) ( portBYTE_ALIGNMENT - 1 ) ) ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+/* The free lists and the bitmaps of the lists that are not empty. */
+PRIVILEGED_DATA static TLSFBlock_t * pxFreeLists[ tlsfFL_INDEX_COUNT ][ tlsfSL_INDEX_COUNT ];
+PRIVILEGED_DATA static uint32_t ulFLBitmap = 0U;
+PRIVILEGED_DATA static uint32_t ulSLBitmap[ tlsfFL_INDEX_COUNT ];
+
+/* The zero size block at the end of the heap, which is never free so that
+ * blocks are not merged beyond it. */
+PRIVILEGED_DATA static TLSFBlock_t * pxEnd = NULL;
+
+/* Keeps track of the number of calls to allocate and free memory as well as the
+ * number of free bytes remaining, but says nothing about fragmentation. */
+PRIVILEGED_DATA static size_t xFreeBytesRemaining = 0U;
+PRIVILEGED_DATA static size_t xMinimumEverFreeBytesRemaining = 0U;
+PRIVILEGED_DATA static size_t xNumberOfSuccessfulAllocations = 0;
+PRIVILEGED_DATA static size_t xNumberOfSuccessfulFrees = 0;
+
+/*-----------------------------------------------------------*/
+
+void * pvPortMalloc( size_t xWantedSize )
+{
+    TLSFBlock_t * pxBlock = NULL;
+    TLSFBlock_t * pxNewBlock;
+    void * pvReturn = NULL;
+    size_t xSize;
+    uint32_t ulMap;
+    UBaseType_t uxFL = tlsfFL_INDEX_COUNT;
+    UBaseType_t uxSL = 0;
+
+    vTaskSuspendAll();
+    {
+        /* If this is the first call to malloc then the heap will require
+         * initialisation to setup the free lists. */
+        if( pxEnd == NULL )
+        {
+            prvHeapInit();
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        if( ( xWantedSize > 0 ) && ( xWantedSize <= xFreeBytesRemaining ) )
+        {
+            /* The wanted size must be increased so it can contain the block
+             * header, and aligned. */
+            xSize = ( xWantedSize + xHeapStructSize + ( ( size_t ) ( portBYTE_ALIGNMENT - 1 ) ) ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+            if( xSize < xMinimumBlockSize )
+            {
+                xSize = xMinimumBlockSize;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            /* The first block of the class of the size itself is taken when
+             * it is large enough, which keeps the larger blocks whole. */
+            prvMappingInsert( xSize, &uxFL, &uxSL );
+
+            if( ( uxFL < tlsfFL_INDEX_COUNT ) && ( pxFreeLists[ uxFL ][ uxSL ] != NULL ) &&
+                ( tlsfBLOCK_SIZE( pxFreeLists[ uxFL ][ uxSL ] ) >= xSize ) )
+            {
+                pxBlock = pxFreeLists[ uxFL ][ uxSL ];
+                prvRemoveFreeBlock( pxBlock, uxFL, uxSL );
+            }
+            else if( xSize >= tlsfSMALL_BLOCK_SIZE )
+            {
+                /* Otherwise round up to the next class boundary, so that
+                 * every block in the class found is large enough and the
+                 * first one can be taken. */
+                prvMappingInsert( xSize + ( ( ( size_t ) 1U << ( tlsfFLS( ( uint32_t ) xSize ) - tlsfSL_INDEX_COUNT_LOG2 ) ) - 1U ), &uxFL, &uxSL );
+            }
+            else
+            {
+                /* Every block of a small class has the same size. */
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            if( ( pxBlock == NULL ) && ( uxFL < tlsfFL_INDEX_COUNT ) )
+            {
+                /* The lowest class that is not empty, first in the same first
+                 * level, then in the levels above it. */
+                ulMap = ulSLBitmap[ uxFL ] & ( ~0UL << uxSL );
+
+                if( ulMap == 0U )
+                {
+                    ulMap = ( uxFL + 1U < 32U ) ? ( ulFLBitmap & ( ~0UL << ( uxFL + 1U ) ) ) : 0U;
+
+                    if( ulMap != 0U )
+                    {
+                        uxFL = tlsfFFS( ulMap );
+                        ulMap = ulSLBitmap[ uxFL ];
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                if( ulMap != 0U )
+                {
+                    uxSL = tlsfFFS( ulMap );
+                    pxBlock = pxFreeLists[ uxFL ][ uxSL ];
+                    prvRemoveFreeBlock( pxBlock, uxFL, uxSL );
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            if( pxBlock != NULL )
+            {
+                configASSERT( tlsfBLOCK_SIZE( pxBlock ) >= xSize );
+
+                /* If the block is larger than required the rest is split off
+                 * and freed. */
+                if( ( tlsfBLOCK_SIZE( pxBlock ) - xSize ) >= xMinimumBlockSize )
+                {
+                    pxNewBlock = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xSize );
+                    configASSERT( ( ( ( size_t ) pxNewBlock ) & portBYTE_ALIGNMENT_MASK ) == 0 );
+
+                    pxNewBlock->xBlockSize = ( tlsfBLOCK_SIZE( pxBlock ) - xSize ) | tlsfBLOCK_FREE_BIT;
+                    pxNewBlock->pxPrevPhysBlock = pxBlock;
+                    tlsfNEXT_PHYS_BLOCK( pxNewBlock )->pxPrevPhysBlock = pxNewBlock;
+                    pxBlock->xBlockSize = xSize;
+                    prvInsertFreeBlock( pxNewBlock );
+                }
+                else
+                {
+                    /* The block is used whole. */
+                    pxBlock->xBlockSize = tlsfBLOCK_SIZE( pxBlock );
+                }
+
+                xFreeBytesRemaining -= pxBlock->xBlockSize;
+
+                if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
+                {
+                    xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                pvReturn = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xHeapStructSize );
+                xNumberOfSuccessfulAllocations++;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        traceMALLOC( pvReturn, xWantedSize );
+    }
+    ( void ) xTaskResumeAll();
+
+    #if ( configUSE_MALLOC_FAILED_HOOK == 1 )
+    {
+        if( pvReturn == NULL )
+        {
+            vApplicationMallocFailedHook();
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+    #endif /* if ( configUSE_MALLOC_FAILED_HOOK == 1 ) */
+
+    configASSERT( ( ( ( size_t ) pvReturn ) & ( size_t ) portBYTE_ALIGNMENT_MASK ) == 0 );
+    return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vPortFree( void * pv )
+{
+    TLSFBlock_t * pxBlock;
+    TLSFBlock_t * pxNeighbour;
+    UBaseType_t uxFL, uxSL;
+
+    if( pv != NULL )
+    {
+        /* The memory being freed will have the block header immediately
+         * before it. */
+        pxBlock = ( void * ) ( ( ( uint8_t * ) pv ) - xHeapStructSize );
+
+        configASSERT( tlsfBLOCK_IS_FREE( pxBlock ) == pdFALSE );
+        configASSERT( tlsfBLOCK_SIZE( pxBlock ) >= xMinimumBlockSize );
+
+        if( tlsfBLOCK_IS_FREE( pxBlock ) == pdFALSE )
+        {
+            #if ( configHEAP_CLEAR_MEMORY_ON_FREE == 1 )
+            {
+                ( void ) memset( pv, 0, pxBlock->xBlockSize - xHeapStructSize );
+            }
+            #endif
+
+            vTaskSuspendAll();
+            {
+                xFreeBytesRemaining += pxBlock->xBlockSize;
+                traceFREE( pv, pxBlock->xBlockSize );
+
+                /* Merge with the block before it if that is free. */
+                pxNeighbour = pxBlock->pxPrevPhysBlock;
+
+                if( ( pxNeighbour != NULL ) && ( tlsfBLOCK_IS_FREE( pxNeighbour ) != pdFALSE ) )
+                {
+                    prvMappingInsert( tlsfBLOCK_SIZE( pxNeighbour ), &uxFL, &uxSL );
+                    prvRemoveFreeBlock( pxNeighbour, uxFL, uxSL );
+                    pxNeighbour->xBlockSize = tlsfBLOCK_SIZE( pxNeighbour ) + pxBlock->xBlockSize;
+                    pxBlock = pxNeighbour;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                /* Merge with the block after it if that is free.  The block
+                 * at the end of the heap never is. */
+                pxNeighbour = tlsfNEXT_PHYS_BLOCK( pxBlock );
+
+                if( tlsfBLOCK_IS_FREE( pxNeighbour ) != pdFALSE )
+                {
+                    prvMappingInsert( tlsfBLOCK_SIZE( pxNeighbour ), &uxFL, &uxSL );
+                    prvRemoveFreeBlock( pxNeighbour, uxFL, uxSL );
+                    pxBlock->xBlockSize = tlsfBLOCK_SIZE( pxBlock ) + tlsfBLOCK_SIZE( pxNeighbour );
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                tlsfNEXT_PHYS_BLOCK( pxBlock )->pxPrevPhysBlock = pxBlock;
+                pxBlock->xBlockSize |= tlsfBLOCK_FREE_BIT;
+                prvInsertFreeBlock( pxBlock );
+                xNumberOfSuccessfulFrees++;
+            }
+            ( void ) xTaskResumeAll();
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetFreeHeapSize( void )
+{
+    return xFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetMinimumEverFreeHeapSize( void )
+{
+    return xMinimumEverFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+void vPortInitialiseBlocks( void )
+{
+    /* This just exists to keep the linker quiet. */
+}
+/*-----------------------------------------------------------*/
+
+void * pvPortCalloc( size_t xNum,
+                     size_t xSize )
+{
+    void * pv = NULL;
+
+    if( heapMULTIPLY_WILL_OVERFLOW( xNum, xSize ) == 0 )
+    {
+        pv = pvPortMalloc( xNum * xSize );
+
+        if( pv != NULL )
+        {
+            ( void ) memset( pv, 0, xNum * xSize );
+        }
+    }
+
+    return pv;
+}
+/*-----------------------------------------------------------*/
+
+static void prvMappingInsert( size_t xSize,
+                              UBaseType_t * puxFL,
+                              UBaseType_t * puxSL ) /* PRIVILEGED_FUNCTION */
+{
+    UBaseType_t uxBit;
+
+    if( xSize < tlsfSMALL_BLOCK_SIZE )
+    {
+        *puxFL = 0;
+        *puxSL = ( UBaseType_t ) ( xSize >> tlsfALIGNMENT_LOG2 );
+    }
+    else
+    {
+        uxBit = tlsfFLS( ( uint32_t ) xSize );
+        *puxSL = ( UBaseType_t ) ( ( xSize >> ( uxBit - tlsfSL_INDEX_COUNT_LOG2 ) ) ^ tlsfSL_INDEX_COUNT );
+        *puxFL = uxBit - ( tlsfFL_INDEX_SHIFT - 1U );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvInsertFreeBlock( TLSFBlock_t * pxBlock ) /* PRIVILEGED_FUNCTION */
+{
+    UBaseType_t uxFL, uxSL;
+    TLSFBlock_t * pxHead;
+
+    prvMappingInsert( tlsfBLOCK_SIZE( pxBlock ), &uxFL, &uxSL );
+    configASSERT( uxFL < tlsfFL_INDEX_COUNT );
+
+    pxHead = pxFreeLists[ uxFL ][ uxSL ];
+    pxBlock->pxNextFreeBlock = pxHead;
+    pxBlock->pxPrevFreeBlock = NULL;
+
+    if( pxHead != NULL )
+    {
+        pxHead->pxPrevFreeBlock = pxBlock;
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    pxFreeLists[ uxFL ][ uxSL ] = pxBlock;
+    ulFLBitmap |= ( 1UL << uxFL );
+    ulSLBitmap[ uxFL ] |= ( 1UL << uxSL );
+}
+/*-----------------------------------------------------------*/
+
+static void prvRemoveFreeBlock( TLSFBlock_t * pxBlock,
+                                UBaseType_t uxFL,
+                                UBaseType_t uxSL ) /* PRIVILEGED_FUNCTION */
+{
+    if( pxBlock->pxNextFreeBlock != NULL )
+    {
+        pxBlock->pxNextFreeBlock->pxPrevFreeBlock = pxBlock->pxPrevFreeBlock;
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    if( pxBlock->pxPrevFreeBlock != NULL )
+    {
+        pxBlock->pxPrevFreeBlock->pxNextFreeBlock = pxBlock->pxNextFreeBlock;
+    }
+    else
+    {
+        /* The block was the head of its list. */
+        configASSERT( pxFreeLists[ uxFL ][ uxSL ] == pxBlock );
+        pxFreeLists[ uxFL ][ uxSL ] = pxBlock->pxNextFreeBlock;
+
+        if( pxFreeLists[ uxFL ][ uxSL ] == NULL )
+        {
+            ulSLBitmap[ uxFL ] &= ~( 1UL << uxSL );
+
+            if( ulSLBitmap[ uxFL ] == 0U )
+            {
+                ulFLBitmap &= ~( 1UL << uxFL );
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvHeapInit( void ) /* PRIVILEGED_FUNCTION */
+{
+    TLSFBlock_t * pxFirstFreeBlock;
+    portPOINTER_SIZE_TYPE uxAddress;
+    size_t xTotalHeapSize = configTOTAL_HEAP_SIZE;
+
+    /* Every block must fit the classes. */
+    configASSERT( ( xTotalHeapSize >> configTLSF_FL_INDEX_MAX ) <= 1U );
+
+    /* Ensure the heap starts on a correctly aligned boundary. */
+    uxAddress = ( portPOINTER_SIZE_TYPE ) ucHeap;
+
+    if( ( uxAddress & portBYTE_ALIGNMENT_MASK ) != 0 )
+    {
+        uxAddress += ( portBYTE_ALIGNMENT - 1 );
+        uxAddress &= ~( ( portPOINTER_SIZE_TYPE ) portBYTE_ALIGNMENT_MASK );
+        xTotalHeapSize -= uxAddress - ( portPOINTER_SIZE_TYPE ) ucHeap;
+    }
+
+    pxFirstFreeBlock = ( TLSFBlock_t * ) uxAddress;
+
+    /* pxEnd is a header with no space after it, at the end of the heap. */
+    uxAddress += xTotalHeapSize;
+    uxAddress -= xHeapStructSize;
+    uxAddress &= ~( ( portPOINTER_SIZE_TYPE ) portBYTE_ALIGNMENT_MASK );
+    pxEnd = ( TLSFBlock_t * ) uxAddress;
+    pxEnd->xBlockSize = 0;
+
+    /* To start with there is a single free block that is sized to take up the
+     * entire heap space, minus the space taken by pxEnd. */
+    pxFirstFreeBlock->pxPrevPhysBlock = NULL;
+    pxFirstFreeBlock->xBlockSize = ( size_t ) ( uxAddress - ( portPOINTER_SIZE_TYPE ) pxFirstFreeBlock ) | tlsfBLOCK_FREE_BIT;
+    pxEnd->pxPrevPhysBlock = pxFirstFreeBlock;
+    prvInsertFreeBlock( pxFirstFreeBlock );
+
+    /* Only one block exists - and it covers the entire usable heap space. */
+    xMinimumEverFreeBytesRemaining = tlsfBLOCK_SIZE( pxFirstFreeBlock );
+    xFreeBytesRemaining = tlsfBLOCK_SIZE( pxFirstFreeBlock );
+}
+/*-----------------------------------------------------------*/
+
+void vPortGetHeapStats( HeapStats_t * pxHeapStats )
+{
+    TLSFBlock_t * pxBlock;
+    UBaseType_t uxFL, uxSL;
+    size_t xBlocks = 0, xMaxSize = 0, xMinSize = portMAX_DELAY; /* portMAX_DELAY used as a portable way of getting the maximum value. */
+
+    vTaskSuspendAll();
+    {
+        for( uxFL = 0; uxFL < tlsfFL_INDEX_COUNT; uxFL++ )
+        {
+            for( uxSL = 0; uxSL < tlsfSL_INDEX_COUNT; uxSL++ )
+            {
+                for( pxBlock = pxFreeLists[ uxFL ][ uxSL ]; pxBlock != NULL; pxBlock = pxBlock->pxNextFreeBlock )
+                {
+                    xBlocks++;
+
+                    if( tlsfBLOCK_SIZE( pxBlock ) > xMaxSize )
+                    {
+                        xMaxSize = tlsfBLOCK_SIZE( pxBlock );
+                    }
+
+                    if( tlsfBLOCK_SIZE( pxBlock ) < xMinSize )
+                    {
+                        xMinSize = tlsfBLOCK_SIZE( pxBlock );
+                    }
+                }
+            }
+        }
+    }
+    ( void ) xTaskResumeAll();
+
+    pxHeapStats->xSizeOfLargestFreeBlockInBytes = xMaxSize;
+    pxHeapStats->xSizeOfSmallestFreeBlockInBytes = xMinSize;
+    pxHeapStats->xNumberOfFreeBlocks = xBlocks;
+
+    taskENTER_CRITICAL();
+    {
+        pxHeapStats->xAvailableHeapSpaceInBytes = xFreeBytesRemaining;
+        pxHeapStats->xNumberOfSuccessfulAllocations = xNumberOfSuccessfulAllocations;
+        pxHeapStats->xNumberOfSuccessfulFrees = xNumberOfSuccessfulFrees;
+        pxHeapStats->xMinimumEverFreeBytesRemaining = xMinimumEverFreeBytesRemaining;
+    }
+    taskEXIT_CRITICAL();
+}
+
+#endif /* configUSE_TLSF_HEAP */
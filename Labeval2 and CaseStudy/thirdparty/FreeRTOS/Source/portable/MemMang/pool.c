@@ -0,0 +1,292 @@
+/*
+ * FreeRTOS Kernel V10.5.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/*
+ * Fixed block pools, used beside one of the heap_x.c implementations of
+ * pvPortMalloc().
+ *
+ * configPOOL_CLASSES( X ) lists the block classes as X( size, count ) in
+ * increasing order of size, for example:
+ *
+ *     #define configPOOL_CLASSES( X )    X( 32, 16 ) X( 128, 8 ) X( 512, 2 )
+ *
+ * The blocks of all the classes are laid out in one static array at compile
+ * time.  Each class hands out the blocks it has never used in address order
+ * and then reuses freed blocks from a singly linked list threaded through
+ * them, so allocating and freeing take constant time and there is nothing to
+ * initialise.  Both only need a short critical section, entered with
+ * ATOMIC_ENTER_CRITICAL(), so they may be called from interrupts.  Freeing a
+ * block finds its class from its address.
+ */
+#include <stdlib.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+ * all the API functions to use the MPU wrappers.  That should only be done when
+ * task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "atomic.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#if ( configUSE_POOL_ALLOCATOR == 1 )
+
+#ifndef configPOOL_CLASSES
+    #error configPOOL_CLASSES() must be defined when configUSE_POOL_ALLOCATOR is set to 1
+#endif
+
+/* Every block starts on portBYTE_ALIGNMENT and holds at least the free list
+ * link. */
+#define poolBLOCK_SIZE( xSize ) \
+    ( ( ( ( ( size_t ) ( xSize ) < sizeof( PoolBlock_t ) ) ? sizeof( PoolBlock_t ) : ( size_t ) ( xSize ) ) + \
+        ( ( size_t ) ( portBYTE_ALIGNMENT - 1 ) ) ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK ) )
+
+#define poolARENA_BYTES( xSize, xCount )    + ( poolBLOCK_SIZE( xSize ) * ( size_t ) ( xCount ) )
+#define poolCLASS_COUNT( xSize, xCount )    + 1
+#define poolCLASS( xSize, xCount )          { poolBLOCK_SIZE( xSize ), ( size_t ) ( xCount ) },
+
+/* The total size of the blocks, and the number of classes. */
+#define poolARENA_SIZE                      ( ( size_t ) ( 0 configPOOL_CLASSES( poolARENA_BYTES ) ) )
+#define poolNUMBER_OF_CLASSES               ( ( UBaseType_t ) ( 0 configPOOL_CLASSES( poolCLASS_COUNT ) ) )
+
+/*-----------------------------------------------------------*/
+
+/* The link that a free block holds in its first bytes. */
+typedef struct A_POOL_BLOCK
+{
+    struct A_POOL_BLOCK * pxNextFreeBlock; /*<< The next free block of the class. */
+} PoolBlock_t;
+
+/* The layout of a class, fixed at compile time. */
+typedef struct A_POOL_CLASS
+{
+    size_t xBlockSize; /*<< The size of each block, rounded up. */
+    size_t xBlocks;    /*<< The number of blocks. */
+} PoolClass_t;
+
+/* The state of a class. */
+typedef struct A_POOL_STATE
+{
+    PoolBlock_t * pxFreeList;        /*<< Blocks that have been freed, most recent first. */
+    size_t xNeverUsed;               /*<< Blocks from the end of the class that have never been allocated. */
+    size_t xBlocksInUse;
+    size_t xMaximumEverBlocksInUse;
+    size_t xNumberOfFailedAllocations;
+} PoolState_t;
+
+/*-----------------------------------------------------------*/
+
+/* One extra alignment unit lets the first block be aligned, as in heap_4.c. */
+PRIVILEGED_DATA static uint8_t ucPoolArena[ poolARENA_SIZE + portBYTE_ALIGNMENT ];
+
+static const PoolClass_t xPoolClasses[] = { configPOOL_CLASSES( poolCLASS ) };
+
+/* Zero initialised: every block of every class is never used. */
+PRIVILEGED_DATA static PoolState_t xPoolStates[ poolNUMBER_OF_CLASSES ];
+
+/*-----------------------------------------------------------*/
+
+/*
+ * The first block of the arena, aligned to portBYTE_ALIGNMENT.
+ */
+static uint8_t * prvPoolArenaStart( void ) PRIVILEGED_FUNCTION;
+
+/*-----------------------------------------------------------*/
+
+static uint8_t * prvPoolArenaStart( void )
+{
+    portPOINTER_SIZE_TYPE uxAddress = ( portPOINTER_SIZE_TYPE ) ucPoolArena;
+
+    uxAddress += ( portBYTE_ALIGNMENT - 1 );
+    uxAddress &= ~( ( portPOINTER_SIZE_TYPE ) portBYTE_ALIGNMENT_MASK );
+
+    return ( uint8_t * ) uxAddress;
+}
+/*-----------------------------------------------------------*/
+
+void * pvPortPoolMalloc( size_t xSize )
+{
+    uint8_t * pucClassStart = prvPoolArenaStart();
+    PoolState_t * pxState;
+    void * pvReturn = NULL;
+    UBaseType_t uxClass;
+
+    /* The classes are in increasing order of size, so the first that holds
+     * the request is the smallest.  The number of classes is fixed, so the
+     * search takes constant time. */
+    for( uxClass = 0; uxClass < poolNUMBER_OF_CLASSES; uxClass++ )
+    {
+        if( xSize <= xPoolClasses[ uxClass ].xBlockSize )
+        {
+            break;
+        }
+
+        pucClassStart += xPoolClasses[ uxClass ].xBlockSize * xPoolClasses[ uxClass ].xBlocks;
+    }
+
+    if( ( uxClass < poolNUMBER_OF_CLASSES ) && ( xSize > ( size_t ) 0 ) )
+    {
+        pxState = &( xPoolStates[ uxClass ] );
+
+        ATOMIC_ENTER_CRITICAL();
+        {
+            if( pxState->pxFreeList != NULL )
+            {
+                pvReturn = ( void * ) pxState->pxFreeList;
+                pxState->pxFreeList = pxState->pxFreeList->pxNextFreeBlock;
+            }
+            else if( pxState->xNeverUsed < xPoolClasses[ uxClass ].xBlocks )
+            {
+                pvReturn = ( void * ) ( pucClassStart + ( pxState->xNeverUsed * xPoolClasses[ uxClass ].xBlockSize ) );
+                pxState->xNeverUsed++;
+            }
+            else
+            {
+                pxState->xNumberOfFailedAllocations++;
+            }
+
+            if( pvReturn != NULL )
+            {
+                pxState->xBlocksInUse++;
+
+                if( pxState->xBlocksInUse > pxState->xMaximumEverBlocksInUse )
+                {
+                    pxState->xMaximumEverBlocksInUse = pxState->xBlocksInUse;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        ATOMIC_EXIT_CRITICAL();
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    #if ( configUSE_MALLOC_FAILED_HOOK == 1 )
+    {
+        if( pvReturn == NULL )
+        {
+            vApplicationMallocFailedHook();
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+    #endif /* if ( configUSE_MALLOC_FAILED_HOOK == 1 ) */
+
+    configASSERT( ( ( ( portPOINTER_SIZE_TYPE ) pvReturn ) & ( portPOINTER_SIZE_TYPE ) portBYTE_ALIGNMENT_MASK ) == 0 );
+    return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vPortPoolFree( void * pv )
+{
+    uint8_t * puc = ( uint8_t * ) pv;
+    uint8_t * pucClassStart = prvPoolArenaStart();
+    uint8_t * pucClassEnd;
+    PoolState_t * pxState;
+    PoolBlock_t * pxBlock;
+    UBaseType_t uxClass;
+
+    if( pv != NULL )
+    {
+        for( uxClass = 0; uxClass < poolNUMBER_OF_CLASSES; uxClass++ )
+        {
+            pucClassEnd = pucClassStart + ( xPoolClasses[ uxClass ].xBlockSize * xPoolClasses[ uxClass ].xBlocks );
+
+            if( ( puc >= pucClassStart ) && ( puc < pucClassEnd ) )
+            {
+                break;
+            }
+
+            pucClassStart = pucClassEnd;
+        }
+
+        /* The block must have been returned by pvPortPoolMalloc(). */
+        configASSERT( uxClass < poolNUMBER_OF_CLASSES );
+
+        if( uxClass < poolNUMBER_OF_CLASSES )
+        {
+            configASSERT( ( ( size_t ) ( puc - pucClassStart ) % xPoolClasses[ uxClass ].xBlockSize ) == ( size_t ) 0 );
+
+            pxState = &( xPoolStates[ uxClass ] );
+            pxBlock = ( PoolBlock_t * ) pv; /*lint !e9087 !e9079 The block is aligned to portBYTE_ALIGNMENT and at least as large as a PoolBlock_t. */
+
+            ATOMIC_ENTER_CRITICAL();
+            {
+                configASSERT( pxState->xBlocksInUse > ( size_t ) 0 );
+
+                pxBlock->pxNextFreeBlock = pxState->pxFreeList;
+                pxState->pxFreeList = pxBlock;
+                pxState->xBlocksInUse--;
+            }
+            ATOMIC_EXIT_CRITICAL();
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxPortGetPoolStats( PoolStats_t * pxPoolStats,
+                                UBaseType_t uxArraySize )
+{
+    UBaseType_t uxClass;
+
+    configASSERT( pxPoolStats );
+
+    for( uxClass = 0; ( uxClass < poolNUMBER_OF_CLASSES ) && ( uxClass < uxArraySize ); uxClass++ )
+    {
+        ATOMIC_ENTER_CRITICAL();
+        {
+            pxPoolStats[ uxClass ].xBlockSize = xPoolClasses[ uxClass ].xBlockSize;
+            pxPoolStats[ uxClass ].xNumberOfBlocks = xPoolClasses[ uxClass ].xBlocks;
+            pxPoolStats[ uxClass ].xBlocksInUse = xPoolStates[ uxClass ].xBlocksInUse;
+            pxPoolStats[ uxClass ].xMaximumEverBlocksInUse = xPoolStates[ uxClass ].xMaximumEverBlocksInUse;
+            pxPoolStats[ uxClass ].xNumberOfFailedAllocations = xPoolStates[ uxClass ].xNumberOfFailedAllocations;
+        }
+        ATOMIC_EXIT_CRITICAL();
+    }
+
+    return uxClass;
+}
+
+#endif /* configUSE_POOL_ALLOCATOR */
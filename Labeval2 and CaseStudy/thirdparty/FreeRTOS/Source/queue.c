@@ -130,6 +130,10 @@ typedef struct QueueDefinition /* The old naming convention is used to prevent b
         UBaseType_t uxQueueNumber;
         uint8_t ucQueueType;
     #endif
+
+    #if ( configUSE_MUTEX_CEILING == 1 )
+        UBaseType_t uxCeilingPriority; /*< The priority a task runs at while it holds the mutex, or tskIDLE_PRIORITY if the queue is not a mutex created with a ceiling. */
+    #endif
 } xQUEUE;
 
 /* The old xQUEUE name is maintained above then typedefed to the new Queue_t
@@ -453,7 +457,7 @@ BaseType_t xQueueGenericReset( QueueHandle_t xQueue,
              * are greater than or equal to the pointer to char requirements the cast
              * is safe.  In other cases alignment requirements are not strict (one or
              * two bytes). */
-            pxNewQueue = ( Queue_t * ) pvPortMalloc( sizeof( Queue_t ) + xQueueSizeInBytes ); /*lint !e9087 !e9079 see comment above. */
+            pxNewQueue = ( Queue_t * ) pvPortMallocQueue( sizeof( Queue_t ) + xQueueSizeInBytes ); /*lint !e9087 !e9079 see comment above. */
 
             if( pxNewQueue != NULL )
             {
@@ -533,6 +537,12 @@ static void prvInitialiseNewQueue( const UBaseType_t uxQueueLength,
     }
     #endif /* configUSE_QUEUE_SETS */
 
+    #if ( configUSE_MUTEX_CEILING == 1 )
+    {
+        pxNewQueue->uxCeilingPriority = tskIDLE_PRIORITY;
+    }
+    #endif /* configUSE_MUTEX_CEILING */
+
     traceQUEUE_CREATE( pxNewQueue );
 }
 /*-----------------------------------------------------------*/
@@ -604,6 +614,59 @@ static void prvInitialiseNewQueue( const UBaseType_t uxQueueLength,
 #endif /* configUSE_MUTEXES */
 /*-----------------------------------------------------------*/
 
+#if ( ( configUSE_MUTEX_CEILING == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) )
+
+    QueueHandle_t xQueueCreateMutexWithCeiling( const UBaseType_t uxCeilingPriority )
+    {
+        QueueHandle_t xNewQueue;
+
+        configASSERT( uxCeilingPriority < ( UBaseType_t ) configMAX_PRIORITIES );
+
+        xNewQueue = xQueueCreateMutex( queueQUEUE_TYPE_MUTEX );
+
+        /* No task can hold the mutex before the handle is returned, so the
+         * ceiling can be set after the mutex is initialised. */
+        if( xNewQueue != NULL )
+        {
+            ( ( Queue_t * ) xNewQueue )->uxCeilingPriority = uxCeilingPriority;
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        return xNewQueue;
+    }
+
+#endif /* configUSE_MUTEX_CEILING */
+/*-----------------------------------------------------------*/
+
+#if ( ( configUSE_MUTEX_CEILING == 1 ) && ( configSUPPORT_STATIC_ALLOCATION == 1 ) )
+
+    QueueHandle_t xQueueCreateMutexWithCeilingStatic( const UBaseType_t uxCeilingPriority,
+                                                      StaticQueue_t * pxStaticQueue )
+    {
+        QueueHandle_t xNewQueue;
+
+        configASSERT( uxCeilingPriority < ( UBaseType_t ) configMAX_PRIORITIES );
+
+        xNewQueue = xQueueCreateMutexStatic( queueQUEUE_TYPE_MUTEX, pxStaticQueue );
+
+        if( xNewQueue != NULL )
+        {
+            ( ( Queue_t * ) xNewQueue )->uxCeilingPriority = uxCeilingPriority;
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        return xNewQueue;
+    }
+
+#endif /* configUSE_MUTEX_CEILING */
+/*-----------------------------------------------------------*/
+
 #if ( ( configUSE_MUTEXES == 1 ) && ( INCLUDE_xSemaphoreGetMutexHolder == 1 ) )
 
     TaskHandle_t xQueueGetMutexHolder( QueueHandle_t xSemaphore )
@@ -1571,6 +1634,25 @@ BaseType_t xQueueSemaphoreTake( QueueHandle_t xQueue,
                         /* Record the information required to implement
                          * priority inheritance should it become necessary. */
                         pxQueue->u.xSemaphore.xMutexHolder = pvTaskIncrementMutexHeldCount();
+
+                        #if ( configUSE_MUTEX_CEILING == 1 )
+                        {
+                            /* Raise the new holder to the ceiling in the same
+                             * critical section that gives it the mutex, so it
+                             * cannot be preempted by another user of the mutex
+                             * in between.  The priority is dropped again by
+                             * xTaskPriorityDisinherit() when the mutex is
+                             * given back. */
+                            if( pxQueue->uxCeilingPriority != tskIDLE_PRIORITY )
+                            {
+                                vTaskPriorityRaiseToCeiling( pxQueue->uxCeilingPriority );
+                            }
+                            else
+                            {
+                                mtCOVERAGE_TEST_MARKER();
+                            }
+                        }
+                        #endif /* configUSE_MUTEX_CEILING */
                     }
                     else
                     {
@@ -2089,7 +2171,7 @@ void vQueueDelete( QueueHandle_t xQueue )
     {
         /* The queue can only have been allocated dynamically - free it
          * again. */
-        vPortFree( pxQueue );
+        vPortFreeQueue( pxQueue );
     }
     #elif ( ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) && ( configSUPPORT_STATIC_ALLOCATION == 1 ) )
     {
@@ -2097,7 +2179,7 @@ void vQueueDelete( QueueHandle_t xQueue )
          * check before attempting to free the memory. */
         if( pxQueue->ucStaticallyAllocated == ( uint8_t ) pdFALSE )
         {
-            vPortFree( pxQueue );
+            vPortFreeQueue( pxQueue );
         }
         else
         {
@@ -2166,6 +2248,20 @@ void vQueueDelete( QueueHandle_t xQueue )
             uxHighestPriorityOfWaitingTasks = tskIDLE_PRIORITY;
         }
 
+        #if ( configUSE_MUTEX_CEILING == 1 )
+        {
+            /* The holder of a mutex with a ceiling never drops below it. */
+            if( pxQueue->uxCeilingPriority > uxHighestPriorityOfWaitingTasks )
+            {
+                uxHighestPriorityOfWaitingTasks = pxQueue->uxCeilingPriority;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        #endif /* configUSE_MUTEX_CEILING */
+
         return uxHighestPriorityOfWaitingTasks;
     }
 
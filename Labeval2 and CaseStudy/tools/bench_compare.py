@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+"""Compares two runs of the kernel benchmark suite in Core/Src/kernel_bench.c.
+
+The inputs are captures of the USART2 output of a Benchmark build, or the
+stdout of the host build (make -C host bench).  Lines that do not start with
+"bench," are ignored, so a raw terminal log can be passed as it is.
+
+Prints the median and 99th percentile (or with --tail max, the maximum) of
+every case in both runs with the change between them, and exits with status
+1 when a median got slower by more than the threshold.
+
+usage: bench_compare.py before.csv after.csv [--threshold 5] [--tail p99|max]
+"""
+
+import argparse
+import sys
+
+FIELDS = ("case", "parameter", "unit", "samples", "min", "median", "p99", "max")
+
+
+def read_results(path):
+    """Returns the result rows of a run keyed by (case, parameter)."""
+    results = {}
+    with open(path, encoding="ascii", errors="replace") as f:
+        for line in f:
+            columns = line.strip().split(",")
+            if columns[0] != "bench" or len(columns) != len(FIELDS) + 1 or columns[1] == "case":
+                continue
+            row = dict(zip(FIELDS, columns[1:]))
+            for field in ("parameter", "samples", "min", "median", "p99", "max"):
+                row[field] = int(row[field])
+            results[(row["case"], row["parameter"])] = row
+    if not results:
+        sys.exit("%s: no benchmark results" % path)
+    return results
+
+
+def change(before, after):
+    if before == 0:
+        return "%+8s" % "-"
+    return "%+7.1f%%" % (100.0 * (after - before) / before)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare two kernel benchmark runs.")
+    parser.add_argument("before")
+    parser.add_argument("after")
+    parser.add_argument("--threshold", type=float, default=5.0,
+                        help="median slowdown in percent that counts as a regression (default: 5)")
+    parser.add_argument("--tail", choices=("p99", "max"), default="p99",
+                        help="second column to compare (default: p99)")
+    args = parser.parse_args()
+
+    before = read_results(args.before)
+    after = read_results(args.after)
+
+    regressions = []
+    print("%-20s %6s %7s %10s %10s %8s %10s %10s %8s" %
+          ("case", "param", "unit", "median", "median", "change", args.tail, args.tail, "change"))
+    for key in sorted(set(before) | set(after)):
+        if key not in before or key not in after:
+            print("%-20s %6d  only in %s" % (key[0], key[1], args.before if key in before else args.after))
+            continue
+        old, new = before[key], after[key]
+        if old["unit"] != new["unit"]:
+            sys.exit("%s %d: cannot compare %s with %s" % (key[0], key[1], old["unit"], new["unit"]))
+        print("%-20s %6d %7s %10d %10d %s %10d %10d %s" %
+              (key[0], key[1], old["unit"], old["median"], new["median"], change(old["median"], new["median"]),
+               old[args.tail], new[args.tail], change(old[args.tail], new[args.tail])))
+        if old["median"] and 100.0 * (new["median"] - old["median"]) / old["median"] > args.threshold:
+            regressions.append(key)
+
+    if regressions:
+        print("%d case(s) slower than the %.1f%% threshold:" % (len(regressions), args.threshold))
+        for case, parameter in regressions:
+            print("    %s %d" % (case, parameter))
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
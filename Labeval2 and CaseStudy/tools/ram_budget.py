@@ -0,0 +1,395 @@
+#!/usr/bin/env python3
+"""Checks the RAM budget of a board build.
+
+Combines three outputs of the build in Debug/ (or Release/):
+
+    01Tasks.map       the RAM region and the size of .data, .bss, the FreeRTOS
+                      heap (ucHeap) and the main stack reserved by the linker
+    *.su              the stack frame of every compiled function, from
+                      -fstack-usage
+    01Tasks.list      the disassembly, from which the call graph is taken:
+                      bl and blx to a symbol, and branches to another function
+                      (tail calls)
+
+The worst case stack of a task is the deepest path through the call graph
+from its entry point, plus the frame that an interrupt and a context switch
+push on the task stack (SWITCH_FRAME).  The tasks are those of the task set
+(see taskset.py) with an "entry" function and a "stack" in words, and the
+idle and timer tasks of the kernel, whose stacks come from
+FreeRTOSConfig.h.  Functions without a .su entry, the C library, get the
+frame of their prologue in the disassembly; calls through a pointer and
+recursion cannot be bounded and are reported with the task.
+
+Fails the build (exit status 1) when a worst case exceeds the stack of its
+task, when the task stacks do not fit the heap, or when the sections in
+RAM exceed the RAM region.  For each task it suggests the smallest stack
+that holds the worst case with --margin percent to spare, so the table can
+be trimmed and the RAM given back.
+
+usage: ram_budget.py Debug/01Tasks.map --list Debug/01Tasks.list --su Debug
+                     --taskset Core/taskset.json --config FreeRTOSConfig.h [--margin 20]
+"""
+
+import argparse
+import math
+import os
+import re
+import sys
+
+import taskset
+
+# Bytes of one StackType_t on the Cortex-M4
+STACK_WORD = 4
+
+# An interrupt stacks 26 words with the FPU context on the task stack and
+# PendSV saves r4-r11, lr and s16-s31 there on a switch: 51 words in all
+SWITCH_FRAME = 204
+
+# Suggested stacks are rounded up to a multiple of this many words
+STACK_ROUNDING = 8
+
+FUNCTION = re.compile(r"^([0-9a-f]{8}) <([^>]+)>:$")
+INSTRUCTION = re.compile(r"^\s+([0-9a-f]+):\t[0-9a-f ]+\t(\S+)\s*(.*)$")
+TARGET = re.compile(r"\b[0-9a-f]+ <([^>+]+)>")
+BRANCH = re.compile(r"^b(eq|ne|cs|cc|hs|lo|mi|pl|vs|vc|hi|ls|ge|lt|gt|le|al)?(\.w|\.n)?$")
+REGISTERS = re.compile(r"\{([^}]*)\}")
+
+
+class Function:
+    def __init__(self, name):
+        self.name = name
+        self.frame = None       # bytes, from the .su or the prologue
+        self.estimated = False  # frame taken from the prologue
+        self.dynamic = False    # the frame depends on run time values
+        self.calls = set()
+        self.indirect = False   # calls through a pointer
+
+
+def register_count(operands):
+    """Returns the number of registers in a {r4-r7, lr} style list."""
+    match = REGISTERS.search(operands)
+    if match is None:
+        return 0
+    count = 0
+    for item in match.group(1).split(","):
+        item = item.strip()
+        if "-" in item:
+            first, last = item.split("-")
+            count += int(last.strip()[1:]) - int(first.strip()[1:]) + 1
+        elif item:
+            count += 1
+    return count
+
+
+def read_listing(path):
+    """Returns the functions of the disassembly by name, with their calls and prologue frames."""
+    functions = {}
+    current = None
+    prologue = 0
+    with open(path, encoding="ascii", errors="replace") as f:
+        for line in f:
+            match = FUNCTION.match(line)
+            if match:
+                current = functions.setdefault(match.group(2), Function(match.group(2)))
+                current.frame = 0
+                current.estimated = True
+                prologue = 0
+                continue
+            match = INSTRUCTION.match(line)
+            if match is None or current is None:
+                continue
+            mnemonic, operands = match.group(2), match.group(3)
+            target = TARGET.search(operands)
+            if mnemonic in ("bl", "blx") and target:
+                current.calls.add(target.group(1))
+            elif mnemonic in ("blx", "bx") and operands.split()[0] != "lr":
+                current.indirect = True
+            elif BRANCH.match(mnemonic) and target and target.group(1) != current.name:
+                current.calls.add(target.group(1))
+
+            # The frame of a function without a .su entry: what its first
+            # instructions push and subtract from sp
+            if prologue < 8:
+                prologue += 1
+                words = register_count(operands)
+                if mnemonic in ("push", "push.w") or (mnemonic == "stmdb" and operands.startswith("sp!")):
+                    current.frame += 4 * words
+                elif mnemonic == "vpush":
+                    current.frame += (8 if "d" in REGISTERS.search(operands).group(1) else 4) * words
+                elif mnemonic in ("sub", "sub.w", "subw") and re.match(r"sp,\s*(sp,\s*)?#", operands):
+                    current.frame += int(re.search(r"#(\d+)", operands).group(1))
+    return functions
+
+
+def read_stack_usage(directory, functions):
+    """Sets the frames of the functions from the .su files under directory."""
+    found = 0
+    for root, _, files in os.walk(directory):
+        for name in files:
+            if not name.endswith(".su"):
+                continue
+            with open(os.path.join(root, name), encoding="ascii", errors="replace") as f:
+                for line in f:
+                    columns = line.rstrip("\n").split("\t")
+                    if len(columns) != 3:
+                        continue
+                    function = columns[0].rsplit(":", 1)[-1]
+                    entry = functions.setdefault(function, Function(function))
+                    # A static function of the same name in two files takes the larger frame
+                    frame = int(columns[1])
+                    if entry.estimated or entry.frame is None or frame > entry.frame:
+                        entry.frame = frame
+                    entry.estimated = False
+                    entry.dynamic = entry.dynamic or ("dynamic" in columns[2] and "bounded" not in columns[2])
+                    found += 1
+    if not found:
+        sys.exit("%s: no .su files; build with -fstack-usage" % directory)
+
+
+class Path:
+    """The worst case from a function down, and what it could not bound."""
+
+    def __init__(self, depth, chain, unknown=(), indirect=(), recursive=(), dynamic=()):
+        self.depth = depth
+        self.chain = chain
+        self.unknown = set(unknown)
+        self.indirect = set(indirect)
+        self.recursive = set(recursive)
+        self.dynamic = set(dynamic)
+
+    @property
+    def bounded(self):
+        return not (self.indirect or self.recursive or self.dynamic)
+
+
+def worst_case(functions, name, memo, active):
+    """Returns the deepest Path from the function name."""
+    if name in memo:
+        return memo[name]
+    function = functions.get(name)
+    if function is None or function.frame is None:
+        return Path(0, [name], unknown=[name])
+    if name in active:
+        return Path(0, [name], recursive=[name])
+
+    active.add(name)
+    deepest = None
+    flags = Path(0, [])
+    for callee in sorted(function.calls):
+        path = worst_case(functions, callee, memo, active)
+        for attribute in ("unknown", "indirect", "recursive", "dynamic"):
+            getattr(flags, attribute).update(getattr(path, attribute))
+        if deepest is None or path.depth > deepest.depth:
+            deepest = path
+    active.discard(name)
+
+    result = Path(function.frame + (deepest.depth if deepest else 0),
+                  [name] + (deepest.chain if deepest else []),
+                  flags.unknown, flags.indirect, flags.recursive, flags.dynamic)
+    if function.indirect:
+        result.indirect.add(name)
+    if function.dynamic:
+        result.dynamic.add(name)
+    # A result that went through a function still on the stack is only
+    # valid for this path into the cycle
+    if not result.recursive:
+        memo[name] = result
+    return result
+
+
+def read_config(path):
+    """Returns the macros of a FreeRTOSConfig.h as strings, and fails on conflicting definitions."""
+    macros = {}
+    depth = 0
+    guard = None
+    with open(path, encoding="ascii", errors="replace") as f:
+        lines = f.read().replace("\\\n", " ").splitlines()
+    for number, line in enumerate(lines, 1):
+        line = re.sub(r"/\*.*?\*/|//.*", "", line).strip()
+        directive = re.match(r"#\s*(\w+)\s*(.*)", line)
+        if directive is None:
+            continue
+        keyword, rest = directive.groups()
+        if keyword in ("if", "ifdef", "ifndef"):
+            if keyword == "ifndef" and guard is None and depth == 0 and not macros:
+                guard = rest.strip()
+            depth += 1
+        elif keyword == "endif":
+            depth -= 1
+        elif keyword == "define":
+            match = re.match(r"(\w+)(\([^)]*\))?\s*(.*)", rest)
+            name, parameters, value = match.groups()
+            if parameters or name == guard:
+                continue
+            conditional = depth > (1 if guard else 0)
+            if name in macros and not conditional and not macros[name][1] and macros[name][0] != value:
+                sys.exit("%s:%d: %s is defined again as %s, after %s" % (path, number, name, value, macros[name][0]))
+            if name not in macros:
+                macros[name] = (value, conditional)
+    return {name: value for name, (value, _) in macros.items()}
+
+
+def config_value(macros, name, default=None):
+    """Evaluates a numeric macro of the configuration."""
+    if name not in macros:
+        if default is None:
+            sys.exit("FreeRTOSConfig.h: %s is not defined" % name)
+        return default
+    text = macros[name]
+    for _ in range(8):
+        text = re.sub(r"\b(config\w+)\b", lambda m: "(%s)" % macros.get(m.group(1), "0"), text)
+    text = re.sub(r"\(\s*(unsigned\s+|signed\s+)?(size_t|short|int|long|char|u?int\d+_t|TickType_t)\s*\)", "", text)
+    text = re.sub(r"(\d+)[uUlL]+\b", r"\1", text)
+    if not re.fullmatch(r"[\d\s+\-*/()x]*", text):
+        sys.exit("FreeRTOSConfig.h: cannot evaluate %s = %s" % (name, macros[name]))
+    return int(eval(text))
+
+
+def read_map(path):
+    """Returns the RAM region, the output sections in it and the sizes of some symbols."""
+    region = None
+    sections = []
+    symbols = {}
+    with open(path, encoding="ascii", errors="replace") as f:
+        lines = f.read().splitlines()
+    pending = None
+    for index, line in enumerate(lines):
+        match = re.match(r"^RAM\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)", line)
+        if match and region is None:
+            region = (int(match.group(1), 16), int(match.group(2), 16))
+            continue
+        # A name too long for its column has the address and size on the next line
+        match = re.match(r"^( ?)(\.\S+|COMMON)\s*$", line)
+        if match:
+            pending = match.groups()
+            continue
+        match = re.match(r"^( ?)(\.\S+|COMMON)?\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)", line)
+        if match and (match.group(2) or pending):
+            indent, name = (match.group(1), match.group(2)) if match.group(2) else pending
+            address, size = int(match.group(3), 16), int(match.group(4), 16)
+            if indent == "":
+                sections.append((name, address, size))
+            else:
+                symbols[name] = symbols.get(name, 0) + size
+        pending = None
+        match = re.match(r"^\s+0x([0-9a-f]+)\s+(_Min_Stack_Size|_Min_Heap_Size)\s*=", line)
+        if match:
+            symbols[match.group(2)] = int(match.group(1), 16)
+    if region is None:
+        sys.exit("%s: no RAM region in the memory configuration" % path)
+    origin, length = region
+    in_ram = [(name, size) for name, address, size in sections
+              if origin <= address < origin + length and size > 0]
+    return region, in_ram, symbols
+
+
+def suggestion(depth, margin):
+    """Returns the smallest stack in words that holds depth bytes with margin percent to spare."""
+    words = math.ceil(depth * (100 + margin) / 100.0 / STACK_WORD)
+    return STACK_ROUNDING * math.ceil(words / STACK_ROUNDING)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Check the RAM budget of a board build.")
+    parser.add_argument("map")
+    parser.add_argument("--list", required=True, help="objdump -S listing of the image")
+    parser.add_argument("--su", required=True, help="directory searched for .su files")
+    parser.add_argument("--taskset", required=True)
+    parser.add_argument("--config", required=True, help="FreeRTOSConfig.h of the build")
+    parser.add_argument("--margin", type=float, default=20.0,
+                        help="percent added to a worst case for the suggested stack (default: 20)")
+    parser.add_argument("--verbose", action="store_true", help="print the worst case call chain of every task")
+    args = parser.parse_args()
+
+    functions = read_listing(args.list)
+    read_stack_usage(args.su, functions)
+    macros = read_config(args.config)
+    table = taskset.load(args.taskset)
+    (ram_origin, ram_length), sections, symbols = read_map(args.map)
+
+    # The tasks and where their stacks come from
+    tasks = []
+    for task in table.tasks:
+        if "stack" not in task.extra:
+            sys.exit("%s: no stack size for %s" % (args.taskset, task.name))
+        tasks.append((task.name, task.extra.get("entry"), task.extra["stack"]))
+    minimal = config_value(macros, "configMINIMAL_STACK_SIZE")
+    tasks.append(("IDLE", "prvIdleTask", minimal))
+    if config_value(macros, "configUSE_TIMERS", 0) == 1:
+        tasks.append(("Tmr Svc", "prvTimerTask", config_value(macros, "configTIMER_TASK_STACK_DEPTH")))
+    static_kernel_tasks = config_value(macros, "configSUPPORT_STATIC_ALLOCATION", 0) == 1
+
+    failures = []
+    warnings = []
+    heap_stacks = 0
+    reclaimable = 0
+    memo = {}
+    print("%-12s %-24s %8s %8s %8s %9s" % ("task", "entry", "worst", "stack", "spare", "suggested"))
+    for name, entry, words in tasks:
+        size = words * STACK_WORD
+        if not (static_kernel_tasks and name in ("IDLE", "Tmr Svc")):
+            heap_stacks += size
+        if entry is None:
+            warnings.append("%s: no \"entry\" in %s, the stack is not analysed" % (name, args.taskset))
+            print("%-12s %-24s %8s %8d" % (name, "-", "-", size))
+            continue
+        if entry not in functions:
+            warnings.append("%s: %s is not in %s" % (name, entry, args.list))
+            print("%-12s %-24s %8s %8d" % (name, entry, "-", size))
+            continue
+
+        path = worst_case(functions, entry, memo, set())
+        depth = path.depth + SWITCH_FRAME
+        suggested = suggestion(depth, args.margin)
+        print("%-12s %-24s %8d %8d %8d %9d%s" %
+              (name, entry, depth, size, size - depth, suggested, "" if path.bounded else "  unbounded"))
+        if args.verbose:
+            print("%12s %s" % ("", " > ".join(path.chain)))
+        if depth > size:
+            failures.append("%s: the worst case of %d bytes exceeds its stack of %d words (%d bytes)" %
+                            (name, depth, words, size))
+        elif name not in ("IDLE", "Tmr Svc") and suggested < words:
+            reclaimable += (words - suggested) * STACK_WORD
+        if path.indirect:
+            warnings.append("%s: calls through a pointer in %s are not counted" % (name, ", ".join(sorted(path.indirect))))
+        if path.recursive:
+            warnings.append("%s: recursion through %s is counted once" % (name, ", ".join(sorted(path.recursive))))
+        if path.dynamic:
+            warnings.append("%s: dynamic frames in %s are not bounded" % (name, ", ".join(sorted(path.dynamic))))
+        if path.unknown:
+            warnings.append("%s: no frame for %s, counted as 0" % (name, ", ".join(sorted(path.unknown))))
+    print("%d bytes are added to each worst case for the interrupt and context switch frame" % SWITCH_FRAME)
+
+    # The heap holds the task stacks; the TCBs and queues need the rest
+    heap = symbols.get(".bss.ucHeap", config_value(macros, "configTOTAL_HEAP_SIZE"))
+    print("\nheap %d bytes: %d for task stacks, %d left for TCBs, queues and other allocations" %
+          (heap, heap_stacks, heap - heap_stacks))
+    if heap_stacks > heap:
+        failures.append("the task stacks need %d bytes, more than the heap of %d" % (heap_stacks, heap))
+
+    used = sum(size for _, size in sections)
+    print("\nRAM 0x%08x, %d bytes:" % (ram_origin, ram_length))
+    for name, size in sections:
+        detail = ""
+        if name == ".bss":
+            parts = [("heap", symbols.get(".bss.ucHeap", 0)), ("pools", symbols.get(".bss.ucPoolArena", 0))]
+            detail = ", ".join("%s %d" % part for part in parts if part[1])
+        elif name == "._user_heap_stack" and "_Min_Stack_Size" in symbols:
+            detail = "main stack %d, C heap %d" % (symbols["_Min_Stack_Size"], symbols.get("_Min_Heap_Size", 0))
+        print("    %-20s %8d%s" % (name, size, "  (%s)" % detail if detail else ""))
+    print("    %-20s %8d  %.1f%%, %d free" % ("total", used, 100.0 * used / ram_length, ram_length - used))
+    if used > ram_length:
+        failures.append("RAM is overcommitted by %d bytes" % (used - ram_length))
+
+    if reclaimable:
+        print("\nthe suggested stacks would give back %d bytes of heap" % reclaimable)
+    for warning in warnings:
+        print("warning: " + warning)
+    if failures:
+        for failure in failures:
+            print("error: " + failure, file=sys.stderr)
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,174 @@
+"""Task set descriptions for the offline scheduling tools.
+
+A task set is a JSON file with a list of periodic tasks:
+
+    {
+        "tasks": [
+            {"name": "ADCTask", "period": "100ms", "deadline": "100ms", "wcet": "500us",
+             "sections": [{"resource": "adc_resource", "start": "490us", "length": "5us"}]},
+            ...
+        ]
+    }
+
+Times are numbers of microseconds or strings with a unit (ns, us, ms, s).
+"deadline" defaults to the period and "offset", the release time of the
+first job, to 0.  "priority" is optional, a FreeRTOS priority where higher
+is more urgent; tools that need one and do not find it assign deadline
+monotonic priorities.  A section holds a resource from "start" units of
+execution into the job for "length" units; sections of a task may nest but
+not overlap otherwise.  Other keys are kept in Task.extra, and the keys
+next to "tasks" in TaskSet.extra, for the tools that use them.
+
+Core/taskset.json describes the application of Core/Src/main.c.
+"""
+
+import json
+import math
+import re
+import sys
+
+UNITS = {"ns": 1, "us": 1000, "ms": 1000000, "s": 1000000000}
+
+
+def parse_time(value, what):
+    """Returns a time in nanoseconds from a number of us or a string with a unit."""
+    if isinstance(value, (int, float)) and not isinstance(value, bool):
+        return int(round(value * 1000))
+    match = re.fullmatch(r"\s*([0-9]*\.?[0-9]+)\s*(ns|us|ms|s)\s*", str(value))
+    if match is None:
+        raise ValueError("%s: cannot read the time %r" % (what, value))
+    return int(round(float(match.group(1)) * UNITS[match.group(2)]))
+
+
+def format_time(ns):
+    """Formats nanoseconds as microseconds."""
+    if ns % 1000 == 0:
+        return "%d" % (ns // 1000)
+    return "%.3f" % (ns / 1000.0)
+
+
+class Section:
+    def __init__(self, resource, start, length):
+        self.resource = resource
+        self.start = start
+        self.length = length
+
+    @property
+    def end(self):
+        return self.start + self.length
+
+
+class Task:
+    def __init__(self, index, name, period, deadline, wcet, offset=0, priority=None, sections=(), extra=None):
+        self.index = index
+        self.name = name
+        self.period = period
+        self.deadline = deadline
+        self.wcet = wcet
+        self.offset = offset
+        self.priority = priority
+        self.sections = list(sections)
+        self.extra = extra or {}
+
+    @property
+    def utilization(self):
+        return self.wcet / self.period
+
+    @property
+    def resources(self):
+        return sorted({section.resource for section in self.sections})
+
+    def longest_section(self, resource):
+        """The longest time the task holds a resource, 0 if it never does."""
+        return max((s.length for s in self.sections if s.resource == resource), default=0)
+
+
+class TaskSet:
+    def __init__(self, tasks, extra=None):
+        self.tasks = tasks
+        self.extra = extra or {}
+
+    @property
+    def resources(self):
+        return sorted({r for task in self.tasks for r in task.resources})
+
+    @property
+    def utilization(self):
+        return sum(task.utilization for task in self.tasks)
+
+    def hyperperiod(self):
+        return math.lcm(*[task.period for task in self.tasks])
+
+    def users(self, resource):
+        return [task for task in self.tasks if resource in task.resources]
+
+
+def _check_sections(task):
+    for section in task.sections:
+        if section.length <= 0 or section.start < 0 or section.end > task.wcet:
+            raise ValueError("%s: section on %s is not within the WCET" % (task.name, section.resource))
+    for a in task.sections:
+        for b in task.sections:
+            if a is b:
+                continue
+            nested = (a.start <= b.start and b.end <= a.end) or (b.start <= a.start and a.end <= b.end)
+            if not nested and a.start < b.end and b.start < a.end:
+                raise ValueError("%s: sections on %s and %s overlap without nesting" %
+                                 (task.name, a.resource, b.resource))
+            if nested and a.resource == b.resource:
+                raise ValueError("%s: %s is locked while held" % (task.name, a.resource))
+
+
+def load(path):
+    """Reads and checks a task set file; exits with a message when it is wrong."""
+    try:
+        with open(path, encoding="utf-8") as f:
+            data = json.load(f)
+        tasks = []
+        for index, entry in enumerate(data["tasks"]):
+            name = entry.get("name", "task%d" % index)
+            period = parse_time(entry["period"], name + " period")
+            deadline = parse_time(entry.get("deadline", entry["period"]), name + " deadline")
+            wcet = parse_time(entry["wcet"], name + " wcet")
+            offset = parse_time(entry.get("offset", 0), name + " offset")
+            if period <= 0 or deadline <= 0 or wcet <= 0:
+                raise ValueError("%s: period, deadline and WCET must be positive" % name)
+            sections = [Section(s["resource"], parse_time(s.get("start", 0), name + " section start"),
+                                parse_time(s["length"], name + " section length"))
+                        for s in entry.get("sections", [])]
+            extra = {key: value for key, value in entry.items()
+                     if key not in ("name", "period", "deadline", "wcet", "offset", "priority", "sections")}
+            task = Task(index, name, period, deadline, wcet, offset, entry.get("priority"), sections, extra)
+            _check_sections(task)
+            tasks.append(task)
+        if not tasks:
+            raise ValueError("no tasks")
+        if len({task.name for task in tasks}) != len(tasks):
+            raise ValueError("task names are not unique")
+    except (OSError, KeyError, TypeError, ValueError) as error:
+        sys.exit("%s: %s" % (path, error if not isinstance(error, KeyError) else "missing %s" % error))
+    return TaskSet(tasks, {key: value for key, value in data.items() if key != "tasks"})
+
+
+def monotonic_priorities(tasks, key, lowest=1):
+    """Priorities ordered by key (shorter is more urgent), lowest first.
+
+    Tasks with the same key get the same priority.  Returns {task: priority}.
+    """
+    priorities = {}
+    priority = lowest - 1
+    previous = None
+    for task in sorted(tasks, key=lambda t: (key(t), t.index), reverse=True):
+        if key(task) != previous:
+            priority += 1
+            previous = key(task)
+        priorities[task] = priority
+    return priorities
+
+
+def deadline_monotonic(tasks, lowest=1):
+    return monotonic_priorities(tasks, lambda t: t.deadline, lowest)
+
+
+def rate_monotonic(tasks, lowest=1):
+    return monotonic_priorities(tasks, lambda t: t.period, lowest)
@@ -0,0 +1,332 @@
+#!/usr/bin/env python3
+"""Analyses a task set and generates the header with its task parameters.
+
+Reads a task set (see taskset.py) and runs two analyses:
+
+    fixed priority    priorities by rate monotonic, deadline monotonic or
+                      Audsley's optimal assignment, and the exact response
+                      time of every task, with the blocking of ceiling
+                      mutexes (xSemaphoreCreateMutexWithCeiling()): one
+                      section of a lower priority task on a resource whose
+                      ceiling is at least the priority of the task
+    EDF with SRP      the processor demand test with the blocking of SRP, as
+                      the EDF band of the kernel schedules the tasks
+
+The table says which one the firmware uses, next to "tasks":
+
+    "scheduling": "edf", "edf_priority": 2
+    "scheduling": "fp", "fixed_priorities": [1, 3, 4], "assignment": "dm"
+
+With "edf" every task gets the priority of the EDF band; with "fp" the
+tasks would get the given FreeRTOS priorities, lowest first, in the order of
+the assignment (rm, dm or audsley).  Each task needs a "stack" in words and
+may have an "id" for its macros, else one is made from its name (LEDHighTask
+gives LED_HIGH_TASK).
+
+Writes the header only for "edf" tables, as main.c creates its tasks with
+xTaskCreatePeriodic() and locks adc_resource under SRP; an "fp" table is
+analysed but not written.  The header is only written when the task set
+passes the analysis, or with --force.  --check compares instead of writing
+and exits with status 1 when the header is out of date.
+
+usage: taskset_gen.py Core/taskset.json [-o Core/Inc/taskset_config.h] [--assign dm] [--check]
+"""
+
+import argparse
+import os
+import re
+import sys
+
+import taskset
+
+ASSIGNMENTS = ("rm", "dm", "audsley")
+
+# Paths in the header are relative to the project
+PROJECT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+def macro_name(name):
+    """LEDHighTask -> LED_HIGH_TASK, adc_resource -> ADC_RESOURCE."""
+    name = re.sub(r"([a-z0-9])([A-Z])", r"\1_\2", name)
+    name = re.sub(r"([A-Z]+)([A-Z][a-z])", r"\1_\2", name)
+    return re.sub(r"[^A-Za-z0-9]+", "_", name).strip("_").upper()
+
+
+def blocking(task, lower, resources):
+    """The longest section of a lower priority task on one of resources."""
+    return max((section.length for other in lower for section in other.sections
+                if section.resource in resources), default=0)
+
+
+def response_time(task, higher, block):
+    """Exact response time over the level-i busy period, None past the deadline."""
+    worst = 0
+    q = 0
+    while True:
+        w = (q + 1) * task.wcet + block
+        while True:
+            demand = (q + 1) * task.wcet + block + sum(-(-w // other.period) * other.wcet for other in higher)
+            if demand == w:
+                break
+            w = demand
+            if w - q * task.period > task.deadline:
+                return None
+        worst = max(worst, w - q * task.period)
+        if w <= (q + 1) * task.period:
+            return worst
+        q += 1
+
+
+class FixedPriority:
+    """Ranks 1 (lowest) to n, the response times and blocking at them."""
+
+    def __init__(self, tasks, method):
+        self.method = method
+        self.ranks = self.assign(tasks, method)
+        self.blocking = {}
+        self.response = {}
+        if self.ranks is None:
+            return
+        for task in tasks:
+            higher = [t for t in tasks if self.ranks[t] > self.ranks[task]]
+            lower = [t for t in tasks if self.ranks[t] < self.ranks[task]]
+            self.blocking[task] = blocking(task, lower, self.ceiling_resources(task, higher))
+            self.response[task] = response_time(task, higher, self.blocking[task])
+
+    @staticmethod
+    def ceiling_resources(task, higher):
+        """Resources with a ceiling at or above the priority of task."""
+        return {r for t in higher + [task] for r in t.resources}
+
+    @classmethod
+    def assign(cls, tasks, method):
+        if method == "audsley":
+            return cls.audsley(tasks)
+        key = (lambda t: t.period) if method == "rm" else (lambda t: t.deadline)
+        # Ties go to the task listed first
+        ordered = sorted(tasks, key=lambda t: (key(t), t.index), reverse=True)
+        return {task: rank for rank, task in enumerate(ordered, 1)}
+
+    @classmethod
+    def audsley(cls, tasks):
+        """Optimal priority assignment, lowest priority first; None if there is none."""
+        ranks = {}
+        unassigned = sorted(tasks, key=lambda t: (t.deadline, t.index))
+        lower = []
+        for rank in range(1, len(tasks) + 1):
+            for task in reversed(unassigned):
+                higher = [t for t in unassigned if t is not task]
+                block = blocking(task, lower, cls.ceiling_resources(task, higher))
+                if response_time(task, higher, block) is not None:
+                    ranks[task] = rank
+                    unassigned.remove(task)
+                    lower.append(task)
+                    break
+            else:
+                return None
+        return ranks
+
+    @property
+    def schedulable(self):
+        return self.ranks is not None and all(r is not None for r in self.response.values())
+
+
+class EDFDemand:
+    """Processor demand test of EDF with SRP blocking."""
+
+    def __init__(self, tasks):
+        self.utilization = sum(task.utilization for task in tasks)
+        self.checked = 0
+        self.least_slack = None
+        self.failure = None
+        if self.utilization > 1:
+            self.failure = 0
+            return
+
+        most_blocking = max((s.length for t in tasks for s in t.sections), default=0)
+        if self.utilization < 1:
+            bound = (sum((t.period - t.deadline) * t.utilization for t in tasks) + most_blocking) \
+                / (1 - self.utilization)
+            bound = max(max(t.deadline for t in tasks), int(bound) + 1)
+        else:
+            bound = max(t.deadline for t in tasks) + taskset.TaskSet(tasks).hyperperiod()
+
+        deadlines = sorted({d for t in tasks for d in range(t.deadline, bound + 1, t.period)})
+        for length in deadlines:
+            demand = sum(((length - t.deadline) // t.period + 1) * t.wcet for t in tasks if t.deadline <= length)
+            # A job with a later relative deadline can hold a resource that a
+            # job inside the interval needs
+            inside = {r for t in tasks if t.deadline <= length for r in t.resources}
+            demand += max((s.length for t in tasks if t.deadline > length
+                           for s in t.sections if s.resource in inside), default=0)
+            self.checked += 1
+            slack = length - demand
+            if self.least_slack is None or slack < self.least_slack[0]:
+                self.least_slack = (slack, length)
+            if slack < 0:
+                self.failure = length
+                return
+
+    @property
+    def schedulable(self):
+        return self.failure is None
+
+
+def report_fixed(tasks, analysis, priorities):
+    names = {"rm": "rate monotonic", "dm": "deadline monotonic", "audsley": "Audsley"}
+    print("\nfixed priority, %s, ceiling mutexes" % names[analysis.method])
+    if analysis.ranks is None:
+        print("no priority assignment meets every deadline")
+        return
+    print("%-16s %5s %10s %10s %10s %10s %10s" %
+          ("task", "prio", "period", "deadline", "wcet", "blocking", "response"))
+    for task in sorted(tasks, key=lambda t: -analysis.ranks[t]):
+        response = analysis.response[task]
+        print("%-16s %5s %10s %10s %10s %10s %10s" %
+              (task.name, priorities[task] if priorities else analysis.ranks[task],
+               taskset.format_time(task.period), taskset.format_time(task.deadline),
+               taskset.format_time(task.wcet), taskset.format_time(analysis.blocking[task]),
+               taskset.format_time(response) if response is not None else "miss"))
+    print("all deadlines met" if analysis.schedulable else "deadlines missed")
+
+
+def report_edf(analysis):
+    print("\nEDF with SRP, processor demand")
+    if analysis.utilization > 1:
+        print("utilization %.3f is above 1" % analysis.utilization)
+        return
+    print("checked %d deadlines, least slack %s us at %s us" %
+          (analysis.checked, taskset.format_time(analysis.least_slack[0]),
+           taskset.format_time(analysis.least_slack[1])))
+    if analysis.schedulable:
+        print("all deadlines met")
+    else:
+        print("the demand exceeds the interval of %s us" % taskset.format_time(analysis.failure))
+
+
+def microseconds(ns, what, round_up=False):
+    if ns % 1000:
+        if not round_up:
+            sys.exit("%s is not a whole number of microseconds" % what)
+        return ns // 1000 + 1
+    return ns // 1000
+
+
+def header(path, data, tasks, priorities, summary):
+    """Returns the text of the header."""
+    lines = []
+    add = lines.append
+    name = os.path.basename(path)
+    guard = "__" + macro_name(name.replace(".", "_"))
+    source = os.path.relpath(os.path.abspath(data), PROJECT)
+    add("/**")
+    add("  " + "*" * 78)
+    add("  * @file           : %s" % name)
+    add("  * @brief          : Task parameters, generated from %s." % source)
+    add("  *")
+    add("  * Generated by tools/taskset_gen.py from the analysed task table; change")
+    add("  * the table and generate again instead of editing this file.")
+    add("  *")
+    for line in summary:
+        add("  * %s" % line)
+    add("  " + "*" * 78)
+    add("  */")
+    add("")
+    add("#ifndef %s" % guard)
+    add("#define %s" % guard)
+    add("")
+    add("/* Times in microseconds, stack sizes in words */")
+    for task in tasks:
+        macro = task.extra.get("id") or macro_name(task.name)
+        add("")
+        add("/* %s */" % task.name)
+        rows = [("PRIORITY", priorities[task]),
+                ("PERIOD_US", microseconds(task.period, task.name + " period")),
+                ("DEADLINE_US", microseconds(task.deadline, task.name + " deadline")),
+                ("WCET_US", microseconds(task.wcet, task.name + " wcet", round_up=True)),
+                ("STACK_SIZE", task.extra["stack"])]
+        for suffix, value in rows:
+            add("#define %-31s %s" % ("%s_%s" % (macro, suffix), value))
+    add("")
+    add("#endif /* %s */" % guard)
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Analyse a task set and generate its header.")
+    parser.add_argument("taskset")
+    parser.add_argument("-o", "--output", help="header to write (default: only the analysis)")
+    parser.add_argument("--assign", choices=ASSIGNMENTS,
+                        help="fixed priority assignment (default: the table's, else dm)")
+    parser.add_argument("--check", action="store_true",
+                        help="exit with status 1 if the header differs from what would be written")
+    parser.add_argument("--force", action="store_true", help="write the header even if deadlines are missed")
+    args = parser.parse_args()
+
+    table = taskset.load(args.taskset)
+    tasks = table.tasks
+    scheduling = table.extra.get("scheduling", "fp")
+    if scheduling not in ("fp", "edf"):
+        sys.exit("%s: scheduling must be fp or edf" % args.taskset)
+    method = args.assign or table.extra.get("assignment", "dm")
+    if method not in ASSIGNMENTS:
+        sys.exit("%s: unknown assignment %s" % (args.taskset, method))
+
+    fixed = FixedPriority(tasks, method)
+    edf = EDFDemand(tasks)
+
+    if scheduling == "edf":
+        if "edf_priority" not in table.extra:
+            sys.exit("%s: edf scheduling needs edf_priority" % args.taskset)
+        priorities = {task: table.extra["edf_priority"] for task in tasks}
+        summary = ["Scheduling: EDF in the band at priority %d, resources under SRP." %
+                   table.extra["edf_priority"],
+                   "Processor demand test passed at utilization %.3f." % edf.utilization]
+        schedulable = edf.schedulable
+    else:
+        available = table.extra.get("fixed_priorities", list(range(1, len(tasks) + 1)))
+        if len(available) < len(tasks):
+            sys.exit("%s: %d tasks need %d fixed priorities, the table gives %d" %
+                     (args.taskset, len(tasks), len(tasks), len(available)))
+        priorities = {task: available[rank - 1] for task, rank in fixed.ranks.items()} if fixed.ranks else None
+        summary = ["Scheduling: fixed priority, %s assignment, ceiling mutexes." % method,
+                   "Response time analysis passed at utilization %.3f." % edf.utilization]
+        schedulable = fixed.schedulable
+
+    print("%s: %d tasks, utilization %.3f, scheduling %s" %
+          (args.taskset, len(tasks), edf.utilization, scheduling))
+    report_fixed(tasks, fixed, priorities if scheduling == "fp" else None)
+    report_edf(edf)
+
+    if not args.output:
+        sys.exit(0 if schedulable else 1)
+    if scheduling != "edf":
+        sys.exit("\nnot writing %s: main.c only schedules the tasks by EDF with SRP" % args.output)
+    if not schedulable and not args.force:
+        sys.exit("\nnot writing %s: the task set misses deadlines under %s scheduling" % (args.output, scheduling))
+    if priorities is None:
+        sys.exit("\nnot writing %s: no priority assignment" % args.output)
+    missing = [task.name for task in tasks if "stack" not in task.extra]
+    if missing:
+        sys.exit("%s: no stack size for %s" % (args.taskset, ", ".join(missing)))
+    if not schedulable:
+        summary[-1] = "The analysis FAILED; written with --force."
+
+    text = header(args.output, args.taskset, tasks, priorities, summary)
+    if args.check:
+        try:
+            with open(args.output, encoding="utf-8") as f:
+                current = f.read()
+        except OSError:
+            current = None
+        if current != text:
+            sys.exit("\n%s is out of date; generate it again" % args.output)
+        print("\n%s is up to date" % args.output)
+        return
+    with open(args.output, "w", encoding="utf-8") as f:
+        f.write(text)
+    print("\nwrote %s" % args.output)
+
+
+if __name__ == "__main__":
+    main()
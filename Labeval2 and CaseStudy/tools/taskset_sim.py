@@ -0,0 +1,442 @@
+#!/usr/bin/env python3
+"""Simulates a periodic task set under EDF, fixed priority, PCP and SRP.
+
+Runs every job of the task set (see taskset.py for the file format) over
+the hyperperiod, or twice the hyperperiod after the last first release when
+the tasks have offsets, with every job taking its WCET.  The policies:
+
+    fp    fixed priority, resources are plain mutexes without inheritance
+    pcp   fixed priority with the priority ceiling protocol: a lock is granted
+          only above the ceilings of the resources other jobs hold, and the
+          job that blocks a higher priority one inherits its priority
+    edf   earliest deadline first, plain mutexes
+    srp   earliest deadline first with the stack resource policy, as in the
+          EDF band of the kernel: a job starts only when its preemption level
+          (from its relative deadline) is above the ceilings of the resources
+          held, and then never blocks
+
+The fixed priorities are the "priority" values of the task set, else
+deadline monotonic (--priorities).  A later job of a task waits for the
+previous one, like a task that calls xTaskWaitForNextPeriod().
+
+Prints per task the worst case response time, the longest blocking (time a
+pending job waited while a job of lower base priority ran, or a later
+deadline under EDF), the deadline misses and the preemptions, and a summary
+of the policies.  Exits with status 1 on a miss with --fail-on-miss.
+
+usage: taskset_sim.py Core/taskset.json [--policy edf,fp,pcp,srp] [--horizon 10s] [-v]
+"""
+
+import argparse
+import heapq
+import sys
+
+import taskset
+
+POLICIES = ("edf", "fp", "pcp", "srp")
+DESCRIPTIONS = {
+    "edf": "EDF, plain mutexes",
+    "fp": "fixed priority, plain mutexes",
+    "pcp": "fixed priority, priority ceiling protocol",
+    "srp": "EDF, stack resource policy",
+}
+
+# Keeps the default horizon to about this many jobs
+MAX_JOBS = 500000
+
+EXEC, LOCK, UNLOCK = range(3)
+
+
+def job_steps(task):
+    """Splits the WCET of a task into execution, lock and unlock steps."""
+    events = []
+    for section in task.sections:
+        events.append((section.start, 1, -section.length, LOCK, section.resource))
+        events.append((section.end, 0, section.length, UNLOCK, section.resource))
+    # At the same time, unlocks come before locks and outer locks before inner ones
+    events.sort(key=lambda e: e[:3])
+    steps = []
+    time = 0
+    for at, _, _, kind, resource in events:
+        if at > time:
+            steps.append((EXEC, at - time))
+            time = at
+        steps.append((kind, resource))
+    if task.wcet > time:
+        steps.append((EXEC, task.wcet - time))
+    return steps
+
+
+class Stats:
+    def __init__(self):
+        self.jobs = 0
+        self.wcrt = 0
+        self.blocking = 0
+        self.misses = 0
+        self.preemptions = 0
+
+
+class Job:
+    __slots__ = ("task", "release", "deadline", "base", "key", "step", "left", "started",
+                 "waited", "blocker", "held", "preemptions", "version")
+
+    def __init__(self, task, release, base):
+        self.task = task
+        self.release = release
+        self.deadline = release + task.deadline
+        self.base = base
+        self.key = base
+        self.step = 0
+        self.left = 0
+        self.started = False
+        self.waited = 0
+        self.blocker = None
+        self.held = []
+        self.preemptions = 0
+        self.version = 0
+
+
+class Simulator:
+    def __init__(self, tasks, policy, priorities, horizon, verbose=False):
+        self.tasks = tasks
+        self.policy = policy
+        self.priorities = priorities
+        self.horizon = horizon
+        self.verbose = verbose
+        self.steps = [job_steps(task) for task in tasks]
+        self.stats = [Stats() for _ in tasks]
+
+        # Preemption levels for SRP: a shorter relative deadline is a higher level
+        self.levels = taskset.deadline_monotonic(tasks)
+        self.ceilings = {}
+        for task in tasks:
+            for resource in task.resources:
+                level = self.levels[task] if policy == "srp" else priorities[task]
+                self.ceilings[resource] = max(self.ceilings.get(resource, 0), level)
+
+        self.now = 0
+        self.releases = [(task.offset, task.index) for task in tasks if task.offset < horizon]
+        heapq.heapify(self.releases)
+        self.backlog = [[] for _ in tasks]
+        self.current = [None] * len(tasks)
+        self.ready = []
+        self.sequence = 0
+        self.holders = {}
+        self.waiters = {}
+        self.locked = []
+        self.blocked = set()
+        self.running = None
+        self.switches = 0
+        self.busy = 0
+        self.deadlock = None
+
+    # The priority of a job as a heap key: smaller runs first
+    def base_key(self, task, release):
+        if self.policy in ("edf", "srp"):
+            return (release + task.deadline, release, task.index)
+        return (-self.priorities[task], release, task.index)
+
+    def push(self, job):
+        job.version += 1
+        self.sequence += 1
+        heapq.heappush(self.ready, (job.key, self.sequence, job.version, job))
+
+    def release(self, task, release):
+        if self.current[task.index] is None:
+            self.start_job(task, release)
+        else:
+            self.backlog[task.index].append(release)
+        following = release + task.period
+        if following < self.horizon:
+            heapq.heappush(self.releases, (following, task.index))
+
+    def start_job(self, task, release):
+        job = Job(task, release, self.base_key(task, release))
+        self.current[task.index] = job
+        self.push(job)
+
+    def system_ceiling(self, excluding=None):
+        ceiling = 0
+        for resource in self.locked:
+            if self.holders[resource] is not excluding:
+                ceiling = max(ceiling, self.ceilings[resource])
+        return ceiling
+
+    def pick(self):
+        """Returns the job to run and the jobs SRP keeps from starting."""
+        held_back = []
+        chosen = None
+        while self.ready:
+            key, sequence, version, job = self.ready[0]
+            if version != job.version:
+                heapq.heappop(self.ready)
+                continue
+            if self.policy == "srp" and not job.started and self.locked and \
+                    self.levels[job.task] <= self.system_ceiling():
+                heapq.heappop(self.ready)
+                held_back.append((key, sequence, version, job))
+                continue
+            chosen = job
+            break
+        for entry in held_back:
+            heapq.heappush(self.ready, entry)
+        return chosen, [entry[3] for entry in held_back]
+
+    def charge_blocking(self, running, held_back, duration):
+        if running.key < running.base:
+            # Running on an inherited priority delays every job in between
+            for job in self.current:
+                if job is not None and job is not running and job.base < running.base:
+                    job.waited += duration
+            return
+        for job in self.blocked:
+            if job.base < running.base:
+                job.waited += duration
+        for job in held_back:
+            if job.base < running.base:
+                job.waited += duration
+
+    def inherit(self, blocker, key):
+        while blocker is not None and key < blocker.key:
+            blocker.key = key
+            if blocker.blocker is None:
+                self.push(blocker)
+                break
+            blocker = blocker.blocker
+
+    def block(self, job, blocker):
+        job.blocker = blocker
+        job.version += 1
+        self.blocked.add(job)
+        if self.policy == "pcp":
+            self.inherit(blocker, job.key)
+
+    def try_lock(self, job, resource):
+        holder = self.holders.get(resource)
+        if self.policy == "pcp":
+            ceiling = self.system_ceiling(excluding=job)
+            if holder is None and self.priorities[job.task] > ceiling:
+                return True
+            if holder is None:
+                # Blocked by the job holding the highest ceiling
+                holder = max((self.holders[r] for r in self.locked if self.holders[r] is not job),
+                             key=lambda j: max(self.ceilings[r] for r in j.held))
+            self.block(job, holder)
+            return False
+        if holder is None:
+            return True
+        if holder is job or self.policy == "srp":
+            raise RuntimeError("%s: %s is held by %s under SRP" % (job.task.name, resource, holder.task.name))
+        self.waiters.setdefault(resource, []).append(job)
+        self.block(job, holder)
+        return False
+
+    def lock(self, job, resource):
+        self.holders[resource] = job
+        self.locked.append(resource)
+        job.held.append(resource)
+
+    def unlock(self, job, resource):
+        del self.holders[resource]
+        self.locked.remove(resource)
+        job.held.remove(resource)
+        if self.policy == "pcp":
+            # The jobs it blocked try again and it drops back to its own priority
+            for other in [other for other in self.blocked if other.blocker is job]:
+                other.blocker = None
+                self.blocked.discard(other)
+                self.push(other)
+            if job.key != job.base:
+                job.key = job.base
+                self.push(job)
+            return
+        waiters = self.waiters.get(resource)
+        if waiters:
+            # The most urgent waiter takes the resource over
+            waiter = min(waiters, key=lambda j: j.key)
+            waiters.remove(waiter)
+            waiter.blocker = None
+            self.blocked.discard(waiter)
+            for other in waiters:
+                other.blocker = waiter
+            self.lock(waiter, resource)
+            waiter.step += 1
+            self.push(waiter)
+
+    def advance(self, job):
+        job.step += 1
+        if job.step == len(self.steps[job.task.index]):
+            self.running = None
+            self.finish(job)
+
+    def finish(self, job):
+        task = job.task
+        stats = self.stats[task.index]
+        response = self.now - job.release
+        stats.jobs += 1
+        stats.wcrt = max(stats.wcrt, response)
+        stats.blocking = max(stats.blocking, job.waited)
+        stats.preemptions += job.preemptions
+        if self.now > job.deadline:
+            stats.misses += 1
+            if self.verbose:
+                print("%12s %-16s missed its deadline at %s" %
+                      (taskset.format_time(self.now), task.name, taskset.format_time(job.deadline)))
+        job.version += 1
+        self.current[task.index] = None
+        if self.backlog[task.index]:
+            self.start_job(task, self.backlog[task.index].pop(0))
+
+    def run(self):
+        while True:
+            while self.releases and self.releases[0][0] <= self.now:
+                release, index = heapq.heappop(self.releases)
+                self.release(self.tasks[index], release)
+
+            job, held_back = self.pick()
+            if job is not self.running:
+                previous = self.running
+                if previous is not None and previous.blocker is None:
+                    previous.preemptions += 1
+                self.running = job
+                if job is not None:
+                    self.switches += 1
+                    if self.verbose:
+                        print("%12s %s" % (taskset.format_time(self.now), job.task.name))
+            if job is None:
+                if self.releases:
+                    self.now = self.releases[0][0]
+                    continue
+                if any(self.current):
+                    self.deadlock = [j.task.name for j in self.current if j is not None]
+                break
+
+            job.started = True
+            kind, value = self.steps[job.task.index][job.step]
+            if kind == LOCK:
+                if self.try_lock(job, value):
+                    self.lock(job, value)
+                    self.advance(job)
+                else:
+                    self.running = None
+                continue
+            if kind == UNLOCK:
+                self.unlock(job, value)
+                self.advance(job)
+                continue
+
+            if job.left == 0:
+                job.left = value
+            duration = job.left
+            if self.releases:
+                duration = min(duration, self.releases[0][0] - self.now)
+            if held_back or self.blocked or job.key < job.base:
+                self.charge_blocking(job, held_back, duration)
+            job.left -= duration
+            self.busy += duration
+            self.now += duration
+            if job.left == 0:
+                self.advance(job)
+
+
+def fixed_priorities(tasks, method):
+    if method is None:
+        method = "given" if all(task.priority is not None for task in tasks) else "dm"
+    if method == "given":
+        missing = [task.name for task in tasks if task.priority is None]
+        if missing:
+            sys.exit("no priority for %s" % ", ".join(missing))
+        return {task: task.priority for task in tasks}
+    if method == "rm":
+        return taskset.rate_monotonic(tasks)
+    return taskset.deadline_monotonic(tasks)
+
+
+def default_horizon(tasks):
+    offset = max(task.offset for task in tasks)
+    hyperperiod = taskset.TaskSet(tasks).hyperperiod()
+    horizon = offset + (2 * hyperperiod if offset else hyperperiod)
+    jobs = sum(horizon // task.period for task in tasks)
+    if jobs > MAX_JOBS:
+        limit = offset + MAX_JOBS * 1.0 / sum(1.0 / task.period for task in tasks)
+        count = str(jobs) if jobs < 10 ** 12 else "about 10^%d" % (len(str(jobs)) - 1)
+        print("warning: the hyperperiod has %s jobs; simulating the first %s us" %
+              (count, taskset.format_time(int(limit))), file=sys.stderr)
+        horizon = int(limit)
+    return horizon
+
+
+def print_policy(simulator):
+    tasks = simulator.tasks
+    fixed = simulator.policy in ("fp", "pcp")
+    print("%-16s %5s %10s %10s %10s %7s %10s %10s %6s %8s" %
+          ("task", "prio" if fixed else "level", "period", "deadline", "wcet", "jobs",
+           "wcrt", "blocking", "misses", "preempt"))
+    for task in tasks:
+        stats = simulator.stats[task.index]
+        print("%-16s %5d %10s %10s %10s %7d %10s %10s %6d %8d" %
+              (task.name, simulator.priorities[task] if fixed else simulator.levels[task],
+               taskset.format_time(task.period), taskset.format_time(task.deadline),
+               taskset.format_time(task.wcet), stats.jobs, taskset.format_time(stats.wcrt),
+               taskset.format_time(stats.blocking), stats.misses, stats.preemptions))
+    if simulator.deadlock:
+        print("deadlock at %s us: %s" % (taskset.format_time(simulator.now), ", ".join(simulator.deadlock)))
+    print("context switches %d, busy %.1f%%, misses %d" %
+          (simulator.switches, 100.0 * simulator.busy / max(simulator.now, 1),
+           sum(stats.misses for stats in simulator.stats)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Simulate a task set under EDF, FP, PCP and SRP.")
+    parser.add_argument("taskset")
+    parser.add_argument("--policy", default=",".join(POLICIES),
+                        help="comma separated policies out of %s (default: all)" % ", ".join(POLICIES))
+    parser.add_argument("--priorities", choices=("given", "dm", "rm"),
+                        help="fixed priorities: as given, deadline or rate monotonic "
+                        "(default: given when every task has one, else dm)")
+    parser.add_argument("--horizon", help="simulated time, e.g. 10s (default: the hyperperiod)")
+    parser.add_argument("--fail-on-miss", action="store_true", help="exit with status 1 on a deadline miss")
+    parser.add_argument("-v", "--verbose", action="store_true", help="print every dispatch and miss")
+    args = parser.parse_args()
+
+    policies = [p.strip() for p in args.policy.split(",") if p.strip()]
+    for policy in policies:
+        if policy not in POLICIES:
+            sys.exit("unknown policy %s" % policy)
+
+    tasks = taskset.load(args.taskset).tasks
+    priorities = fixed_priorities(tasks, args.priorities)
+    try:
+        horizon = taskset.parse_time(args.horizon, "--horizon") if args.horizon else default_horizon(tasks)
+    except ValueError as error:
+        sys.exit(str(error))
+
+    utilization = sum(task.utilization for task in tasks)
+    resources = sorted({r for task in tasks for r in task.resources})
+    print("%s: %d tasks, utilization %.3f, simulated %s us, resources %s" %
+          (args.taskset, len(tasks), utilization, taskset.format_time(horizon), ", ".join(resources) or "none"))
+
+    results = []
+    for policy in policies:
+        print("\npolicy %s (%s)" % (policy, DESCRIPTIONS[policy]))
+        simulator = Simulator(tasks, policy, priorities, horizon, args.verbose)
+        simulator.run()
+        print_policy(simulator)
+        results.append(simulator)
+
+    if len(results) > 1:
+        print("\n%-6s %7s %8s %10s %10s %10s" %
+              ("policy", "misses", "preempt", "switches", "max r/d", "blocking"))
+        for simulator in results:
+            worst = max(s.wcrt / t.deadline for s, t in zip(simulator.stats, tasks))
+            print("%-6s %7d %8d %10d %10.3f %10s" %
+                  (simulator.policy, sum(s.misses for s in simulator.stats),
+                   sum(s.preemptions for s in simulator.stats), simulator.switches, worst,
+                   taskset.format_time(max(s.blocking for s in simulator.stats))))
+
+    if args.fail_on_miss and any(s.misses or sim.deadlock for sim in results for s in sim.stats):
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
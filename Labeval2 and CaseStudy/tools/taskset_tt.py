@@ -0,0 +1,160 @@
+#!/usr/bin/env python3
+"""Builds the time triggered schedule table of a task set.
+
+Reads a task set (see taskset.py) and takes the tasks marked
+"time_triggered": true.  Their jobs over one major frame, the hyperperiod
+of their periods, are laid out offline by non-preemptive EDF: at each point
+the released job with the earliest deadline gets a slot as long as its WCET,
+rounded up to a microsecond.  The kernel then only replays the table
+(xTaskStartTimeTriggered()), so no scheduling decision is left for run time.
+
+A slot must end by the deadline of its job and within the major frame, as
+the table repeats from the start of the next frame.  The header gives the
+frame, the index of each task in the array of task handles and the slots
+as TT_SLOT(offset_us, task, budget_us) rows for the firmware to expand.
+
+--check compares instead of writing and exits with status 1 when the
+header is out of date.
+
+usage: taskset_tt.py Core/taskset.json [-o Core/Inc/tt_table.h] [--check]
+"""
+
+import argparse
+import math
+import os
+import sys
+
+import taskset
+from taskset_gen import PROJECT, macro_name, microseconds
+
+# More slots than this do not fit a table in RAM on the board
+MAX_SLOTS = 1024
+
+
+class Job:
+    def __init__(self, task, release):
+        self.task = task
+        self.release = release
+        self.deadline = release + task.deadline
+
+
+def schedule(tasks, frame):
+    """Returns the slots as (offset, task, budget) in us, or exits with the job that fails."""
+    jobs = []
+    for task in tasks:
+        if task.offset >= task.period:
+            sys.exit("%s: offset must be less than the period" % task.name)
+        jobs += [Job(task, task.offset + k * task.period) for k in range(frame // task.period)]
+    if len(jobs) > MAX_SLOTS:
+        sys.exit("%d jobs in a major frame of %s us; at most %d fit the table" %
+                 (len(jobs), taskset.format_time(frame), MAX_SLOTS))
+
+    pending = sorted(jobs, key=lambda j: (j.release, j.task.index))
+    slots = []
+    now = 0
+    while pending:
+        released = [j for j in pending if j.release <= now]
+        if not released:
+            now = pending[0].release
+            continue
+        job = min(released, key=lambda j: (j.deadline, j.task.index))
+        pending.remove(job)
+        budget = microseconds(job.task.wcet, job.task.name + " wcet", round_up=True) * 1000
+        end = now + budget
+        if end > job.deadline:
+            sys.exit("%s: the job released at %s us ends at %s us, after its deadline" %
+                     (job.task.name, taskset.format_time(job.release), taskset.format_time(end)))
+        if end > frame:
+            sys.exit("%s: the job released at %s us ends at %s us, after the major frame" %
+                     (job.task.name, taskset.format_time(job.release), taskset.format_time(end)))
+        slots.append((now // 1000, job.task, budget // 1000))
+        now = end
+    return slots
+
+
+def header(path, data, tasks, frame, slots):
+    """Returns the text of the header."""
+    lines = []
+    add = lines.append
+    name = os.path.basename(path)
+    guard = "__" + macro_name(name.replace(".", "_"))
+    source = os.path.relpath(os.path.abspath(data), PROJECT)
+    busy = sum(budget for _, _, budget in slots)
+    add("/**")
+    add("  " + "*" * 78)
+    add("  * @file           : %s" % name)
+    add("  * @brief          : Time triggered schedule, generated from %s." % source)
+    add("  *")
+    add("  * Generated by tools/taskset_tt.py from the tasks of the table marked")
+    add("  * time_triggered; change the table and generate again instead of")
+    add("  * editing this file.")
+    add("  *")
+    add("  * %d slots in a major frame of %d us, %.1f%% of it dispatched." %
+        (len(slots), frame // 1000, 100.0 * busy * 1000 / frame))
+    add("  " + "*" * 78)
+    add("  */")
+    add("")
+    add("#ifndef %s" % guard)
+    add("#define %s" % guard)
+    add("")
+    add("/* Times in microseconds */")
+    add("#define %-31s %d" % ("TT_MAJOR_FRAME_US", frame // 1000))
+    add("")
+    add("/* Index of each task in the array of task handles */")
+    for index, task in enumerate(tasks):
+        add("#define %-31s %d" % ("TT_" + (task.extra.get("id") or macro_name(task.name)), index))
+    add("#define %-31s %d" % ("TT_TASKS", len(tasks)))
+    add("")
+    add("/* The slots of one major frame, ordered by offset */")
+    add("#define %-31s %d" % ("TT_TABLE_ENTRIES", len(slots)))
+    add("#define TT_TABLE \\")
+    for offset, task, budget in slots:
+        add("    TT_SLOT(%d, %s, %d), \\" % (offset, "TT_" + (task.extra.get("id") or macro_name(task.name)), budget))
+    add("")
+    add("#endif /* %s */" % guard)
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Build the time triggered schedule table of a task set.")
+    parser.add_argument("taskset")
+    parser.add_argument("-o", "--output", help="header to write (default: only the table)")
+    parser.add_argument("--check", action="store_true",
+                        help="exit with status 1 if the header differs from what would be written")
+    args = parser.parse_args()
+
+    table = taskset.load(args.taskset)
+    tasks = [task for task in table.tasks if task.extra.get("time_triggered") is True]
+    if not tasks:
+        sys.exit("%s: no task is marked time_triggered" % args.taskset)
+    frame = math.lcm(*[task.period for task in tasks])
+    if frame % 1000:
+        sys.exit("%s: the major frame is not a whole number of microseconds" % args.taskset)
+
+    slots = schedule(tasks, frame)
+    print("%s: %d time triggered tasks, major frame %s us, %d slots" %
+          (args.taskset, len(tasks), taskset.format_time(frame), len(slots)))
+    print("%10s %10s  %s" % ("offset", "budget", "task"))
+    for offset, task, budget in slots:
+        print("%10d %10d  %s" % (offset, budget, task.name))
+
+    if not args.output:
+        return
+    text = header(args.output, args.taskset, tasks, frame, slots)
+    if args.check:
+        try:
+            with open(args.output, encoding="utf-8") as f:
+                current = f.read()
+        except OSError:
+            current = None
+        if current != text:
+            sys.exit("\n%s is out of date; generate it again" % args.output)
+        print("\n%s is up to date" % args.output)
+        return
+    with open(args.output, "w", encoding="utf-8") as f:
+        f.write(text)
+    print("\nwrote %s" % args.output)
+
+
+if __name__ == "__main__":
+    main()
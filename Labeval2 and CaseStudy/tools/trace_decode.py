@@ -0,0 +1,281 @@
+#!/usr/bin/env python3
+"""Decodes a trace recorded by Core/Src/trace_recorder.c.
+
+The input is either a snapshot saved from the debugger
+    (gdb) dump binary value trace.bin trace_buffer
+or a capture of the USART1 stream of a TRACE_STREAMING build.
+
+Writes a Chrome/Perfetto JSON timeline with one track per task and one per
+interrupt, and prints per-task response times and preemption counts.  A job
+is counted from the moment the task becomes ready until it blocks; jobs that
+were already running when the trace started are skipped.
+
+usage: trace_decode.py trace.bin [-o trace.json]
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+TRACE_MAGIC = 0x52544652
+TRACE_VERSION = 1
+
+HEADER = struct.Struct("<IHHIIIIIBBBB")
+RECORD = struct.Struct("<IBBH")
+
+MODE_SNAPSHOT = 0
+MODE_STREAMING = 1
+
+(TASK_CREATE, TASK_NAME, TASK_DELETE, TASK_READY, TASK_SWITCHED_IN,
+ TASK_SWITCHED_OUT, TASK_PRIORITY_SET, TASK_PRIORITY_INHERIT,
+ TASK_PRIORITY_DISINHERIT, TASK_PRIORITY_CEILING, DEADLINE_MISSED,
+ SERVER_BUDGET_EXHAUSTED, QUEUE_CREATE, QUEUE_SEND, QUEUE_RECEIVE,
+ QUEUE_BLOCK_SEND, QUEUE_BLOCK_RECEIVE, QUEUE_SEND_FROM_ISR,
+ QUEUE_RECEIVE_FROM_ISR, ISR_ENTER, ISR_EXIT, DROPPED) = range(1, 23)
+
+QUEUE_EVENTS = {
+    QUEUE_SEND: "send",
+    QUEUE_RECEIVE: "receive",
+    QUEUE_BLOCK_SEND: "block on send",
+    QUEUE_BLOCK_RECEIVE: "block on receive",
+    QUEUE_SEND_FROM_ISR: "send from ISR",
+    QUEUE_RECEIVE_FROM_ISR: "receive from ISR",
+}
+
+PRIORITY_EVENTS = {
+    TASK_PRIORITY_SET: "priority set",
+    TASK_PRIORITY_INHERIT: "priority inherit",
+    TASK_PRIORITY_DISINHERIT: "priority disinherit",
+    TASK_PRIORITY_CEILING: "priority ceiling",
+}
+
+# queueQUEUE_TYPE_* from queue.h
+QUEUE_TYPES = {0: "queue", 1: "mutex", 2: "counting semaphore",
+               3: "binary semaphore", 4: "recursive mutex"}
+
+ISR_TRACK_BASE = 1000
+
+
+def read_trace(data):
+    """Returns the header fields, the name table and the records in order."""
+    if len(data) < HEADER.size:
+        sys.exit("trace is shorter than its header")
+    (magic, version, record_size, capacity, write_index, read_index, dropped,
+     timestamp_hz, mode, running, max_tasks, name_len) = HEADER.unpack_from(data, 0)
+    if magic != TRACE_MAGIC:
+        sys.exit("not a trace: bad magic 0x%08x" % magic)
+    if version != TRACE_VERSION or record_size != RECORD.size:
+        sys.exit("unsupported trace version %d record size %d" % (version, record_size))
+
+    names = {}
+    offset = HEADER.size
+    for task in range(max_tasks):
+        raw = data[offset + task * name_len:offset + (task + 1) * name_len]
+        name = raw.split(b"\0", 1)[0].decode("ascii", "replace")
+        if name:
+            names[task] = name
+    offset += max_tasks * name_len
+
+    if mode == MODE_STREAMING:
+        count = (len(data) - offset) // RECORD.size
+        records = [RECORD.unpack_from(data, offset + n * RECORD.size) for n in range(count)]
+    else:
+        # The ring holds the newest min(write_index, capacity) records
+        count = min(write_index, capacity)
+        first = write_index - count
+        records = [RECORD.unpack_from(data, offset + ((first + n) % capacity) * RECORD.size)
+                   for n in range(count)]
+        if write_index > capacity:
+            print("snapshot wrapped: %d oldest events were overwritten" % (write_index - capacity))
+
+    return timestamp_hz, names, records
+
+
+def unwrap(records):
+    """Extends the 32-bit timestamps so that time never goes backwards and
+    starts the timeline at the first event."""
+    base = 0
+    last = None
+    for timestamp, event, obj, value in records:
+        if event == TASK_NAME:
+            yield None, event, obj, value, timestamp
+            continue
+        if event == DROPPED and last is not None:
+            # Stamped when it was sent rather than recorded, so it does not
+            # take part in detecting a wrap
+            yield base + last, event, obj, value, None
+            continue
+        if last is None:
+            base = -timestamp
+        elif timestamp < last:
+            base += 1 << 32
+        last = timestamp
+        yield base + timestamp, event, obj, value, None
+
+
+class Task:
+    def __init__(self, number):
+        self.number = number
+        self.name = None
+        self.state = "unknown"
+        self.slice_start = None
+        self.job_start = None
+        self.responses = []
+        self.preemptions = 0
+        self.run_time = 0
+        self.deadline_misses = 0
+        self.budget_exhaustions = 0
+
+
+def decode(timestamp_hz, names, records):
+    scale = 1e6 / timestamp_hz
+    tasks = {}
+    queues = {}
+    events = []
+    running = None
+    isr_start = {}
+    last_time = 0
+    dropped = 0
+
+    def task(number):
+        if number not in tasks:
+            tasks[number] = Task(number)
+            tasks[number].name = names.get(number)
+        return tasks[number]
+
+    def instant(name, tid, time, args=None):
+        events.append({"name": name, "ph": "i", "s": "t", "pid": 1, "tid": tid,
+                       "ts": time * scale, "args": args or {}})
+
+    for time, event, obj, value, packed in unwrap(records):
+        if event == TASK_NAME:
+            chunk = struct.pack("<IH", packed, value).split(b"\0", 1)[0]
+            t = task(obj)
+            t.name = (t.name if t.state == "naming" else "") + chunk.decode("ascii", "replace")
+            t.state = "naming" if len(chunk) == 6 else "blocked"
+            continue
+
+        last_time = time
+        if event == TASK_CREATE:
+            t = task(obj)
+            t.name = ""
+            t.state = "naming"
+            instant("create (priority %d)" % value, obj, time)
+        elif event == TASK_DELETE:
+            task(obj).state = "deleted"
+            instant("delete", obj, time)
+        elif event == TASK_READY:
+            t = task(obj)
+            if t.state == "blocked":
+                t.job_start = time
+            if t.state != "running":
+                t.state = "ready"
+        elif event == TASK_SWITCHED_IN:
+            t = task(obj)
+            t.state = "running"
+            t.slice_start = time
+            running = obj
+        elif event == TASK_SWITCHED_OUT:
+            t = task(obj)
+            if t.slice_start is not None:
+                events.append({"name": t.name or "task %d" % obj, "ph": "X", "pid": 1, "tid": obj,
+                               "ts": t.slice_start * scale, "dur": (time - t.slice_start) * scale})
+                t.run_time += time - t.slice_start
+            t.slice_start = None
+            if value:
+                t.state = "ready"
+                t.preemptions += 1
+            else:
+                t.state = "blocked"
+                if t.job_start is not None:
+                    t.responses.append(time - t.job_start)
+                t.job_start = None
+            running = None
+        elif event in PRIORITY_EVENTS:
+            instant("%s %d" % (PRIORITY_EVENTS[event], value), obj, time)
+        elif event == DEADLINE_MISSED:
+            task(obj).deadline_misses += 1
+            instant("deadline missed", obj, time)
+        elif event == SERVER_BUDGET_EXHAUSTED:
+            task(obj).budget_exhaustions += 1
+            instant("server budget exhausted", obj, time)
+        elif event == QUEUE_CREATE:
+            queues[obj] = QUEUE_TYPES.get(value, "queue")
+        elif event in QUEUE_EVENTS:
+            # Queue events carry the queue, they belong to whatever was running
+            kind = queues.get(obj, "queue")
+            tid = running if running is not None else ISR_TRACK_BASE
+            instant("%s %d %s" % (kind, obj, QUEUE_EVENTS[event]), tid, time)
+        elif event == ISR_ENTER:
+            isr_start[value] = time
+        elif event == ISR_EXIT:
+            start = isr_start.pop(value, None)
+            if start is not None:
+                events.append({"name": "IRQ %d" % (value - 16), "ph": "X", "pid": 1,
+                               "tid": ISR_TRACK_BASE + value,
+                               "ts": start * scale, "dur": (time - start) * scale})
+        elif event == DROPPED:
+            dropped += value
+            instant("%d events dropped" % value, ISR_TRACK_BASE, time)
+
+    # Close the slice of the task that was running when the trace ended
+    if running is not None and tasks[running].slice_start is not None:
+        t = tasks[running]
+        events.append({"name": t.name or "task %d" % running, "ph": "X", "pid": 1, "tid": running,
+                       "ts": t.slice_start * scale, "dur": (last_time - t.slice_start) * scale})
+        t.run_time += last_time - t.slice_start
+
+    for number, t in tasks.items():
+        events.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": number,
+                       "args": {"name": t.name or "task %d" % number}})
+        events.append({"name": "thread_sort_index", "ph": "M", "pid": 1, "tid": number,
+                       "args": {"sort_index": number}})
+    for tid in sorted({e["tid"] for e in events if e["tid"] >= ISR_TRACK_BASE}):
+        name = "IRQ %d" % (tid - ISR_TRACK_BASE - 16) if tid > ISR_TRACK_BASE else "interrupts"
+        events.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": tid, "args": {"name": name}})
+    events.append({"name": "process_name", "ph": "M", "pid": 1, "args": {"name": "STM32F401"}})
+
+    return tasks, events, dropped, scale
+
+
+def report(tasks, dropped, scale):
+    print("%-16s %6s %10s %10s %10s %8s %6s %10s" %
+          ("task", "jobs", "min us", "avg us", "max us", "preempt", "misses", "cpu us"))
+    for number in sorted(tasks):
+        t = tasks[number]
+        if t.responses:
+            response = (min(t.responses) * scale,
+                        sum(t.responses) * scale / len(t.responses),
+                        max(t.responses) * scale)
+            times = "%10.0f %10.0f %10.0f" % response
+        else:
+            times = "%10s %10s %10s" % ("-", "-", "-")
+        print("%-16s %6d %s %8d %6d %10.0f" %
+              (t.name or "task %d" % number, len(t.responses), times,
+               t.preemptions, t.deadline_misses, t.run_time * scale))
+    if dropped:
+        print("%d events were dropped while streaming" % dropped)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode a binary FreeRTOS scheduling trace.")
+    parser.add_argument("trace", help="snapshot dump or captured stream")
+    parser.add_argument("-o", "--output", default="trace.json",
+                        help="Chrome/Perfetto JSON output (default: trace.json)")
+    args = parser.parse_args()
+
+    with open(args.trace, "rb") as f:
+        data = f.read()
+
+    timestamp_hz, names, records = read_trace(data)
+    tasks, events, dropped, scale = decode(timestamp_hz, names, records)
+
+    with open(args.output, "w") as f:
+        json.dump({"traceEvents": events, "displayTimeUnit": "ms"}, f)
+
+    report(tasks, dropped, scale)
+
+
+if __name__ == "__main__":
+    main()
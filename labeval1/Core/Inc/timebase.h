@@ -0,0 +1,26 @@
+/**
+  ******************************************************************************
+  * @file           : timebase.h
+  * @brief          : 64-bit microsecond time base on TIM5.
+  ******************************************************************************
+  */
+
+#ifndef __TIMEBASE_H
+#define __TIMEBASE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* TIM5 counts microseconds from HAL_InitTick() and is extended to 64 bits in
+ * software, so the time never wraps while the device is running.  Safe to
+ * call from tasks, from interrupts and with interrupts masked. */
+uint64_t timebase_get_us(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TIMEBASE_H */
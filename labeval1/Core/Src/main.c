@@ -39,6 +39,7 @@
 /* USER CODE BEGIN PD */
 #define TASK_STACK_SIZE 128  // Reduced stack size for tasks
 #define TIMER_PERIOD pdMS_TO_TICKS(500)  // 500ms timer period
+#define ADC_CONVERSION_TIMEOUT pdMS_TO_TICKS(2)  // Only reached if the end of conversion interrupt is lost
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -50,6 +51,7 @@
 
 /* USER CODE BEGIN PV */
 ADC_HandleTypeDef hadc1;
+static TaskHandle_t potentiometer_task_handle;
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -57,6 +59,7 @@ void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
 static void MX_ADC1_Init(void);
 /* USER CODE BEGIN PFP */
+static BaseType_t adc_read(uint32_t* value);
 static void potentiometer_task(void* parameters);
 /* USER CODE END PFP */
 
@@ -78,7 +81,7 @@ int main(void)
     MX_ADC1_Init();
 
     /* Create the potentiometer task */
-    xTaskCreate(potentiometer_task, "PotTask", TASK_STACK_SIZE, NULL, 1, NULL);
+    xTaskCreate(potentiometer_task, "PotTask", TASK_STACK_SIZE, NULL, 1, &potentiometer_task_handle);
 
     /* Start scheduler */
     vTaskStartScheduler();
@@ -200,6 +203,41 @@ static void MX_ADC1_Init(void)
     }
 }
 
+/* Converts one sample, blocking the calling task until the end of
+ * conversion interrupt instead of polling the ADC */
+static BaseType_t adc_read(uint32_t* value)
+{
+    BaseType_t result = pdFAIL;
+
+    // A give left by a conversion that timed out would end the wait early.
+    // ulTaskNotifyTake() looks at the count, not the state, so clear the count.
+    ulTaskNotifyValueClear(NULL, UINT32_MAX);
+
+    if (HAL_ADC_Start_IT(&hadc1) == HAL_OK)
+    {
+        if (ulTaskNotifyTake(pdTRUE, ADC_CONVERSION_TIMEOUT) != 0)
+        {
+            *value = HAL_ADC_GetValue(&hadc1);
+            result = pdPASS;
+        }
+        HAL_ADC_Stop_IT(&hadc1);
+    }
+
+    return result;
+}
+
+/* Wakes the potentiometer task blocked in adc_read() */
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef* hadc)
+{
+    BaseType_t higher_priority_task_woken = pdFALSE;
+
+    if (hadc->Instance == ADC1)
+    {
+        vTaskNotifyGiveFromISR(potentiometer_task_handle, &higher_priority_task_woken);
+        portYIELD_FROM_ISR(higher_priority_task_woken);
+    }
+}
+
 static void potentiometer_task(void* parameters)
 {
     uint32_t adcValue;
@@ -207,22 +245,19 @@ static void potentiometer_task(void* parameters)
 
     while (1)
     {
-        // Start ADC Conversion
-        HAL_ADC_Start(&hadc1);
-        // Poll for end of conversion
-        HAL_ADC_PollForConversion(&hadc1, HAL_MAX_DELAY);
-        // Get the ADC value
-        adcValue = HAL_ADC_GetValue(&hadc1);
-
-        // Turn on LED if ADC value is above the threshold
-        if (adcValue > ledThreshold)
-        {
-            HAL_GPIO_WritePin(GPIOC, GPIO_PIN_13, GPIO_PIN_SET); // Turn on LED
-        }
-        // Turn off LED if ADC value is below or equal to the threshold
-        else
+        // Convert, blocked until the ADC interrupt so other tasks can run
+        if (adc_read(&adcValue) == pdPASS)
         {
-            HAL_GPIO_WritePin(GPIOC, GPIO_PIN_13, GPIO_PIN_RESET); // Turn off LED
+            // Turn on LED if ADC value is above the threshold
+            if (adcValue > ledThreshold)
+            {
+                HAL_GPIO_WritePin(GPIOC, GPIO_PIN_13, GPIO_PIN_SET); // Turn on LED
+            }
+            // Turn off LED if ADC value is below or equal to the threshold
+            else
+            {
+                HAL_GPIO_WritePin(GPIOC, GPIO_PIN_13, GPIO_PIN_RESET); // Turn off LED
+            }
         }
 
         // Delay for a while
@@ -283,6 +283,14 @@
     #define configUSE_MUTEXES    0
 #endif
 
+#ifndef configUSE_MUTEX_CEILING
+    #define configUSE_MUTEX_CEILING    0
+#endif
+
+#if ( ( configUSE_MUTEX_CEILING == 1 ) && ( configUSE_MUTEXES != 1 ) )
+    #error configUSE_MUTEX_CEILING requires configUSE_MUTEXES to be set to 1
+#endif
+
 #ifndef configUSE_TIMERS
     #define configUSE_TIMERS    0
 #endif
@@ -449,6 +457,15 @@
     #define traceTASK_PRIORITY_INHERIT( pxTCBOfMutexHolder, uxInheritedPriority )
 #endif
 
+#ifndef traceTASK_PRIORITY_CEILING
+
+/* Called when a task takes a mutex that was created with a priority ceiling
+ * above the priority of the task.  pxTCBOfMutexHolder is a pointer to the TCB
+ * of the task, which now holds the mutex.  uxCeilingPriority is the priority
+ * the task is raised to. */
+    #define traceTASK_PRIORITY_CEILING( pxTCBOfMutexHolder, uxCeilingPriority )
+#endif
+
 #ifndef traceTASK_PRIORITY_DISINHERIT
 
 /* Called when a task releases a mutex, the holding of which had resulted in
@@ -619,6 +636,14 @@
     #define traceTASK_DELAY_UNTIL( x )
 #endif
 
+#ifndef traceTASK_DEADLINE_MISSED
+    #define traceTASK_DEADLINE_MISSED( pxTCB )
+#endif
+
+#ifndef traceTASK_SERVER_BUDGET_EXHAUSTED
+    #define traceTASK_SERVER_BUDGET_EXHAUSTED( pxTCB )
+#endif
+
 #ifndef traceTASK_DELAY
     #define traceTASK_DELAY()
 #endif
@@ -941,6 +966,178 @@
     #define configUSE_POSIX_ERRNO    0
 #endif
 
+/* Values that can be assigned to configSCHEDULING_POLICY. */
+#define SCHEDULING_POLICY_FIXED_PRIORITY    0
+#define SCHEDULING_POLICY_EDF               1
+#define SCHEDULING_POLICY_HYBRID            2
+
+#ifndef configSCHEDULING_POLICY
+
+/* SCHEDULING_POLICY_FIXED_PRIORITY is the standard FreeRTOS scheduler.
+ * SCHEDULING_POLICY_EDF orders every task other than the idle task by deadline
+ * and ignores task priorities.  SCHEDULING_POLICY_HYBRID selects between
+ * priority bands by priority, and orders the tasks within the bands set in
+ * configEDF_PRIORITY_BANDS by deadline.  Configurations that predate the
+ * option and set configUSE_EDF_SCHEDULER to 1 get the hybrid policy. */
+    #if ( defined( configUSE_EDF_SCHEDULER ) && ( configUSE_EDF_SCHEDULER == 1 ) )
+        #define configSCHEDULING_POLICY    SCHEDULING_POLICY_HYBRID
+    #else
+        #define configSCHEDULING_POLICY    SCHEDULING_POLICY_FIXED_PRIORITY
+    #endif
+#endif
+
+#if ( ( configSCHEDULING_POLICY != SCHEDULING_POLICY_FIXED_PRIORITY ) && ( configSCHEDULING_POLICY != SCHEDULING_POLICY_EDF ) && ( configSCHEDULING_POLICY != SCHEDULING_POLICY_HYBRID ) )
+    #error configSCHEDULING_POLICY must be set to SCHEDULING_POLICY_FIXED_PRIORITY, SCHEDULING_POLICY_EDF or SCHEDULING_POLICY_HYBRID
+#endif
+
+/* configUSE_EDF_SCHEDULER includes the deadline support that both EDF
+ * policies use, and follows from the policy. */
+#ifndef configUSE_EDF_SCHEDULER
+    #if ( configSCHEDULING_POLICY == SCHEDULING_POLICY_FIXED_PRIORITY )
+        #define configUSE_EDF_SCHEDULER    0
+    #else
+        #define configUSE_EDF_SCHEDULER    1
+    #endif
+#endif
+
+#if ( ( configUSE_EDF_SCHEDULER == 1 ) != ( configSCHEDULING_POLICY != SCHEDULING_POLICY_FIXED_PRIORITY ) )
+    #error configUSE_EDF_SCHEDULER does not match configSCHEDULING_POLICY.  Remove configUSE_EDF_SCHEDULER from FreeRTOSConfig.h.
+#endif
+
+#ifndef configEDF_PRIORITY_BANDS
+
+/* Under SCHEDULING_POLICY_HYBRID, bit n set means the tasks of priority n are
+ * scheduled earliest deadline first.  The tasks of the other priorities are
+ * time sliced as with the fixed priority scheduler.  By default every band
+ * except the idle band uses EDF. */
+    #define configEDF_PRIORITY_BANDS    0xFFFFFFFEUL
+#endif
+
+#if ( ( configSCHEDULING_POLICY == SCHEDULING_POLICY_HYBRID ) && ( configMAX_PRIORITIES > 32 ) )
+    #error SCHEDULING_POLICY_HYBRID can only be used when configMAX_PRIORITIES is less than or equal to 32
+#endif
+
+#ifndef configUSE_EDF_ADMISSION_CONTROL
+
+/* Set to 1 to reject periodic tasks that would make the task set
+ * unschedulable under EDF. */
+    #define configUSE_EDF_ADMISSION_CONTROL    0
+#endif
+
+#if ( ( configUSE_EDF_ADMISSION_CONTROL == 1 ) && ( configUSE_EDF_SCHEDULER != 1 ) )
+    #error configUSE_EDF_ADMISSION_CONTROL requires configSCHEDULING_POLICY to be set to SCHEDULING_POLICY_EDF or SCHEDULING_POLICY_HYBRID
+#endif
+
+#ifndef configEDF_DEMAND_TEST_MAX_INTERVAL_MS
+
+/* The longest interval, in milliseconds, that the admission test checks
+ * deadlines over.  The test runs with the scheduler suspended, so a task set
+ * that needs a longer interval is rejected instead. */
+    #define configEDF_DEMAND_TEST_MAX_INTERVAL_MS    1000
+#endif
+
+#ifndef configUSE_EDF_MICROSECOND_TIME
+
+/* Set to 1 to keep deadlines, periods and execution times in microseconds of
+ * a 64-bit time base read with portGET_DEADLINE_TIME(), instead of in ticks.
+ * Jobs are still released on tick boundaries. */
+    #define configUSE_EDF_MICROSECOND_TIME    0
+#endif
+
+#if ( configUSE_EDF_MICROSECOND_TIME == 1 )
+    #if ( configUSE_EDF_SCHEDULER != 1 )
+        #error configUSE_EDF_MICROSECOND_TIME requires configSCHEDULING_POLICY to be set to SCHEDULING_POLICY_EDF or SCHEDULING_POLICY_HYBRID
+    #endif
+
+    #ifndef portGET_DEADLINE_TIME
+        #error configUSE_EDF_MICROSECOND_TIME is set to 1 but portGET_DEADLINE_TIME() is not defined.  It must return the current time in microseconds as a uint64_t.
+    #endif
+
+/* The time base never overflows in practice, but the kernel still orders
+ * deadlines by their difference so the same code works for either unit. */
+    typedef uint64_t DeadlineTime_t;
+    #define portDEADLINE_TIME_PER_TICK    ( ( DeadlineTime_t ) ( 1000000U / configTICK_RATE_HZ ) )
+#else
+    typedef TickType_t DeadlineTime_t;
+    #define portDEADLINE_TIME_PER_TICK    ( ( DeadlineTime_t ) 1U )
+#endif
+
+#ifndef configUSE_DEADLINE_MISS_DETECTION
+
+/* Set to 1 to count the jobs of periodic tasks that finish after their
+ * deadline and to keep a histogram of how late they were. */
+    #define configUSE_DEADLINE_MISS_DETECTION    0
+#endif
+
+#if ( ( configUSE_DEADLINE_MISS_DETECTION == 1 ) && ( configUSE_EDF_SCHEDULER != 1 ) )
+    #error configUSE_DEADLINE_MISS_DETECTION requires configSCHEDULING_POLICY to be set to SCHEDULING_POLICY_EDF or SCHEDULING_POLICY_HYBRID
+#endif
+
+#ifndef configUSE_DEADLINE_MISS_HOOK
+    #define configUSE_DEADLINE_MISS_HOOK    0
+#endif
+
+#ifndef configTARDINESS_HISTOGRAM_BUCKETS
+
+/* Bucket n of the tardiness histogram counts the jobs that finished between
+ * 2^n and 2^(n+1) - 1 ticks, or microseconds, late.  The last bucket also counts every job
+ * that was later than that. */
+    #define configTARDINESS_HISTOGRAM_BUCKETS    8
+#endif
+
+#ifndef configUSE_JOB_STATS
+
+/* Set to 1 to record the response time and start latency of the jobs of
+ * periodic tasks, returned with their run time by uxTaskGetRunStats(). */
+    #define configUSE_JOB_STATS    0
+#endif
+
+#if ( ( configUSE_JOB_STATS == 1 ) && ( configUSE_EDF_SCHEDULER != 1 ) )
+    #error configUSE_JOB_STATS requires configSCHEDULING_POLICY to be set to SCHEDULING_POLICY_EDF or SCHEDULING_POLICY_HYBRID
+#endif
+
+#if ( ( configUSE_JOB_STATS == 1 ) && ( configGENERATE_RUN_TIME_STATS != 1 ) )
+    #error configUSE_JOB_STATS requires configGENERATE_RUN_TIME_STATS to be set to 1
+#endif
+
+#ifndef configUSE_SRP
+
+/* Set to 1 to include the Stack Resource Policy, which bounds the blocking of
+ * EDF scheduled tasks that share resources to one critical section. */
+    #define configUSE_SRP    0
+#endif
+
+#if ( ( configUSE_SRP == 1 ) && ( configUSE_EDF_SCHEDULER != 1 ) )
+    #error configUSE_SRP requires configSCHEDULING_POLICY to be set to SCHEDULING_POLICY_EDF or SCHEDULING_POLICY_HYBRID
+#endif
+
+#ifndef configUSE_CBS
+
+/* Set to 1 to include the Constant Bandwidth Server, which runs aperiodic
+ * tasks under EDF without letting them overload the periodic tasks. */
+    #define configUSE_CBS    0
+#endif
+
+#if ( ( configUSE_CBS == 1 ) && ( configUSE_EDF_SCHEDULER != 1 ) )
+    #error configUSE_CBS requires configSCHEDULING_POLICY to be set to SCHEDULING_POLICY_EDF or SCHEDULING_POLICY_HYBRID
+#endif
+
+#ifndef configUSE_TIME_TRIGGERED
+
+/* Set to 1 to include the time triggered mode, in which tasks are dispatched
+ * from a static table of slots instead of being selected from the ready
+ * lists. */
+    #define configUSE_TIME_TRIGGERED    0
+#endif
+
+#if ( ( configUSE_TIME_TRIGGERED == 1 ) && ( configUSE_EDF_SCHEDULER != 1 ) )
+    #error configUSE_TIME_TRIGGERED requires configSCHEDULING_POLICY to be set to SCHEDULING_POLICY_EDF or SCHEDULING_POLICY_HYBRID
+#endif
+
+#if ( ( configUSE_TIME_TRIGGERED == 1 ) && ( INCLUDE_vTaskSuspend != 1 ) )
+    #error configUSE_TIME_TRIGGERED requires INCLUDE_vTaskSuspend to be set to 1
+#endif
+
 #ifndef configUSE_SB_COMPLETED_CALLBACK
 
 /* By default per-instance callbacks are not enabled for stream buffer or message buffer. */
@@ -1301,6 +1498,36 @@ typedef struct xSTATIC_TCB
     #if ( configUSE_POSIX_ERRNO == 1 )
         int iDummy22;
     #endif
+    #if ( configUSE_EDF_SCHEDULER == 1 )
+        DeadlineTime_t xDummy23[ 4 ];
+    #endif
+    #if ( configUSE_EDF_ADMISSION_CONTROL == 1 )
+        DeadlineTime_t xDummy24;
+        void * pxDummy25;
+    #endif
+    #if ( configUSE_DEADLINE_MISS_DETECTION == 1 )
+        uint32_t ulDummy26[ 2 ];
+        DeadlineTime_t xDummy27;
+        uint32_t ulDummy28[ configTARDINESS_HISTOGRAM_BUCKETS ];
+        uint8_t ucDummy29;
+    #endif
+    #if ( configUSE_SRP == 1 )
+        UBaseType_t uxDummy30;
+    #endif
+    #if ( configUSE_CBS == 1 )
+        DeadlineTime_t xDummy31[ 2 ];
+        uint8_t ucDummy32;
+    #endif
+    #if ( configUSE_JOB_STATS == 1 )
+        struct
+        {
+            uint32_t ulDummy33;
+            DeadlineTime_t xDummy34[ 2 ];
+            uint64_t ullDummy35;
+            DeadlineTime_t xDummy36[ 2 ];
+        } xDummy37;
+        uint8_t ucDummy38;
+    #endif
 } StaticTask_t;
 
 /*
@@ -1343,6 +1570,10 @@ typedef struct xSTATIC_QUEUE
         UBaseType_t uxDummy8;
         uint8_t ucDummy9;
     #endif
+
+    #if ( configUSE_MUTEX_CEILING == 1 )
+        UBaseType_t uxDummy10;
+    #endif
 } StaticQueue_t;
 typedef StaticQueue_t StaticSemaphore_t;
 
@@ -44,10 +44,12 @@
 #ifdef __GNUC__
 	#include <stdint.h>
 	extern uint32_t SystemCoreClock;
+	extern uint64_t timebase_get_us( void );
 #endif
 
 #define configUSE_PREEMPTION			1
 #define configUSE_TIME_SLICING          1
+#define configSCHEDULING_POLICY		SCHEDULING_POLICY_FIXED_PRIORITY
 
 #define configUSE_IDLE_HOOK				0
 #define configUSE_TICK_HOOK				0
@@ -67,7 +69,13 @@
 #define configUSE_MALLOC_FAILED_HOOK	0
 #define configUSE_APPLICATION_TASK_TAG	0
 #define configUSE_COUNTING_SEMAPHORES	1
-#define configGENERATE_RUN_TIME_STATS	0
+#define configGENERATE_RUN_TIME_STATS	1
+
+/* Run time stats count microseconds on the TIM5 time base, which is started
+by HAL_InitTick() before the scheduler. */
+#define configRUN_TIME_COUNTER_TYPE		uint64_t
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()	timebase_get_us()
 
 
 /* Software timer definitions. */
@@ -90,6 +90,34 @@
     #define configSTACK_ALLOCATION_FROM_SEPARATE_HEAP    0
 #endif
 
+#ifndef configUSE_TLSF_HEAP
+    /* Set to 1 to take pvPortMalloc() and vPortFree() from the constant time
+     * allocator of portable/MemMang/heap_tlsf.c instead of heap_4.c. */
+    #define configUSE_TLSF_HEAP    0
+#endif
+
+#ifndef configUSE_POOL_ALLOCATOR
+    /* Set to 1 to include the fixed block pools of portable/MemMang/pool.c,
+     * in which case configPOOL_CLASSES() must list the block classes. */
+    #define configUSE_POOL_ALLOCATOR    0
+#endif
+
+#ifndef configTCB_FROM_POOL
+    /* Set to 1 to allocate the TCBs of dynamically created tasks from the
+     * pools instead of the heap. */
+    #define configTCB_FROM_POOL    0
+#endif
+
+#ifndef configQUEUE_FROM_POOL
+    /* Set to 1 to allocate dynamically created queues, semaphores and
+     * mutexes, with their storage, from the pools instead of the heap. */
+    #define configQUEUE_FROM_POOL    0
+#endif
+
+#if ( ( ( configTCB_FROM_POOL == 1 ) || ( configQUEUE_FROM_POOL == 1 ) ) && ( configUSE_POOL_ALLOCATOR != 1 ) )
+    #error configTCB_FROM_POOL and configQUEUE_FROM_POOL require configUSE_POOL_ALLOCATOR to be set to 1
+#endif
+
 /* *INDENT-OFF* */
 #ifdef __cplusplus
     extern "C" {
@@ -150,6 +178,16 @@ typedef struct xHeapStats
     size_t xNumberOfSuccessfulFrees;        /* The number of calls to vPortFree() that has successfully freed a block of memory. */
 } HeapStats_t;
 
+/* Used to pass information about each block class out of uxPortGetPoolStats(). */
+typedef struct xPoolStats
+{
+    size_t xBlockSize;                 /* The size of the blocks of the class, rounded up to portBYTE_ALIGNMENT. */
+    size_t xNumberOfBlocks;            /* The number of blocks of the class. */
+    size_t xBlocksInUse;               /* The number of blocks allocated and not yet freed. */
+    size_t xMaximumEverBlocksInUse;    /* The largest number of blocks there have been in use at once since the system booted. */
+    size_t xNumberOfFailedAllocations; /* The number of calls to pvPortPoolMalloc() that found every block of the class in use. */
+} PoolStats_t;
+
 /*
  * Used to define multiple heap regions for use by heap_5.c.  This function
  * must be called before any calls to pvPortMalloc() - not creating a task,
@@ -188,6 +226,43 @@ size_t xPortGetMinimumEverFreeHeapSize( void ) PRIVILEGED_FUNCTION;
     #define vPortFreeStack       vPortFree
 #endif
 
+#if ( configUSE_POOL_ALLOCATOR == 1 )
+
+/*
+ * Allocate a block of the smallest class listed by configPOOL_CLASSES() that
+ * holds xSize bytes, or return NULL if there is no such class or all of its
+ * blocks are in use.  A larger class is never used instead, so that the
+ * blocks of each class can be budgeted.  Takes constant time and may be
+ * called from tasks and from interrupts at or below
+ * configMAX_SYSCALL_INTERRUPT_PRIORITY, as may vPortPoolFree().
+ */
+    void * pvPortPoolMalloc( size_t xSize ) PRIVILEGED_FUNCTION;
+    void vPortPoolFree( void * pv ) PRIVILEGED_FUNCTION;
+
+/*
+ * Fills pxPoolStats with the state of each class, smallest first, and
+ * returns the number of classes written, at most uxArraySize.
+ */
+    UBaseType_t uxPortGetPoolStats( PoolStats_t * pxPoolStats,
+                                    UBaseType_t uxArraySize ) PRIVILEGED_FUNCTION;
+#endif
+
+#if ( configTCB_FROM_POOL == 1 )
+    #define pvPortMallocTCB    pvPortPoolMalloc
+    #define vPortFreeTCB       vPortPoolFree
+#else
+    #define pvPortMallocTCB    pvPortMalloc
+    #define vPortFreeTCB       vPortFree
+#endif
+
+#if ( configQUEUE_FROM_POOL == 1 )
+    #define pvPortMallocQueue    pvPortPoolMalloc
+    #define vPortFreeQueue       vPortPoolFree
+#else
+    #define pvPortMallocQueue    pvPortMalloc
+    #define vPortFreeQueue       vPortFree
+#endif
+
 #if ( configUSE_MALLOC_FAILED_HOOK == 1 )
 
 /**
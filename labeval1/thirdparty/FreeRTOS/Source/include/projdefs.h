@@ -42,6 +42,13 @@ typedef void (* TaskFunction_t)( void * );
     #define pdMS_TO_TICKS( xTimeInMs )    ( ( TickType_t ) ( ( ( TickType_t ) ( xTimeInMs ) * ( TickType_t ) configTICK_RATE_HZ ) / ( TickType_t ) 1000U ) )
 #endif
 
+/* Converts a time in microseconds to a time in ticks.  The result is rounded
+ * up, so a timeout is never shorter than the time asked for.  This macro can be
+ * overridden by a macro of the same name defined in FreeRTOSConfig.h. */
+#ifndef pdUS_TO_TICKS
+    #define pdUS_TO_TICKS( xTimeInUs )    ( ( TickType_t ) ( ( ( ( uint64_t ) ( xTimeInUs ) * ( uint64_t ) configTICK_RATE_HZ ) + 999999U ) / ( uint64_t ) 1000000U ) )
+#endif
+
 #define pdFALSE                                  ( ( BaseType_t ) 0 )
 #define pdTRUE                                   ( ( BaseType_t ) 1 )
 
@@ -54,6 +61,7 @@ typedef void (* TaskFunction_t)( void * );
 #define errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY    ( -1 )
 #define errQUEUE_BLOCKED                         ( -4 )
 #define errQUEUE_YIELD                           ( -5 )
+#define errTASK_NOT_SCHEDULABLE                  ( -6 )
 
 /* Macros used for basic data corruption checks. */
 #ifndef configUSE_LIST_DATA_INTEGRITY_CHECK_BYTES
@@ -33,8 +33,9 @@
 #ifndef INC_FREERTOS_H
     #error "include FreeRTOS.h must appear in source files before include task.h"
 #endif
-
+#include "FreeRTOS.h"   /* Base include for FreeRTOS */
 #include "list.h"
+#include "portmacro.h"  /* For TickType_t, StackType_t, etc. */
 
 /* *INDENT-OFF* */
 #ifdef __cplusplus
@@ -86,6 +87,19 @@
 struct tskTaskControlBlock; /* The old naming convention is used to prevent breaking kernel aware debuggers. */
 typedef struct tskTaskControlBlock * TaskHandle_t;
 
+/**
+ * task. h
+ *
+ * Type by which resources shared under the Stack Resource Policy are
+ * referenced.  For example, a call to xTaskCreateSRPResource() returns (via a
+ * pointer parameter) an SRPResourceHandle_t variable that can then be used as
+ * a parameter to vTaskSRPLock() to lock the resource.
+ *
+ * \ingroup Tasks
+ */
+struct tskSRPResource;
+typedef struct tskSRPResource * SRPResourceHandle_t;
+
 /*
  * Defines the prototype to which the application task hook function must
  * conform.
@@ -168,6 +182,57 @@ typedef struct xTASK_STATUS
     configSTACK_DEPTH_TYPE usStackHighWaterMark;  /* The minimum amount of stack space that has remained for the task since the task was created.  The closer this value is to zero the closer the task has come to overflowing its stack. */
 } TaskStatus_t;
 
+/* Used with the vTaskGetDeadlineStats() function to return the deadline
+ * statistics of a periodic task. */
+typedef struct xTASK_DEADLINE_STATS
+{
+    uint32_t ulJobsCompleted;                                        /* The number of jobs that have called xTaskWaitForNextPeriod(). */
+    uint32_t ulDeadlinesMissed;                                      /* The number of jobs that were still running, or had not yet completed, after their deadline. */
+    DeadlineTime_t xMaxTardiness;                                    /* The largest amount of time by which a completed job missed its deadline. */
+    uint32_t ulTardinessHistogram[ configTARDINESS_HISTOGRAM_BUCKETS ]; /* Late jobs by tardiness.  Bucket n counts tardiness from 2^n to 2^(n+1) - 1 units of DeadlineTime_t, the last bucket also counts anything later. */
+} TaskDeadlineStats_t;
+
+/* The job statistics of a periodic task, part of TaskRunStats_t. */
+typedef struct xTASK_JOB_STATS
+{
+    uint32_t ulJobs;                 /* The number of jobs that have called xTaskWaitForNextPeriod(). */
+    DeadlineTime_t xMinResponseTime; /* The shortest time from the release of a job to its completion. */
+    DeadlineTime_t xMaxResponseTime; /* The longest time from the release of a job to its completion. */
+    uint64_t ullTotalResponseTime;   /* The sum of the response times.  The average is ullTotalResponseTime / ulJobs. */
+    DeadlineTime_t xMinStartLatency; /* The shortest time from the release of a job until it first ran. */
+    DeadlineTime_t xMaxStartLatency; /* The longest time from the release of a job until it first ran.  The release jitter of the task is xMaxStartLatency - xMinStartLatency. */
+} TaskJobStats_t;
+
+/* Used with the uxTaskGetRunStats() function to return the run time of each
+ * task in the system. */
+typedef struct xTASK_RUN_STATS
+{
+    TaskHandle_t xHandle;                         /* The handle of the task to which the rest of the information in the structure relates. */
+    configRUN_TIME_COUNTER_TYPE ulRunTimeCounter; /* The time the task has spent in the Running state, including the current run of the calling task. */
+    #if ( configUSE_JOB_STATS == 1 )
+        TaskJobStats_t xJobStats;                 /* All zero for a task that is not periodic. */
+    #endif
+} TaskRunStats_t;
+
+/* A slot of the schedule table passed to xTaskStartTimeTriggered(). */
+typedef struct xTIME_TRIGGERED_ENTRY
+{
+    DeadlineTime_t xOffset; /* The start of the slot, relative to the start of the major frame. */
+    UBaseType_t uxTask;     /* The index of the task in the array of tasks passed to xTaskStartTimeTriggered(). */
+    DeadlineTime_t xBudget; /* The length of the slot.  The task overruns if its job has not completed by the end of the slot. */
+} TimeTriggeredEntry_t;
+
+/* Used with the vTaskGetTimeTriggeredStats() function to return the
+ * statistics of the time triggered dispatcher. */
+typedef struct xTIME_TRIGGERED_STATS
+{
+    uint32_t ulFrames;          /* The number of major frames completed. */
+    uint32_t ulOverruns;        /* The number of slots that ended before their job completed. */
+    uint32_t ulNotReady;        /* The number of slots whose task had not completed the job of its previous slot. */
+    DeadlineTime_t xMinLatency; /* The shortest time from the start of a slot until it was dispatched. */
+    DeadlineTime_t xMaxLatency; /* The longest time from the start of a slot until it was dispatched.  The dispatch jitter is xMaxLatency - xMinLatency. */
+} TimeTriggeredStats_t;
+
 /* Possible return values for eTaskConfirmSleepModeStatus(). */
 typedef enum
 {
@@ -185,6 +250,31 @@ typedef enum
  */
 #define tskIDLE_PRIORITY    ( ( UBaseType_t ) 0U )
 
+/**
+ * The utilisation of a fully loaded processor, as returned by
+ * ulTaskGetUtilisation().  Utilisation is expressed in parts per million.
+ *
+ * \ingroup TaskUtils
+ */
+#define tskUTILISATION_FULL    ( ( uint32_t ) 1000000UL )
+
+/**
+ * task. h
+ *
+ * Convert a time to the unit of DeadlineTime_t, which is used for deadlines,
+ * periods and execution times.  The unit is the tick, or the microsecond when
+ * configUSE_EDF_MICROSECOND_TIME is set to 1.
+ *
+ * \ingroup TaskUtils
+ */
+#if ( configUSE_EDF_MICROSECOND_TIME == 1 )
+    #define tskMS_TO_DEADLINE_TIME( xTimeInMs )    ( ( DeadlineTime_t ) ( xTimeInMs ) * ( DeadlineTime_t ) 1000U )
+    #define tskUS_TO_DEADLINE_TIME( xTimeInUs )    ( ( DeadlineTime_t ) ( xTimeInUs ) )
+#else
+    #define tskMS_TO_DEADLINE_TIME( xTimeInMs )    ( ( DeadlineTime_t ) pdMS_TO_TICKS( xTimeInMs ) )
+    #define tskUS_TO_DEADLINE_TIME( xTimeInUs )    ( ( DeadlineTime_t ) pdUS_TO_TICKS( xTimeInUs ) )
+#endif
+
 /**
  * task. h
  *
@@ -360,6 +450,180 @@ typedef enum
                             TaskHandle_t * const pxCreatedTask ) PRIVILEGED_FUNCTION;
 #endif
 
+/**
+ * task. h
+ * @code{c}
+ * BaseType_t xTaskCreatePeriodic(
+ *                            TaskFunction_t pxTaskCode,
+ *                            const char *pcName,
+ *                            configSTACK_DEPTH_TYPE usStackDepth,
+ *                            void *pvParameters,
+ *                            UBaseType_t uxPriority,
+ *                            DeadlineTime_t xPeriod,
+ *                            DeadlineTime_t xRelativeDeadline,
+ *                            DeadlineTime_t xWCET,
+ *                            TaskHandle_t *pxCreatedTask
+ *                        );
+ * @endcode
+ *
+ * configSCHEDULING_POLICY must be set to SCHEDULING_POLICY_EDF or
+ * SCHEDULING_POLICY_HYBRID, and configSUPPORT_DYNAMIC_ALLOCATION must be
+ * defined as 1, for this function to be available.
+ *
+ * Create a periodic task and add it to the list of tasks that are ready to
+ * run.  The first job of the task is released immediately.  Each job ends
+ * with a call to xTaskWaitForNextPeriod(), which blocks the task until its
+ * next release.  Releases happen exactly xPeriod apart, and the absolute
+ * deadline of the task is recomputed from each release, so the task is always
+ * scheduled by the deadline of its current job.
+ *
+ * Times are in ticks, or in microseconds when configUSE_EDF_MICROSECOND_TIME
+ * is set to 1.  tskMS_TO_DEADLINE_TIME() and tskUS_TO_DEADLINE_TIME() convert
+ * to the configured unit.  With microsecond time jobs are still released by
+ * the tick interrupt, never before their release time but up to two ticks
+ * after it, as the phase of the tick is not known.  The deadline keeps the
+ * full resolution.
+ *
+ * The parameters are as for xTaskCreate(), with the addition of:
+ *
+ * @param xPeriod The time between two releases of the task.
+ *
+ * @param xRelativeDeadline The time after its release by which each job must
+ * complete.
+ *
+ * @param xWCET The worst case execution time of a job.  When
+ * configUSE_EDF_ADMISSION_CONTROL is 1 the task is only created if it, together
+ * with the tasks already admitted, passes the EDF schedulability test.  A set
+ * that would have to be checked over more than
+ * configEDF_DEMAND_TEST_MAX_INTERVAL_MS fails the test.  Passing 0 creates the
+ * task without testing it, and the task is then not counted in the system
+ * utilisation.
+ *
+ * @return pdPASS if the task was successfully created and added to a ready
+ * list, errTASK_NOT_SCHEDULABLE if the task failed the admission test,
+ * otherwise an error code defined in the file projdefs.h
+ *
+ * Example usage:
+ * @code{c}
+ * // Task released every 100ms that runs for up to 5ms and must finish
+ * // within 20ms.
+ * void vTaskCode( void * pvParameters )
+ * {
+ *   for( ;; )
+ *   {
+ *       // Job code goes here.
+ *
+ *       xTaskWaitForNextPeriod();
+ *   }
+ * }
+ *
+ * void vOtherFunction( void )
+ * {
+ *   if( xTaskCreatePeriodic( vTaskCode, "NAME", STACK_SIZE, NULL, tskIDLE_PRIORITY,
+ *                            tskMS_TO_DEADLINE_TIME( 100 ), tskMS_TO_DEADLINE_TIME( 20 ),
+ *                            tskMS_TO_DEADLINE_TIME( 5 ), NULL ) == errTASK_NOT_SCHEDULABLE )
+ *   {
+ *       // The system would be overloaded by the new task.
+ *   }
+ * }
+ * @endcode
+ * \defgroup xTaskCreatePeriodic xTaskCreatePeriodic
+ * \ingroup Tasks
+ */
+#if ( ( configUSE_EDF_SCHEDULER == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) )
+    BaseType_t xTaskCreatePeriodic( TaskFunction_t pxTaskCode,
+                                    const char * const pcName, /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+                                    const configSTACK_DEPTH_TYPE usStackDepth,
+                                    void * const pvParameters,
+                                    UBaseType_t uxPriority,
+                                    const DeadlineTime_t xPeriod,
+                                    const DeadlineTime_t xRelativeDeadline,
+                                    const DeadlineTime_t xWCET,
+                                    TaskHandle_t * const pxCreatedTask ) PRIVILEGED_FUNCTION;
+#endif
+
+/**
+ * task. h
+ * @code{c}
+ * BaseType_t xTaskCreateServed(
+ *                            TaskFunction_t pxTaskCode,
+ *                            const char *pcName,
+ *                            configSTACK_DEPTH_TYPE usStackDepth,
+ *                            void *pvParameters,
+ *                            UBaseType_t uxPriority,
+ *                            DeadlineTime_t xBudget,
+ *                            DeadlineTime_t xServerPeriod,
+ *                            TaskHandle_t *pxCreatedTask
+ *                        );
+ * @endcode
+ *
+ * configUSE_CBS and configSUPPORT_DYNAMIC_ALLOCATION must be defined as 1 for
+ * this function to be available.
+ *
+ * Create an aperiodic task that runs in its own Constant Bandwidth Server.
+ * The task is written as an ordinary event driven task that blocks on a
+ * queue, semaphore or notification, and does not call
+ * xTaskWaitForNextPeriod().
+ *
+ * The kernel schedules the task by the deadline of its server.  The server
+ * may run the task for xBudget in every xServerPeriod.  Each time the budget
+ * is used up the budget is refilled and the server deadline is postponed by
+ * xServerPeriod, so a task that runs for longer than it declared only delays
+ * itself.  When the task becomes ready again after blocking it keeps its
+ * current budget and deadline if they can be used without exceeding the
+ * server bandwidth, otherwise it is given a full budget and a deadline one
+ * server period away.  An aperiodic task therefore can never take more than
+ * xBudget / xServerPeriod of the processor away from the periodic tasks.
+ *
+ * Budget is charged at every context switch and checked at every tick, so a
+ * server can overrun its budget by up to one tick before it is postponed.
+ *
+ * Times are in the same unit as for xTaskCreatePeriodic().
+ *
+ * The parameters are as for xTaskCreate(), with the addition of:
+ *
+ * @param xBudget The execution time the server may use in each period.
+ *
+ * @param xServerPeriod The server period.  It is also the relative deadline
+ * of the server, and its preemption level under SRP.
+ *
+ * @return pdPASS if the task was successfully created and added to a ready
+ * list, errTASK_NOT_SCHEDULABLE if the bandwidth of the server failed the
+ * admission test, otherwise an error code defined in the file projdefs.h
+ *
+ * Example usage:
+ * @code{c}
+ * // Command handler that may use up to 2ms in every 20ms.
+ * void vHandlerCode( void * pvParameters )
+ * {
+ *   for( ;; )
+ *   {
+ *       ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+ *
+ *       // Handle the event.
+ *   }
+ * }
+ *
+ * void vOtherFunction( void )
+ * {
+ *   xTaskCreateServed( vHandlerCode, "NAME", STACK_SIZE, NULL, tskIDLE_PRIORITY,
+ *                      tskMS_TO_DEADLINE_TIME( 2 ), tskMS_TO_DEADLINE_TIME( 20 ), NULL );
+ * }
+ * @endcode
+ * \defgroup xTaskCreateServed xTaskCreateServed
+ * \ingroup Tasks
+ */
+#if ( ( configUSE_CBS == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) )
+    BaseType_t xTaskCreateServed( TaskFunction_t pxTaskCode,
+                                  const char * const pcName, /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+                                  const configSTACK_DEPTH_TYPE usStackDepth,
+                                  void * const pvParameters,
+                                  UBaseType_t uxPriority,
+                                  const DeadlineTime_t xBudget,
+                                  const DeadlineTime_t xServerPeriod,
+                                  TaskHandle_t * const pxCreatedTask ) PRIVILEGED_FUNCTION;
+#endif
+
 /**
  * task. h
  * @code{c}
@@ -861,6 +1125,353 @@ void vTaskDelay( const TickType_t xTicksToDelay ) PRIVILEGED_FUNCTION;
 BaseType_t xTaskDelayUntil( TickType_t * const pxPreviousWakeTime,
                             const TickType_t xTimeIncrement ) PRIVILEGED_FUNCTION;
 
+/**
+ * task. h
+ * @code{c}
+ * BaseType_t xTaskWaitForNextPeriod( void );
+ * @endcode
+ *
+ * configSCHEDULING_POLICY must be set to SCHEDULING_POLICY_EDF or
+ * SCHEDULING_POLICY_HYBRID for this function to be available.
+ *
+ * Called by a task created with xTaskCreatePeriodic() to complete its current
+ * job.  The task's next release is one period after its previous release, and
+ * its deadline is moved to that release plus the task's relative deadline.
+ * The task then blocks until the release.
+ *
+ * @return pdTRUE if the task was delayed until its next release.  pdFALSE if
+ * the next release was already in the past, in which case the next job is
+ * started immediately.
+ *
+ * \defgroup xTaskWaitForNextPeriod xTaskWaitForNextPeriod
+ * \ingroup TaskCtrl
+ */
+BaseType_t xTaskWaitForNextPeriod( void ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * @code{c}
+ * BaseType_t xTaskDeclareTiming( TaskHandle_t xTask, DeadlineTime_t xWCET, DeadlineTime_t xPeriod, DeadlineTime_t xRelativeDeadline );
+ * @endcode
+ *
+ * configSCHEDULING_POLICY must be set to SCHEDULING_POLICY_EDF or
+ * SCHEDULING_POLICY_HYBRID for this function to be available.
+ *
+ * Give a task created with xTaskCreate() the timing of a periodic task, as if
+ * it had been created with xTaskCreatePeriodic().  The current job of the task
+ * is taken to be released at the time of the call.  A task can be declared
+ * again to change its timing.
+ *
+ * @param xTask Handle of the task.  Passing a NULL handle declares the timing
+ * of the calling task.
+ *
+ * @param xWCET The worst case execution time of a job.  When
+ * configUSE_EDF_ADMISSION_CONTROL is 1 and xWCET is not 0 the new timing is
+ * only applied if it passes the EDF schedulability test.
+ *
+ * @param xPeriod The time between two releases of the task.
+ *
+ * @param xRelativeDeadline The time after its release by which each job must
+ * complete.
+ *
+ * @return pdPASS if the timing was applied, or errTASK_NOT_SCHEDULABLE if the
+ * task failed the admission test, in which case its timing is unchanged.
+ *
+ * \defgroup xTaskDeclareTiming xTaskDeclareTiming
+ * \ingroup TaskCtrl
+ */
+BaseType_t xTaskDeclareTiming( TaskHandle_t xTask,
+                               const DeadlineTime_t xWCET,
+                               const DeadlineTime_t xPeriod,
+                               const DeadlineTime_t xRelativeDeadline ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * @code{c}
+ * DeadlineTime_t xTaskGetDeadlineTime( void );
+ * @endcode
+ *
+ * configSCHEDULING_POLICY must be set to SCHEDULING_POLICY_EDF or
+ * SCHEDULING_POLICY_HYBRID for this function to be available.
+ *
+ * @return The current time in the unit of DeadlineTime_t, for computing
+ * absolute deadlines to pass to vTaskSetDeadline().  This is the tick count,
+ * or the microsecond time base when configUSE_EDF_MICROSECOND_TIME is 1.
+ *
+ * \defgroup xTaskGetDeadlineTime xTaskGetDeadlineTime
+ * \ingroup TaskUtils
+ */
+DeadlineTime_t xTaskGetDeadlineTime( void ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * @code{c}
+ * uint32_t ulTaskGetUtilisation( void );
+ * @endcode
+ *
+ * configUSE_EDF_ADMISSION_CONTROL must be defined as 1 for this function to
+ * be available.
+ *
+ * @return The sum of WCET / period over all admitted tasks, in parts per
+ * million.  tskUTILISATION_FULL is a fully loaded processor.  Each task's
+ * share is rounded up.
+ *
+ * \defgroup ulTaskGetUtilisation ulTaskGetUtilisation
+ * \ingroup TaskUtils
+ */
+uint32_t ulTaskGetUtilisation( void ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * @code{c}
+ * void vTaskGetDeadlineStats( TaskHandle_t xTask, TaskDeadlineStats_t *pxStats );
+ * @endcode
+ *
+ * configUSE_DEADLINE_MISS_DETECTION must be defined as 1 for this function to
+ * be available.
+ *
+ * A deadline miss is detected when a job of a periodic task completes after
+ * its deadline, or when the task is switched out while its current job is
+ * already past its deadline, whichever happens first.  Each late job is
+ * counted once.  Its tardiness, the time between its deadline and its
+ * completion, is added to the histogram when the job completes.
+ *
+ * @param xTask Handle of the task to query.  Passing a NULL handle queries the
+ * calling task.
+ *
+ * @param pxStats Receives a consistent copy of the task's statistics.
+ *
+ * \defgroup vTaskGetDeadlineStats vTaskGetDeadlineStats
+ * \ingroup TaskUtils
+ */
+void vTaskGetDeadlineStats( TaskHandle_t xTask,
+                            TaskDeadlineStats_t * pxStats ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * @code{c}
+ * void vTaskResetDeadlineStats( TaskHandle_t xTask );
+ * @endcode
+ *
+ * configUSE_DEADLINE_MISS_DETECTION must be defined as 1 for this function to
+ * be available.
+ *
+ * Clear the deadline statistics of a task.  Passing a NULL handle clears the
+ * statistics of the calling task.
+ *
+ * \defgroup vTaskResetDeadlineStats vTaskResetDeadlineStats
+ * \ingroup TaskUtils
+ */
+void vTaskResetDeadlineStats( TaskHandle_t xTask ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * @code{c}
+ * SRPResourceHandle_t xTaskCreateSRPResource( void );
+ * @endcode
+ *
+ * configUSE_SRP and configSUPPORT_DYNAMIC_ALLOCATION must be defined as 1 for
+ * this function to be available.
+ *
+ * Create a resource that is shared under Baker's Stack Resource Policy.  Each
+ * task has a static preemption level derived from its relative deadline, a
+ * shorter relative deadline giving a higher level.  Each resource has a
+ * ceiling, the highest preemption level of the tasks that use it, and while
+ * resources are locked the system ceiling is the highest ceiling of the locked
+ * resources.  A task only starts to run once it has the earliest deadline and
+ * a preemption level above the system ceiling.  Every resource a task can lock
+ * is then already free, so a task never blocks on a resource, and is blocked
+ * at most once, before it starts, for the length of one critical section.
+ *
+ * The ceiling only applies within the priority band of the task that locked
+ * the resource.  Tasks that share a resource should therefore have the same
+ * priority.
+ *
+ * @return A handle to the resource, or NULL if there was not enough heap to
+ * create it.
+ *
+ * Example usage:
+ * @code{c}
+ * SRPResourceHandle_t xResource;
+ *
+ * void vSetup( TaskHandle_t xTask1, TaskHandle_t xTask2 )
+ * {
+ *   xResource = xTaskCreateSRPResource();
+ *   vTaskAddSRPResourceUser( xResource, xTask1 );
+ *   vTaskAddSRPResourceUser( xResource, xTask2 );
+ * }
+ *
+ * void vJob( void )
+ * {
+ *   vTaskSRPLock( xResource );
+ *   // Access the resource.  Must not block.
+ *   vTaskSRPUnlock( xResource );
+ * }
+ * @endcode
+ * \defgroup xTaskCreateSRPResource xTaskCreateSRPResource
+ * \ingroup Tasks
+ */
+SRPResourceHandle_t xTaskCreateSRPResource( void ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * @code{c}
+ * void vTaskAddSRPResourceUser( SRPResourceHandle_t xResource, TaskHandle_t xTask );
+ * @endcode
+ *
+ * configUSE_SRP must be defined as 1 for this function to be available.
+ *
+ * Declare that a task locks a resource, raising the ceiling of the resource to
+ * the preemption level of the task if that is higher.  Every task that locks
+ * the resource must be declared, after its timing has been set and before the
+ * resource is first locked.  Tasks without a relative deadline have the lowest
+ * preemption level and do not change the ceiling.
+ *
+ * @param xResource The resource.
+ *
+ * @param xTask Handle of the task.  Passing a NULL handle declares the
+ * calling task.
+ *
+ * \defgroup vTaskAddSRPResourceUser vTaskAddSRPResourceUser
+ * \ingroup Tasks
+ */
+void vTaskAddSRPResourceUser( SRPResourceHandle_t xResource,
+                              TaskHandle_t xTask ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * @code{c}
+ * void vTaskSRPLock( SRPResourceHandle_t xResource );
+ * void vTaskSRPUnlock( SRPResourceHandle_t xResource );
+ * @endcode
+ *
+ * configUSE_SRP must be defined as 1 for these functions to be available.
+ *
+ * Lock and unlock a resource, raising the system ceiling to the ceiling of the
+ * resource and restoring it again.  Locking never blocks.  Resources must be
+ * unlocked in the reverse order to which they were locked, and a task must not
+ * block while it has a resource locked.  Unlocking causes a context switch if
+ * a task that the ceiling held back now has an earlier deadline than the
+ * calling task.
+ *
+ * @param xResource The resource.
+ *
+ * \defgroup vTaskSRPLock vTaskSRPLock
+ * \ingroup Tasks
+ */
+void vTaskSRPLock( SRPResourceHandle_t xResource ) PRIVILEGED_FUNCTION;
+void vTaskSRPUnlock( SRPResourceHandle_t xResource ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * @code{c}
+ * BaseType_t xTaskStartTimeTriggered( const TimeTriggeredEntry_t * pxTable, UBaseType_t uxEntries, TaskHandle_t const * pxTasks, UBaseType_t uxTasks, DeadlineTime_t xMajorFrame, DeadlineTime_t xStartTime );
+ * @endcode
+ *
+ * configUSE_TIME_TRIGGERED must be defined as 1 for this function to be
+ * available.
+ *
+ * Start dispatching tasks from a static schedule table.  The table lists the
+ * slots of one major frame, which repeats from xStartTime for as long as the
+ * scheduler runs.  Every task named by the table is suspended until its slot
+ * starts, and is then run in preference to every other task without searching
+ * the ready lists.  The task calls vTaskWaitForNextSlot() when its job is
+ * complete; if the slot ends first the job is counted as an overrun and
+ * continues at the task's own priority outside the slot.
+ *
+ * The dispatcher is driven by calling xTaskTimeTriggeredDispatchFromISR() at
+ * the time it returns, from the tick hook or from a timer compare interrupt.
+ * Time triggered tasks should be created with a fixed priority, not one in an
+ * EDF band, and must not block inside a job.  Must be called before the
+ * scheduler is started, and only once.
+ *
+ * @param pxTable The slots, ordered by offset.  Slots must not overlap and
+ * must end within the major frame.  The table is used in place and must
+ * remain valid.
+ *
+ * @param uxEntries The number of slots in the table.
+ *
+ * @param pxTasks The tasks named by the table, indexed by the uxTask member
+ * of each slot.
+ *
+ * @param uxTasks The number of tasks in pxTasks.
+ *
+ * @param xMajorFrame The length of the major frame.
+ *
+ * @param xStartTime The time, in the units of DeadlineTime_t, at which the
+ * first major frame starts.
+ *
+ * @return pdPASS if the table was accepted, otherwise pdFAIL.
+ *
+ * \defgroup xTaskStartTimeTriggered xTaskStartTimeTriggered
+ * \ingroup TaskCtrl
+ */
+BaseType_t xTaskStartTimeTriggered( const TimeTriggeredEntry_t * pxTable,
+                                    UBaseType_t uxEntries,
+                                    TaskHandle_t const * pxTasks,
+                                    UBaseType_t uxTasks,
+                                    DeadlineTime_t xMajorFrame,
+                                    DeadlineTime_t xStartTime ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * @code{c}
+ * DeadlineTime_t xTaskTimeTriggeredDispatchFromISR( BaseType_t * pxHigherPriorityTaskWoken );
+ * @endcode
+ *
+ * configUSE_TIME_TRIGGERED must be defined as 1 for this function to be
+ * available.
+ *
+ * Start and end every slot of the schedule table that is due.  Must be called
+ * from an interrupt whose priority is at or below
+ * configMAX_SYSCALL_INTERRUPT_PRIORITY.
+ *
+ * @param pxHigherPriorityTaskWoken Set to pdTRUE if a slot started or ended,
+ * in which case a context switch should be requested before the interrupt
+ * exits.
+ *
+ * @return The time at which the dispatcher must be called next.
+ *
+ * \defgroup xTaskTimeTriggeredDispatchFromISR xTaskTimeTriggeredDispatchFromISR
+ * \ingroup TaskCtrl
+ */
+DeadlineTime_t xTaskTimeTriggeredDispatchFromISR( BaseType_t * pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * @code{c}
+ * void vTaskWaitForNextSlot( void );
+ * @endcode
+ *
+ * configUSE_TIME_TRIGGERED must be defined as 1 for this function to be
+ * available.
+ *
+ * Called by a time triggered task to complete its current job.  The task is
+ * suspended until its next slot starts.
+ *
+ * \defgroup vTaskWaitForNextSlot vTaskWaitForNextSlot
+ * \ingroup TaskCtrl
+ */
+void vTaskWaitForNextSlot( void ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * @code{c}
+ * void vTaskGetTimeTriggeredStats( TimeTriggeredStats_t * pxStats );
+ * @endcode
+ *
+ * configUSE_TIME_TRIGGERED must be defined as 1 for this function to be
+ * available.
+ *
+ * Get the statistics of the time triggered dispatcher.
+ *
+ * @param pxStats The structure to fill.
+ *
+ * \defgroup vTaskGetTimeTriggeredStats vTaskGetTimeTriggeredStats
+ * \ingroup TaskCtrl
+ */
+void vTaskGetTimeTriggeredStats( TimeTriggeredStats_t * pxStats ) PRIVILEGED_FUNCTION;
+
 /*
  * vTaskDelayUntil() is the older version of xTaskDelayUntil() and does not
  * return a value.
@@ -1043,6 +1654,35 @@ void vTaskGetInfo( TaskHandle_t xTask,
                    BaseType_t xGetFreeStackSpace,
                    eTaskState eState ) PRIVILEGED_FUNCTION;
 
+/**
+ * task. h
+ * @code{c}
+ * void vTaskSetDeadline( TaskHandle_t xTask, DeadlineTime_t xDeadline );
+ * @endcode
+ *
+ * configSCHEDULING_POLICY must be set to SCHEDULING_POLICY_EDF or
+ * SCHEDULING_POLICY_HYBRID for this function to be available.
+ *
+ * Set the absolute deadline of any task.  Tasks that share a priority are
+ * scheduled earliest deadline first.  If the task is in the Ready state it is
+ * moved to keep its ready list in deadline order, and a context switch will
+ * occur before the function returns if it now has an earlier deadline than the
+ * calling task.
+ *
+ * @param xTask Handle to the task whose deadline is being set.  Passing a NULL
+ * handle results in the deadline of the calling task being set.
+ *
+ * @param xDeadline The time by which the task must complete, as returned by
+ * xTaskGetDeadlineTime().  Deadlines are compared by their difference, so the
+ * order stays correct when the time wraps as long as no two deadlines are
+ * more than half the range of DeadlineTime_t apart.
+ *
+ * \defgroup vTaskSetDeadline vTaskSetDeadline
+ * \ingroup TaskCtrl
+ */
+void vTaskSetDeadline( TaskHandle_t xTask,
+                       DeadlineTime_t xDeadline ) PRIVILEGED_FUNCTION;
+
 /**
  * task. h
  * @code{c}
@@ -1442,6 +2082,22 @@ BaseType_t xTaskResumeAll( void ) PRIVILEGED_FUNCTION;
  */
 TickType_t xTaskGetTickCount( void ) PRIVILEGED_FUNCTION;
 
+/**
+ * task. h
+ * @code{c}
+ * DeadlineTime_t getTaskDeadline( TaskHandle_t xTask );
+ * @endcode
+ *
+ * configSCHEDULING_POLICY must be set to SCHEDULING_POLICY_EDF or
+ * SCHEDULING_POLICY_HYBRID for this function to be available.
+ *
+ * @param xTask Handle of the task to query.  Passing a NULL handle queries the
+ * calling task.
+ *
+ * @return The absolute deadline last set by vTaskSetDeadline().
+ */
+DeadlineTime_t getTaskDeadline( TaskHandle_t xTask ) PRIVILEGED_FUNCTION;
+
 /**
  * task. h
  * @code{c}
@@ -1649,6 +2305,28 @@ configSTACK_DEPTH_TYPE uxTaskGetStackHighWaterMark2( TaskHandle_t xTask ) PRIVIL
 
 #endif
 
+#if ( configUSE_DEADLINE_MISS_HOOK == 1 )
+
+/**
+ * task.h
+ * @code{c}
+ * void vApplicationDeadlineMissHook( TaskHandle_t xTask, DeadlineTime_t xTardiness );
+ * @endcode
+ *
+ * Called once for each job of a periodic task that misses its deadline, as
+ * soon as the miss is detected.  It is called either from the context switch
+ * or from xTaskWaitForNextPeriod() with the scheduler suspended, so it must be
+ * short and must not call any API function that might block.
+ *
+ * @param xTask The task that missed its deadline.
+ * @param xTardiness The time by which the deadline had passed when the miss
+ * was detected.
+ */
+    void vApplicationDeadlineMissHook( TaskHandle_t xTask,
+                                       DeadlineTime_t xTardiness );
+
+#endif
+
 #if  ( configUSE_TICK_HOOK > 0 )
 
 /**
@@ -1809,6 +2487,57 @@ UBaseType_t uxTaskGetSystemState( TaskStatus_t * const pxTaskStatusArray,
                                   const UBaseType_t uxArraySize,
                                   configRUN_TIME_COUNTER_TYPE * const pulTotalRunTime ) PRIVILEGED_FUNCTION;
 
+/**
+ * task. h
+ * @code{c}
+ * UBaseType_t uxTaskGetRunStats( TaskRunStats_t * const pxRunStatsArray, const UBaseType_t uxArraySize, configRUN_TIME_COUNTER_TYPE * const pulTotalRunTime, configRUN_TIME_COUNTER_TYPE * const pulIdleRunTime );
+ * @endcode
+ *
+ * configGENERATE_RUN_TIME_STATS must be defined as 1 for this function to be
+ * available.  The job statistics are only included when configUSE_JOB_STATS
+ * is also defined as 1.
+ *
+ * Take a consistent snapshot of the run time, and the job statistics, of
+ * every task.  Unlike vTaskGetRunTimeStats() nothing is formatted and no
+ * division is done, so the snapshot is cheap enough to be taken periodically
+ * and streamed.  The CPU share of a task is its ulRunTimeCounter divided by
+ * the total run time, and the idle time is the idle run time divided by the
+ * total run time.
+ *
+ * The response time of a job runs from its release to its call to
+ * xTaskWaitForNextPeriod().  Its start latency runs from its release to the
+ * first time it is switched in.
+ *
+ * @param pxRunStatsArray Receives one TaskRunStats_t structure per task.
+ *
+ * @param uxArraySize The number of structures in pxRunStatsArray.  Nothing is
+ * written if this is less than uxTaskGetNumberOfTasks().
+ *
+ * @param pulTotalRunTime Receives the run time counter value at the time of
+ * the snapshot.  Can be NULL.
+ *
+ * @param pulIdleRunTime Receives the time spent in the idle task.  Can be
+ * NULL.
+ *
+ * @return The number of structures written.
+ *
+ * Example usage:
+ * @code{c}
+ *  TaskRunStats_t xStats[ 8 ];
+ *  configRUN_TIME_COUNTER_TYPE ulTotal, ulIdle;
+ *  UBaseType_t uxTasks;
+ *
+ *  uxTasks = uxTaskGetRunStats( xStats, 8, &ulTotal, &ulIdle );
+ *  // Send uxTasks entries of xStats, ulTotal and ulIdle as they are.
+ * @endcode
+ * \defgroup uxTaskGetRunStats uxTaskGetRunStats
+ * \ingroup TaskUtils
+ */
+UBaseType_t uxTaskGetRunStats( TaskRunStats_t * const pxRunStatsArray,
+                               const UBaseType_t uxArraySize,
+                               configRUN_TIME_COUNTER_TYPE * const pulTotalRunTime,
+                               configRUN_TIME_COUNTER_TYPE * const pulIdleRunTime ) PRIVILEGED_FUNCTION;
+
 /**
  * task. h
  * @code{c}
@@ -3042,6 +3771,13 @@ BaseType_t xTaskGetSchedulerState( void ) PRIVILEGED_FUNCTION;
  */
 BaseType_t xTaskPriorityInherit( TaskHandle_t const pxMutexHolder ) PRIVILEGED_FUNCTION;
 
+/*
+ * Raises the priority of the calling task to the ceiling of a mutex it has
+ * just taken, should its priority be lower.  Must be called from a critical
+ * section.
+ */
+void vTaskPriorityRaiseToCeiling( UBaseType_t uxCeilingPriority ) PRIVILEGED_FUNCTION;
+
 /*
  * Set the priority of a task back to its proper priority in the case that it
  * inherited a higher priority while it was holding a semaphore.
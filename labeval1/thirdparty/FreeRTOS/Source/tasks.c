@@ -115,6 +115,113 @@
     #define configIDLE_TASK_NAME    "IDLE"
 #endif
 
+#if ( configUSE_EDF_SCHEDULER == 1 )
+
+    #if ( configSCHEDULING_POLICY == SCHEDULING_POLICY_EDF )
+
+/* Priorities are not used to order tasks under pure EDF.  Every task other
+ * than the idle task is placed in the top band, so the whole task set is
+ * ordered by deadline and the idle task only runs when nothing else is
+ * ready. */
+        #define taskSCHEDULING_PRIORITY( uxPriority )    ( ( ( uxPriority ) > tskIDLE_PRIORITY ) ? ( ( UBaseType_t ) configMAX_PRIORITIES - ( UBaseType_t ) 1U ) : tskIDLE_PRIORITY )
+        #define taskBAND_USES_EDF( uxPriority )          ( ( uxPriority ) != tskIDLE_PRIORITY )
+    #else
+
+/* Under the hybrid policy the bands are selected by priority, and each band
+ * set in configEDF_PRIORITY_BANDS is ordered by deadline. */
+        #define taskSCHEDULING_PRIORITY( uxPriority )    ( uxPriority )
+        #define taskBAND_USES_EDF( uxPriority )          ( ( ( ( uint32_t ) configEDF_PRIORITY_BANDS >> ( uxPriority ) ) & 1UL ) != 0UL )
+    #endif
+
+/* Each EDF band is kept sorted by absolute deadline, earliest first.  The task
+ * to run from the band is then always the head entry, so selecting it costs
+ * the same no matter how many tasks are ready.  The cost of ordering is paid
+ * once, when a task is moved into the Ready state, and not inside every
+ * context switch.  The other bands are appended to and selected in turn, as
+ * with the fixed priority scheduler, and pay nothing for the ordering. */
+    #define taskINSERT_INTO_READY_LIST( pxList, pxTCB )                       \
+    {                                                                         \
+        if( taskBAND_USES_EDF( ( pxTCB )->uxPriority ) )                      \
+        {                                                                     \
+            prvInsertIntoReadyListByDeadline( ( pxList ), ( pxTCB ) );        \
+        }                                                                     \
+        else                                                                  \
+        {                                                                     \
+            listINSERT_END( ( pxList ), &( ( pxTCB )->xStateListItem ) );     \
+        }                                                                     \
+    }
+
+    #if ( configUSE_SRP == 1 )
+
+/* Under SRP the head task of the band in which a resource is locked can be
+ * held back by the system ceiling, so the band is searched for the first task
+ * that may run. */
+        #define taskGET_OWNER_OF_EDF_ENTRY( pxTCB, pxList )    ( pxTCB ) = prvGetReadyTaskUnderSRP( pxList )
+    #else
+        #define taskGET_OWNER_OF_EDF_ENTRY( pxTCB, pxList )    ( pxTCB ) = listGET_OWNER_OF_HEAD_ENTRY( pxList )
+    #endif
+
+    #define taskGET_OWNER_OF_READY_ENTRY( pxTCB, uxPriority )                             \
+    {                                                                                     \
+        if( taskBAND_USES_EDF( uxPriority ) )                                             \
+        {                                                                                 \
+            taskGET_OWNER_OF_EDF_ENTRY( ( pxTCB ), &( pxReadyTasksLists[ uxPriority ] ) ); \
+        }                                                                                 \
+        else                                                                              \
+        {                                                                                 \
+            listGET_OWNER_OF_NEXT_ENTRY( ( pxTCB ), &( pxReadyTasksLists[ uxPriority ] ) ); \
+        }                                                                                 \
+    }
+
+/* Evaluates to true if deadline xA is earlier than deadline xB.  Comparing the
+ * difference rather than the values keeps the order correct when the time
+ * wraps, provided no two deadlines are more than half the range of
+ * DeadlineTime_t apart. */
+    #define taskDEADLINE_IS_BEFORE( xA, xB )                  ( ( DeadlineTime_t ) ( ( xA ) - ( xB ) ) > ( ( ( DeadlineTime_t ) ~( ( DeadlineTime_t ) 0U ) ) >> 1 ) )
+
+    #if ( configUSE_EDF_MICROSECOND_TIME == 1 )
+        #define taskGET_DEADLINE_TIME()                       ( ( DeadlineTime_t ) portGET_DEADLINE_TIME() )
+    #else
+        #define taskGET_DEADLINE_TIME()                       ( ( DeadlineTime_t ) xTickCount )
+    #endif
+
+/* A task that has just been made ready preempts the running task if it has a
+ * higher priority, or the same priority and an earlier deadline in an EDF
+ * band. */
+    #define taskPREEMPTS_CURRENT_TASK( pxTCB )                                                                   \
+    ( ( ( pxTCB )->uxPriority > pxCurrentTCB->uxPriority ) ||                                                  \
+      ( ( ( pxTCB )->uxPriority == pxCurrentTCB->uxPriority ) && taskBAND_USES_EDF( ( pxTCB )->uxPriority ) && \
+        taskDEADLINE_IS_BEFORE( ( pxTCB )->xDeadline, pxCurrentTCB->xDeadline ) ) )
+
+#else /* configUSE_EDF_SCHEDULER */
+
+/* Tasks of equal priority are appended to their ready list and selected in
+ * turn so they get an equal share of the processor time. */
+    #define taskSCHEDULING_PRIORITY( uxPriority )                ( uxPriority )
+    #define taskBAND_USES_EDF( uxPriority )                      pdFALSE
+
+    #define taskINSERT_INTO_READY_LIST( pxList, pxTCB )          listINSERT_END( ( pxList ), &( ( pxTCB )->xStateListItem ) )
+
+    #define taskGET_OWNER_OF_READY_ENTRY( pxTCB, uxPriority )    listGET_OWNER_OF_NEXT_ENTRY( ( pxTCB ), &( pxReadyTasksLists[ uxPriority ] ) )
+
+    #define taskPREEMPTS_CURRENT_TASK( pxTCB )                   ( ( pxTCB )->uxPriority > pxCurrentTCB->uxPriority )
+
+#endif /* configUSE_EDF_SCHEDULER */
+
+#if ( configUSE_CBS == 1 )
+
+/* A task is served if it runs in a Constant Bandwidth Server.  When such a
+ * task becomes ready after blocking, the wake up rule of its server decides
+ * its deadline before it is placed in deadline order. */
+    #define taskIS_SERVED( pxTCB )         ( ( pxTCB )->xServerBudget != ( DeadlineTime_t ) 0U )
+    #define taskSERVER_WAKE_UP( pxTCB )    prvServerWakeUp( pxTCB )
+#else
+    #define taskIS_SERVED( pxTCB )         pdFALSE
+    #define taskSERVER_WAKE_UP( pxTCB )
+#endif
+
+/*-----------------------------------------------------------*/
+
 #if ( configUSE_PORT_OPTIMISED_TASK_SELECTION == 0 )
 
 /* If configUSE_PORT_OPTIMISED_TASK_SELECTION is 0 then task selection is
@@ -144,10 +251,11 @@
             --uxTopPriority;                                                  \
         }                                                                     \
                                                                               \
-        /* listGET_OWNER_OF_NEXT_ENTRY indexes through the list, so the tasks of \
-         * the  same priority get an equal share of the processor time. */                    \
-        listGET_OWNER_OF_NEXT_ENTRY( pxCurrentTCB, &( pxReadyTasksLists[ uxTopPriority ] ) ); \
-        uxTopReadyPriority = uxTopPriority;                                                   \
+        /* taskGET_OWNER_OF_READY_ENTRY either indexes through the list, so the \
+         * tasks of the same priority get an equal share of the processor time, \
+         * or takes the head entry, which has the earliest deadline. */          \
+        taskGET_OWNER_OF_READY_ENTRY( pxCurrentTCB, uxTopPriority );            \
+        uxTopReadyPriority = uxTopPriority;                                     \
     } /* taskSELECT_HIGHEST_PRIORITY_TASK */
 
 /*-----------------------------------------------------------*/
@@ -176,7 +284,7 @@
         /* Find the highest priority list that contains ready tasks. */                         \
         portGET_HIGHEST_PRIORITY( uxTopPriority, uxTopReadyPriority );                          \
         configASSERT( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ uxTopPriority ] ) ) > 0 ); \
-        listGET_OWNER_OF_NEXT_ENTRY( pxCurrentTCB, &( pxReadyTasksLists[ uxTopPriority ] ) );   \
+        taskGET_OWNER_OF_READY_ENTRY( pxCurrentTCB, uxTopPriority );                            \
     } /* taskSELECT_HIGHEST_PRIORITY_TASK() */
 
 /*-----------------------------------------------------------*/
@@ -216,12 +324,14 @@
 
 /*
  * Place the task represented by pxTCB into the appropriate ready list for
- * the task.  It is inserted at the end of the list.
+ * the task.  It is inserted at the end of the list, or in deadline order when
+ * the EDF scheduler is used.
  */
-#define prvAddTaskToReadyList( pxTCB )                                                                 \
-    traceMOVED_TASK_TO_READY_STATE( pxTCB );                                                           \
-    taskRECORD_READY_PRIORITY( ( pxTCB )->uxPriority );                                                \
-    listINSERT_END( &( pxReadyTasksLists[ ( pxTCB )->uxPriority ] ), &( ( pxTCB )->xStateListItem ) ); \
+#define prvAddTaskToReadyList( pxTCB )                                                    \
+    traceMOVED_TASK_TO_READY_STATE( pxTCB );                                              \
+    taskSERVER_WAKE_UP( pxTCB );                                                          \
+    taskRECORD_READY_PRIORITY( ( pxTCB )->uxPriority );                                   \
+    taskINSERT_INTO_READY_LIST( &( pxReadyTasksLists[ ( pxTCB )->uxPriority ] ), pxTCB ); \
     tracePOST_MOVED_TASK_TO_READY_STATE( pxTCB )
 /*-----------------------------------------------------------*/
 
@@ -318,12 +428,52 @@ typedef struct tskTaskControlBlock       /* The old naming convention is used to
     #if ( configUSE_POSIX_ERRNO == 1 )
         int iTaskErrno;
     #endif
+
+    #if ( configUSE_EDF_SCHEDULER == 1 )
+        DeadlineTime_t xDeadline;         /*< The absolute deadline of the task.  Orders the task within the ready list of its priority. */
+        DeadlineTime_t xPeriod;           /*< The release period of a periodic task, or the period of the server of a served task, or 0 if the task is neither. */
+        DeadlineTime_t xRelativeDeadline; /*< The deadline of each job of a periodic task, relative to its release. */
+        DeadlineTime_t xReleaseTime;      /*< The time at which the current job of a periodic task was released. */
+    #endif
+
+    #if ( configUSE_EDF_ADMISSION_CONTROL == 1 )
+        DeadlineTime_t xWCET;                         /*< The declared worst case execution time of each job, or 0 if the task has not been admitted. */
+        struct tskTaskControlBlock * pxNextAdmitted; /*< Links the tasks whose load is accounted for by the admission test. */
+    #endif
+
+    #if ( configUSE_DEADLINE_MISS_DETECTION == 1 )
+        TaskDeadlineStats_t xDeadlineStats; /*< Deadline misses and tardiness of the jobs of a periodic task. */
+        uint8_t ucDeadlineMissed;           /*< Set to pdTRUE once the miss of the current job has been counted. */
+    #endif
+
+    #if ( configUSE_SRP == 1 )
+        UBaseType_t uxSRPLocksHeld; /*< The number of SRP resources the task has locked. */
+    #endif
+
+    #if ( configUSE_CBS == 1 )
+        DeadlineTime_t xServerBudget;    /*< The budget of the server the task runs in per server period, or 0 if the task is not served. */
+        DeadlineTime_t xServerRemaining; /*< The part of the budget that is left before the server deadline is postponed. */
+        uint8_t ucServerActive;          /*< Set to pdTRUE while the task is ready or running, so the wake up rule is only applied when it becomes ready. */
+    #endif
+
+    #if ( configUSE_JOB_STATS == 1 )
+        TaskJobStats_t xJobStats; /*< Response times and start latencies of the jobs of a periodic task. */
+        uint8_t ucJobStarted;     /*< Set to pdTRUE once the current job has run, so its start latency is only recorded once. */
+    #endif
 } tskTCB;
 
 /* The old tskTCB name is maintained above then typedefed to the new TCB_t name
  * below to enable the use of older kernel aware debuggers. */
 typedef tskTCB TCB_t;
 
+#if ( configTCB_FROM_POOL == 1 )
+
+/* pvPortPoolMalloc() has no fallback, so if no class of configPOOL_CLASSES()
+ * holds a TCB every task creation would fail.  Fail the build instead. */
+    #define taskTCB_FITS_CLASS( xSize, xCount )    + ( ( sizeof( TCB_t ) <= ( size_t ) ( xSize ) ) ? 1 : 0 )
+    typedef char TCBFitsPoolClass_t[ ( ( 0 configPOOL_CLASSES( taskTCB_FITS_CLASS ) ) > 0 ) ? 1 : -1 ];
+#endif
+
 /*lint -save -e956 A manual analysis and inspection has been used to determine
  * which static variables must be declared volatile. */
 portDONT_DISCARD PRIVILEGED_DATA TCB_t * volatile pxCurrentTCB = NULL;
@@ -394,6 +544,72 @@ PRIVILEGED_DATA static volatile UBaseType_t uxSchedulerSuspended = ( UBaseType_t
 
 #endif
 
+#if ( configUSE_EDF_ADMISSION_CONTROL == 1 )
+
+/* The tasks that passed the admission test, and the sum of their
+ * utilisations in parts per million.  Both are only accessed with the
+ * scheduler suspended or from a critical section. */
+    PRIVILEGED_DATA static TCB_t * pxAdmittedTasks = NULL;
+    PRIVILEGED_DATA static uint32_t ulAdmittedUtilisation = 0UL;
+
+#endif
+
+#if ( configUSE_SRP == 1 )
+
+/* The ceiling of an SRP resource, and the system ceiling, are held as the
+ * shortest relative deadline of the tasks concerned.  A task has a preemption
+ * level above a ceiling if its relative deadline is shorter.  The largest value
+ * means there is no ceiling. */
+    #define taskSRP_NO_CEILING    ( ( DeadlineTime_t ) ~( ( DeadlineTime_t ) 0U ) )
+
+    typedef struct tskSRPResource
+    {
+        DeadlineTime_t xCeiling;                  /*< The shortest relative deadline of the tasks that use the resource. */
+        TCB_t * pxHolder;                         /*< The task that has the resource locked, or NULL. */
+        DeadlineTime_t xPreviousCeiling;          /*< The system ceiling before the resource was locked. */
+        UBaseType_t uxPreviousCeilingPriority;    /*< The band the previous system ceiling applied to. */
+        struct tskSRPResource * pxPreviousLocked; /*< The resource locked before this one, forming the stack of locked resources. */
+    } SRPResource_t;
+
+/* The system ceiling, the priority band it applies to and the most recently
+ * locked resource.  Only accessed from a critical section. */
+    PRIVILEGED_DATA static DeadlineTime_t xSRPSystemCeiling = taskSRP_NO_CEILING;
+    PRIVILEGED_DATA static UBaseType_t uxSRPCeilingPriority = tskIDLE_PRIORITY;
+    PRIVILEGED_DATA static SRPResource_t * pxSRPLockedResources = NULL;
+
+#endif
+
+#if ( configUSE_CBS == 1 )
+
+/* The time at which the budget of the running task was last charged.  Only
+ * meaningful while a served task is running. */
+    PRIVILEGED_DATA static DeadlineTime_t xServerChargedTime = ( DeadlineTime_t ) 0U;
+
+#endif
+
+#if ( configUSE_TIME_TRIGGERED == 1 )
+
+/* The schedule table and its tasks, as passed to xTaskStartTimeTriggered(). */
+    PRIVILEGED_DATA static const TimeTriggeredEntry_t * pxTimeTriggeredTable = NULL;
+    PRIVILEGED_DATA static UBaseType_t uxTimeTriggeredEntries = ( UBaseType_t ) 0U;
+    PRIVILEGED_DATA static TCB_t * const * pxTimeTriggeredTasks = NULL;
+    PRIVILEGED_DATA static DeadlineTime_t xTimeTriggeredMajorFrame = ( DeadlineTime_t ) 0U;
+
+/* The start of the current major frame, the slot that starts or ends next,
+ * and whether that slot has started. */
+    PRIVILEGED_DATA static DeadlineTime_t xTimeTriggeredFrameStart = ( DeadlineTime_t ) 0U;
+    PRIVILEGED_DATA static UBaseType_t uxTimeTriggeredNextEntry = ( UBaseType_t ) 0U;
+    PRIVILEGED_DATA static BaseType_t xTimeTriggeredSlotOpen = pdFALSE;
+
+/* The task of the open slot until its job completes or the slot ends.  While
+ * it is ready it runs without the ready lists being searched. */
+    PRIVILEGED_DATA static TCB_t * volatile pxTimeTriggeredTCB = NULL;
+
+    PRIVILEGED_DATA static TimeTriggeredStats_t xTimeTriggeredStats = { 0 };
+    PRIVILEGED_DATA static uint32_t ulTimeTriggeredSlots = 0UL;
+
+#endif
+
 /*lint -restore */
 
 /*-----------------------------------------------------------*/
@@ -473,6 +689,17 @@ static void prvAddCurrentTaskToDelayedList( TickType_t xTicksToWait,
 
 #endif
 
+/*
+ * Fills a TaskRunStats_t structure for each task that is referenced from the
+ * pxList list.
+ */
+#if ( configGENERATE_RUN_TIME_STATS == 1 )
+
+    static UBaseType_t prvListRunStatsWithinSingleList( TaskRunStats_t * pxRunStatsArray,
+                                                        List_t * pxList ) PRIVILEGED_FUNCTION;
+
+#endif
+
 /*
  * Searches pxList for a task with name pcNameToQuery - returning a handle to
  * the task if it is found, or NULL if the task is not found.
@@ -546,6 +773,142 @@ static void prvInitialiseNewTask( TaskFunction_t pxTaskCode,
  */
 static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB ) PRIVILEGED_FUNCTION;
 
+#if ( configUSE_EDF_SCHEDULER == 1 )
+
+/*
+ * Insert a task into a ready list behind every task whose deadline is not
+ * later than its own, so the list is ordered earliest deadline first and tasks
+ * with equal deadlines run in the order they became ready.
+ */
+    static void prvInsertIntoReadyListByDeadline( List_t * const pxList,
+                                                  TCB_t * const pxTCB ) PRIVILEGED_FUNCTION;
+
+#endif /* configUSE_EDF_SCHEDULER */
+
+#if ( configUSE_EDF_ADMISSION_CONTROL == 1 )
+
+/*
+ * Returns pdPASS if the admitted tasks, together with a task that has the
+ * given timing, can all meet their deadlines under EDF.  Must be called with
+ * the scheduler suspended.
+ */
+    static uint64_t prvHyperperiod( DeadlineTime_t xPeriod,
+                                    uint64_t ullLimit )
+    {
+        const TCB_t * pxTCB;
+        uint64_t ullHyperperiod = xPeriod;
+        uint64_t ullA, ullB, ullRemainder;
+
+        /* The least common multiple of all periods, or a value above the
+         * limit once it grows past it. */
+        for( pxTCB = pxAdmittedTasks; ( pxTCB != NULL ) && ( ullHyperperiod <= ullLimit ); pxTCB = pxTCB->pxNextAdmitted )
+        {
+            ullA = ullHyperperiod;
+            ullB = pxTCB->xPeriod;
+
+            while( ullB != 0U )
+            {
+                ullRemainder = ullA % ullB;
+                ullA = ullB;
+                ullB = ullRemainder;
+            }
+
+            ullHyperperiod /= ullA;
+
+            if( ullHyperperiod > ( ullLimit / pxTCB->xPeriod ) )
+            {
+                ullHyperperiod = ullLimit + 1U;
+            }
+            else
+            {
+                ullHyperperiod *= pxTCB->xPeriod;
+            }
+        }
+
+        return ullHyperperiod;
+    }
+
+    static BaseType_t prvIsSchedulableWith( DeadlineTime_t xWCET,
+                                            DeadlineTime_t xPeriod,
+                                            DeadlineTime_t xRelativeDeadline ) PRIVILEGED_FUNCTION;
+
+/*
+ * Add the load of a task that passed the admission test to the admitted set,
+ * or remove it again.  Must be called with the scheduler suspended or from a
+ * critical section.
+ */
+    static void prvAdmitTask( TCB_t * pxTCB,
+                              DeadlineTime_t xWCET ) PRIVILEGED_FUNCTION;
+    static void prvWithdrawTask( TCB_t * pxTCB ) PRIVILEGED_FUNCTION;
+
+#endif /* configUSE_EDF_ADMISSION_CONTROL */
+
+#if ( configUSE_DEADLINE_MISS_DETECTION == 1 )
+
+/*
+ * Count the miss of the current job of a periodic task, if it is past its
+ * deadline at xTime and has not been counted already.
+ */
+    static void prvCheckForDeadlineMiss( TCB_t * pxTCB,
+                                         DeadlineTime_t xTime ) PRIVILEGED_FUNCTION;
+
+/*
+ * Account for the completion of the current job of a periodic task at xTime.
+ */
+    static void prvRecordJobCompletion( TCB_t * pxTCB,
+                                        DeadlineTime_t xTime ) PRIVILEGED_FUNCTION;
+
+#endif /* configUSE_DEADLINE_MISS_DETECTION */
+
+#if ( configUSE_JOB_STATS == 1 )
+
+/*
+ * Record the start latency of the current job of a periodic task, if this is
+ * the first time the job runs.
+ */
+    static void prvRecordJobStart( TCB_t * pxTCB,
+                                   DeadlineTime_t xTime ) PRIVILEGED_FUNCTION;
+
+/*
+ * Record the response time of the current job of a periodic task, which
+ * completes at xTime.
+ */
+    static void prvRecordJobResponse( TCB_t * pxTCB,
+                                      DeadlineTime_t xTime ) PRIVILEGED_FUNCTION;
+
+#endif /* configUSE_JOB_STATS */
+
+#if ( configUSE_SRP == 1 )
+
+/*
+ * Return the task to run from a ready list.  This is the task with the
+ * earliest deadline among those that have a resource locked or have a
+ * preemption level above the system ceiling.
+ */
+    static TCB_t * prvGetReadyTaskUnderSRP( List_t * const pxList ) PRIVILEGED_FUNCTION;
+
+#endif /* configUSE_SRP */
+
+#if ( configUSE_CBS == 1 )
+
+/*
+ * Apply the wake up rule of the server of a task that is being moved into the
+ * Ready state.  Does nothing if the task is not served or was already ready.
+ */
+    static void prvServerWakeUp( TCB_t * const pxTCB ) PRIVILEGED_FUNCTION;
+
+/*
+ * Charge the server of a served task for the time it has run up to xNow,
+ * postponing the server deadline for each budget used up.  Returns pdTRUE if
+ * the deadline was postponed, in which case the task has been moved to its new
+ * place in its ready list.  Must be called from a critical section or the tick
+ * interrupt.
+ */
+    static BaseType_t prvServerCharge( TCB_t * const pxTCB,
+                                       DeadlineTime_t xNow ) PRIVILEGED_FUNCTION;
+
+#endif /* configUSE_CBS */
+
 /*
  * freertos_tasks_c_additions_init() should only be called if the user definable
  * macro FREERTOS_TASKS_C_ADDITIONS_INIT() is defined, as that is the only macro
@@ -679,7 +1042,7 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB ) PRIVILEGED_FUNCTION;
             /* Allocate space for the TCB.  Where the memory comes from depends
              * on the implementation of the port malloc function and whether or
              * not static allocation is being used. */
-            pxNewTCB = ( TCB_t * ) pvPortMalloc( sizeof( TCB_t ) );
+            pxNewTCB = ( TCB_t * ) pvPortMallocTCB( sizeof( TCB_t ) );
 
             if( pxNewTCB != NULL )
             {
@@ -736,7 +1099,7 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB ) PRIVILEGED_FUNCTION;
             /* Allocate space for the TCB.  Where the memory comes from depends on
              * the implementation of the port malloc function and whether or not static
              * allocation is being used. */
-            pxNewTCB = ( TCB_t * ) pvPortMalloc( sizeof( TCB_t ) );
+            pxNewTCB = ( TCB_t * ) pvPortMallocTCB( sizeof( TCB_t ) );
 
             if( pxNewTCB != NULL )
             {
@@ -750,7 +1113,7 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB ) PRIVILEGED_FUNCTION;
                 if( pxNewTCB->pxStack == NULL )
                 {
                     /* Could not allocate the stack.  Delete the allocated TCB. */
-                    vPortFree( pxNewTCB );
+                    vPortFreeTCB( pxNewTCB );
                     pxNewTCB = NULL;
                 }
             }
@@ -765,7 +1128,7 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB ) PRIVILEGED_FUNCTION;
             if( pxStack != NULL )
             {
                 /* Allocate space for the TCB. */
-                pxNewTCB = ( TCB_t * ) pvPortMalloc( sizeof( TCB_t ) ); /*lint !e9087 !e9079 All values returned by pvPortMalloc() have at least the alignment required by the MCU's stack, and the first member of TCB_t is always a pointer to the task's stack. */
+                pxNewTCB = ( TCB_t * ) pvPortMallocTCB( sizeof( TCB_t ) ); /*lint !e9087 !e9079 All values returned by pvPortMalloc() have at least the alignment required by the MCU's stack, and the first member of TCB_t is always a pointer to the task's stack. */
 
                 if( pxNewTCB != NULL )
                 {
@@ -813,6 +1176,192 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB ) PRIVILEGED_FUNCTION;
 #endif /* configSUPPORT_DYNAMIC_ALLOCATION */
 /*-----------------------------------------------------------*/
 
+#if ( ( configUSE_EDF_SCHEDULER == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) )
+
+    BaseType_t xTaskCreatePeriodic( TaskFunction_t pxTaskCode,
+                                    const char * const pcName, /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+                                    const configSTACK_DEPTH_TYPE usStackDepth,
+                                    void * const pvParameters,
+                                    UBaseType_t uxPriority,
+                                    const DeadlineTime_t xPeriod,
+                                    const DeadlineTime_t xRelativeDeadline,
+                                    const DeadlineTime_t xWCET,
+                                    TaskHandle_t * const pxCreatedTask )
+    {
+        TaskHandle_t xCreatedTask = NULL;
+        TCB_t * pxNewTCB;
+        BaseType_t xReturn = pdPASS;
+
+        configASSERT( xPeriod > 0U );
+        configASSERT( xRelativeDeadline > 0U );
+
+        /* The scheduler is suspended so the new task cannot run before its
+         * timing parameters are in place, even if it has a higher priority
+         * than the calling task.  This also keeps the admitted task set from
+         * changing between the admission test and the creation of the task. */
+        vTaskSuspendAll();
+        {
+            #if ( configUSE_EDF_ADMISSION_CONTROL == 1 )
+            {
+                /* A task that declares no execution time is not admission
+                 * tested and does not count towards the system load. */
+                if( ( xWCET > 0U ) && ( prvIsSchedulableWith( xWCET, xPeriod, xRelativeDeadline ) == pdFAIL ) )
+                {
+                    traceTASK_CREATE_FAILED();
+                    xReturn = errTASK_NOT_SCHEDULABLE;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+            #else
+            {
+                ( void ) xWCET;
+            }
+            #endif /* configUSE_EDF_ADMISSION_CONTROL */
+
+            if( xReturn == pdPASS )
+            {
+                xReturn = xTaskCreate( pxTaskCode, pcName, usStackDepth, pvParameters, uxPriority, &xCreatedTask );
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            if( xReturn == pdPASS )
+            {
+                pxNewTCB = xCreatedTask;
+                pxNewTCB->xPeriod = xPeriod;
+                pxNewTCB->xRelativeDeadline = xRelativeDeadline;
+
+                /* The first job is released now. */
+                pxNewTCB->xReleaseTime = taskGET_DEADLINE_TIME();
+                vTaskSetDeadline( xCreatedTask, pxNewTCB->xReleaseTime + xRelativeDeadline );
+
+                #if ( configUSE_EDF_ADMISSION_CONTROL == 1 )
+                {
+                    if( xWCET > 0U )
+                    {
+                        prvAdmitTask( pxNewTCB, xWCET );
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+                }
+                #endif
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        ( void ) xTaskResumeAll();
+
+        if( pxCreatedTask != NULL )
+        {
+            *pxCreatedTask = xCreatedTask;
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        return xReturn;
+    }
+
+#endif /* ( configUSE_EDF_SCHEDULER == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) */
+/*-----------------------------------------------------------*/
+
+#if ( ( configUSE_CBS == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) )
+
+    BaseType_t xTaskCreateServed( TaskFunction_t pxTaskCode,
+                                  const char * const pcName, /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+                                  const configSTACK_DEPTH_TYPE usStackDepth,
+                                  void * const pvParameters,
+                                  UBaseType_t uxPriority,
+                                  const DeadlineTime_t xBudget,
+                                  const DeadlineTime_t xServerPeriod,
+                                  TaskHandle_t * const pxCreatedTask )
+    {
+        TaskHandle_t xCreatedTask = NULL;
+        TCB_t * pxNewTCB;
+        BaseType_t xReturn = pdPASS;
+
+        configASSERT( xBudget > 0U );
+        configASSERT( xBudget <= xServerPeriod );
+        configASSERT( taskBAND_USES_EDF( taskSCHEDULING_PRIORITY( uxPriority ) ) );
+
+        vTaskSuspendAll();
+        {
+            #if ( configUSE_EDF_ADMISSION_CONTROL == 1 )
+            {
+                /* A server never uses more than its budget in a period, so it
+                 * is tested as a periodic task with an implicit deadline. */
+                if( prvIsSchedulableWith( xBudget, xServerPeriod, xServerPeriod ) == pdFAIL )
+                {
+                    traceTASK_CREATE_FAILED();
+                    xReturn = errTASK_NOT_SCHEDULABLE;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+            #endif /* configUSE_EDF_ADMISSION_CONTROL */
+
+            if( xReturn == pdPASS )
+            {
+                xReturn = xTaskCreate( pxTaskCode, pcName, usStackDepth, pvParameters, uxPriority, &xCreatedTask );
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            if( xReturn == pdPASS )
+            {
+                pxNewTCB = xCreatedTask;
+                pxNewTCB->xPeriod = xServerPeriod;
+                pxNewTCB->xRelativeDeadline = xServerPeriod;
+                pxNewTCB->xServerBudget = xBudget;
+                pxNewTCB->xServerRemaining = xBudget;
+
+                /* The task is already ready, so the server starts a period
+                 * now with a full budget. */
+                pxNewTCB->ucServerActive = ( uint8_t ) pdTRUE;
+                vTaskSetDeadline( xCreatedTask, taskGET_DEADLINE_TIME() + xServerPeriod );
+
+                #if ( configUSE_EDF_ADMISSION_CONTROL == 1 )
+                {
+                    prvAdmitTask( pxNewTCB, xBudget );
+                }
+                #endif
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        ( void ) xTaskResumeAll();
+
+        if( pxCreatedTask != NULL )
+        {
+            *pxCreatedTask = xCreatedTask;
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        return xReturn;
+    }
+
+#endif /* ( configUSE_CBS == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) */
+/*-----------------------------------------------------------*/
+
 static void prvInitialiseNewTask( TaskFunction_t pxTaskCode,
                                   const char * const pcName, /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
                                   const uint32_t ulStackDepth,
@@ -922,6 +1471,7 @@ static void prvInitialiseNewTask( TaskFunction_t pxTaskCode,
         mtCOVERAGE_TEST_MARKER();
     }
 
+    uxPriority = taskSCHEDULING_PRIORITY( uxPriority );
     pxNewTCB->uxPriority = uxPriority;
     #if ( configUSE_MUTEXES == 1 )
     {
@@ -1091,7 +1641,7 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
     {
         /* If the created task is of a higher priority than the current task
          * then it should run now. */
-        if( pxCurrentTCB->uxPriority < pxNewTCB->uxPriority )
+        if( taskPREEMPTS_CURRENT_TASK( pxNewTCB ) )
         {
             taskYIELD_IF_USING_PREEMPTION();
         }
@@ -1139,6 +1689,13 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
                 mtCOVERAGE_TEST_MARKER();
             }
 
+            #if ( configUSE_EDF_ADMISSION_CONTROL == 1 )
+            {
+                /* The load of the task is no longer part of the system. */
+                prvWithdrawTask( pxTCB );
+            }
+            #endif
+
             /* Increment the uxTaskNumber also so kernel aware debuggers can
              * detect that the task lists need re-generating.  This is done before
              * portPRE_TASK_DELETE_HOOK() as in the Windows port that macro will
@@ -1296,7 +1853,1096 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
 #endif /* INCLUDE_xTaskDelayUntil */
 /*-----------------------------------------------------------*/
 
-#if ( INCLUDE_vTaskDelay == 1 )
+#if ( configUSE_EDF_SCHEDULER == 1 )
+
+    BaseType_t xTaskWaitForNextPeriod( void )
+    {
+        TCB_t * const pxTCB = pxCurrentTCB;
+        BaseType_t xAlreadyYielded, xShouldDelay;
+
+        configASSERT( pxTCB->xPeriod > 0U );
+        configASSERT( taskIS_SERVED( pxTCB ) == pdFALSE );
+        configASSERT( uxSchedulerSuspended == 0 );
+
+        vTaskSuspendAll();
+        {
+            /* Read the time once, it is used for both the completion of this
+             * job and the release of the next. */
+            const DeadlineTime_t xNow = taskGET_DEADLINE_TIME();
+            TickType_t xTicksToWait;
+
+            #if ( configUSE_DEADLINE_MISS_DETECTION == 1 )
+            {
+                prvRecordJobCompletion( pxTCB, xNow );
+            }
+            #endif
+
+            /* If the next job is released at once its start is recorded when
+             * the yield below selects it. */
+            #if ( configUSE_JOB_STATS == 1 )
+            {
+                prvRecordJobResponse( pxTCB, xNow );
+            }
+            #endif
+
+            /* Releases are always a whole number of periods after the first
+             * one, however long each job took, so the schedule does not
+             * drift. */
+            pxTCB->xReleaseTime += pxTCB->xPeriod;
+            pxTCB->xDeadline = pxTCB->xReleaseTime + pxTCB->xRelativeDeadline;
+
+            if( taskDEADLINE_IS_BEFORE( xNow, pxTCB->xReleaseTime ) )
+            {
+                xShouldDelay = pdTRUE;
+
+                /* Block until a tick at or after the release.  The time base
+                 * and the tick run from the same clock, but the current tick
+                 * may be part way through and ticks may be pended while the
+                 * scheduler is suspended, so the next tick is anywhere up to
+                 * one tick after xNow and the count is taken from
+                 * xTickCount + xPendedTicks.  The jth tick after that one is
+                 * then more than j - 1 ticks after xNow, and one more tick
+                 * than the time to the release, rounded up, is never early.
+                 * With tick time the release falls on a tick and needs none.
+                 * The task is placed in its ready list by deadline when it is
+                 * released. */
+                xTicksToWait = ( TickType_t ) ( ( ( pxTCB->xReleaseTime - xNow ) + ( portDEADLINE_TIME_PER_TICK - 1U ) ) / portDEADLINE_TIME_PER_TICK );
+
+                #if ( configUSE_EDF_MICROSECOND_TIME == 1 )
+                {
+                    xTicksToWait += xPendedTicks + ( TickType_t ) 1U;
+                }
+                #endif
+
+                traceTASK_DELAY_UNTIL( xTickCount + xTicksToWait );
+
+                prvAddCurrentTaskToDelayedList( xTicksToWait, pdFALSE );
+            }
+            else
+            {
+                /* The job overran into the next period, which is therefore
+                 * released immediately.  Re-sort the task under its new
+                 * deadline.  The scheduler is suspended so the ready lists
+                 * cannot be accessed from an interrupt. */
+                xShouldDelay = pdFALSE;
+
+                ( void ) uxListRemove( &( pxTCB->xStateListItem ) );
+                taskINSERT_INTO_READY_LIST( &( pxReadyTasksLists[ pxTCB->uxPriority ] ), pxTCB );
+            }
+        }
+        xAlreadyYielded = xTaskResumeAll();
+
+        /* Force a reschedule if xTaskResumeAll has not already done so, we may
+         * have put ourselves to sleep or no longer have the earliest
+         * deadline. */
+        if( xAlreadyYielded == pdFALSE )
+        {
+            portYIELD_WITHIN_API();
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        return xShouldDelay;
+    }
+
+#endif /* configUSE_EDF_SCHEDULER */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_EDF_SCHEDULER == 1 )
+
+    BaseType_t xTaskDeclareTiming( TaskHandle_t xTask,
+                                   const DeadlineTime_t xWCET,
+                                   const DeadlineTime_t xPeriod,
+                                   const DeadlineTime_t xRelativeDeadline )
+    {
+        TCB_t * pxTCB;
+        BaseType_t xReturn = pdPASS;
+
+        configASSERT( xPeriod > 0U );
+        configASSERT( xRelativeDeadline > 0U );
+
+        vTaskSuspendAll();
+        {
+            pxTCB = prvGetTCBFromHandle( xTask );
+
+            #if ( configUSE_EDF_ADMISSION_CONTROL == 1 )
+            {
+                DeadlineTime_t xPreviousWCET = pxTCB->xWCET;
+
+                /* A task that is declared again is tested without the load it
+                 * declared before, and keeps that load if the test fails. */
+                prvWithdrawTask( pxTCB );
+
+                if( xWCET > 0U )
+                {
+                    if( prvIsSchedulableWith( xWCET, xPeriod, xRelativeDeadline ) == pdPASS )
+                    {
+                        pxTCB->xPeriod = xPeriod;
+                        pxTCB->xRelativeDeadline = xRelativeDeadline;
+                        prvAdmitTask( pxTCB, xWCET );
+                    }
+                    else
+                    {
+                        xReturn = errTASK_NOT_SCHEDULABLE;
+
+                        if( xPreviousWCET > 0U )
+                        {
+                            prvAdmitTask( pxTCB, xPreviousWCET );
+                        }
+                        else
+                        {
+                            mtCOVERAGE_TEST_MARKER();
+                        }
+                    }
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+            #else
+            {
+                ( void ) xWCET;
+            }
+            #endif /* configUSE_EDF_ADMISSION_CONTROL */
+
+            if( xReturn == pdPASS )
+            {
+                /* The current job of the task is taken to be released now. */
+                pxTCB->xPeriod = xPeriod;
+                pxTCB->xRelativeDeadline = xRelativeDeadline;
+                pxTCB->xReleaseTime = taskGET_DEADLINE_TIME();
+                vTaskSetDeadline( pxTCB, pxTCB->xReleaseTime + xRelativeDeadline );
+
+                /* A task that declares its own timing is already running the
+                 * job, which therefore has no start latency to record. */
+                #if ( configUSE_JOB_STATS == 1 )
+                {
+                    pxTCB->ucJobStarted = ( uint8_t ) ( ( pxTCB == pxCurrentTCB ) ? pdTRUE : pdFALSE );
+                }
+                #endif
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        ( void ) xTaskResumeAll();
+
+        return xReturn;
+    }
+
+#endif /* configUSE_EDF_SCHEDULER */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_EDF_ADMISSION_CONTROL == 1 )
+
+    uint32_t ulTaskGetUtilisation( void )
+    {
+        /* A 32-bit read is atomic on the architectures this is used on. */
+        return ulAdmittedUtilisation;
+    }
+
+#endif /* configUSE_EDF_ADMISSION_CONTROL */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_EDF_ADMISSION_CONTROL == 1 )
+
+    static uint32_t prvUtilisation( DeadlineTime_t xWCET,
+                                    DeadlineTime_t xPeriod )
+    {
+        /* Rounded up so that rounding never admits an overloaded set. */
+        return ( uint32_t ) ( ( ( ( uint64_t ) xWCET * tskUTILISATION_FULL ) + xPeriod - 1U ) / xPeriod );
+    }
+
+    static uint64_t prvDemandBound( uint64_t ullInterval,
+                                    DeadlineTime_t xWCET,
+                                    DeadlineTime_t xPeriod,
+                                    DeadlineTime_t xRelativeDeadline )
+    {
+        uint64_t ullDemand = 0U;
+
+        /* The execution time of all jobs that are released and have their
+         * deadline inside an interval of the given length. */
+        if( ullInterval >= xRelativeDeadline )
+        {
+            ullDemand = ( ( ( ullInterval - xRelativeDeadline ) / xPeriod ) + 1U ) * xWCET;
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        return ullDemand;
+    }
+
+    static BaseType_t prvDemandIsMet( uint64_t ullInterval,
+                                      DeadlineTime_t xWCET,
+                                      DeadlineTime_t xPeriod,
+                                      DeadlineTime_t xRelativeDeadline )
+    {
+        const TCB_t * pxTCB;
+        uint64_t ullDemand;
+
+        ullDemand = prvDemandBound( ullInterval, xWCET, xPeriod, xRelativeDeadline );
+
+        for( pxTCB = pxAdmittedTasks; pxTCB != NULL; pxTCB = pxTCB->pxNextAdmitted )
+        {
+            ullDemand += prvDemandBound( ullInterval, pxTCB->xWCET, pxTCB->xPeriod, pxTCB->xRelativeDeadline );
+        }
+
+        return ( ullDemand <= ullInterval ) ? pdPASS : pdFAIL;
+    }
+
+    static BaseType_t prvDeadlinesAreMet( uint64_t ullTestInterval,
+                                          DeadlineTime_t xPeriodOfTask,
+                                          DeadlineTime_t xDeadlineOfTask,
+                                          DeadlineTime_t xWCET,
+                                          DeadlineTime_t xPeriod,
+                                          DeadlineTime_t xRelativeDeadline )
+    {
+        uint64_t ullDeadline;
+        BaseType_t xReturn = pdPASS;
+
+        /* The demand only changes at deadlines, so it is enough to check at
+         * every deadline of every task inside the test interval. */
+        for( ullDeadline = xDeadlineOfTask; ( ullDeadline <= ullTestInterval ) && ( xReturn == pdPASS ); ullDeadline += xPeriodOfTask )
+        {
+            xReturn = prvDemandIsMet( ullDeadline, xWCET, xPeriod, xRelativeDeadline );
+        }
+
+        return xReturn;
+    }
+
+    static BaseType_t prvIsSchedulableWith( DeadlineTime_t xWCET,
+                                            DeadlineTime_t xPeriod,
+                                            DeadlineTime_t xRelativeDeadline )
+    {
+        const TCB_t * pxTCB;
+        uint32_t ulUtilisation, ulDensity;
+        uint64_t ullSlack, ullTestInterval, ullHyperperiod;
+        const uint64_t ullMaxTestInterval = ( uint64_t ) tskMS_TO_DEADLINE_TIME( configEDF_DEMAND_TEST_MAX_INTERVAL_MS );
+        DeadlineTime_t xMaxDeadline;
+        BaseType_t xConstrained, xReturn;
+
+        ulUtilisation = ulAdmittedUtilisation + prvUtilisation( xWCET, xPeriod );
+        ulDensity = prvUtilisation( xWCET, ( xRelativeDeadline < xPeriod ) ? xRelativeDeadline : xPeriod );
+        xConstrained = ( xRelativeDeadline < xPeriod ) ? pdTRUE : pdFALSE;
+        ullSlack = ( xConstrained != pdFALSE ) ? ( ( uint64_t ) ( xPeriod - xRelativeDeadline ) * prvUtilisation( xWCET, xPeriod ) ) : 0U;
+        xMaxDeadline = xRelativeDeadline;
+
+        for( pxTCB = pxAdmittedTasks; pxTCB != NULL; pxTCB = pxTCB->pxNextAdmitted )
+        {
+            if( pxTCB->xRelativeDeadline < pxTCB->xPeriod )
+            {
+                xConstrained = pdTRUE;
+                ulDensity += prvUtilisation( pxTCB->xWCET, pxTCB->xRelativeDeadline );
+                ullSlack += ( uint64_t ) ( pxTCB->xPeriod - pxTCB->xRelativeDeadline ) * prvUtilisation( pxTCB->xWCET, pxTCB->xPeriod );
+            }
+            else
+            {
+                ulDensity += prvUtilisation( pxTCB->xWCET, pxTCB->xPeriod );
+            }
+
+            if( pxTCB->xRelativeDeadline > xMaxDeadline )
+            {
+                xMaxDeadline = pxTCB->xRelativeDeadline;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+
+        if( ulUtilisation > tskUTILISATION_FULL )
+        {
+            /* No task set with a utilisation above 1 can be scheduled. */
+            xReturn = pdFAIL;
+        }
+        else if( ( xConstrained == pdFALSE ) || ( ulDensity <= tskUTILISATION_FULL ) )
+        {
+            /* With implicit deadlines U <= 1 is exact, and a density of at
+             * most 1 is sufficient for any deadlines. */
+            xReturn = pdPASS;
+        }
+        else
+        {
+            /* Processor demand test.  If the demand exceeds the length of an
+             * interval at all then it does so within
+             * max( Dmax, sum( ( Ti - Di ) * Ui ) / ( 1 - U ) ).  A fully
+             * loaded set has no such bound and needs the hyperperiod. */
+            if( ulUtilisation < tskUTILISATION_FULL )
+            {
+                ullTestInterval = ( ullSlack + ( tskUTILISATION_FULL - ulUtilisation ) - 1U ) / ( tskUTILISATION_FULL - ulUtilisation );
+
+                if( ullTestInterval < xMaxDeadline )
+                {
+                    ullTestInterval = xMaxDeadline;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+            else
+            {
+                ullTestInterval = UINT64_MAX;
+            }
+
+            /* The schedule repeats after the hyperperiod, so no interval
+             * longer than the hyperperiod plus Dmax needs to be checked. */
+            ullHyperperiod = prvHyperperiod( xPeriod, ullMaxTestInterval );
+
+            if( ( ullHyperperiod <= ullMaxTestInterval ) && ( ( ullHyperperiod + xMaxDeadline ) < ullTestInterval ) )
+            {
+                ullTestInterval = ullHyperperiod + xMaxDeadline;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            if( ullTestInterval > ullMaxTestInterval )
+            {
+                /* The set might be schedulable, but checking it would take
+                 * too long with the scheduler suspended, so the task is
+                 * conservatively rejected. */
+                xReturn = pdFAIL;
+            }
+            else
+            {
+                xReturn = prvDeadlinesAreMet( ullTestInterval, xPeriod, xRelativeDeadline, xWCET, xPeriod, xRelativeDeadline );
+            }
+
+            for( pxTCB = pxAdmittedTasks; ( pxTCB != NULL ) && ( xReturn == pdPASS ); pxTCB = pxTCB->pxNextAdmitted )
+            {
+                xReturn = prvDeadlinesAreMet( ullTestInterval, pxTCB->xPeriod, pxTCB->xRelativeDeadline, xWCET, xPeriod, xRelativeDeadline );
+            }
+        }
+
+        return xReturn;
+    }
+
+    static void prvAdmitTask( TCB_t * pxTCB,
+                              DeadlineTime_t xWCET )
+    {
+        pxTCB->xWCET = xWCET;
+        pxTCB->pxNextAdmitted = pxAdmittedTasks;
+        pxAdmittedTasks = pxTCB;
+        ulAdmittedUtilisation += prvUtilisation( xWCET, pxTCB->xPeriod );
+    }
+
+    static void prvWithdrawTask( TCB_t * pxTCB )
+    {
+        TCB_t ** ppxLink;
+
+        if( pxTCB->xWCET > 0U )
+        {
+            for( ppxLink = &pxAdmittedTasks; *ppxLink != NULL; ppxLink = &( ( *ppxLink )->pxNextAdmitted ) )
+            {
+                if( *ppxLink == pxTCB )
+                {
+                    *ppxLink = pxTCB->pxNextAdmitted;
+                    ulAdmittedUtilisation -= prvUtilisation( pxTCB->xWCET, pxTCB->xPeriod );
+                    break;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+
+            pxTCB->xWCET = 0U;
+            pxTCB->pxNextAdmitted = NULL;
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+
+#endif /* configUSE_EDF_ADMISSION_CONTROL */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_DEADLINE_MISS_DETECTION == 1 )
+
+    static void prvCheckForDeadlineMiss( TCB_t * pxTCB,
+                                         DeadlineTime_t xTime )
+    {
+        /* Only the jobs of periodic tasks have a deadline to miss.  The
+         * deadline of a served task is that of its server. */
+        if( ( pxTCB->xPeriod != ( DeadlineTime_t ) 0U ) && ( taskIS_SERVED( pxTCB ) == pdFALSE ) && ( pxTCB->ucDeadlineMissed == ( uint8_t ) pdFALSE ) )
+        {
+            if( taskDEADLINE_IS_BEFORE( pxTCB->xDeadline, xTime ) )
+            {
+                pxTCB->ucDeadlineMissed = ( uint8_t ) pdTRUE;
+                pxTCB->xDeadlineStats.ulDeadlinesMissed++;
+                traceTASK_DEADLINE_MISSED( pxTCB );
+
+                #if ( configUSE_DEADLINE_MISS_HOOK == 1 )
+                {
+                    vApplicationDeadlineMissHook( ( TaskHandle_t ) pxTCB, xTime - pxTCB->xDeadline );
+                }
+                #endif
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+    /*-----------------------------------------------------------*/
+
+    static void prvRecordJobCompletion( TCB_t * pxTCB,
+                                        DeadlineTime_t xTime )
+    {
+        DeadlineTime_t xTardiness;
+        UBaseType_t uxBucket = 0;
+
+        prvCheckForDeadlineMiss( pxTCB, xTime );
+
+        if( taskDEADLINE_IS_BEFORE( pxTCB->xDeadline, xTime ) )
+        {
+            xTardiness = xTime - pxTCB->xDeadline;
+
+            if( xTardiness > pxTCB->xDeadlineStats.xMaxTardiness )
+            {
+                pxTCB->xDeadlineStats.xMaxTardiness = xTardiness;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            /* Bucket n holds tardiness in [ 2^n, 2^(n+1) ), so the bucket is
+             * the index of the highest set bit.  This takes at most one pass
+             * per bucket. */
+            while( ( xTardiness > ( DeadlineTime_t ) 1U ) && ( uxBucket < ( UBaseType_t ) ( configTARDINESS_HISTOGRAM_BUCKETS - 1 ) ) )
+            {
+                xTardiness >>= 1;
+                uxBucket++;
+            }
+
+            pxTCB->xDeadlineStats.ulTardinessHistogram[ uxBucket ]++;
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        pxTCB->xDeadlineStats.ulJobsCompleted++;
+        pxTCB->ucDeadlineMissed = ( uint8_t ) pdFALSE;
+    }
+    /*-----------------------------------------------------------*/
+
+    void vTaskGetDeadlineStats( TaskHandle_t xTask,
+                                TaskDeadlineStats_t * pxStats )
+    {
+        TCB_t * pxTCB;
+
+        configASSERT( pxStats );
+
+        taskENTER_CRITICAL();
+        {
+            pxTCB = prvGetTCBFromHandle( xTask );
+            *pxStats = pxTCB->xDeadlineStats;
+        }
+        taskEXIT_CRITICAL();
+    }
+    /*-----------------------------------------------------------*/
+
+    void vTaskResetDeadlineStats( TaskHandle_t xTask )
+    {
+        TCB_t * pxTCB;
+
+        taskENTER_CRITICAL();
+        {
+            pxTCB = prvGetTCBFromHandle( xTask );
+            ( void ) memset( ( void * ) &( pxTCB->xDeadlineStats ), 0x00, sizeof( pxTCB->xDeadlineStats ) );
+        }
+        taskEXIT_CRITICAL();
+    }
+
+#endif /* configUSE_DEADLINE_MISS_DETECTION */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_JOB_STATS == 1 )
+
+    static void prvRecordJobStart( TCB_t * pxTCB,
+                                   DeadlineTime_t xTime )
+    {
+        TaskJobStats_t * const pxStats = &( pxTCB->xJobStats );
+        DeadlineTime_t xLatency;
+
+        if( ( pxTCB->xPeriod != ( DeadlineTime_t ) 0U ) && ( taskIS_SERVED( pxTCB ) == pdFALSE ) && ( pxTCB->ucJobStarted == ( uint8_t ) pdFALSE ) )
+        {
+            pxTCB->ucJobStarted = ( uint8_t ) pdTRUE;
+
+            /* xTaskWaitForNextPeriod() never wakes a job before its release. */
+            configASSERT( !taskDEADLINE_IS_BEFORE( xTime, pxTCB->xReleaseTime ) );
+            xLatency = xTime - pxTCB->xReleaseTime;
+
+            /* The first job sets both extremes. */
+            if( ( pxStats->ulJobs == 0U ) || ( xLatency < pxStats->xMinStartLatency ) )
+            {
+                pxStats->xMinStartLatency = xLatency;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            if( xLatency > pxStats->xMaxStartLatency )
+            {
+                pxStats->xMaxStartLatency = xLatency;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+    /*-----------------------------------------------------------*/
+
+    static void prvRecordJobResponse( TCB_t * pxTCB,
+                                      DeadlineTime_t xTime )
+    {
+        TaskJobStats_t * const pxStats = &( pxTCB->xJobStats );
+        DeadlineTime_t xResponse;
+
+        /* A job cannot complete before it is released. */
+        configASSERT( !taskDEADLINE_IS_BEFORE( xTime, pxTCB->xReleaseTime ) );
+        xResponse = xTime - pxTCB->xReleaseTime;
+
+        if( ( pxStats->ulJobs == 0U ) || ( xResponse < pxStats->xMinResponseTime ) )
+        {
+            pxStats->xMinResponseTime = xResponse;
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        if( xResponse > pxStats->xMaxResponseTime )
+        {
+            pxStats->xMaxResponseTime = xResponse;
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        pxStats->ullTotalResponseTime += xResponse;
+        pxStats->ulJobs++;
+        pxTCB->ucJobStarted = ( uint8_t ) pdFALSE;
+    }
+
+#endif /* configUSE_JOB_STATS */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_SRP == 1 )
+
+    static TCB_t * prvGetReadyTaskUnderSRP( List_t * const pxList )
+    {
+        const ListItem_t * pxIterator;
+        const ListItem_t * const pxEnd = listGET_END_MARKER( pxList );
+        TCB_t * pxTCB;
+        TCB_t * pxSelectedTCB = listGET_OWNER_OF_HEAD_ENTRY( pxList );
+
+        if( ( xSRPSystemCeiling != taskSRP_NO_CEILING ) && ( pxList == &( pxReadyTasksLists[ uxSRPCeilingPriority ] ) ) )
+        {
+            /* The holder of the resource that set the ceiling is in this
+             * list, so the search ends at the latest when it is found. */
+            for( pxIterator = listGET_HEAD_ENTRY( pxList ); pxIterator != pxEnd; pxIterator = listGET_NEXT( pxIterator ) ) /*lint !e826 !e740 !e9087 The mini list structure is used as the list end to save RAM.  This is checked and valid. */
+            {
+                pxTCB = listGET_LIST_ITEM_OWNER( pxIterator );
+
+                if( ( pxTCB->uxSRPLocksHeld > ( UBaseType_t ) 0U ) ||
+                    ( ( pxTCB->xRelativeDeadline != ( DeadlineTime_t ) 0U ) && ( pxTCB->xRelativeDeadline < xSRPSystemCeiling ) ) )
+                {
+                    pxSelectedTCB = pxTCB;
+                    break;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        return pxSelectedTCB;
+    }
+    /*-----------------------------------------------------------*/
+
+    #if ( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+
+        SRPResourceHandle_t xTaskCreateSRPResource( void )
+        {
+            SRPResource_t * pxResource;
+
+            pxResource = ( SRPResource_t * ) pvPortMalloc( sizeof( SRPResource_t ) );
+
+            if( pxResource != NULL )
+            {
+                pxResource->xCeiling = taskSRP_NO_CEILING;
+                pxResource->pxHolder = NULL;
+                pxResource->xPreviousCeiling = taskSRP_NO_CEILING;
+                pxResource->uxPreviousCeilingPriority = tskIDLE_PRIORITY;
+                pxResource->pxPreviousLocked = NULL;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            return pxResource;
+        }
+
+    #endif /* configSUPPORT_DYNAMIC_ALLOCATION */
+    /*-----------------------------------------------------------*/
+
+    void vTaskAddSRPResourceUser( SRPResourceHandle_t xResource,
+                                  TaskHandle_t xTask )
+    {
+        SRPResource_t * const pxResource = xResource;
+        TCB_t * pxTCB;
+
+        configASSERT( pxResource );
+
+        taskENTER_CRITICAL();
+        {
+            pxTCB = prvGetTCBFromHandle( xTask );
+
+            if( ( pxTCB->xRelativeDeadline != ( DeadlineTime_t ) 0U ) && ( pxTCB->xRelativeDeadline < pxResource->xCeiling ) )
+            {
+                pxResource->xCeiling = pxTCB->xRelativeDeadline;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        taskEXIT_CRITICAL();
+    }
+    /*-----------------------------------------------------------*/
+
+    void vTaskSRPLock( SRPResourceHandle_t xResource )
+    {
+        SRPResource_t * const pxResource = xResource;
+
+        configASSERT( pxResource );
+
+        taskENTER_CRITICAL();
+        {
+            /* A task only starts once every resource it can lock is free, so
+             * a locked resource here means a user was not declared. */
+            configASSERT( pxResource->pxHolder == NULL );
+
+            pxResource->pxHolder = pxCurrentTCB;
+            pxResource->xPreviousCeiling = xSRPSystemCeiling;
+            pxResource->uxPreviousCeilingPriority = uxSRPCeilingPriority;
+            pxResource->pxPreviousLocked = pxSRPLockedResources;
+            pxSRPLockedResources = pxResource;
+            ( pxCurrentTCB->uxSRPLocksHeld )++;
+
+            if( pxResource->xCeiling < xSRPSystemCeiling )
+            {
+                xSRPSystemCeiling = pxResource->xCeiling;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            uxSRPCeilingPriority = pxCurrentTCB->uxPriority;
+        }
+        taskEXIT_CRITICAL();
+    }
+    /*-----------------------------------------------------------*/
+
+    void vTaskSRPUnlock( SRPResourceHandle_t xResource )
+    {
+        SRPResource_t * const pxResource = xResource;
+
+        configASSERT( pxResource );
+
+        taskENTER_CRITICAL();
+        {
+            configASSERT( pxResource->pxHolder == pxCurrentTCB );
+
+            /* Resources are unlocked in the reverse order to which they were
+             * locked, so the ceiling saved when this resource was locked is
+             * the system ceiling of the remaining locked resources. */
+            configASSERT( pxSRPLockedResources == pxResource );
+
+            xSRPSystemCeiling = pxResource->xPreviousCeiling;
+            uxSRPCeilingPriority = pxResource->uxPreviousCeilingPriority;
+            pxSRPLockedResources = pxResource->pxPreviousLocked;
+            pxResource->pxHolder = NULL;
+            ( pxCurrentTCB->uxSRPLocksHeld )--;
+
+            /* A task the ceiling held back may now be the one to run. */
+            if( prvGetReadyTaskUnderSRP( &( pxReadyTasksLists[ pxCurrentTCB->uxPriority ] ) ) != pxCurrentTCB )
+            {
+                taskYIELD_IF_USING_PREEMPTION();
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        taskEXIT_CRITICAL();
+    }
+
+#endif /* configUSE_SRP */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_TIME_TRIGGERED == 1 )
+
+    BaseType_t xTaskStartTimeTriggered( const TimeTriggeredEntry_t * pxTable,
+                                        UBaseType_t uxEntries,
+                                        TaskHandle_t const * pxTasks,
+                                        UBaseType_t uxTasks,
+                                        DeadlineTime_t xMajorFrame,
+                                        DeadlineTime_t xStartTime )
+    {
+        UBaseType_t ux;
+        DeadlineTime_t xFree = ( DeadlineTime_t ) 0U;
+
+        configASSERT( xSchedulerRunning == pdFALSE );
+        configASSERT( pxTimeTriggeredTable == NULL );
+
+        if( ( pxTable == NULL ) || ( uxEntries == ( UBaseType_t ) 0U ) ||
+            ( pxTasks == NULL ) || ( uxTasks == ( UBaseType_t ) 0U ) ||
+            ( xMajorFrame == ( DeadlineTime_t ) 0U ) )
+        {
+            return pdFAIL;
+        }
+
+        /* Slots must be ordered, must not overlap and must end within the
+         * major frame, so that the dispatcher only ever has one slot open. */
+        for( ux = ( UBaseType_t ) 0U; ux < uxEntries; ux++ )
+        {
+            if( ( pxTable[ ux ].uxTask >= uxTasks ) ||
+                ( pxTasks[ pxTable[ ux ].uxTask ] == NULL ) ||
+                ( pxTable[ ux ].xBudget == ( DeadlineTime_t ) 0U ) ||
+                ( pxTable[ ux ].xOffset < xFree ) ||
+                ( pxTable[ ux ].xBudget > ( xMajorFrame - pxTable[ ux ].xOffset ) ) ||
+                ( pxTable[ ux ].xOffset >= xMajorFrame ) )
+            {
+                return pdFAIL;
+            }
+
+            xFree = pxTable[ ux ].xOffset + pxTable[ ux ].xBudget;
+        }
+
+        /* Every task waits for its first slot. */
+        for( ux = ( UBaseType_t ) 0U; ux < uxTasks; ux++ )
+        {
+            if( pxTasks[ ux ] != NULL )
+            {
+                vTaskSuspend( pxTasks[ ux ] );
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+
+        taskENTER_CRITICAL();
+        {
+            pxTimeTriggeredTable = pxTable;
+            uxTimeTriggeredEntries = uxEntries;
+            pxTimeTriggeredTasks = pxTasks;
+            xTimeTriggeredMajorFrame = xMajorFrame;
+            xTimeTriggeredFrameStart = xStartTime;
+            uxTimeTriggeredNextEntry = ( UBaseType_t ) 0U;
+            xTimeTriggeredSlotOpen = pdFALSE;
+        }
+        taskEXIT_CRITICAL();
+
+        return pdPASS;
+    }
+/*-----------------------------------------------------------*/
+
+    DeadlineTime_t xTaskTimeTriggeredDispatchFromISR( BaseType_t * pxHigherPriorityTaskWoken )
+    {
+        const TimeTriggeredEntry_t * pxEntry;
+        TCB_t * pxTCB;
+        DeadlineTime_t xNow, xEvent, xLatency;
+        BaseType_t xSwitchRequired = pdFALSE;
+        UBaseType_t uxSavedInterruptStatus;
+
+        /* See the comment in xTaskResumeFromISR(). */
+        portASSERT_IF_INTERRUPT_PRIORITY_INVALID();
+        configASSERT( pxTimeTriggeredTable != NULL );
+
+        uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+        {
+            xNow = taskGET_DEADLINE_TIME();
+
+            /* Process every slot start and end that is due, in order, so a
+             * late call still leaves the dispatcher in step with the table. */
+            for( ; ; )
+            {
+                pxEntry = &( pxTimeTriggeredTable[ uxTimeTriggeredNextEntry ] );
+                xEvent = xTimeTriggeredFrameStart + pxEntry->xOffset;
+
+                if( xTimeTriggeredSlotOpen != pdFALSE )
+                {
+                    xEvent += pxEntry->xBudget;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                if( taskDEADLINE_IS_BEFORE( xNow, xEvent ) != pdFALSE )
+                {
+                    break;
+                }
+
+                if( xTimeTriggeredSlotOpen == pdFALSE )
+                {
+                    /* The slot starts.  Its task is made ready if it is
+                     * waiting for the slot, in the same way as
+                     * xTaskResumeFromISR(), and then takes the processor. */
+                    pxTCB = pxTimeTriggeredTasks[ pxEntry->uxTask ];
+
+                    if( prvTaskIsTaskSuspended( pxTCB ) != pdFALSE )
+                    {
+                        traceTASK_RESUME_FROM_ISR( pxTCB );
+
+                        if( uxSchedulerSuspended == ( UBaseType_t ) pdFALSE )
+                        {
+                            ( void ) uxListRemove( &( pxTCB->xStateListItem ) );
+                            prvAddTaskToReadyList( pxTCB );
+                        }
+                        else
+                        {
+                            vListInsertEnd( &( xPendingReadyList ), &( pxTCB->xEventListItem ) );
+                        }
+                    }
+                    else
+                    {
+                        /* The job of the previous slot has not completed. */
+                        xTimeTriggeredStats.ulNotReady++;
+                    }
+
+                    xLatency = xNow - xEvent;
+
+                    if( ( ulTimeTriggeredSlots == 0UL ) || ( xLatency < xTimeTriggeredStats.xMinLatency ) )
+                    {
+                        xTimeTriggeredStats.xMinLatency = xLatency;
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+
+                    if( xLatency > xTimeTriggeredStats.xMaxLatency )
+                    {
+                        xTimeTriggeredStats.xMaxLatency = xLatency;
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+
+                    ulTimeTriggeredSlots++;
+                    pxTimeTriggeredTCB = pxTCB;
+                    xTimeTriggeredSlotOpen = pdTRUE;
+                    xSwitchRequired = pdTRUE;
+                }
+                else
+                {
+                    /* The slot ends.  A job that has not completed overruns
+                     * and continues at the priority of its task. */
+                    if( pxTimeTriggeredTCB != NULL )
+                    {
+                        xTimeTriggeredStats.ulOverruns++;
+                        pxTimeTriggeredTCB = NULL;
+                        xSwitchRequired = pdTRUE;
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+
+                    xTimeTriggeredSlotOpen = pdFALSE;
+                    uxTimeTriggeredNextEntry++;
+
+                    if( uxTimeTriggeredNextEntry >= uxTimeTriggeredEntries )
+                    {
+                        uxTimeTriggeredNextEntry = ( UBaseType_t ) 0U;
+                        xTimeTriggeredFrameStart += xTimeTriggeredMajorFrame;
+                        xTimeTriggeredStats.ulFrames++;
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+                }
+            }
+
+            if( xSwitchRequired != pdFALSE )
+            {
+                /* Mark that a yield is pending in case the caller does not use
+                 * pxHigherPriorityTaskWoken. */
+                xYieldPending = pdTRUE;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+        if( pxHigherPriorityTaskWoken != NULL )
+        {
+            *pxHigherPriorityTaskWoken = xSwitchRequired;
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        return xEvent;
+    }
+/*-----------------------------------------------------------*/
+
+    void vTaskWaitForNextSlot( void )
+    {
+        taskENTER_CRITICAL();
+        {
+            /* The job has completed, so the slot no longer holds the
+             * processor for the task. */
+            if( pxTimeTriggeredTCB == pxCurrentTCB )
+            {
+                pxTimeTriggeredTCB = NULL;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            vTaskSuspend( NULL );
+        }
+        taskEXIT_CRITICAL();
+    }
+/*-----------------------------------------------------------*/
+
+    void vTaskGetTimeTriggeredStats( TimeTriggeredStats_t * pxStats )
+    {
+        configASSERT( pxStats );
+
+        taskENTER_CRITICAL();
+        {
+            *pxStats = xTimeTriggeredStats;
+        }
+        taskEXIT_CRITICAL();
+    }
+
+#endif /* configUSE_TIME_TRIGGERED */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_CBS == 1 )
+
+    static void prvServerWakeUp( TCB_t * const pxTCB )
+    {
+        DeadlineTime_t xNow;
+
+        if( taskIS_SERVED( pxTCB ) && ( pxTCB->ucServerActive == ( uint8_t ) pdFALSE ) )
+        {
+            xNow = taskGET_DEADLINE_TIME();
+
+            /* The remaining budget can be kept only if using it before the
+             * current deadline does not exceed the server bandwidth, that is
+             * if remaining / ( deadline - now ) < budget / period.  Otherwise
+             * the server starts a new period now. */
+            if( ( taskDEADLINE_IS_BEFORE( xNow, pxTCB->xDeadline ) == pdFALSE ) ||
+                ( ( ( uint64_t ) pxTCB->xServerRemaining * ( uint64_t ) pxTCB->xPeriod ) >= ( ( uint64_t ) ( pxTCB->xDeadline - xNow ) * ( uint64_t ) pxTCB->xServerBudget ) ) )
+            {
+                pxTCB->xServerRemaining = pxTCB->xServerBudget;
+                pxTCB->xDeadline = xNow + pxTCB->xPeriod;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            pxTCB->ucServerActive = ( uint8_t ) pdTRUE;
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+    /*-----------------------------------------------------------*/
+
+    static BaseType_t prvServerCharge( TCB_t * const pxTCB,
+                                       DeadlineTime_t xNow )
+    {
+        DeadlineTime_t xUsed = xNow - xServerChargedTime;
+        BaseType_t xPostponed = pdFALSE;
+
+        xServerChargedTime = xNow;
+
+        /* Every time the budget is used up it is refilled and the deadline
+         * moves one server period later.  More than one period can pass if
+         * the task ran for longer than a budget since it was last charged. */
+        while( xUsed >= pxTCB->xServerRemaining )
+        {
+            xUsed -= pxTCB->xServerRemaining;
+            pxTCB->xServerRemaining = pxTCB->xServerBudget;
+            pxTCB->xDeadline += pxTCB->xPeriod;
+            xPostponed = pdTRUE;
+        }
+
+        pxTCB->xServerRemaining -= xUsed;
+
+        if( xPostponed != pdFALSE )
+        {
+            traceTASK_SERVER_BUDGET_EXHAUSTED( pxTCB );
+
+            /* The task may already have left the Ready state if it is being
+             * switched out because it blocked. */
+            if( listIS_CONTAINED_WITHIN( &( pxReadyTasksLists[ pxTCB->uxPriority ] ), &( pxTCB->xStateListItem ) ) != pdFALSE )
+            {
+                ( void ) uxListRemove( &( pxTCB->xStateListItem ) );
+                taskINSERT_INTO_READY_LIST( &( pxReadyTasksLists[ pxTCB->uxPriority ] ), pxTCB );
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        return xPostponed;
+    }
+
+#endif /* configUSE_CBS */
+/*-----------------------------------------------------------*/
+
+#if ( INCLUDE_vTaskDelay == 1 )
 
     void vTaskDelay( const TickType_t xTicksToDelay )
     {
@@ -1523,6 +3169,8 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
             mtCOVERAGE_TEST_MARKER();
         }
 
+        uxNewPriority = taskSCHEDULING_PRIORITY( uxNewPriority );
+
         taskENTER_CRITICAL();
         {
             /* If null is passed in here then it is the priority of the calling
@@ -1705,6 +3353,12 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
 
             vListInsertEnd( &xSuspendedTaskList, &( pxTCB->xStateListItem ) );
 
+            #if ( configUSE_CBS == 1 )
+            {
+                pxTCB->ucServerActive = ( uint8_t ) pdFALSE;
+            }
+            #endif
+
             #if ( configUSE_TASK_NOTIFICATIONS == 1 )
             {
                 BaseType_t x;
@@ -2045,6 +3699,19 @@ void vTaskStartScheduler( void )
          * FreeRTOSConfig.h file. */
         portCONFIGURE_TIMER_FOR_RUN_TIME_STATS();
 
+        /* The first task does not pass through vTaskSwitchContext(). */
+        #if ( configUSE_CBS == 1 )
+        {
+            xServerChargedTime = taskGET_DEADLINE_TIME();
+        }
+        #endif
+
+        #if ( configUSE_JOB_STATS == 1 )
+        {
+            prvRecordJobStart( pxCurrentTCB, taskGET_DEADLINE_TIME() );
+        }
+        #endif
+
         traceTASK_SWITCHED_IN();
 
         /* Setting up the timer tick is hardware specific and thus in the
@@ -2283,6 +3950,47 @@ BaseType_t xTaskResumeAll( void )
 }
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_EDF_SCHEDULER == 1 )
+
+    DeadlineTime_t getTaskDeadline( TaskHandle_t xTask )
+    {
+        TCB_t * pxTCB;
+
+        pxTCB = prvGetTCBFromHandle( xTask );
+
+        return pxTCB->xDeadline;
+    }
+
+#endif /* configUSE_EDF_SCHEDULER */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_EDF_SCHEDULER == 1 )
+
+    DeadlineTime_t xTaskGetDeadlineTime( void )
+    {
+        DeadlineTime_t xTime;
+
+        #if ( configUSE_EDF_MICROSECOND_TIME == 1 )
+        {
+            xTime = taskGET_DEADLINE_TIME();
+        }
+        #else
+        {
+            /* Critical section required if running on a 16 bit processor. */
+            portTICK_TYPE_ENTER_CRITICAL();
+            {
+                xTime = taskGET_DEADLINE_TIME();
+            }
+            portTICK_TYPE_EXIT_CRITICAL();
+        }
+        #endif
+
+        return xTime;
+    }
+
+#endif /* configUSE_EDF_SCHEDULER */
+/*-----------------------------------------------------------*/
+
 TickType_t xTaskGetTickCount( void )
 {
     TickType_t xTicks;
@@ -2559,6 +4267,96 @@ char * pcTaskGetName( TaskHandle_t xTaskToQuery ) /*lint !e971 Unqualified char
 #endif /* configUSE_TRACE_FACILITY */
 /*----------------------------------------------------------*/
 
+#if ( configGENERATE_RUN_TIME_STATS == 1 )
+
+    UBaseType_t uxTaskGetRunStats( TaskRunStats_t * const pxRunStatsArray,
+                                   const UBaseType_t uxArraySize,
+                                   configRUN_TIME_COUNTER_TYPE * const pulTotalRunTime,
+                                   configRUN_TIME_COUNTER_TYPE * const pulIdleRunTime )
+    {
+        UBaseType_t uxTask = 0, uxQueue = configMAX_PRIORITIES, x;
+        configRUN_TIME_COUNTER_TYPE ulNow;
+
+        configASSERT( pxRunStatsArray );
+
+        /* With the scheduler suspended no task can be switched in or out, so
+         * the counters of all the tasks are read at the same point. */
+        vTaskSuspendAll();
+        {
+            if( uxArraySize >= uxCurrentNumberOfTasks )
+            {
+                do
+                {
+                    uxQueue--;
+                    uxTask += prvListRunStatsWithinSingleList( &( pxRunStatsArray[ uxTask ] ), &( pxReadyTasksLists[ uxQueue ] ) );
+                } while( uxQueue > ( UBaseType_t ) tskIDLE_PRIORITY ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
+
+                uxTask += prvListRunStatsWithinSingleList( &( pxRunStatsArray[ uxTask ] ), ( List_t * ) pxDelayedTaskList );
+                uxTask += prvListRunStatsWithinSingleList( &( pxRunStatsArray[ uxTask ] ), ( List_t * ) pxOverflowDelayedTaskList );
+
+                #if ( INCLUDE_vTaskDelete == 1 )
+                {
+                    uxTask += prvListRunStatsWithinSingleList( &( pxRunStatsArray[ uxTask ] ), &xTasksWaitingTermination );
+                }
+                #endif
+
+                #if ( INCLUDE_vTaskSuspend == 1 )
+                {
+                    uxTask += prvListRunStatsWithinSingleList( &( pxRunStatsArray[ uxTask ] ), &xSuspendedTaskList );
+                }
+                #endif
+
+                #ifdef portALT_GET_RUN_TIME_COUNTER_VALUE
+                    portALT_GET_RUN_TIME_COUNTER_VALUE( ulNow );
+                #else
+                    ulNow = portGET_RUN_TIME_COUNTER_VALUE();
+                #endif
+
+                /* The time of the calling task is only added to its counter
+                 * when it is switched out, so add its current run here. */
+                for( x = 0; x < uxTask; x++ )
+                {
+                    if( ( pxRunStatsArray[ x ].xHandle == pxCurrentTCB ) && ( ulNow > ulTaskSwitchedInTime ) )
+                    {
+                        pxRunStatsArray[ x ].ulRunTimeCounter += ( ulNow - ulTaskSwitchedInTime );
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+                }
+
+                if( pulTotalRunTime != NULL )
+                {
+                    *pulTotalRunTime = ulNow;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                if( pulIdleRunTime != NULL )
+                {
+                    *pulIdleRunTime = ( xIdleTaskHandle != NULL ) ? xIdleTaskHandle->ulRunTimeCounter : ( configRUN_TIME_COUNTER_TYPE ) 0;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        ( void ) xTaskResumeAll();
+
+        return uxTask;
+    }
+
+#endif /* configGENERATE_RUN_TIME_STATS */
+/*----------------------------------------------------------*/
+
 #if ( INCLUDE_xTaskGetIdleTaskHandle == 1 )
 
     TaskHandle_t xTaskGetIdleTaskHandle( void )
@@ -2691,7 +4489,7 @@ BaseType_t xTaskCatchUpTicks( TickType_t xTicksToCatchUp )
                     /* Preemption is on, but a context switch should only be
                      * performed if the unblocked task has a priority that is
                      * higher than the currently executing task. */
-                    if( pxTCB->uxPriority > pxCurrentTCB->uxPriority )
+                    if( taskPREEMPTS_CURRENT_TASK( pxTCB ) )
                     {
                         /* Pend the yield to be performed when the scheduler
                          * is unsuspended. */
@@ -2819,7 +4617,7 @@ BaseType_t xTaskIncrementTick( void )
                          * processing time (which happens when both
                          * preemption and time slicing are on) is
                          * handled below.*/
-                        if( pxTCB->uxPriority > pxCurrentTCB->uxPriority )
+                        if( taskPREEMPTS_CURRENT_TASK( pxTCB ) )
                         {
                             xSwitchRequired = pdTRUE;
                         }
@@ -2833,12 +4631,30 @@ BaseType_t xTaskIncrementTick( void )
             }
         }
 
+        /* A served task that has used up its budget gets a later deadline,
+         * which may let another task run. */
+        #if ( configUSE_CBS == 1 )
+        {
+            if( taskIS_SERVED( pxCurrentTCB ) && ( prvServerCharge( pxCurrentTCB, taskGET_DEADLINE_TIME() ) != pdFALSE ) )
+            {
+                xSwitchRequired = pdTRUE;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        #endif /* configUSE_CBS */
+
         /* Tasks of equal priority to the currently running task will share
          * processing time (time slice) if preemption is on, and the application
          * writer has not explicitly turned time slicing off. */
         #if ( ( configUSE_PREEMPTION == 1 ) && ( configUSE_TIME_SLICING == 1 ) )
         {
-            if( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ pxCurrentTCB->uxPriority ] ) ) > ( UBaseType_t ) 1 )
+            /* An EDF band is not time sliced.  Its head task keeps running
+             * until a task with an earlier deadline preempts it. */
+            if( ( taskBAND_USES_EDF( pxCurrentTCB->uxPriority ) == pdFALSE ) &&
+                ( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ pxCurrentTCB->uxPriority ] ) ) > ( UBaseType_t ) 1 ) )
             {
                 xSwitchRequired = pdTRUE;
             }
@@ -3006,6 +4822,88 @@ BaseType_t xTaskIncrementTick( void )
 #endif /* configUSE_APPLICATION_TASK_TAG */
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_EDF_SCHEDULER == 1 )
+
+    void vTaskSetDeadline( TaskHandle_t xTask,
+                           DeadlineTime_t xDeadline )
+    {
+        TCB_t * pxTCB;
+        BaseType_t xYieldRequired = pdFALSE;
+
+        taskENTER_CRITICAL();
+        {
+            pxTCB = prvGetTCBFromHandle( xTask );
+            pxTCB->xDeadline = xDeadline;
+
+            /* A task that is already in the Ready state has to be moved so
+             * its ready list stays in deadline order. */
+            if( listIS_CONTAINED_WITHIN( &( pxReadyTasksLists[ pxTCB->uxPriority ] ), &( pxTCB->xStateListItem ) ) != pdFALSE )
+            {
+                ( void ) uxListRemove( &( pxTCB->xStateListItem ) );
+                taskINSERT_INTO_READY_LIST( &( pxReadyTasksLists[ pxTCB->uxPriority ] ), pxTCB );
+
+                /* If the order of the running task's band changed then the
+                 * running task might no longer be the one with the earliest
+                 * deadline. */
+                if( ( xSchedulerRunning != pdFALSE ) &&
+                    ( pxTCB->uxPriority == pxCurrentTCB->uxPriority ) &&
+                    ( listGET_OWNER_OF_HEAD_ENTRY( &( pxReadyTasksLists[ pxTCB->uxPriority ] ) ) != pxCurrentTCB ) )
+                {
+                    xYieldRequired = pdTRUE;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            if( xYieldRequired != pdFALSE )
+            {
+                taskYIELD_IF_USING_PREEMPTION();
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        taskEXIT_CRITICAL();
+    }
+
+#endif /* configUSE_EDF_SCHEDULER */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_EDF_SCHEDULER == 1 )
+
+    static void prvInsertIntoReadyListByDeadline( List_t * const pxList,
+                                                  TCB_t * const pxTCB )
+    {
+        ListItem_t * pxIterator;
+        const ListItem_t * const pxEnd = listGET_END_MARKER( pxList );
+
+        /* The item values cannot be used to order the list as they are no
+         * wider than a tick, so the deadlines of the owners are compared. */
+        for( pxIterator = listGET_HEAD_ENTRY( pxList ); pxIterator != pxEnd; pxIterator = listGET_NEXT( pxIterator ) ) /*lint !e826 !e740 !e9087 The mini list structure is used as the list end to save RAM.  This is checked and valid. */
+        {
+            if( taskDEADLINE_IS_BEFORE( pxTCB->xDeadline, ( ( TCB_t * ) listGET_LIST_ITEM_OWNER( pxIterator ) )->xDeadline ) )
+            {
+                break;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+
+        listINSERT_BEFORE( pxList, pxIterator, &( pxTCB->xStateListItem ) );
+    }
+
+#endif /* configUSE_EDF_SCHEDULER */
+/*-----------------------------------------------------------*/
+
 void vTaskSwitchContext( void )
 {
     if( uxSchedulerSuspended != ( UBaseType_t ) pdFALSE )
@@ -3050,6 +4948,29 @@ void vTaskSwitchContext( void )
         /* Check for stack overflow, if configured. */
         taskCHECK_FOR_STACK_OVERFLOW();
 
+        /* A job that is preempted or blocks after its deadline has already
+         * missed it, so report the miss now rather than when the job ends. */
+        #if ( configUSE_DEADLINE_MISS_DETECTION == 1 )
+        {
+            prvCheckForDeadlineMiss( pxCurrentTCB, taskGET_DEADLINE_TIME() );
+        }
+        #endif
+
+        /* Charge the server of the outgoing task before the next task is
+         * selected, as a used up budget changes its place in the ready list. */
+        #if ( configUSE_CBS == 1 )
+        {
+            if( taskIS_SERVED( pxCurrentTCB ) )
+            {
+                ( void ) prvServerCharge( pxCurrentTCB, taskGET_DEADLINE_TIME() );
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        #endif
+
         /* Before the currently running task is switched out, save its errno. */
         #if ( configUSE_POSIX_ERRNO == 1 )
         {
@@ -3058,10 +4979,42 @@ void vTaskSwitchContext( void )
         #endif
 
         /* Select a new task to run using either the generic C or port
-         * optimised asm code. */
-        taskSELECT_HIGHEST_PRIORITY_TASK(); /*lint !e9079 void * is used as this macro is used with timers and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
+         * optimised asm code.  The task of an open time triggered slot is
+         * selected without searching the ready lists, so that the time taken
+         * does not depend on the state of the other tasks. */
+        #if ( configUSE_TIME_TRIGGERED == 1 )
+            if( ( pxTimeTriggeredTCB != NULL ) &&
+                ( listIS_CONTAINED_WITHIN( &( pxReadyTasksLists[ pxTimeTriggeredTCB->uxPriority ] ), &( pxTimeTriggeredTCB->xStateListItem ) ) != pdFALSE ) )
+            {
+                pxCurrentTCB = pxTimeTriggeredTCB;
+            }
+            else
+        #endif
+        {
+            taskSELECT_HIGHEST_PRIORITY_TASK(); /*lint !e9079 void * is used as this macro is used with timers and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
+        }
         traceTASK_SWITCHED_IN();
 
+        /* The first run of a job ends its start latency. */
+        #if ( configUSE_JOB_STATS == 1 )
+        {
+            prvRecordJobStart( pxCurrentTCB, taskGET_DEADLINE_TIME() );
+        }
+        #endif
+
+        #if ( configUSE_CBS == 1 )
+        {
+            if( taskIS_SERVED( pxCurrentTCB ) )
+            {
+                xServerChargedTime = taskGET_DEADLINE_TIME();
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        #endif
+
         /* After the new task is switched in, update the global errno. */
         #if ( configUSE_POSIX_ERRNO == 1 )
         {
@@ -3214,7 +5167,7 @@ BaseType_t xTaskRemoveFromEventList( const List_t * const pxEventList )
         listINSERT_END( &( xPendingReadyList ), &( pxUnblockedTCB->xEventListItem ) );
     }
 
-    if( pxUnblockedTCB->uxPriority > pxCurrentTCB->uxPriority )
+    if( taskPREEMPTS_CURRENT_TASK( pxUnblockedTCB ) )
     {
         /* Return true if the task removed from the event list has a higher
          * priority than the calling task.  This allows the calling task to know if
@@ -3272,7 +5225,7 @@ void vTaskRemoveFromUnorderedEventList( ListItem_t * pxEventListItem,
     listREMOVE_ITEM( &( pxUnblockedTCB->xStateListItem ) );
     prvAddTaskToReadyList( pxUnblockedTCB );
 
-    if( pxUnblockedTCB->uxPriority > pxCurrentTCB->uxPriority )
+    if( taskPREEMPTS_CURRENT_TASK( pxUnblockedTCB ) )
     {
         /* The unblocked task has a priority above that of the calling task, so
          * a context switch is required.  This function is called with the
@@ -3853,6 +5806,45 @@ static void prvCheckTasksWaitingTermination( void )
 #endif /* configUSE_TRACE_FACILITY */
 /*-----------------------------------------------------------*/
 
+#if ( configGENERATE_RUN_TIME_STATS == 1 )
+
+    static UBaseType_t prvListRunStatsWithinSingleList( TaskRunStats_t * pxRunStatsArray,
+                                                        List_t * pxList )
+    {
+        configLIST_VOLATILE TCB_t * pxNextTCB;
+        configLIST_VOLATILE TCB_t * pxFirstTCB;
+        UBaseType_t uxTask = 0;
+
+        if( listCURRENT_LIST_LENGTH( pxList ) > ( UBaseType_t ) 0 )
+        {
+            listGET_OWNER_OF_NEXT_ENTRY( pxFirstTCB, pxList ); /*lint !e9079 void * is used as this macro is used with timers and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
+
+            do
+            {
+                listGET_OWNER_OF_NEXT_ENTRY( pxNextTCB, pxList ); /*lint !e9079 void * is used as this macro is used with timers and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
+                pxRunStatsArray[ uxTask ].xHandle = ( TaskHandle_t ) pxNextTCB;
+                pxRunStatsArray[ uxTask ].ulRunTimeCounter = pxNextTCB->ulRunTimeCounter;
+
+                #if ( configUSE_JOB_STATS == 1 )
+                {
+                    pxRunStatsArray[ uxTask ].xJobStats = pxNextTCB->xJobStats;
+                }
+                #endif
+
+                uxTask++;
+            } while( pxNextTCB != pxFirstTCB );
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        return uxTask;
+    }
+
+#endif /* configGENERATE_RUN_TIME_STATS */
+/*-----------------------------------------------------------*/
+
 #if ( ( configUSE_TRACE_FACILITY == 1 ) || ( INCLUDE_uxTaskGetStackHighWaterMark == 1 ) || ( INCLUDE_uxTaskGetStackHighWaterMark2 == 1 ) )
 
     static configSTACK_DEPTH_TYPE prvTaskCheckFreeStackSpace( const uint8_t * pucStackByte )
@@ -3962,7 +5954,7 @@ static void prvCheckTasksWaitingTermination( void )
             /* The task can only have been allocated dynamically - free both
              * the stack and TCB. */
             vPortFreeStack( pxTCB->pxStack );
-            vPortFree( pxTCB );
+            vPortFreeTCB( pxTCB );
         }
         #elif ( tskSTATIC_AND_DYNAMIC_ALLOCATION_POSSIBLE != 0 ) /*lint !e731 !e9029 Macro has been consolidated for readability reasons. */
         {
@@ -3974,13 +5966,13 @@ static void prvCheckTasksWaitingTermination( void )
                 /* Both the stack and TCB were allocated dynamically, so both
                  * must be freed. */
                 vPortFreeStack( pxTCB->pxStack );
-                vPortFree( pxTCB );
+                vPortFreeTCB( pxTCB );
             }
             else if( pxTCB->ucStaticallyAllocated == tskSTATICALLY_ALLOCATED_STACK_ONLY )
             {
                 /* Only the stack was statically allocated, so the TCB is the
                  * only memory that must be freed. */
-                vPortFree( pxTCB );
+                vPortFreeTCB( pxTCB );
             }
             else
             {
@@ -4152,6 +6144,53 @@ static void prvResetNextTaskUnblockTime( void )
 #endif /* configUSE_MUTEXES */
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_MUTEX_CEILING == 1 )
+
+    void vTaskPriorityRaiseToCeiling( UBaseType_t uxCeilingPriority )
+    {
+        TCB_t * const pxTCB = pxCurrentTCB;
+
+        configASSERT( uxCeilingPriority < ( UBaseType_t ) configMAX_PRIORITIES );
+
+        if( pxTCB->uxPriority < uxCeilingPriority )
+        {
+            /* Only reset the event list item value if the value is not being
+             * used for anything else. */
+            if( ( listGET_LIST_ITEM_VALUE( &( pxTCB->xEventListItem ) ) & taskEVENT_LIST_ITEM_VALUE_IN_USE ) == 0UL )
+            {
+                listSET_LIST_ITEM_VALUE( &( pxTCB->xEventListItem ), ( TickType_t ) configMAX_PRIORITIES - ( TickType_t ) uxCeilingPriority ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            /* The calling task is running, so it is known to be in its ready
+             * list and the port level reset macro can be called directly.
+             * Raising the running task never requires a context switch. */
+            if( uxListRemove( &( pxTCB->xStateListItem ) ) == ( UBaseType_t ) 0 )
+            {
+                portRESET_READY_PRIORITY( pxTCB->uxPriority, uxTopReadyPriority );
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            pxTCB->uxPriority = uxCeilingPriority;
+            prvAddTaskToReadyList( pxTCB );
+
+            traceTASK_PRIORITY_CEILING( pxTCB, uxCeilingPriority );
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+
+#endif /* configUSE_MUTEX_CEILING */
+/*-----------------------------------------------------------*/
+
 #if ( configUSE_MUTEXES == 1 )
 
     BaseType_t xTaskPriorityDisinherit( TaskHandle_t const pxMutexHolder )
@@ -4943,7 +6982,7 @@ TickType_t uxTaskResetEventItemValue( void )
                 }
                 #endif
 
-                if( pxTCB->uxPriority > pxCurrentTCB->uxPriority )
+                if( taskPREEMPTS_CURRENT_TASK( pxTCB ) )
                 {
                     /* The notified task has a priority above the currently
                      * executing task so a yield is required. */
@@ -5078,7 +7117,7 @@ TickType_t uxTaskResetEventItemValue( void )
                     listINSERT_END( &( xPendingReadyList ), &( pxTCB->xEventListItem ) );
                 }
 
-                if( pxTCB->uxPriority > pxCurrentTCB->uxPriority )
+                if( taskPREEMPTS_CURRENT_TASK( pxTCB ) )
                 {
                     /* The notified task has a priority above the currently
                      * executing task so a yield is required. */
@@ -5169,7 +7208,7 @@ TickType_t uxTaskResetEventItemValue( void )
                     listINSERT_END( &( xPendingReadyList ), &( pxTCB->xEventListItem ) );
                 }
 
-                if( pxTCB->uxPriority > pxCurrentTCB->uxPriority )
+                if( taskPREEMPTS_CURRENT_TASK( pxTCB ) )
                 {
                     /* The notified task has a priority above the currently
                      * executing task so a yield is required. */
@@ -5309,6 +7348,14 @@ static void prvAddCurrentTaskToDelayedList( TickType_t xTicksToWait,
     }
     #endif
 
+    #if ( configUSE_CBS == 1 )
+    {
+        /* The server of a served task goes idle while the task is blocked,
+         * so the wake up rule is applied when the task is unblocked. */
+        pxCurrentTCB->ucServerActive = ( uint8_t ) pdFALSE;
+    }
+    #endif
+
     /* Remove the task from the ready list before adding it to the blocked list
      * as the same list item is used for both lists. */
     if( uxListRemove( &( pxCurrentTCB->xStateListItem ) ) == ( UBaseType_t ) 0 )